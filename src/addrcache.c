@@ -0,0 +1,103 @@
+/*
+ * Search By - resolved server address cache
+ *
+ * Open addressing with linear probing. Removal shifts the following entries of
+ * the probe sequence back, so there are no tombstones and lookups stay short no
+ * matter how often connections come and go.
+ */
+
+#include <string.h>
+#include "addrcache.h"
+
+struct AddressEntry {
+	uint64 serverConnectionHandlerID;  /* 0 marks a free slot, handler IDs start at 1 */
+	char address[ADDRCACHE_ADDRESS_BUFSIZE];
+};
+
+static struct AddressEntry entries[ADDRCACHE_SIZE];
+static unsigned int entryCount = 0;  /* Kept below ADDRCACHE_SIZE so every probe sequence ends at a free slot */
+
+static unsigned int slotOf(uint64 serverConnectionHandlerID) {
+	return (unsigned int)((serverConnectionHandlerID * 0x9E3779B97F4A7C15ULL) >> 58) & (ADDRCACHE_SIZE - 1);
+}
+
+/* Returns the slot holding the ID, or the free slot where it would go */
+static unsigned int findSlot(uint64 serverConnectionHandlerID) {
+	unsigned int slot = slotOf(serverConnectionHandlerID);
+	unsigned int probes;
+
+	for(probes = 0; probes < ADDRCACHE_SIZE; probes++) {
+		if(entries[slot].serverConnectionHandlerID == serverConnectionHandlerID || entries[slot].serverConnectionHandlerID == 0) {
+			return slot;
+		}
+		slot = (slot + 1) & (ADDRCACHE_SIZE - 1);
+	}
+	return ADDRCACHE_SIZE;  /* Full */
+}
+
+const char* addrcache_get(uint64 serverConnectionHandlerID) {
+	unsigned int slot;
+
+	if(serverConnectionHandlerID == 0) {
+		return NULL;
+	}
+	slot = findSlot(serverConnectionHandlerID);
+	if(slot == ADDRCACHE_SIZE || entries[slot].serverConnectionHandlerID == 0) {
+		return NULL;
+	}
+	return entries[slot].address;
+}
+
+void addrcache_put(uint64 serverConnectionHandlerID, const char* address) {
+	const size_t length = strlen(address);
+	unsigned int slot;
+
+	if(serverConnectionHandlerID == 0 || length >= ADDRCACHE_ADDRESS_BUFSIZE) {
+		return;
+	}
+	slot = findSlot(serverConnectionHandlerID);
+	if(slot == ADDRCACHE_SIZE) {
+		return;
+	}
+	if(entries[slot].serverConnectionHandlerID == 0) {
+		if(entryCount == ADDRCACHE_SIZE - 1) {
+			return;
+		}
+		entryCount++;
+	}
+	entries[slot].serverConnectionHandlerID = serverConnectionHandlerID;
+	memcpy(entries[slot].address, address, length + 1);
+}
+
+void addrcache_invalidate(uint64 serverConnectionHandlerID) {
+	unsigned int slot, next, home;
+
+	if(serverConnectionHandlerID == 0) {
+		return;
+	}
+	slot = findSlot(serverConnectionHandlerID);
+	if(slot == ADDRCACHE_SIZE || entries[slot].serverConnectionHandlerID == 0) {
+		return;
+	}
+
+	/* Move later entries of the probe sequence into the hole if their home slot allows it */
+	next = slot;
+	for(;;) {
+		next = (next + 1) & (ADDRCACHE_SIZE - 1);
+		if(entries[next].serverConnectionHandlerID == 0) {
+			break;
+		}
+		home = slotOf(entries[next].serverConnectionHandlerID);
+		if(((next - home) & (ADDRCACHE_SIZE - 1)) >= ((next - slot) & (ADDRCACHE_SIZE - 1))) {
+			entries[slot] = entries[next];
+			slot = next;
+		}
+	}
+	entries[slot].serverConnectionHandlerID = 0;
+	entryCount--;
+}
+
+void addrcache_clear() {
+	memset(entries, 0, sizeof(entries));
+	entryCount = 0;
+}
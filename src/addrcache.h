@@ -0,0 +1,39 @@
+/*
+ * Search By - resolved server address cache
+ *
+ * Finding a server's address takes up to three client library calls (see
+ * getSearchTerm in plugin.c). The result is cached per server connection
+ * until the connection status changes.
+ *
+ * Only used from the client callback thread, no locking.
+ */
+
+#ifndef ADDRCACHE_H
+#define ADDRCACHE_H
+
+#include "public_definitions.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADDRCACHE_SIZE 64  /* Power of two, more than the number of tabs anyone has open */
+#define ADDRCACHE_ADDRESS_BUFSIZE 256
+
+/* Returns the cached address of a server connection, or NULL if there is none */
+const char* addrcache_get(uint64 serverConnectionHandlerID);
+
+/* Caches the address of a server connection, overlong addresses are not cached */
+void addrcache_put(uint64 serverConnectionHandlerID, const char* address);
+
+/* Drops the cached address of a server connection */
+void addrcache_invalidate(uint64 serverConnectionHandlerID);
+
+/* Drops all cached addresses */
+void addrcache_clear();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
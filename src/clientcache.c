@@ -0,0 +1,214 @@
+/*
+ * Search By - client snapshot cache
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "clientcache.h"
+
+#define ANYID_COUNT 65536
+#define INITIAL_CAPACITY 64
+
+static struct ClientTable* tables[CLIENTCACHE_MAX_SERVERS];
+
+static struct ClientTable* findTable(uint64 serverConnectionHandlerID) {
+	int i;
+	for(i = 0; i < CLIENTCACHE_MAX_SERVERS; i++) {
+		if(tables[i] && tables[i]->serverConnectionHandlerID == serverConnectionHandlerID) {
+			return tables[i];
+		}
+	}
+	return NULL;
+}
+
+static void freeTable(struct ClientTable* table) {
+	free(table->clientIDs);
+	free(table->channelIDs);
+	free(table->databaseIDs);
+	free(table->nicknames);
+	free(table->uids);
+	free(table->slotOfClient);
+	free(table);
+}
+
+static struct ClientTable* createTable(uint64 serverConnectionHandlerID) {
+	struct ClientTable* table;
+	int i;
+
+	for(i = 0; i < CLIENTCACHE_MAX_SERVERS && tables[i]; i++) {
+	}
+	if(i == CLIENTCACHE_MAX_SERVERS) {
+		return NULL;
+	}
+	table = (struct ClientTable*)calloc(1, sizeof(struct ClientTable));
+	if(!table) {
+		return NULL;
+	}
+	table->serverConnectionHandlerID = serverConnectionHandlerID;
+	table->slotOfClient = (unsigned short*)calloc(ANYID_COUNT, sizeof(unsigned short));
+	if(!table->slotOfClient) {
+		free(table);
+		return NULL;
+	}
+	tables[i] = table;
+	return table;
+}
+
+/* Grows all columns together. Returns 0 on success, 1 if out of memory. */
+static int growTable(struct ClientTable* table) {
+	unsigned int capacity = table->capacity ? table->capacity * 2 : INITIAL_CAPACITY;
+	void* p;
+
+	if(capacity > ANYID_COUNT - 1) {
+		capacity = ANYID_COUNT - 1;  /* Rows are stored + 1 in an unsigned short */
+	}
+	if(capacity <= table->capacity) {
+		return 1;
+	}
+
+	/* Each column is replaced as soon as it is reallocated, a failure later on leaves the table consistent */
+	p = realloc(table->clientIDs, capacity * sizeof(anyID));
+	if(!p) {
+		return 1;
+	}
+	table->clientIDs = (anyID*)p;
+	p = realloc(table->channelIDs, capacity * sizeof(uint64));
+	if(!p) {
+		return 1;
+	}
+	table->channelIDs = (uint64*)p;
+	p = realloc(table->databaseIDs, capacity * sizeof(uint64));
+	if(!p) {
+		return 1;
+	}
+	table->databaseIDs = (uint64*)p;
+	p = realloc(table->nicknames, capacity * CLIENTCACHE_NICKNAME_BUFSIZE);
+	if(!p) {
+		return 1;
+	}
+	table->nicknames = (char (*)[CLIENTCACHE_NICKNAME_BUFSIZE])p;
+	p = realloc(table->uids, capacity * CLIENTCACHE_UID_BUFSIZE);
+	if(!p) {
+		return 1;
+	}
+	table->uids = (char (*)[CLIENTCACHE_UID_BUFSIZE])p;
+
+	table->capacity = capacity;
+	return 0;
+}
+
+static void copyField(char* dest, size_t destSize, const char* src) {
+	size_t length = strlen(src);
+	if(length >= destSize) {
+		length = destSize - 1;
+	}
+	memcpy(dest, src, length);
+	dest[length] = '\0';
+}
+
+int clientcache_set(uint64 serverConnectionHandlerID, anyID clientID, uint64 channelID, const char* nickname, const char* uid, uint64 databaseID) {
+	struct ClientTable* table = findTable(serverConnectionHandlerID);
+	unsigned int row;
+
+	if(!table && !(table = createTable(serverConnectionHandlerID))) {
+		return 1;
+	}
+	if(table->slotOfClient[clientID]) {
+		row = table->slotOfClient[clientID] - 1u;
+	} else {
+		if(table->count == table->capacity && growTable(table) != 0) {
+			return 1;
+		}
+		row = table->count++;
+		table->slotOfClient[clientID] = (unsigned short)(row + 1);
+	}
+
+	table->clientIDs[row] = clientID;
+	table->channelIDs[row] = channelID;
+	table->databaseIDs[row] = databaseID;
+	copyField(table->nicknames[row], CLIENTCACHE_NICKNAME_BUFSIZE, nickname);
+	copyField(table->uids[row], CLIENTCACHE_UID_BUFSIZE, uid);
+	return 0;
+}
+
+int clientcache_setServerUid(uint64 serverConnectionHandlerID, const char* serverUid) {
+	struct ClientTable* table = findTable(serverConnectionHandlerID);
+	if(!table && !(table = createTable(serverConnectionHandlerID))) {
+		return 1;
+	}
+	copyField(table->serverUid, CLIENTCACHE_UID_BUFSIZE, serverUid);
+	return 0;
+}
+
+int clientcache_find(uint64 serverConnectionHandlerID, anyID clientID) {
+	const struct ClientTable* table = findTable(serverConnectionHandlerID);
+	if(!table || !table->slotOfClient[clientID]) {
+		return -1;
+	}
+	return table->slotOfClient[clientID] - 1;
+}
+
+int clientcache_setNickname(uint64 serverConnectionHandlerID, anyID clientID, const char* nickname) {
+	struct ClientTable* table = findTable(serverConnectionHandlerID);
+	if(!table || !table->slotOfClient[clientID]) {
+		return 1;
+	}
+	copyField(table->nicknames[table->slotOfClient[clientID] - 1], CLIENTCACHE_NICKNAME_BUFSIZE, nickname);
+	return 0;
+}
+
+int clientcache_setChannel(uint64 serverConnectionHandlerID, anyID clientID, uint64 channelID) {
+	struct ClientTable* table = findTable(serverConnectionHandlerID);
+	if(!table || !table->slotOfClient[clientID]) {
+		return 1;
+	}
+	table->channelIDs[table->slotOfClient[clientID] - 1] = channelID;
+	return 0;
+}
+
+void clientcache_remove(uint64 serverConnectionHandlerID, anyID clientID) {
+	struct ClientTable* table = findTable(serverConnectionHandlerID);
+	unsigned int row, last;
+
+	if(!table || !table->slotOfClient[clientID]) {
+		return;
+	}
+	row = table->slotOfClient[clientID] - 1u;
+	last = table->count - 1;
+	table->slotOfClient[clientID] = 0;
+
+	/* Move the last row into the hole to keep the columns dense */
+	if(row != last) {
+		table->clientIDs[row] = table->clientIDs[last];
+		table->channelIDs[row] = table->channelIDs[last];
+		table->databaseIDs[row] = table->databaseIDs[last];
+		memcpy(table->nicknames[row], table->nicknames[last], CLIENTCACHE_NICKNAME_BUFSIZE);
+		memcpy(table->uids[row], table->uids[last], CLIENTCACHE_UID_BUFSIZE);
+		table->slotOfClient[table->clientIDs[row]] = (unsigned short)(row + 1);
+	}
+	table->count--;
+}
+
+void clientcache_clearServer(uint64 serverConnectionHandlerID) {
+	int i;
+	for(i = 0; i < CLIENTCACHE_MAX_SERVERS; i++) {
+		if(tables[i] && tables[i]->serverConnectionHandlerID == serverConnectionHandlerID) {
+			freeTable(tables[i]);
+			tables[i] = NULL;
+		}
+	}
+}
+
+void clientcache_clear() {
+	int i;
+	for(i = 0; i < CLIENTCACHE_MAX_SERVERS; i++) {
+		if(tables[i]) {
+			freeTable(tables[i]);
+			tables[i] = NULL;
+		}
+	}
+}
+
+const struct ClientTable* clientcache_table(uint64 serverConnectionHandlerID) {
+	return findTable(serverConnectionHandlerID);
+}
@@ -0,0 +1,68 @@
+/*
+ * Search By - client snapshot cache
+ *
+ * Keeps nickname, UID, database ID and channel of every visible client per
+ * server connection, maintained from the client move/update events. Searches
+ * and bulk operations read these tables instead of calling into the client
+ * library for every variable.
+ *
+ * Each server's clients are stored as a struct of arrays, so scans over one
+ * field (e.g. all nicknames) walk contiguous memory. Only used from the client
+ * callback thread, no locking.
+ */
+
+#ifndef CLIENTCACHE_H
+#define CLIENTCACHE_H
+
+#include "public_definitions.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLIENTCACHE_MAX_SERVERS 32
+#define CLIENTCACHE_NICKNAME_BUFSIZE 128  /* 30 characters, up to 4 bytes each in UTF-8 */
+#define CLIENTCACHE_UID_BUFSIZE 32        /* 28 characters of base64 */
+
+struct ClientTable {
+	uint64 serverConnectionHandlerID;
+	char serverUid[CLIENTCACHE_UID_BUFSIZE];  /* The virtual server's unique identifier, stable across sessions */
+	unsigned int count;
+	unsigned int capacity;
+	anyID* clientIDs;
+	uint64* channelIDs;
+	uint64* databaseIDs;
+	char (*nicknames)[CLIENTCACHE_NICKNAME_BUFSIZE];
+	char (*uids)[CLIENTCACHE_UID_BUFSIZE];
+	unsigned short* slotOfClient;  /* Indexed by client ID, 0 = not cached, else row + 1 */
+};
+
+/* Adds a client or replaces all its fields. Returns 0 on success, 1 if out of memory or servers. */
+int clientcache_set(uint64 serverConnectionHandlerID, anyID clientID, uint64 channelID, const char* nickname, const char* uid, uint64 databaseID);
+
+/* Sets the unique identifier of a server connection's virtual server. Returns 0 on success, 1 if out of memory or servers. */
+int clientcache_setServerUid(uint64 serverConnectionHandlerID, const char* serverUid);
+
+/* Updates single fields of a cached client. Return 0 on success, 1 if the client is not cached. */
+int clientcache_setNickname(uint64 serverConnectionHandlerID, anyID clientID, const char* nickname);
+int clientcache_setChannel(uint64 serverConnectionHandlerID, anyID clientID, uint64 channelID);
+
+void clientcache_remove(uint64 serverConnectionHandlerID, anyID clientID);
+
+/* Drops the table of one server connection */
+void clientcache_clearServer(uint64 serverConnectionHandlerID);
+
+/* Drops all tables */
+void clientcache_clear();
+
+/* Returns the row of a client in its server's table, or -1 if it is not cached */
+int clientcache_find(uint64 serverConnectionHandlerID, anyID clientID);
+
+/* Returns the table of a server connection, or NULL if none exists. Valid until the next modification. */
+const struct ClientTable* clientcache_table(uint64 serverConnectionHandlerID);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
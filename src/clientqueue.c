@@ -0,0 +1,94 @@
+/*
+ * Search By - work handed to the client callback thread
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <stddef.h>
+#include "clientqueue.h"
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION queue_mutex;
+#define mutexInit(m)        InitializeCriticalSection(m)
+#define mutexDestroy(m)     DeleteCriticalSection(m)
+#define mutexLock(m)        EnterCriticalSection(m)
+#define mutexUnlock(m)      LeaveCriticalSection(m)
+#define loadPointer(p)      InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define storePointer(p, v)  InterlockedExchangePointer((PVOID volatile*)(p), (v))
+#else
+typedef pthread_mutex_t queue_mutex;
+#define mutexInit(m)        pthread_mutex_init(m, NULL)
+#define mutexDestroy(m)     pthread_mutex_destroy(m)
+#define mutexLock(m)        pthread_mutex_lock(m)
+#define mutexUnlock(m)      pthread_mutex_unlock(m)
+#define loadPointer(p)      __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define storePointer(p, v)  __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
+static queue_mutex mutex;
+static int initialized = 0;
+static struct ClientTask* volatile first = NULL;  /* Oldest task */
+static struct ClientTask* last = NULL;
+
+int clientqueue_init() {
+	if(!initialized) {
+		mutexInit(&mutex);
+		initialized = 1;
+	}
+	return 0;
+}
+
+/* Takes all queued tasks, oldest first */
+static struct ClientTask* takeAll() {
+	struct ClientTask* tasks;
+
+	mutexLock(&mutex);
+	tasks = first;
+	storePointer(&first, NULL);
+	last = NULL;
+	mutexUnlock(&mutex);
+	return tasks;
+}
+
+static void runAll(int discard) {
+	struct ClientTask* task = takeAll();
+	struct ClientTask* next;
+
+	for(; task; task = next) {
+		next = task->next;
+		task->run(task, discard);
+	}
+}
+
+void clientqueue_shutdown() {
+	if(!initialized) {
+		return;
+	}
+	runAll(1);
+	mutexDestroy(&mutex);
+	initialized = 0;
+}
+
+void clientqueue_post(struct ClientTask* task) {
+	task->next = NULL;
+	mutexLock(&mutex);
+	if(last) {
+		last->next = task;
+	} else {
+		storePointer(&first, task);  /* Read without the lock by clientqueue_run */
+	}
+	last = task;
+	mutexUnlock(&mutex);
+}
+
+void clientqueue_run() {
+	/* Callbacks run far more often than tasks are posted, most of them only need this one load */
+	if(!initialized || !loadPointer(&first)) {
+		return;
+	}
+	runAll(0);
+}
@@ -0,0 +1,40 @@
+/*
+ * Search By - work handed to the client callback thread
+ *
+ * Background threads must not call into the client or write state that the
+ * callbacks own, like the search statistics. They post a task instead, and the
+ * plugin runs all posted tasks at the start of its callbacks. Tasks run in the
+ * order they were posted.
+ *
+ * A task is embedded in the caller's own struct, posting never allocates.
+ */
+
+#ifndef CLIENTQUEUE_H
+#define CLIENTQUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ClientTask {
+	/* Runs the task on the client thread, or only frees it if discard is set. The task is not used afterwards. */
+	void (*run)(struct ClientTask* task, int discard);
+	struct ClientTask* next;
+};
+
+int clientqueue_init();
+
+/* Discards the tasks still queued. Nothing may post anymore. */
+void clientqueue_shutdown();
+
+/* Queues a task. Safe from any thread. */
+void clientqueue_post(struct ClientTask* task);
+
+/* Runs the queued tasks. Only called from the client callback thread. */
+void clientqueue_run();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
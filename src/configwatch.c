@@ -0,0 +1,186 @@
+/*
+ * Search By - config file watcher
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <errno.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#include <string.h>
+#include "configwatch.h"
+
+#if defined(_WIN32) || defined(__linux__)
+
+static char watchedFile[CONFIGWATCH_PATH_BUFSIZE];
+static void (*changeCallback)() = NULL;
+static int running = 0;
+
+#ifdef _WIN32
+static HANDLE worker = NULL;
+static HANDLE stopEvent = NULL;
+static HANDLE change = INVALID_HANDLE_VALUE;
+static char watchedPath[CONFIGWATCH_PATH_BUFSIZE * 2];
+
+/* Change notifications are per directory, the file's write time tells whether it was our file */
+static int lastWriteTime(FILETIME* time) {
+	WIN32_FILE_ATTRIBUTE_DATA data;
+
+	if(!GetFileAttributesExA(watchedPath, GetFileExInfoStandard, &data)) {
+		memset(time, 0, sizeof(*time));
+		return 1;
+	}
+	*time = data.ftLastWriteTime;
+	return 0;
+}
+
+static DWORD WINAPI workerMain(LPVOID arg) {
+	HANDLE handles[2];
+	FILETIME previous, now;
+
+	handles[0] = stopEvent;
+	handles[1] = change;
+	lastWriteTime(&previous);
+	while(WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+		lastWriteTime(&now);
+		if(CompareFileTime(&now, &previous) != 0) {
+			previous = now;
+			changeCallback();
+		}
+		if(!FindNextChangeNotification(change)) {
+			break;
+		}
+	}
+	return 0;
+}
+#else
+static pthread_t worker;
+static int notifyFd = -1;
+static int stopPipe[2] = { -1, -1 };
+
+static void* workerMain(void* arg) {
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct pollfd fds[2];
+	const struct inotify_event* event;
+	ssize_t length;
+	char* p;
+	int changed;
+
+	fds[0].fd = stopPipe[0];
+	fds[0].events = POLLIN;
+	fds[1].fd = notifyFd;
+	fds[1].events = POLLIN;
+	for(;;) {
+		if(poll(fds, 2, -1) < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		if(fds[0].revents) {  /* configwatch_stop closed the other end */
+			break;
+		}
+		changed = 0;
+		while((length = read(notifyFd, buffer, sizeof(buffer))) > 0) {
+			for(p = buffer; p < buffer + length; p += sizeof(struct inotify_event) + event->len) {
+				event = (const struct inotify_event*)p;
+				changed |= event->len > 0 && strcmp(event->name, watchedFile) == 0;
+			}
+		}
+		if(changed) {
+			changeCallback();
+		}
+	}
+	return NULL;
+}
+#endif
+
+int configwatch_start(const char* directory, const char* fileName, void (*onChange)()) {
+	if(running || strlen(fileName) >= CONFIGWATCH_PATH_BUFSIZE) {
+		return 1;
+	}
+	strcpy(watchedFile, fileName);
+	changeCallback = onChange;
+
+#ifdef _WIN32
+	if(strlen(directory) >= CONFIGWATCH_PATH_BUFSIZE) {
+		return 1;
+	}
+	strcpy(watchedPath, directory);
+	strcat(watchedPath, fileName);
+	change = FindFirstChangeNotificationA(directory, FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	if(change == INVALID_HANDLE_VALUE) {
+		return 1;
+	}
+	stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	worker = stopEvent ? CreateThread(NULL, 0, workerMain, NULL, 0, NULL) : NULL;
+	if(!worker) {
+		if(stopEvent) {
+			CloseHandle(stopEvent);
+			stopEvent = NULL;
+		}
+		FindCloseChangeNotification(change);
+		change = INVALID_HANDLE_VALUE;
+		return 1;
+	}
+#else
+	notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(notifyFd < 0) {
+		return 1;
+	}
+	/* Editors either rewrite the file or write a new one and rename it over the old one */
+	if(inotify_add_watch(notifyFd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || pipe(stopPipe) != 0) {
+		close(notifyFd);
+		notifyFd = -1;
+		return 1;
+	}
+	if(pthread_create(&worker, NULL, workerMain, NULL) != 0) {
+		close(stopPipe[0]);
+		close(stopPipe[1]);
+		close(notifyFd);
+		stopPipe[0] = stopPipe[1] = notifyFd = -1;
+		return 1;
+	}
+#endif
+	running = 1;
+	return 0;
+}
+
+void configwatch_stop() {
+	if(!running) {
+		return;
+	}
+#ifdef _WIN32
+	SetEvent(stopEvent);
+	WaitForSingleObject(worker, INFINITE);
+	CloseHandle(worker);
+	CloseHandle(stopEvent);
+	FindCloseChangeNotification(change);
+	worker = NULL;
+	stopEvent = NULL;
+	change = INVALID_HANDLE_VALUE;
+#else
+	close(stopPipe[1]);
+	pthread_join(worker, NULL);
+	close(stopPipe[0]);
+	close(notifyFd);
+	stopPipe[0] = stopPipe[1] = notifyFd = -1;
+#endif
+	running = 0;
+}
+
+#else
+
+int configwatch_start(const char* directory, const char* fileName, void (*onChange)()) {
+	return 1;
+}
+
+void configwatch_stop() {
+}
+
+#endif
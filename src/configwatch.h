@@ -0,0 +1,29 @@
+/*
+ * Search By - config file watcher
+ *
+ * Calls a function on a background thread whenever one file in a directory is
+ * written or replaced. Uses inotify on Linux and change notifications on
+ * Windows; elsewhere watching is not supported and the file is only read when
+ * the plugin loads.
+ */
+
+#ifndef CONFIGWATCH_H
+#define CONFIGWATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONFIGWATCH_PATH_BUFSIZE 512
+
+/* Starts watching. Returns 0 on success, 1 on failure or if watching is not supported. */
+int configwatch_start(const char* directory, const char* fileName, void (*onChange)());
+
+/* Stops watching and waits for the thread, so onChange is not running anymore when it returns */
+void configwatch_stop();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+/*
+ * Search By - bit-parallel edit distance
+ */
+
+#include <string.h>
+#include "editdist.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EDITDIST_SSE2
+#include <emmintrin.h>
+#endif
+
+typedef unsigned long long word;
+
+void editdist_compile(struct EditPattern* pattern, const char* s, size_t length) {
+	size_t i;
+
+	if(length > EDITDIST_PATTERN_MAX) {
+		length = EDITDIST_PATTERN_MAX;
+	}
+	memset(pattern->peq, 0, sizeof(pattern->peq));
+	for(i = 0; i < length; ++i) {
+		pattern->peq[(unsigned char)s[i]][i / 64] |= (word)1 << (i % 64);
+	}
+	pattern->length = (unsigned int)length;
+	pattern->words = (unsigned int)((length + 63) / 64);
+}
+
+unsigned int editdist_bounded(const struct EditPattern* pattern, const char* text, size_t length, unsigned int maxDistance) {
+	word pv[EDITDIST_WORDS], mv[EDITDIST_WORDS];
+	word eq, xv, xh, ph, mh, lastBit;
+	unsigned int score = pattern->length;
+	unsigned int w, b;
+	int carry;
+	size_t j;
+
+	if((length > score ? length - score : score - length) > maxDistance) {
+		return maxDistance + 1;
+	}
+	if(pattern->words == 0) {
+		return (unsigned int)length;
+	}
+
+	for(b = 0; b < pattern->words; ++b) {
+		pv[b] = ~(word)0;
+		mv[b] = 0;
+	}
+	lastBit = (word)1 << ((pattern->length - 1) % 64);
+	w = pattern->words - 1;
+
+	for(j = 0; j < length; ++j) {
+		const word* peq = pattern->peq[(unsigned char)text[j]];
+
+		/* The top row of the table counts up, so every column enters block 0 with +1 */
+		carry = 1;
+		for(b = 0; b <= w; ++b) {
+			eq = peq[b];
+			xv = eq | mv[b];
+			if(carry < 0) {
+				eq |= 1;
+			}
+			xh = (((eq & pv[b]) + pv[b]) ^ pv[b]) | eq;
+			ph = mv[b] | ~(xh | pv[b]);
+			mh = pv[b] & xh;
+
+			/* The horizontal delta leaving this block, taken from its last pattern row */
+			if(b < w) {
+				int out = (int)(ph >> 63) - (int)(mh >> 63);
+				ph <<= 1;
+				mh <<= 1;
+				ph |= (word)(carry > 0);
+				mh |= (word)(carry < 0);
+				carry = out;
+			} else {
+				score += (ph & lastBit) ? 1 : 0;
+				score -= (mh & lastBit) ? 1 : 0;
+				ph <<= 1;
+				mh <<= 1;
+				ph |= (word)(carry > 0);
+				mh |= (word)(carry < 0);
+			}
+			pv[b] = mh | ~(xv | ph);
+			mv[b] = ph & xv;
+		}
+
+		/* The last row changes by at most one per remaining text byte */
+		if(score > maxDistance + (length - j - 1)) {
+			return maxDistance + 1;
+		}
+	}
+	return score <= maxDistance ? score : maxDistance + 1;
+}
+
+void editdist_batchClear(struct EditBatch* batch) {
+	memset(batch, 0, sizeof(*batch));
+}
+
+int editdist_batchAdd(struct EditBatch* batch, const char* s, size_t length) {
+	const unsigned int lane = batch->count;
+	size_t i;
+
+	if(lane == EDITDIST_BATCH_LANES || length == 0 || length > EDITDIST_BATCH_MAX) {
+		return -1;
+	}
+	for(i = 0; i < length; ++i) {
+		batch->peq[(unsigned char)s[i]][lane] |= 1u << i;
+	}
+	batch->lastBit[lane] = 1u << (length - 1);
+	batch->lengths[lane] = (unsigned int)length;
+	batch->count++;
+	return (int)lane;
+}
+
+#ifdef EDITDIST_SSE2
+
+/* The single word step of editdist_bounded for all lanes at once */
+void editdist_batch(const struct EditBatch* batch, const char* text, size_t length, unsigned int maxDistance, unsigned int* distances) {
+	const __m128i ones = _mm_set1_epi32(-1);
+	const __m128i last = _mm_loadu_si128((const __m128i*)batch->lastBit);
+	__m128i pv = ones, mv = _mm_setzero_si128();
+	__m128i score = _mm_loadu_si128((const __m128i*)batch->lengths);
+	__m128i limit = _mm_set1_epi32((int)(maxDistance + length));
+	__m128i eq, xv, xh, ph, mh;
+	unsigned int scores[EDITDIST_BATCH_LANES];
+	unsigned int lane;
+	size_t j;
+
+	/* Unused lanes have length 0 and would never exceed the bound, they start out past it */
+	score = _mm_or_si128(score, _mm_and_si128(_mm_cmpeq_epi32(last, _mm_setzero_si128()), _mm_set1_epi32(0x40000000)));
+	for(j = 0; j < length; ++j) {
+		eq = _mm_loadu_si128((const __m128i*)batch->peq[(unsigned char)text[j]]);
+		xv = _mm_or_si128(eq, mv);
+		xh = _mm_or_si128(_mm_xor_si128(_mm_add_epi32(_mm_and_si128(eq, pv), pv), pv), eq);
+		ph = _mm_or_si128(mv, _mm_andnot_si128(_mm_or_si128(xh, pv), ones));
+		mh = _mm_and_si128(pv, xh);
+		/* A lane's compare is -1 where its last bit is set, so subtracting it counts up */
+		score = _mm_sub_epi32(score, _mm_cmpeq_epi32(_mm_and_si128(ph, last), last));
+		score = _mm_add_epi32(score, _mm_cmpeq_epi32(_mm_and_si128(mh, last), last));
+		ph = _mm_or_si128(_mm_slli_epi32(ph, 1), _mm_srli_epi32(ones, 31));
+		mh = _mm_slli_epi32(mh, 1);
+		pv = _mm_or_si128(mh, _mm_andnot_si128(_mm_or_si128(xv, ph), ones));
+		mv = _mm_and_si128(ph, xv);
+
+		/* The last row changes by at most one per remaining text byte */
+		limit = _mm_add_epi32(limit, ones);
+		if(_mm_movemask_epi8(_mm_cmpgt_epi32(score, limit)) == 0xFFFF) {
+			break;
+		}
+	}
+	_mm_storeu_si128((__m128i*)scores, score);
+	for(lane = 0; lane < batch->count; ++lane) {
+		distances[lane] = scores[lane] <= maxDistance && j == length ? scores[lane] : maxDistance + 1;
+	}
+}
+
+#else
+
+void editdist_batch(const struct EditBatch* batch, const char* text, size_t length, unsigned int maxDistance, unsigned int* distances) {
+	unsigned int pv[EDITDIST_BATCH_LANES], mv[EDITDIST_BATCH_LANES];
+	unsigned int eq, xv, xh, ph, mh;
+	unsigned int lane, open;
+	size_t j;
+
+	for(lane = 0; lane < batch->count; ++lane) {
+		pv[lane] = ~0u;
+		mv[lane] = 0;
+		distances[lane] = batch->lengths[lane];
+	}
+	for(j = 0; j < length; ++j) {
+		const unsigned int* row = batch->peq[(unsigned char)text[j]];
+
+		open = 0;
+		for(lane = 0; lane < batch->count; ++lane) {
+			eq = row[lane];
+			xv = eq | mv[lane];
+			xh = (((eq & pv[lane]) + pv[lane]) ^ pv[lane]) | eq;
+			ph = mv[lane] | ~(xh | pv[lane]);
+			mh = pv[lane] & xh;
+			distances[lane] += (ph & batch->lastBit[lane]) ? 1 : 0;
+			distances[lane] -= (mh & batch->lastBit[lane]) ? 1 : 0;
+			ph = (ph << 1) | 1;
+			mh <<= 1;
+			pv[lane] = mh | ~(xv | ph);
+			mv[lane] = ph & xv;
+			open += distances[lane] <= maxDistance + (length - j - 1);
+		}
+		if(open == 0) {
+			break;
+		}
+	}
+	for(lane = 0; lane < batch->count; ++lane) {
+		if(distances[lane] > maxDistance || j < length) {
+			distances[lane] = maxDistance + 1;
+		}
+	}
+}
+
+#endif
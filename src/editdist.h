@@ -0,0 +1,67 @@
+/*
+ * Search By - bit-parallel edit distance
+ *
+ * Levenshtein distance with Myers' bit-vector algorithm, in the block form of
+ * Hyyrö: one 64-bit word per 64 pattern bytes, so a text byte costs a handful
+ * of word operations instead of a row of the dynamic programming table.
+ *
+ * A pattern is compiled once and then compared against any number of texts.
+ *
+ * A batch holds up to EDITDIST_BATCH_LANES patterns of at most 32 bytes, like
+ * nicknames, with their match tables interleaved so one text is compared
+ * against all of them in the same pass. With SSE2 the four 32-bit words share
+ * one vector register and a text byte costs a single load; without it the
+ * lanes run one after another.
+ */
+
+#ifndef EDITDIST_H
+#define EDITDIST_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EDITDIST_PATTERN_MAX 128
+#define EDITDIST_WORDS (EDITDIST_PATTERN_MAX / 64)
+
+struct EditPattern {
+	unsigned long long peq[256][EDITDIST_WORDS];  /* Bit i of byte c is set if pattern[i] == c */
+	unsigned int length;
+	unsigned int words;
+};
+
+/* Compiles a pattern, longer patterns are cut at EDITDIST_PATTERN_MAX bytes */
+void editdist_compile(struct EditPattern* pattern, const char* s, size_t length);
+
+/* Returns the edit distance between pattern and text, or maxDistance + 1 as soon as it is known to exceed it */
+unsigned int editdist_bounded(const struct EditPattern* pattern, const char* text, size_t length, unsigned int maxDistance);
+
+#define EDITDIST_BATCH_LANES 4
+#define EDITDIST_BATCH_MAX 32  /* Longest pattern in a batch, one 32-bit word */
+
+struct EditBatch {
+	unsigned int peq[256][EDITDIST_BATCH_LANES];  /* Bit i of lane l is set if pattern l has the byte at i */
+	unsigned int lastBit[EDITDIST_BATCH_LANES];   /* The bit of the last pattern byte, 0 in unused lanes */
+	unsigned int lengths[EDITDIST_BATCH_LANES];
+	unsigned int count;
+};
+
+void editdist_batchClear(struct EditBatch* batch);
+
+/* Adds a pattern of 1 to EDITDIST_BATCH_MAX bytes to the next lane. Returns the lane, or -1 if it is full or the pattern does not fit. */
+int editdist_batchAdd(struct EditBatch* batch, const char* s, size_t length);
+
+/*
+ * Stores the edit distance between the text and the pattern of every used lane
+ * in distances, or maxDistance + 1 where it exceeds maxDistance. Stops early
+ * once every lane is known to exceed it.
+ */
+void editdist_batch(const struct EditBatch* batch, const char* text, size_t length, unsigned int maxDistance, unsigned int* distances);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,352 @@
+/*
+ * Search By - url encoding
+ *
+ * Encoding runs in two passes: the exact output length is computed first so the
+ * output is allocated once at its final size, then the bytes are written. Both
+ * passes classify 32 bytes at a time with AVX2 or 16 with SSE2 where available;
+ * runs of bytes without anything to escape are copied a block at a time and only
+ * the bytes to escape go through the per-byte table. SSE2 is part of every x64 CPU, AVX2 is only
+ * used if the CPU reports it, which is checked once on first use.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "encode.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENCODE_SSE2
+#include <emmintrin.h>
+#endif
+
+/* The block classifiers must be inlined into their loops, calls would cost more than they do */
+#if defined(_MSC_VER)
+#define BLOCK_FUNCTION static __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define BLOCK_FUNCTION static inline __attribute__((always_inline))
+#else
+#define BLOCK_FUNCTION static
+#endif
+
+/* AVX2 code is compiled for its own functions only, the rest of the plugin still runs on any x64 CPU */
+#if defined(ENCODE_SSE2) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ENCODE_AVX2
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(ENCODE_SSE2) && defined(_MSC_VER) && _MSC_VER >= 1700
+#define ENCODE_AVX2
+#define AVX2_FUNCTION
+#include <immintrin.h>
+#endif
+
+/* Byte classes */
+#define C 0  /* Copied as is */
+#define P 1  /* Space, written as '+' */
+#define E 2  /* Written as %xx */
+
+static const unsigned char byteClass[256] = {
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0x00 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0x10 */
+	P, E, E, E, E, E, E, E, E, E, E, E, E, C, C, E,  /* 0x20 */
+	C, C, C, C, C, C, C, C, C, C, E, E, E, E, E, E,  /* 0x30 */
+	E, C, C, C, C, C, C, C, C, C, C, C, C, C, C, C,  /* 0x40 */
+	C, C, C, C, C, C, C, C, C, C, C, E, E, E, E, C,  /* 0x50 */
+	E, C, C, C, C, C, C, C, C, C, C, C, C, C, C, C,  /* 0x60 */
+	C, C, C, C, C, C, C, C, C, C, C, E, E, E, C, E,  /* 0x70 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0x80 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0x90 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0xA0 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0xB0 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0xC0 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0xD0 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,  /* 0xE0 */
+	E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E   /* 0xF0 */
+};
+
+#undef C
+#undef P
+#undef E
+
+/* Converts an integer value to its hex character*/
+static char to_hex(unsigned char code) {
+	static const char hex[] = "0123456789abcdef";
+	return hex[code & 15];
+}
+
+/* The instruction set in use, -1 until the CPU was checked */
+static int level = -1;
+
+#ifdef ENCODE_AVX2
+static int cpuHasAvx2() {
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 0);
+	if(info[0] < 7) {
+		return 0;
+	}
+	__cpuid(info, 1);
+	if(!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6) {  /* The OS must save the YMM registers */
+		return 0;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+/* Returns the instruction set to use, checking the CPU on the first call. Racing first calls pick the same one. */
+static int currentLevel() {
+	if(level < 0) {
+#if defined(ENCODE_AVX2)
+		level = cpuHasAvx2() ? ENCODE_LEVEL_AVX2 : ENCODE_LEVEL_SSE2;
+#elif defined(ENCODE_SSE2)
+		level = ENCODE_LEVEL_SSE2;
+#else
+		level = ENCODE_LEVEL_SCALAR;
+#endif
+	}
+	return level;
+}
+
+int url_encode_level() {
+	return currentLevel();
+}
+
+int url_encode_setLevel(int newLevel) {
+	switch(newLevel) {
+		case ENCODE_LEVEL_SCALAR:
+			break;
+#ifdef ENCODE_SSE2
+		case ENCODE_LEVEL_SSE2:
+			break;
+#endif
+#ifdef ENCODE_AVX2
+		case ENCODE_LEVEL_AVX2:
+			if(!cpuHasAvx2()) {
+				return 1;
+			}
+			break;
+#endif
+		default:
+			return 1;
+	}
+	level = newLevel;
+	return 0;
+}
+
+/* Number of set bits below the lowest clear one, mask must have a clear bit */
+static unsigned int trailingOnes(unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned int)__builtin_ctz(~mask);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, ~mask);
+	return (unsigned int)index;
+#else
+	unsigned int n = 0;
+	for(; mask & 1; mask >>= 1) {
+		n++;
+	}
+	return n;
+#endif
+}
+
+static unsigned int popcount32(unsigned int x) {
+	x = x - ((x >> 1) & 0x55555555u);
+	x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+	x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+	return (x * 0x01010101u) >> 24;
+}
+
+#ifdef ENCODE_SSE2
+/* Returns a bitmask with bit i set if byte i of the block is copied unchanged */
+BLOCK_FUNCTION unsigned int copyMask(__m128i block) {
+	const __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));  /* Folds A-Z onto a-z */
+	/* Signed compares: bytes >= 0x80 are negative and never fall into an ASCII range */
+	__m128i keep = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+	keep = _mm_or_si128(keep, _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1))));
+	keep = _mm_or_si128(keep, _mm_cmpeq_epi8(block, _mm_set1_epi8('-')));
+	keep = _mm_or_si128(keep, _mm_cmpeq_epi8(block, _mm_set1_epi8('_')));
+	keep = _mm_or_si128(keep, _mm_cmpeq_epi8(block, _mm_set1_epi8('.')));
+	keep = _mm_or_si128(keep, _mm_cmpeq_epi8(block, _mm_set1_epi8('~')));
+	return (unsigned int)_mm_movemask_epi8(keep);
+}
+
+/* Returns a bitmask with bit i set if byte i of the block needs %xx escaping */
+BLOCK_FUNCTION unsigned int escapeMask(__m128i block) {
+	const unsigned int space = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')));
+	return ~(copyMask(block) | space) & 0xFFFF;
+}
+#endif
+
+#ifdef ENCODE_AVX2
+/* copyMask and escapeMask for 32 bytes */
+AVX2_FUNCTION BLOCK_FUNCTION unsigned int copyMaskAvx2(__m256i block) {
+	const __m256i lower = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+	__m256i keep = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+	keep = _mm256_or_si256(keep, _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block)));
+	keep = _mm256_or_si256(keep, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('-')));
+	keep = _mm256_or_si256(keep, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('_')));
+	keep = _mm256_or_si256(keep, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('.')));
+	keep = _mm256_or_si256(keep, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('~')));
+	return (unsigned int)_mm256_movemask_epi8(keep);
+}
+
+AVX2_FUNCTION BLOCK_FUNCTION unsigned int escapeMaskAvx2(__m256i block) {
+	const unsigned int space = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')));
+	return ~(copyMaskAvx2(block) | space);
+}
+
+/* Counts the bytes to escape in the whole 32-byte blocks of in, *done is set to the bytes looked at */
+AVX2_FUNCTION static size_t escapedAvx2(const unsigned char* in, size_t length, size_t* done) {
+	size_t escaped = 0;
+	size_t i;
+
+	for(i = 0; i + 32 <= length; i += 32) {
+		escaped += popcount32(escapeMaskAvx2(_mm256_loadu_si256((const __m256i*)(in + i))));
+	}
+	_mm256_zeroupper();  /* Avoids the penalty of the SSE code running next */
+	*done = i;
+	return escaped;
+}
+#endif
+
+size_t url_encoded_length(const char* str, size_t length) {
+	const unsigned char* in = (const unsigned char*)str;
+	const int simd = currentLevel();
+	size_t escaped = 0;
+	size_t i = 0;
+
+#ifdef ENCODE_AVX2
+	if(simd == ENCODE_LEVEL_AVX2 && length >= 32) {
+		escaped = escapedAvx2(in, length, &i);
+	}
+#endif
+#ifdef ENCODE_SSE2
+	if(simd >= ENCODE_LEVEL_SSE2) {
+		for(; i + 16 <= length; i += 16) {
+			escaped += popcount32(escapeMask(_mm_loadu_si128((const __m128i*)(in + i))));
+		}
+	}
+#endif
+	for(; i < length; i++) {
+		escaped += byteClass[in[i]] == 2;
+	}
+	return length + 2 * escaped;
+}
+
+/* Writes the encoded form of length bytes of in to o byte by byte, returns the end of the output */
+static char* encodeScalar(const unsigned char* in, size_t length, char* o) {
+	size_t i;
+
+	for(i = 0; i < length; i++) {
+		switch(byteClass[in[i]]) {
+			case 0:
+				*o++ = (char)in[i];
+				break;
+			case 1:
+				*o++ = '+';
+				break;
+			default:
+				*o++ = '%';
+				*o++ = to_hex(in[i] >> 4);
+				*o++ = to_hex(in[i] & 15);
+				break;
+		}
+	}
+	return o;
+}
+
+/*
+ * The block loops below store every block to the output as is and then keep only its bytes
+ * up to the first one to escape, which is written by the table before the next block is
+ * loaded right after it. Storing a whole block is safe: the output never gets shorter than
+ * the input, so at least as many bytes of output are left as of input.
+ */
+
+#ifdef ENCODE_AVX2
+/* Encodes in while 32 bytes are left, advancing *out. Returns the number of bytes encoded. */
+AVX2_FUNCTION static size_t encodeAvx2(const unsigned char* in, size_t length, char** out) {
+	char* o = *out;
+	size_t i = 0;
+	unsigned int mask, copied;
+
+	while(i + 32 <= length) {
+		const __m256i block = _mm256_loadu_si256((const __m256i*)(in + i));
+		mask = copyMaskAvx2(block);
+		_mm256_storeu_si256((__m256i*)o, block);
+		if(mask == 0xFFFFFFFFu) {
+			o += 32;
+			i += 32;
+			continue;
+		}
+		copied = trailingOnes(mask);
+		o = encodeScalar(in + i + copied, 1, o + copied);
+		i += copied + 1;
+	}
+	_mm256_zeroupper();
+	*out = o;
+	return i;
+}
+#endif
+
+/* Writes the encoded form of length bytes of in to out, returns the number of bytes written */
+static size_t encodeBytes(const unsigned char* in, size_t length, char* out) {
+	const int simd = currentLevel();
+	char* o = out;
+	size_t i = 0;
+#ifdef ENCODE_SSE2
+	unsigned int mask, copied;
+#endif
+
+#ifdef ENCODE_AVX2
+	if(simd == ENCODE_LEVEL_AVX2 && length >= 32) {
+		i = encodeAvx2(in, length, &o);
+	}
+#endif
+#ifdef ENCODE_SSE2
+	if(simd >= ENCODE_LEVEL_SSE2) {
+		while(i + 16 <= length) {
+			const __m128i block = _mm_loadu_si128((const __m128i*)(in + i));
+			mask = copyMask(block);
+			_mm_storeu_si128((__m128i*)o, block);
+			if(mask == 0xFFFF) {
+				o += 16;
+				i += 16;
+				continue;
+			}
+			copied = trailingOnes(mask);
+			o = encodeScalar(in + i + copied, 1, o + copied);
+			i += copied + 1;
+		}
+	}
+#endif
+	o = encodeScalar(in + i, length - i, o);
+	return (size_t)(o - out);
+}
+
+size_t url_encode_into(const char* str, size_t length, char* out, size_t outSize) {
+	const size_t required = url_encoded_length(str, length);
+	if(required < outSize) {
+		out[encodeBytes((const unsigned char*)str, length, out)] = '\0';
+	}
+	return required;
+}
+
+char* url_encode(const char* str) {
+	const size_t length = strlen(str);
+	const size_t required = url_encoded_length(str, length);
+	char* buf = (char*)malloc(required + 1);
+	if(!buf) {
+		return NULL;
+	}
+	buf[encodeBytes((const unsigned char*)str, length, buf)] = '\0';
+	return buf;
+}
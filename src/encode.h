@@ -0,0 +1,48 @@
+/*
+ * Search By - url encoding
+ *
+ * Unreserved characters (A-Z a-z 0-9 - _ . ~) are copied, spaces become '+'
+ * and every other byte is written as %xx.
+ */
+
+#ifndef ENCODE_H
+#define ENCODE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Instruction sets the encoder can use */
+enum EncodeLevel {
+	ENCODE_LEVEL_SCALAR = 0,
+	ENCODE_LEVEL_SSE2,
+	ENCODE_LEVEL_AVX2
+};
+
+/* Returns the instruction set in use, the widest one the build and CPU support unless set otherwise */
+int url_encode_level();
+
+/* Forces an instruction set, for tests and benchmarks. Returns 0 on success, 1 if the build or CPU lacks it. */
+int url_encode_setLevel(int level);
+
+/* Returns the exact length of the url-encoded form of the first length bytes of str, without terminator */
+size_t url_encoded_length(const char* str, size_t length);
+
+/*
+ * Url-encodes the first length bytes of str into out and terminates it, without allocating.
+ * Returns the encoded length without terminator. If that is not less than outSize, nothing is
+ * written and the caller can retry with a buffer of the returned length + 1.
+ */
+size_t url_encode_into(const char* str, size_t length, char* out, size_t outSize);
+
+/* Returns a url-encoded version of str */
+/* IMPORTANT: be sure to free() the returned string after use */
+char* url_encode(const char* str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
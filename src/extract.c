@@ -0,0 +1,347 @@
+/*
+ * Search By - streaming field extractor
+ */
+
+#include <string.h>
+#include "extract.h"
+
+#define EXTRACT_CAPTURE_MAX 4096  /* Gives up on a field whose after marker does not show up */
+
+static void compilePattern(struct ExtractPattern* pattern, const char* text, size_t length) {
+	unsigned int i;
+	unsigned int k = 0;
+
+	memcpy(pattern->text, text, length);
+	pattern->length = (unsigned int)length;
+	pattern->fail[0] = 0;
+	for(i = 1; i < length; i++) {
+		while(k > 0 && text[i] != text[k]) {
+			k = pattern->fail[k - 1];
+		}
+		if(text[i] == text[k]) {
+			k++;
+		}
+		pattern->fail[i] = (unsigned char)k;
+	}
+}
+
+static unsigned int step(const struct ExtractPattern* pattern, unsigned int state, char c) {
+	while(state > 0 && pattern->text[state] != c) {
+		state = pattern->fail[state - 1];
+	}
+	if(pattern->text[state] == c) {
+		state++;
+	}
+	return state;
+}
+
+void extract_initProfile(struct ExtractProfile* profile) {
+	memset(profile, 0, sizeof(*profile));
+}
+
+int extract_addField(struct ExtractProfile* profile, const char* name, const char* before, const char* after) {
+	size_t nameLength = strlen(name);
+	size_t beforeLength = strlen(before);
+	size_t afterLength = after ? strlen(after) : 0;
+	struct ExtractField* field;
+	unsigned int i;
+
+	if(beforeLength == 0 || beforeLength > EXTRACT_PATTERN_MAX) {
+		return 1;
+	}
+	if(strcmp(name, EXTRACT_RECORD_FIELD) == 0) {
+		compilePattern(&profile->record, before, beforeLength);
+		profile->firstByte[(unsigned char)before[0]] = 1;
+		return 0;
+	}
+	if(nameLength == 0 || nameLength >= EXTRACT_NAME_BUFSIZE || afterLength == 0 || afterLength > EXTRACT_PATTERN_MAX) {
+		return 1;
+	}
+
+	for(i = 0; i < profile->fieldCount; i++) {  /* A field given again replaces the earlier markers */
+		if(strcmp(profile->fields[i].name, name) == 0) {
+			break;
+		}
+	}
+	if(i == EXTRACT_MAX_FIELDS) {
+		return 1;
+	}
+	field = &profile->fields[i];
+	memcpy(field->name, name, nameLength + 1);
+	compilePattern(&field->before, before, beforeLength);
+	compilePattern(&field->after, after, afterLength);
+	profile->firstByte[(unsigned char)before[0]] = 1;
+	if(i == profile->fieldCount) {
+		profile->fieldCount++;
+	}
+	return 0;
+}
+
+/* Decodes a numeric or named entity at str, returns its length or 0 if it is not one */
+static size_t decodeEntity(const char* str, char* out, size_t* outLength) {
+	static const struct {
+		const char* name;
+		char c;
+	} named[] = {
+		{ "&amp;", '&' }, { "&lt;", '<' }, { "&gt;", '>' }, { "&quot;", '"' },
+		{ "&apos;", '\'' }, { "&nbsp;", ' ' }
+	};
+	unsigned long cp = 0;
+	size_t i;
+
+	for(i = 0; i < sizeof(named) / sizeof(named[0]); i++) {
+		size_t length = strlen(named[i].name);
+		if(strncmp(str, named[i].name, length) == 0) {
+			out[0] = named[i].c;
+			*outLength = 1;
+			return length;
+		}
+	}
+	if(str[1] != '#') {
+		return 0;
+	}
+	if(str[2] == 'x' || str[2] == 'X') {
+		for(i = 3; i < 9; i++) {
+			char c = str[i];
+			if(c >= '0' && c <= '9') cp = cp * 16 + (c - '0');
+			else if(c >= 'a' && c <= 'f') cp = cp * 16 + (c - 'a' + 10);
+			else if(c >= 'A' && c <= 'F') cp = cp * 16 + (c - 'A' + 10);
+			else break;
+		}
+		if(i == 3) {
+			return 0;
+		}
+	} else {
+		for(i = 2; i < 9 && str[i] >= '0' && str[i] <= '9'; i++) {
+			cp = cp * 10 + (str[i] - '0');
+		}
+		if(i == 2) {
+			return 0;
+		}
+	}
+	if(str[i] != ';' || cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+		return 0;
+	}
+	/* The UTF-8 form is never longer than the entity, so the value can be decoded in place */
+	if(cp < 0x80) {
+		out[0] = (char)cp;
+		*outLength = 1;
+	} else if(cp < 0x800) {
+		out[0] = (char)(0xC0 | (cp >> 6));
+		out[1] = (char)(0x80 | (cp & 0x3F));
+		*outLength = 2;
+	} else if(cp < 0x10000) {
+		out[0] = (char)(0xE0 | (cp >> 12));
+		out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		out[2] = (char)(0x80 | (cp & 0x3F));
+		*outLength = 3;
+	} else {
+		out[0] = (char)(0xF0 | (cp >> 18));
+		out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		out[3] = (char)(0x80 | (cp & 0x3F));
+		*outLength = 4;
+	}
+	return i + 1;
+}
+
+/* Drops tags, decodes entities and collapses whitespace, in place */
+static void cleanValue(char* value) {
+	const char* in = value;
+	char* out = value;
+	int inTag = 0;
+	int space = 0;
+
+	while(*in) {
+		char c = *in;
+		if(inTag) {
+			inTag = c != '>';
+			in++;
+			continue;
+		}
+		if(c == '<') {
+			inTag = 1;
+			space = 1;  /* <br> and block tags separate words */
+			in++;
+			continue;
+		}
+		if(c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+			space = 1;
+			in++;
+			continue;
+		}
+		if(space && out != value) {
+			*out++ = ' ';
+		}
+		space = 0;
+		if(c == '&') {
+			char decoded[4];
+			size_t decodedLength;
+			size_t entityLength = decodeEntity(in, decoded, &decodedLength);
+			if(entityLength > 0) {
+				memcpy(out, decoded, decodedLength);
+				out += decodedLength;
+				in += entityLength;
+				continue;
+			}
+		}
+		*out++ = c;
+		in++;
+	}
+	*out = '\0';
+}
+
+static void resetScan(struct Extractor* extractor) {
+	extractor->recordState = 0;
+	memset(extractor->beforeStates, 0, sizeof(extractor->beforeStates));
+	extractor->activeStates = 0;
+}
+
+static void emitRecord(struct Extractor* extractor) {
+	if(extractor->record.present != 0) {
+		extractor->onRecord(extractor->context, extractor->profile, &extractor->record);
+	}
+	extractor->record.present = 0;
+}
+
+static void startCapture(struct Extractor* extractor, unsigned int field) {
+	resetScan(extractor);
+	extractor->capturing = (int)field;
+	extractor->afterState = 0;
+	extractor->captured = 0;
+	extractor->stored = 0;
+}
+
+static void finishCapture(struct Extractor* extractor) {
+	const struct ExtractField* field = &extractor->profile->fields[extractor->capturing];
+	char* value = extractor->record.values[extractor->capturing];
+	size_t length = extractor->captured - field->after.length;  /* The after marker was stored too */
+
+	if(extractor->stored < length) {
+		length = extractor->stored;
+	}
+	value[length] = '\0';
+	cleanValue(value);
+	if(value[0] != '\0') {
+		extractor->record.present |= 1u << extractor->capturing;
+	}
+	extractor->capturing = -1;
+}
+
+static void store(struct Extractor* extractor, const char* data, size_t length) {
+	size_t room = EXTRACT_VALUE_BUFSIZE - 1 - extractor->stored;
+
+	if(length > room) {
+		length = room;
+	}
+	memcpy(extractor->record.values[extractor->capturing] + extractor->stored, data, length);
+	extractor->stored += length;
+}
+
+/* Consumes bytes of the value being captured, returns how many were used */
+static size_t capture(struct Extractor* extractor, const char* data, size_t length) {
+	const struct ExtractPattern* after = &extractor->profile->fields[extractor->capturing].after;
+	size_t i = 0;
+
+	while(i < length) {
+		if(extractor->captured >= EXTRACT_CAPTURE_MAX) {
+			extractor->capturing = -1;
+			break;
+		}
+		if(extractor->afterState == 0) {  /* Skip straight to the next possible start of the marker */
+			size_t run = length - i;
+			const char* hit;
+			if(run > EXTRACT_CAPTURE_MAX - extractor->captured) {
+				run = EXTRACT_CAPTURE_MAX - extractor->captured;
+			}
+			hit = memchr(data + i, after->text[0], run);
+			if(hit) {
+				run = (size_t)(hit - (data + i));
+			}
+			store(extractor, data + i, run);
+			extractor->captured += run;
+			i += run;
+			if(!hit) {
+				continue;
+			}
+		}
+		store(extractor, data + i, 1);
+		extractor->captured++;
+		extractor->afterState = step(after, extractor->afterState, data[i++]);
+		if(extractor->afterState == after->length) {
+			finishCapture(extractor);
+			break;
+		}
+	}
+	return i;
+}
+
+static unsigned int advance(struct Extractor* extractor, const struct ExtractPattern* pattern, unsigned int state, char c) {
+	unsigned int next = step(pattern, state, c);
+
+	if(state == 0 && next != 0) {
+		extractor->activeStates++;
+	} else if(state != 0 && next == 0) {
+		extractor->activeStates--;
+	}
+	return next;
+}
+
+static void scan(struct Extractor* extractor, char c) {
+	const struct ExtractProfile* profile = extractor->profile;
+	unsigned int i;
+
+	if(profile->record.length > 0) {
+		extractor->recordState = advance(extractor, &profile->record, extractor->recordState, c);
+		if(extractor->recordState == profile->record.length) {
+			emitRecord(extractor);
+			resetScan(extractor);
+			return;
+		}
+	}
+	for(i = 0; i < profile->fieldCount; i++) {
+		if(extractor->record.present & (1u << i)) {  /* The first occurrence in a record wins */
+			continue;
+		}
+		extractor->beforeStates[i] = advance(extractor, &profile->fields[i].before, extractor->beforeStates[i], c);
+		if(extractor->beforeStates[i] == profile->fields[i].before.length) {
+			startCapture(extractor, i);
+			return;
+		}
+	}
+}
+
+void extract_begin(struct Extractor* extractor, const struct ExtractProfile* profile, extract_record_fn onRecord, void* context) {
+	extractor->profile = profile;
+	extractor->onRecord = onRecord;
+	extractor->context = context;
+	extractor->capturing = -1;
+	extractor->record.present = 0;
+	resetScan(extractor);
+}
+
+void extract_feed(struct Extractor* extractor, const char* data, size_t length) {
+	const unsigned char* firstByte = extractor->profile->firstByte;
+	size_t i = 0;
+
+	while(i < length) {
+		if(extractor->capturing >= 0) {
+			i += capture(extractor, data + i, length - i);
+			continue;
+		}
+		if(extractor->activeStates == 0) {  /* No partial match, skip bytes no marker starts with */
+			while(i < length && !firstByte[(unsigned char)data[i]]) {
+				i++;
+			}
+			if(i == length) {
+				break;
+			}
+		}
+		scan(extractor, data[i++]);
+	}
+}
+
+void extract_end(struct Extractor* extractor) {
+	extractor->capturing = -1;  /* A value still open at the end is incomplete */
+	emitRecord(extractor);
+}
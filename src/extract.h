@@ -0,0 +1,91 @@
+/*
+ * Search By - streaming field extractor
+ *
+ * Pulls fields out of a page while it is being received. A field is the text
+ * between a "before" and an "after" marker, and an optional record marker
+ * starts a new record, so a result list becomes one record per entry. The
+ * markers are matched with KMP automata whose state carries over from one
+ * chunk to the next, so a marker split across chunks is still found and the
+ * body itself is never buffered; only the captured values are copied.
+ *
+ * Values are cleaned before they are emitted: tags are removed, the common
+ * HTML entities decoded and whitespace collapsed.
+ */
+
+#ifndef EXTRACT_H
+#define EXTRACT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXTRACT_MAX_FIELDS 8
+#define EXTRACT_PATTERN_MAX 64
+#define EXTRACT_NAME_BUFSIZE 32
+#define EXTRACT_VALUE_BUFSIZE 256
+#define EXTRACT_RECORD_FIELD "record"  /* Field name that sets the record marker */
+
+struct ExtractPattern {
+	char text[EXTRACT_PATTERN_MAX];
+	unsigned int length;
+	unsigned char fail[EXTRACT_PATTERN_MAX];  /* KMP failure function */
+};
+
+struct ExtractField {
+	char name[EXTRACT_NAME_BUFSIZE];
+	struct ExtractPattern before;
+	struct ExtractPattern after;
+};
+
+struct ExtractProfile {
+	struct ExtractPattern record;  /* Empty if the whole page is one record */
+	unsigned int fieldCount;
+	struct ExtractField fields[EXTRACT_MAX_FIELDS];
+	unsigned char firstByte[256];  /* Non-zero for the first byte of any record or before marker */
+};
+
+struct ExtractRecord {
+	unsigned int present;  /* Bit i is set if fields[i] was found */
+	char values[EXTRACT_MAX_FIELDS][EXTRACT_VALUE_BUFSIZE];
+};
+
+typedef void (*extract_record_fn)(void* context, const struct ExtractProfile* profile, const struct ExtractRecord* record);
+
+struct Extractor {
+	const struct ExtractProfile* profile;
+	extract_record_fn onRecord;
+	void* context;
+	unsigned int recordState;
+	unsigned int beforeStates[EXTRACT_MAX_FIELDS];
+	unsigned int activeStates;  /* Number of non-zero states above, 0 allows skipping ahead */
+	int capturing;              /* Field being captured, -1 while scanning */
+	unsigned int afterState;
+	size_t captured;            /* Bytes since the before marker, including a partial after marker */
+	size_t stored;              /* Of those, how many fit into the value */
+	struct ExtractRecord record;
+};
+
+/* Clears a profile, before fields are added */
+void extract_initProfile(struct ExtractProfile* profile);
+
+/*
+ * Adds a field, or sets the record marker if name is EXTRACT_RECORD_FIELD.
+ * Returns 0 on success, 1 if a marker is empty or too long or there are too many fields.
+ */
+int extract_addField(struct ExtractProfile* profile, const char* name, const char* before, const char* after);
+
+void extract_begin(struct Extractor* extractor, const struct ExtractProfile* profile, extract_record_fn onRecord, void* context);
+
+/* Feeds the next chunk of the page, of any size */
+void extract_feed(struct Extractor* extractor, const char* data, size_t length);
+
+/* Ends the page and emits the last record */
+void extract_end(struct Extractor* extractor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
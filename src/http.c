@@ -0,0 +1,1007 @@
+/*
+ * Search By - asynchronous HTTP client
+ */
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#include <Windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "http.h"
+
+#ifdef _WIN32
+typedef SOCKET http_socket;
+#define NO_SOCKET         INVALID_SOCKET
+#define closeSocket(s)    closesocket(s)
+#define socketError()     WSAGetLastError()
+#define wouldBlock(e)     ((e) == WSAEWOULDBLOCK)
+#define inProgress(e)     ((e) == WSAEWOULDBLOCK)
+#define SEND_FLAGS        0
+typedef volatile LONG http_atomic;
+#define atomicIncrement(p)        InterlockedIncrement(p)
+#define atomicDecrement(p)        InterlockedDecrement(p)
+#define atomicLoad(p)             InterlockedCompareExchange(p, 0, 0)
+#define atomicStore(p, v)         InterlockedExchange(p, v)
+#define loadPointer(p)            InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define exchangePointer(p, v)     InterlockedExchangePointer((PVOID volatile*)(p), (v))
+#define compareExchangePointer(p, expected, desired) \
+	(InterlockedCompareExchangePointer((PVOID volatile*)(p), (desired), (expected)) == (expected))
+#define yieldThread()             SwitchToThread()
+#else
+typedef int http_socket;
+#define NO_SOCKET         (-1)
+#define closeSocket(s)    close(s)
+#define socketError()     errno
+#define wouldBlock(e)     ((e) == EAGAIN || (e) == EWOULDBLOCK)
+#define inProgress(e)     ((e) == EINPROGRESS)
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS        MSG_NOSIGNAL
+#else
+#define SEND_FLAGS        0
+#endif
+typedef int http_atomic;
+#define atomicIncrement(p)        __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST)
+#define atomicDecrement(p)        __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST)
+#define atomicLoad(p)             __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define atomicStore(p, v)         __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+#define loadPointer(p)            __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define exchangePointer(p, v)     __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL)
+#define compareExchangePointer(p, expected, desired) \
+	__atomic_compare_exchange_n(p, &(expected), desired, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#define yieldThread()             sched_yield()
+#endif
+
+#define PORT_BUFSIZE 8
+#define REQUEST_BUFSIZE (HTTP_PATH_BUFSIZE + HTTP_HOST_BUFSIZE + HTTP_HEADERS_BUFSIZE + 256)
+
+struct Request {
+	struct Request* next;       /* In the submit stack or the waiting list */
+	struct Request* followers;  /* Identical requests sharing this one's response */
+	int delivered;              /* Body bytes went out already, too late for others to join */
+	char host[HTTP_HOST_BUFSIZE];
+	char port[PORT_BUFSIZE];
+	char path[HTTP_PATH_BUFSIZE];
+	char headers[HTTP_HEADERS_BUFSIZE];
+	const struct HttpHandler* handler;
+	void* context;
+};
+
+enum ConnectionState {
+	CONNECTION_FREE = 0,
+	CONNECTION_CONNECTING,
+	CONNECTION_SENDING,
+	CONNECTION_RECEIVING,
+	CONNECTION_IDLE  /* Kept open for the next request to the same host */
+};
+
+enum ParseState {
+	PARSE_STATUS = 0,
+	PARSE_HEADERS,
+	PARSE_LENGTH_BODY,  /* Content-Length bytes */
+	PARSE_CHUNK_SIZE,
+	PARSE_CHUNK_DATA,
+	PARSE_CHUNK_END,    /* The line break after a chunk */
+	PARSE_TRAILERS,
+	PARSE_CLOSE_BODY,   /* Everything until the server closes the connection */
+	PARSE_DONE
+};
+
+struct Connection {
+	enum ConnectionState state;
+	http_socket sock;
+	char host[HTTP_HOST_BUFSIZE];
+	char port[PORT_BUFSIZE];
+	struct Request* request;       /* While connecting, sending or receiving */
+	int reused;                    /* The request went to a pooled connection, which the server may have closed meanwhile */
+	unsigned long long deadline;   /* Of the request, or when an idle connection is closed */
+	char out[REQUEST_BUFSIZE];
+	size_t outLength;
+	size_t outSent;
+	char in[HTTP_BUFSIZE];         /* Received bytes not parsed yet, body bytes are passed on right away */
+	size_t inLength;
+	int receivedAny;
+	enum ParseState parse;
+	int status;
+	int keepAlive;
+	int chunked;
+	unsigned long long contentLength;  /* Valid if hasContentLength */
+	int hasContentLength;
+	unsigned long long remaining;      /* Of the body or the current chunk */
+};
+
+/* Token bucket of one host. Credit is counted in milliseconds of refill, a request costs HTTP_RATE_INTERVAL_MS. */
+struct Bucket {
+	char host[HTTP_HOST_BUFSIZE];
+	char port[PORT_BUFSIZE];
+	unsigned long long credit;
+	unsigned long long updated;
+};
+
+#define BUCKET_CAPACITY ((unsigned long long)HTTP_RATE_BURST * HTTP_RATE_INTERVAL_MS)
+
+/* Owned by the engine thread */
+static struct Connection connections[HTTP_MAX_CONNECTIONS];
+static struct Bucket buckets[HTTP_MAX_BUCKETS];
+static unsigned int bucketCount = 0;
+static struct Request* waitingHead = NULL;  /* Taken from the submit stack, waiting for a token or a connection */
+static struct Request* waitingTail = NULL;
+
+/*
+ * Submitted requests, a stack that http_get pushes onto with compare-and-swap
+ * and the engine empties in one exchange, so submitting never takes a lock.
+ */
+static struct Request* submitted = NULL;
+static http_atomic outstanding = 0;  /* Accepted requests whose onDone has not been called yet */
+static http_atomic stopping = 0;
+static int running = 0;
+
+/* A loopback datagram socket connected to itself, http_get sends a byte to wake the engine's select */
+static http_socket wakeSocket = NO_SOCKET;
+
+#ifdef _WIN32
+static HANDLE engine = NULL;
+#else
+static pthread_t engine;
+#endif
+
+static unsigned long long nowMs() {
+#ifdef _WIN32
+	return GetTickCount64();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000 + (unsigned long long)ts.tv_nsec / 1000000;
+#endif
+}
+
+static int setNonBlocking(http_socket s) {
+#ifdef _WIN32
+	u_long on = 1;
+	return ioctlsocket(s, FIONBIO, &on) == 0 ? 0 : 1;
+#else
+	int flags = fcntl(s, F_GETFL, 0);
+	return (flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0) ? 0 : 1;
+#endif
+}
+
+/* Case-insensitive prefix match for URL schemes and header names */
+static int startsWith(const char* s, const char* prefix) {
+	for(; *prefix; s++, prefix++) {
+		char c = *s;
+		if(c >= 'A' && c <= 'Z') {
+			c = (char)(c + ('a' - 'A'));
+		}
+		if(c != *prefix) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static enum HttpError parseUrl(const char* url, struct Request* request) {
+	const char* host;
+	const char* p;
+	size_t length;
+
+	if(!startsWith(url, "http://")) {
+		return HTTP_ERROR_URL;
+	}
+	host = url + 7;
+	length = strcspn(host, ":/?#");
+	if(length == 0 || length >= HTTP_HOST_BUFSIZE) {
+		return HTTP_ERROR_URL;
+	}
+	memcpy(request->host, host, length);
+	request->host[length] = '\0';
+	p = host + length;
+
+	strcpy(request->port, "80");
+	if(*p == ':') {
+		length = strcspn(++p, "/?#");
+		if(length == 0 || length >= PORT_BUFSIZE || strspn(p, "0123456789") != length) {
+			return HTTP_ERROR_URL;
+		}
+		memcpy(request->port, p, length);
+		request->port[length] = '\0';
+		p += length;
+	}
+
+	/* The fragment is never sent */
+	length = strcspn(p, "#");
+	if(length + 2 > HTTP_PATH_BUFSIZE) {
+		return HTTP_ERROR_URL;
+	}
+	if(*p == '/') {
+		memcpy(request->path, p, length);
+		request->path[length] = '\0';
+	} else {
+		request->path[0] = '/';
+		memcpy(request->path + 1, p, length);
+		request->path[length + 1] = '\0';
+	}
+	return HTTP_OK;
+}
+
+static void closeConnection(struct Connection* c) {
+	if(c->sock != NO_SOCKET) {
+		closeSocket(c->sock);
+	}
+	c->sock = NO_SOCKET;
+	c->state = CONNECTION_FREE;
+	c->request = NULL;
+}
+
+static unsigned int idleCount(const char* host, const char* port) {
+	unsigned int i, count = 0;
+
+	for(i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+		const struct Connection* c = &connections[i];
+		count += c->state == CONNECTION_IDLE && strcmp(c->host, host) == 0 && strcmp(c->port, port) == 0;
+	}
+	return count;
+}
+
+/* Passes a response header to a request and everyone sharing it */
+static void deliverHeader(struct Request* request, const char* name, const char* value) {
+	request->delivered = 1;
+	for(; request; request = request->followers) {
+		if(request->handler->onHeader) {
+			request->handler->onHeader(request->context, name, value);
+		}
+	}
+}
+
+/* Passes body bytes to a request and everyone sharing it */
+static void deliverBody(struct Request* request, const char* data, size_t length) {
+	request->delivered = 1;
+	for(; request; request = request->followers) {
+		request->handler->onBody(request->context, data, length);
+	}
+}
+
+/* Ends a request and everyone sharing it, and frees them */
+static void deliverDone(struct Request* request, enum HttpError error, int status) {
+	struct Request* follower;
+
+	while(request) {
+		follower = request->followers;
+		request->handler->onDone(request->context, error, status);
+		free(request);
+		atomicDecrement(&outstanding);
+		request = follower;
+	}
+}
+
+/* Ends the current request of a connection and either pools or closes the connection */
+static void finishRequest(struct Connection* c, enum HttpError error) {
+	struct Request* request = c->request;
+
+	c->request = NULL;
+	if(error == HTTP_OK && c->keepAlive && c->inLength == 0 && idleCount(c->host, c->port) < HTTP_MAX_IDLE_PER_HOST) {
+		c->state = CONNECTION_IDLE;
+		c->deadline = nowMs() + HTTP_IDLE_TIMEOUT_MS;
+	} else {
+		closeConnection(c);
+	}
+	deliverDone(request, error, c->status);
+}
+
+/* Resets the response parser and formats the request into the send buffer */
+static void startRequest(struct Connection* c, struct Request* request, int reused) {
+	const int defaultPort = strcmp(request->port, "80") == 0;
+
+	c->request = request;
+	c->reused = reused;
+	c->deadline = nowMs() + HTTP_TIMEOUT_MS;
+	c->outLength = (size_t)sprintf(c->out, "GET %s HTTP/1.1\r\nHost: %s%s%s\r\nUser-Agent: SearchBy\r\nAccept-Encoding: identity\r\nConnection: keep-alive\r\n%s\r\n",
+	                               request->path, request->host, defaultPort ? "" : ":", defaultPort ? "" : request->port, request->headers);
+	c->outSent = 0;
+	c->inLength = 0;
+	c->receivedAny = 0;
+	c->parse = PARSE_STATUS;
+	c->status = 0;
+	c->keepAlive = 1;
+	c->chunked = 0;
+	c->hasContentLength = 0;
+	c->remaining = 0;
+	c->state = reused ? CONNECTION_SENDING : CONNECTION_CONNECTING;
+}
+
+/*
+ * Opens a new connection for a request on a free slot. Name resolution blocks the engine thread,
+ * pooled connections keep that to the first request per host.
+ */
+static enum HttpError openConnection(struct Connection* c, struct Request* request) {
+	struct addrinfo hints;
+	struct addrinfo* addresses;
+	http_socket s;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if(getaddrinfo(request->host, request->port, &hints, &addresses) != 0) {
+		return HTTP_ERROR_RESOLVE;
+	}
+	s = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+#ifndef _WIN32
+	if(s >= FD_SETSIZE) {
+		close(s);
+		s = NO_SOCKET;
+	}
+#endif
+	if(s == NO_SOCKET || setNonBlocking(s) != 0) {
+		if(s != NO_SOCKET) {
+			closeSocket(s);
+		}
+		freeaddrinfo(addresses);
+		return HTTP_ERROR_CONNECT;
+	}
+#ifdef SO_NOSIGPIPE
+	{
+		int on = 1;
+		setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	}
+#endif
+	if(connect(s, addresses->ai_addr, (int)addresses->ai_addrlen) != 0 && !inProgress(socketError())) {
+		closeSocket(s);
+		freeaddrinfo(addresses);
+		return HTTP_ERROR_CONNECT;
+	}
+	freeaddrinfo(addresses);
+
+	c->sock = s;
+	strcpy(c->host, request->host);
+	strcpy(c->port, request->port);
+	startRequest(c, request, 0);
+	return HTTP_OK;
+}
+
+/* Returns a connection slot for a request, or NULL if all are busy */
+static struct Connection* findSlot(const struct Request* request) {
+	struct Connection* unused = NULL;
+	struct Connection* oldestIdle = NULL;
+	unsigned int i;
+
+	for(i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+		struct Connection* c = &connections[i];
+		if(c->state == CONNECTION_IDLE && strcmp(c->host, request->host) == 0 && strcmp(c->port, request->port) == 0) {
+			return c;
+		}
+		if(c->state == CONNECTION_FREE && !unused) {
+			unused = c;
+		} else if(c->state == CONNECTION_IDLE && (!oldestIdle || c->deadline < oldestIdle->deadline)) {
+			oldestIdle = c;
+		}
+	}
+	return unused ? unused : oldestIdle;
+}
+
+static void dispatch(struct Connection* c, struct Request* request) {
+	enum HttpError error;
+
+	if(c->state == CONNECTION_IDLE && strcmp(c->host, request->host) == 0 && strcmp(c->port, request->port) == 0) {
+		startRequest(c, request, 1);
+		return;
+	}
+	if(c->state == CONNECTION_IDLE) {
+		closeConnection(c);  /* Pooled for another host, the slot is needed */
+	}
+	error = openConnection(c, request);
+	if(error != HTTP_OK) {
+		deliverDone(request, error, 0);
+	}
+}
+
+static int sameRequest(const struct Request* a, const struct Request* b) {
+	return strcmp(a->path, b->path) == 0 && strcmp(a->host, b->host) == 0 && strcmp(a->port, b->port) == 0 && strcmp(a->headers, b->headers) == 0;
+}
+
+/* Returns a waiting or running request for the same URL whose response the request can still share, or NULL */
+static struct Request* findLeader(const struct Request* request) {
+	struct Request* r;
+	unsigned int i;
+
+	for(r = waitingHead; r; r = r->next) {
+		if(sameRequest(r, request)) {
+			return r;
+		}
+	}
+	for(i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+		r = connections[i].request;
+		if(r && !r->delivered && sameRequest(r, request)) {
+			return r;
+		}
+	}
+	return NULL;
+}
+
+/* Moves submitted requests to the waiting list in submit order, joining identical requests to the first one */
+static void takeSubmitted() {
+	struct Request* stack = (struct Request*)exchangePointer(&submitted, NULL);
+	struct Request* reversed = NULL;
+	struct Request* r;
+	struct Request* leader;
+
+	while(stack) {
+		r = stack;
+		stack = r->next;
+		r->next = reversed;
+		reversed = r;
+	}
+	while(reversed) {
+		r = reversed;
+		reversed = r->next;
+		r->next = NULL;
+		leader = findLeader(r);
+		if(leader) {
+			r->followers = leader->followers;
+			leader->followers = r;
+		} else if(waitingTail) {
+			waitingTail->next = r;
+			waitingTail = r;
+		} else {
+			waitingHead = waitingTail = r;
+		}
+	}
+}
+
+/* Returns the refilled bucket of a host, reusing the longest unused one if all are taken */
+static struct Bucket* findBucket(const struct Request* request, unsigned long long now) {
+	struct Bucket* b;
+	unsigned int i, oldest = 0;
+
+	for(i = 0; i < bucketCount; i++) {
+		b = &buckets[i];
+		if(strcmp(b->host, request->host) == 0 && strcmp(b->port, request->port) == 0) {
+			b->credit += now - b->updated;
+			if(b->credit > BUCKET_CAPACITY) {
+				b->credit = BUCKET_CAPACITY;
+			}
+			b->updated = now;
+			return b;
+		}
+		if(b->updated < buckets[oldest].updated) {
+			oldest = i;
+		}
+	}
+	b = &buckets[bucketCount < HTTP_MAX_BUCKETS ? bucketCount++ : oldest];
+	strcpy(b->host, request->host);
+	strcpy(b->port, request->port);
+	b->credit = BUCKET_CAPACITY;
+	b->updated = now;
+	return b;
+}
+
+/*
+ * Starts waiting requests whose host has a token while there are connection
+ * slots for them. Returns how many milliseconds until the next token a waiting
+ * request needs, or HTTP_IDLE_TIMEOUT_MS if none waits for one.
+ */
+static unsigned long long startWaiting() {
+	unsigned long long now = nowMs(), wait = HTTP_IDLE_TIMEOUT_MS;
+	struct Request* previous = NULL;
+	struct Request* r;
+	struct Request* next;
+	struct Connection* c;
+	struct Bucket* b;
+
+	takeSubmitted();
+	for(r = waitingHead; r; r = next) {
+		next = r->next;
+		b = findBucket(r, now);
+		if(b->credit < HTTP_RATE_INTERVAL_MS) {
+			if(HTTP_RATE_INTERVAL_MS - b->credit < wait) {
+				wait = HTTP_RATE_INTERVAL_MS - b->credit;
+			}
+			previous = r;
+			continue;
+		}
+		c = findSlot(r);
+		if(!c) {
+			break;
+		}
+		b->credit -= HTTP_RATE_INTERVAL_MS;
+		if(previous) {
+			previous->next = next;
+		} else {
+			waitingHead = next;
+		}
+		if(waitingTail == r) {
+			waitingTail = previous;
+		}
+		r->next = NULL;
+		dispatch(c, r);
+	}
+	return wait;
+}
+
+/* Handles one status, header, chunk size or trailer line */
+static enum HttpError parseLine(struct Connection* c, char* line) {
+	char* end;
+
+	switch(c->parse) {
+	case PARSE_STATUS:
+		if(!startsWith(line, "http/1.") || strlen(line) < 12) {
+			return HTTP_ERROR_PROTOCOL;
+		}
+		c->keepAlive = line[7] != '0';
+		c->status = atoi(line + 9);
+		c->parse = PARSE_HEADERS;
+		return HTTP_OK;
+
+	case PARSE_HEADERS:
+		if(*line) {
+			if(startsWith(line, "content-length:")) {
+				c->contentLength = strtoull(line + 15, NULL, 10);
+				c->hasContentLength = 1;
+			} else if(startsWith(line, "transfer-encoding:")) {
+				c->chunked = strstr(line + 18, "chunked") != NULL;
+			} else if(startsWith(line, "connection:")) {
+				for(end = line + 11; *end == ' '; end++);
+				if(startsWith(end, "close")) {
+					c->keepAlive = 0;
+				} else if(startsWith(end, "keep-alive")) {
+					c->keepAlive = 1;
+				}
+			}
+			if(c->status / 100 != 1 && (end = strchr(line, ':')) != NULL) {
+				*end++ = '\0';
+				for(; *end == ' ' || *end == '\t'; end++);
+				deliverHeader(c->request, line, end);
+			}
+			return HTTP_OK;
+		}
+		/* End of the headers, the framing decides how the body is read */
+		if(c->status / 100 == 1) {
+			c->parse = PARSE_STATUS;  /* Interim response, the real one follows */
+		} else if(c->status == 204 || c->status == 304) {
+			c->parse = PARSE_DONE;
+		} else if(c->chunked) {
+			c->parse = PARSE_CHUNK_SIZE;
+		} else if(c->hasContentLength) {
+			c->remaining = c->contentLength;
+			c->parse = c->remaining ? PARSE_LENGTH_BODY : PARSE_DONE;
+		} else {
+			c->keepAlive = 0;
+			c->parse = PARSE_CLOSE_BODY;
+		}
+		return HTTP_OK;
+
+	case PARSE_CHUNK_SIZE:
+		c->remaining = strtoull(line, &end, 16);
+		if(end == line) {
+			return HTTP_ERROR_PROTOCOL;
+		}
+		c->parse = c->remaining ? PARSE_CHUNK_DATA : PARSE_TRAILERS;
+		return HTTP_OK;
+
+	case PARSE_CHUNK_END:
+		if(*line) {
+			return HTTP_ERROR_PROTOCOL;
+		}
+		c->parse = PARSE_CHUNK_SIZE;
+		return HTTP_OK;
+
+	case PARSE_TRAILERS:
+		if(!*line) {
+			c->parse = PARSE_DONE;
+		}
+		return HTTP_OK;
+
+	default:
+		return HTTP_ERROR_PROTOCOL;
+	}
+}
+
+/* Parses as much of the receive buffer as possible, passing body bytes straight from it to the handler */
+static enum HttpError parseResponse(struct Connection* c) {
+	enum HttpError error = HTTP_OK;
+	size_t pos = 0, available, n;
+	char* data;
+	char* newline;
+
+	while(c->parse != PARSE_DONE && error == HTTP_OK) {
+		data = c->in + pos;
+		available = c->inLength - pos;
+		if(c->parse == PARSE_LENGTH_BODY || c->parse == PARSE_CHUNK_DATA || c->parse == PARSE_CLOSE_BODY) {
+			n = (c->parse == PARSE_CLOSE_BODY || available < c->remaining) ? available : (size_t)c->remaining;
+			if(n == 0) {
+				break;
+			}
+			deliverBody(c->request, data, n);
+			pos += n;
+			if(c->parse != PARSE_CLOSE_BODY && (c->remaining -= n) == 0) {
+				c->parse = c->parse == PARSE_LENGTH_BODY ? PARSE_DONE : PARSE_CHUNK_END;
+			}
+			continue;
+		}
+		newline = (char*)memchr(data, '\n', available);
+		if(!newline) {
+			break;
+		}
+		*newline = '\0';
+		if(newline > data && newline[-1] == '\r') {
+			newline[-1] = '\0';
+		}
+		pos += (size_t)(newline - data) + 1;
+		error = parseLine(c, data);
+	}
+
+	memmove(c->in, c->in + pos, c->inLength - pos);
+	c->inLength -= pos;
+	if(error == HTTP_OK && c->inLength == sizeof(c->in)) {
+		error = HTTP_ERROR_PROTOCOL;  /* A line longer than the buffer */
+	}
+	return error;
+}
+
+/* The server closed the connection or reset it */
+static void connectionClosed(struct Connection* c) {
+	struct Request* request;
+
+	if(c->parse == PARSE_CLOSE_BODY) {
+		c->parse = PARSE_DONE;
+		finishRequest(c, HTTP_OK);
+	} else if(c->reused && !c->receivedAny) {
+		/* The pooled connection timed out on the server side, try once more on a new one */
+		request = c->request;
+		closeConnection(c);
+		dispatch(c, request);
+	} else {
+		finishRequest(c, HTTP_ERROR_CLOSED);
+	}
+}
+
+static void receive(struct Connection* c) {
+	enum HttpError error;
+	int n;
+
+	n = (int)recv(c->sock, c->in + c->inLength, (int)(sizeof(c->in) - c->inLength), 0);
+	if(n < 0 && wouldBlock(socketError())) {
+		return;
+	}
+	if(n <= 0) {
+		connectionClosed(c);
+		return;
+	}
+	c->receivedAny = 1;
+	c->inLength += (size_t)n;
+	error = parseResponse(c);
+	if(error != HTTP_OK) {
+		c->keepAlive = 0;
+		finishRequest(c, error);
+	} else if(c->parse == PARSE_DONE) {
+		finishRequest(c, HTTP_OK);
+	}
+}
+
+static void sendRequest(struct Connection* c) {
+	int n = (int)send(c->sock, c->out + c->outSent, (int)(c->outLength - c->outSent), SEND_FLAGS);
+
+	if(n < 0) {
+		if(!wouldBlock(socketError())) {
+			connectionClosed(c);
+		}
+		return;
+	}
+	c->outSent += (size_t)n;
+	if(c->outSent == c->outLength) {
+		c->state = CONNECTION_RECEIVING;
+	}
+}
+
+static void connected(struct Connection* c) {
+	int error = 0;
+	socklen_t length = sizeof(error);
+
+	if(getsockopt(c->sock, SOL_SOCKET, SO_ERROR, (char*)&error, &length) != 0 || error != 0) {
+		c->keepAlive = 0;
+		finishRequest(c, HTTP_ERROR_CONNECT);
+		return;
+	}
+	c->state = CONNECTION_SENDING;
+	sendRequest(c);
+}
+
+static void engineLoop() {
+	fd_set readSet, writeSet, errorSet;
+	struct timeval timeout;
+	unsigned long long now, next, wait;
+	http_socket maxSocket;
+	char drain[64];
+	unsigned int i;
+
+	for(;;) {
+		wait = startWaiting();
+		if(atomicLoad(&stopping)) {
+			return;
+		}
+
+		FD_ZERO(&readSet);
+		FD_ZERO(&writeSet);
+		FD_ZERO(&errorSet);
+		FD_SET(wakeSocket, &readSet);
+		maxSocket = wakeSocket;
+		now = nowMs();
+		next = now + (wait < 1000 ? wait : 1000);
+		for(i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+			struct Connection* c = &connections[i];
+			if(c->state == CONNECTION_FREE) {
+				continue;
+			}
+			if(c->state == CONNECTION_CONNECTING || c->state == CONNECTION_SENDING) {
+				FD_SET(c->sock, &writeSet);
+				FD_SET(c->sock, &errorSet);  /* Windows reports failed connects here */
+			} else {
+				FD_SET(c->sock, &readSet);  /* Idle connections too, to notice when the server closes them */
+			}
+			if(c->sock > maxSocket) {
+				maxSocket = c->sock;
+			}
+			if(c->deadline < next) {
+				next = c->deadline;
+			}
+		}
+		next = next > now ? next - now : 0;
+		timeout.tv_sec = (long)(next / 1000);
+		timeout.tv_usec = (long)(next % 1000) * 1000;
+		if(select((int)maxSocket + 1, &readSet, &writeSet, &errorSet, &timeout) < 0) {
+#ifndef _WIN32
+			if(errno == EINTR) {
+				continue;
+			}
+#endif
+			printf("PLUGIN: http: select failed\n");
+			return;
+		}
+
+		if(FD_ISSET(wakeSocket, &readSet)) {
+			while(recv(wakeSocket, drain, sizeof(drain), 0) > 0);
+		}
+		now = nowMs();
+		for(i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+			struct Connection* c = &connections[i];
+			switch(c->state) {
+			case CONNECTION_CONNECTING:
+				if(FD_ISSET(c->sock, &writeSet) || FD_ISSET(c->sock, &errorSet)) {
+					connected(c);
+				}
+				break;
+			case CONNECTION_SENDING:
+				if(FD_ISSET(c->sock, &writeSet) || FD_ISSET(c->sock, &errorSet)) {
+					sendRequest(c);
+				}
+				break;
+			case CONNECTION_RECEIVING:
+				if(FD_ISSET(c->sock, &readSet)) {
+					receive(c);
+				}
+				break;
+			case CONNECTION_IDLE:
+				if(FD_ISSET(c->sock, &readSet) || now >= c->deadline) {
+					closeConnection(c);  /* Closed by the server, unexpected data or unused for too long */
+				}
+				continue;
+			default:
+				continue;
+			}
+			if(c->state != CONNECTION_FREE && c->state != CONNECTION_IDLE && now >= c->deadline) {
+				c->keepAlive = 0;
+				finishRequest(c, HTTP_ERROR_TIMEOUT);
+			}
+		}
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI engineMain(LPVOID arg) {
+#else
+static void* engineMain(void* arg) {
+#endif
+	struct Request* r;
+	unsigned int i;
+
+	engineLoop();
+
+	/* Every accepted request gets its onDone */
+	for(i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+		struct Connection* c = &connections[i];
+		if(c->state == CONNECTION_IDLE) {
+			closeConnection(c);
+		} else if(c->state != CONNECTION_FREE) {
+			c->keepAlive = 0;
+			finishRequest(c, HTTP_ERROR_CANCELLED);
+		}
+	}
+	atomicStore(&stopping, 1);  /* Also when the loop ended on an error, http_get must not queue anymore */
+
+	/* A http_get that counted itself before it saw stopping still pushes its request */
+	while(atomicLoad(&outstanding) > 0) {
+		takeSubmitted();
+		while(waitingHead) {
+			r = waitingHead;
+			waitingHead = r->next;
+			deliverDone(r, HTTP_ERROR_CANCELLED, 0);
+		}
+		waitingTail = NULL;
+		yieldThread();
+	}
+	return 0;
+}
+
+static int openWakeSocket() {
+	struct sockaddr_in address;
+	socklen_t length = sizeof(address);
+
+	wakeSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	if(wakeSocket == NO_SOCKET) {
+		return 1;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if(bind(wakeSocket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+	   getsockname(wakeSocket, (struct sockaddr*)&address, &length) != 0 ||
+	   connect(wakeSocket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+	   setNonBlocking(wakeSocket) != 0) {
+		closeSocket(wakeSocket);
+		wakeSocket = NO_SOCKET;
+		return 1;
+	}
+	return 0;
+}
+
+static void wake() {
+	send(wakeSocket, "", 1, 0);
+}
+
+int http_init() {
+	unsigned int i;
+#ifdef _WIN32
+	WSADATA wsaData;
+
+	if(running) {
+		return 0;
+	}
+	if(WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+		return 1;
+	}
+#else
+	if(running) {
+		return 0;
+	}
+#endif
+	if(openWakeSocket() != 0) {
+		printf("PLUGIN: http: cannot create the wake-up socket\n");
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return 1;
+	}
+	for(i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+		connections[i].state = CONNECTION_FREE;
+		connections[i].sock = NO_SOCKET;
+		connections[i].request = NULL;
+	}
+	bucketCount = 0;
+	waitingHead = waitingTail = NULL;
+	submitted = NULL;
+	outstanding = 0;
+	stopping = 0;
+
+#ifdef _WIN32
+	engine = CreateThread(NULL, 0, engineMain, NULL, 0, NULL);
+	if(!engine) {
+#else
+	if(pthread_create(&engine, NULL, engineMain, NULL) != 0) {
+#endif
+		printf("PLUGIN: http: failed to start engine thread\n");
+		closeSocket(wakeSocket);
+		wakeSocket = NO_SOCKET;
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return 1;
+	}
+	running = 1;
+	return 0;
+}
+
+void http_shutdown() {
+	if(!running) {
+		return;
+	}
+	atomicStore(&stopping, 1);
+	wake();
+
+#ifdef _WIN32
+	WaitForSingleObject(engine, INFINITE);
+	CloseHandle(engine);
+	engine = NULL;
+#else
+	pthread_join(engine, NULL);
+#endif
+	closeSocket(wakeSocket);
+	wakeSocket = NO_SOCKET;
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	running = 0;
+}
+
+enum HttpError http_get(const char* url, const struct HttpHandler* handler, void* context) {
+	return http_getWithHeaders(url, NULL, handler, context);
+}
+
+enum HttpError http_getWithHeaders(const char* url, const char* headers, const struct HttpHandler* handler, void* context) {
+	struct Request* request;
+	struct Request* head;
+	enum HttpError error;
+	size_t headersLength = headers ? strlen(headers) : 0;
+
+	if(!running) {
+		return HTTP_ERROR_QUEUE;
+	}
+	if(headersLength >= HTTP_HEADERS_BUFSIZE) {
+		return HTTP_ERROR_URL;
+	}
+	request = (struct Request*)malloc(sizeof(struct Request));
+	if(!request) {
+		return HTTP_ERROR_QUEUE;
+	}
+	error = parseUrl(url, request);
+	if(error != HTTP_OK) {
+		free(request);
+		return error;
+	}
+	memcpy(request->headers, headers ? headers : "", headersLength + 1);
+	request->followers = NULL;
+	request->delivered = 0;
+	request->handler = handler;
+	request->context = context;
+
+	/* Counted before stopping is checked, the engine only exits once the count is back at 0 */
+	if(atomicIncrement(&outstanding) > HTTP_QUEUE_SIZE || atomicLoad(&stopping)) {
+		atomicDecrement(&outstanding);
+		free(request);
+		return HTTP_ERROR_QUEUE;
+	}
+	do {
+		head = (struct Request*)loadPointer(&submitted);
+		request->next = head;
+	} while(!compareExchangePointer(&submitted, head, request));
+	wake();
+	return HTTP_OK;
+}
+
+const char* http_errorText(enum HttpError error) {
+	switch(error) {
+	case HTTP_OK:              return "ok";
+	case HTTP_ERROR_URL:       return "unsupported URL, only http:// is fetched";
+	case HTTP_ERROR_QUEUE:     return "too many requests";
+	case HTTP_ERROR_RESOLVE:   return "host not found";
+	case HTTP_ERROR_CONNECT:   return "cannot connect";
+	case HTTP_ERROR_TIMEOUT:   return "timed out";
+	case HTTP_ERROR_PROTOCOL:  return "malformed response";
+	case HTTP_ERROR_CLOSED:    return "connection closed";
+	case HTTP_ERROR_CANCELLED: return "cancelled";
+	default:                   return "unknown error";
+	}
+}
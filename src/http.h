@@ -0,0 +1,82 @@
+/*
+ * Search By - asynchronous HTTP client
+ *
+ * Plain HTTP/1.1 GET requests run by one engine thread over non-blocking
+ * sockets. Idle connections are kept per host and reused by later requests to
+ * the same host. Every request has a deadline covering connect, send and
+ * receive. There is no TLS, so only http:// URLs are accepted.
+ *
+ * Requests to a host are paced by a token bucket: HTTP_RATE_BURST at once,
+ * then one per HTTP_RATE_INTERVAL_MS, the rest wait in submit order. A request
+ * for a URL that is already waiting or running, and has not received body
+ * bytes yet, shares that response instead of fetching it again, as long as
+ * the extra request headers are the same too. Submitting
+ * never blocks, http_get pushes onto a lock-free stack the engine drains.
+ *
+ * The handler functions are called on the engine thread. onDone is called
+ * exactly once for every accepted request, also when the client shuts down, so
+ * the context can be freed there.
+ */
+
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTP_MAX_CONNECTIONS 16
+#define HTTP_MAX_IDLE_PER_HOST 2
+#define HTTP_QUEUE_SIZE 64  /* Accepted requests not done yet, running ones included */
+#define HTTP_HOST_BUFSIZE 256
+#define HTTP_PATH_BUFSIZE 1024
+#define HTTP_HEADERS_BUFSIZE 512  /* Extra request header lines */
+#define HTTP_BUFSIZE 16384  /* Longest status or header line */
+#define HTTP_TIMEOUT_MS 10000
+#define HTTP_IDLE_TIMEOUT_MS 30000
+#define HTTP_RATE_BURST 4
+#define HTTP_RATE_INTERVAL_MS 1000
+#define HTTP_MAX_BUCKETS 32  /* Hosts with a token bucket, the longest unused one is reused */
+
+enum HttpError {
+	HTTP_OK = 0,
+	HTTP_ERROR_URL,        /* Not an http:// URL, or the URL or headers are too long */
+	HTTP_ERROR_QUEUE,      /* Not started, stopping or too many requests queued */
+	HTTP_ERROR_RESOLVE,
+	HTTP_ERROR_CONNECT,
+	HTTP_ERROR_TIMEOUT,
+	HTTP_ERROR_PROTOCOL,   /* Malformed response */
+	HTTP_ERROR_CLOSED,     /* The connection closed before the response was complete */
+	HTTP_ERROR_CANCELLED   /* The client shut down first */
+};
+
+struct HttpHandler {
+	void (*onBody)(void* context, const char* data, size_t length);  /* Body bytes as they arrive, chunked encoding removed */
+	void (*onDone)(void* context, enum HttpError error, int status);
+	void (*onHeader)(void* context, const char* name, const char* value);  /* Optional, every response header before the body */
+};
+
+int http_init();
+
+/* Cancels everything still running and waits for the engine thread */
+void http_shutdown();
+
+/*
+ * Queues a GET request without waiting for a lock, safe from any thread.
+ * Returns HTTP_OK if it was accepted, in which case the handler gets the
+ * response, or an error and the handler is never called.
+ */
+enum HttpError http_get(const char* url, const struct HttpHandler* handler, void* context);
+
+/* Like http_get, with extra header lines, each ending in \r\n, or NULL */
+enum HttpError http_getWithHeaders(const char* url, const char* headers, const struct HttpHandler* handler, void* context);
+
+const char* http_errorText(enum HttpError error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
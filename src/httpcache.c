@@ -0,0 +1,644 @@
+/*
+ * Search By - on-disk HTTP response cache
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "httpcache.h"
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION cache_mutex;
+#define mutexInit(m)           InitializeCriticalSection(m)
+#define mutexDestroy(m)        DeleteCriticalSection(m)
+#define mutexLock(m)           EnterCriticalSection(m)
+#define mutexUnlock(m)         LeaveCriticalSection(m)
+#define PATH_SEPARATOR         "\\"
+#define makeDirectory(p)       (CreateDirectoryA(p, NULL) || GetLastError() == ERROR_ALREADY_EXISTS)
+#define replaceFile(from, to)  MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING)
+#define syncFile(f)            _commit(_fileno(f))
+#else
+typedef pthread_mutex_t cache_mutex;
+#define mutexInit(m)           pthread_mutex_init(m, NULL)
+#define mutexDestroy(m)        pthread_mutex_destroy(m)
+#define mutexLock(m)           pthread_mutex_lock(m)
+#define mutexUnlock(m)         pthread_mutex_unlock(m)
+#define PATH_SEPARATOR         "/"
+#define makeDirectory(p)       (mkdir(p, 0700) == 0 || errno == EEXIST)
+#define replaceFile(from, to)  (rename(from, to) == 0)
+#define syncFile(f)            fsync(fileno(f))
+#endif
+
+#define FILE_MAGIC "SearchBy-Cache 1"
+#define ENTRY_SUFFIX ".cache"
+#define TEMP_SUFFIX ".tmp"
+#define KEY_DIGITS 16
+#define DIRECTORY_BUFSIZE (HTTPCACHE_PATH_BUFSIZE - 64)  /* Leaves room for the file names */
+#define LINE_BUFSIZE (HTTPCACHE_URL_BUFSIZE + 16)
+#define REPLAY_BUFSIZE 16384
+#define CONDITION_BUFSIZE (2 * HTTPCACHE_VALIDATOR_BUFSIZE + 64)
+
+struct CacheEntry {
+	unsigned long long key;
+	unsigned long long size;  /* Of the file, counted against the budget */
+	long long expires;        /* time(), after which the entry is revalidated */
+	unsigned long long used;  /* From useClock, larger is more recent */
+	char etag[HTTPCACHE_VALIDATOR_BUFSIZE];
+	char modified[HTTPCACHE_VALIDATOR_BUFSIZE];
+};
+
+/* One fetch through the cache, owned by the HTTP engine thread until cacheDone frees it */
+struct CacheFetch {
+	const struct HttpHandler* handler;
+	void* context;
+	unsigned long long key;
+	char url[HTTPCACHE_URL_BUFSIZE];  /* Normalized */
+	int revalidating;
+	long long maxAge;  /* -1 if the response does not say */
+	int noStore;
+	char etag[HTTPCACHE_VALIDATOR_BUFSIZE];
+	char modified[HTTPCACHE_VALIDATOR_BUFSIZE];
+	long long expires;
+	FILE* file;  /* The temporary file the body goes to, from the first body bytes on */
+	int failed;  /* Writing it failed, the response is passed on but not stored */
+	unsigned long long size;
+	char tempPath[HTTPCACHE_PATH_BUFSIZE];
+};
+
+/* Guarded by mutex */
+static struct CacheEntry entries[HTTPCACHE_MAX_ENTRIES];
+static unsigned int entryCount = 0;
+static unsigned long long totalSize = 0;
+static unsigned long long useClock = 0;
+static unsigned int tempCounter = 0;
+
+static unsigned long long budget = 0;
+static char directory[DIRECTORY_BUFSIZE];
+static cache_mutex mutex;
+static int opened = 0;
+
+static int equalsIgnoreCase(const char* a, const char* b, size_t length) {
+	size_t i;
+
+	for(i = 0; i < length; i++) {
+		char x = a[i], y = b[i];
+		if(x >= 'A' && x <= 'Z') x = (char)(x + ('a' - 'A'));
+		if(y >= 'A' && y <= 'Z') y = (char)(y + ('a' - 'A'));
+		if(x != y) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Normalizes an http:// URL: lowercase scheme and host, no default port, no
+ * fragment and a path of at least "/". Returns 0 on success, 1 if the URL is
+ * not one the HTTP client fetches.
+ */
+static int normalizeUrl(const char* url, char* out) {
+	const char* host;
+	const char* rest;
+	size_t hostLength, portLength = 0, restLength, i;
+	char* p = out;
+
+	if(strlen(url) < 7 || !equalsIgnoreCase(url, "http://", 7)) {
+		return 1;
+	}
+	host = url + 7;
+	hostLength = strcspn(host, ":/?#");
+	rest = host + hostLength;
+	if(*rest == ':') {
+		portLength = strcspn(rest + 1, "/?#");
+		if(portLength == 2 && strncmp(rest + 1, "80", 2) == 0) {
+			portLength = 0;
+		} else {
+			portLength++;  /* Keeps the colon */
+		}
+		rest += strcspn(rest, "/?#");
+	}
+	restLength = strcspn(rest, "#");
+	if(hostLength == 0 || hostLength + portLength + restLength + 9 > HTTPCACHE_URL_BUFSIZE) {
+		return 1;
+	}
+
+	memcpy(p, "http://", 7);
+	p += 7;
+	for(i = 0; i < hostLength; i++) {
+		char c = host[i];
+		*p++ = (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+	}
+	memcpy(p, host + hostLength, portLength);
+	p += portLength;
+	if(*rest != '/') {
+		*p++ = '/';
+	}
+	memcpy(p, rest, restLength);
+	p[restLength] = '\0';
+	return 0;
+}
+
+/* FNV-1a, the file name of an entry */
+static unsigned long long hashUrl(const char* url) {
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for(; *url; url++) {
+		hash ^= (unsigned char)*url;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static void entryPath(unsigned long long key, char* path) {
+	snprintf(path, HTTPCACHE_PATH_BUFSIZE, "%s%016llx" ENTRY_SUFFIX, directory, key);
+}
+
+static struct CacheEntry* findEntry(unsigned long long key) {
+	unsigned int i;
+
+	for(i = 0; i < entryCount; i++) {
+		if(entries[i].key == key) {
+			return &entries[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Deletes the file of an entry and forgets the entry. Returns 0 on success, 1
+ * if the file could not be deleted, then the entry stays so its bytes are still
+ * counted and a later eviction tries again.
+ */
+static int removeEntry(struct CacheEntry* entry) {
+	char path[HTTPCACHE_PATH_BUFSIZE];
+
+	entryPath(entry->key, path);
+	if(remove(path) != 0 && errno != ENOENT) {
+		return 1;
+	}
+	totalSize -= entry->size;
+	*entry = entries[--entryCount];
+	return 0;
+}
+
+static struct CacheEntry* leastRecentlyUsed() {
+	struct CacheEntry* oldest = NULL;
+	unsigned int i;
+
+	for(i = 0; i < entryCount; i++) {
+		if(!oldest || entries[i].used < oldest->used) {
+			oldest = &entries[i];
+		}
+	}
+	return oldest;
+}
+
+/*
+ * Deletes the least recently used entries until the files fit into the budget.
+ * Stops at a file that cannot be deleted, like one another process has open on
+ * Windows, instead of retrying it forever; the next store evicts again.
+ */
+static void evict() {
+	while(entryCount > 0 && totalSize > budget) {
+		if(removeEntry(leastRecentlyUsed()) != 0) {
+			break;
+		}
+	}
+}
+
+/* Reads a header line without its line break into line. Returns 0 on success, 1 at the end of the file. */
+static int readLine(FILE* file, char* line) {
+	size_t length;
+
+	if(!fgets(line, LINE_BUFSIZE, file)) {
+		return 1;
+	}
+	length = strlen(line);
+	if(length == 0 || line[length - 1] != '\n') {
+		return 1;  /* Too long or cut off */
+	}
+	line[length - 1] = '\0';
+	return 0;
+}
+
+/*
+ * Reads the header of an entry file, leaving the file at the body. Unknown
+ * lines are skipped. Returns 0 on success, 1 if it is not an entry file.
+ */
+static int readHeader(FILE* file, char* url, long long* stored, long long* expires, char* etag, char* modified) {
+	char line[LINE_BUFSIZE];
+
+	if(readLine(file, line) != 0 || strcmp(line, FILE_MAGIC) != 0) {
+		return 1;
+	}
+	url[0] = etag[0] = modified[0] = '\0';
+	*stored = *expires = 0;
+	for(;;) {
+		if(readLine(file, line) != 0) {
+			return 1;
+		}
+		if(line[0] == '\0') {
+			return url[0] == '\0';
+		}
+		if(strncmp(line, "url ", 4) == 0 && strlen(line + 4) < HTTPCACHE_URL_BUFSIZE) {
+			strcpy(url, line + 4);
+		} else if(strncmp(line, "stored ", 7) == 0) {
+			*stored = strtoll(line + 7, NULL, 10);
+		} else if(strncmp(line, "expires ", 8) == 0) {
+			*expires = strtoll(line + 8, NULL, 10);
+		} else if(strncmp(line, "etag ", 5) == 0 && strlen(line + 5) < HTTPCACHE_VALIDATOR_BUFSIZE) {
+			strcpy(etag, line + 5);
+		} else if(strncmp(line, "modified ", 9) == 0 && strlen(line + 9) < HTTPCACHE_VALIDATOR_BUFSIZE) {
+			strcpy(modified, line + 9);
+		}
+	}
+}
+
+/* Indexes one file found in the cache directory, deleting leftovers of interrupted writes and broken entries */
+static void loadFile(const char* name) {
+	char path[HTTPCACHE_PATH_BUFSIZE];
+	char url[HTTPCACHE_URL_BUFSIZE];
+	struct CacheEntry* entry;
+	long long stored, expires;
+	size_t length = strlen(name);
+	FILE* file;
+	int valid;
+
+	if(length > sizeof(TEMP_SUFFIX) - 1 && strcmp(name + length - (sizeof(TEMP_SUFFIX) - 1), TEMP_SUFFIX) == 0) {
+		snprintf(path, HTTPCACHE_PATH_BUFSIZE, "%s%s", directory, name);
+		remove(path);
+		return;
+	}
+	if(length != KEY_DIGITS + sizeof(ENTRY_SUFFIX) - 1 || strcmp(name + KEY_DIGITS, ENTRY_SUFFIX) != 0 ||
+	   strspn(name, "0123456789abcdef") != KEY_DIGITS) {
+		return;
+	}
+
+	snprintf(path, HTTPCACHE_PATH_BUFSIZE, "%s%s", directory, name);
+	file = fopen(path, "rb");
+	if(!file) {
+		return;
+	}
+	entry = &entries[entryCount];
+	valid = entryCount < HTTPCACHE_MAX_ENTRIES &&
+	        readHeader(file, url, &stored, &expires, entry->etag, entry->modified) == 0 &&
+	        hashUrl(url) == strtoull(name, NULL, 16) &&
+	        fseek(file, 0, SEEK_END) == 0;
+	if(valid) {
+		entry->key = hashUrl(url);
+		entry->size = (unsigned long long)ftell(file);
+		entry->expires = expires;
+		entry->used = stored > 0 ? (unsigned long long)stored : 0;  /* Orders by age until useClock takes over */
+		totalSize += entry->size;
+		entryCount++;
+	}
+	fclose(file);
+	if(!valid) {
+		remove(path);
+	}
+}
+
+static void loadDirectory() {
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	char pattern[HTTPCACHE_PATH_BUFSIZE];
+	HANDLE find;
+
+	snprintf(pattern, HTTPCACHE_PATH_BUFSIZE, "%s*", directory);
+	find = FindFirstFileA(pattern, &found);
+	if(find == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	do {
+		if(!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			loadFile(found.cFileName);
+		}
+	} while(FindNextFileA(find, &found));
+	FindClose(find);
+#else
+	struct dirent* found;
+	DIR* dir = opendir(directory);
+
+	if(!dir) {
+		return;
+	}
+	while((found = readdir(dir)) != NULL) {
+		loadFile(found->d_name);
+	}
+	closedir(dir);
+#endif
+}
+
+int httpcache_open(const char* parent, unsigned long long budgetBytes) {
+	unsigned int i;
+
+	if(opened) {
+		return 0;
+	}
+	if(strlen(parent) + sizeof(HTTPCACHE_DIRECTORY) + sizeof(PATH_SEPARATOR) > DIRECTORY_BUFSIZE) {
+		return 1;
+	}
+	snprintf(directory, DIRECTORY_BUFSIZE, "%s%s", parent, HTTPCACHE_DIRECTORY);
+	if(!makeDirectory(directory)) {
+		return 1;
+	}
+	strcat(directory, PATH_SEPARATOR);
+
+	budget = budgetBytes;
+	entryCount = 0;
+	totalSize = 0;
+	loadDirectory();
+
+	/* Continue the use clock after the stored times so new uses are more recent than every loaded entry */
+	useClock = 0;
+	for(i = 0; i < entryCount; i++) {
+		if(entries[i].used > useClock) {
+			useClock = entries[i].used;
+		}
+	}
+	evict();
+	mutexInit(&mutex);
+	opened = 1;
+	return 0;
+}
+
+void httpcache_close() {
+	if(!opened) {
+		return;
+	}
+	mutexDestroy(&mutex);
+	entryCount = 0;
+	totalSize = 0;
+	opened = 0;
+}
+
+/*
+ * Passes a stored entry to a handler as if it had been fetched. Returns 0 if it
+ * was replayed, 1 if there is no such entry and the handler was not called.
+ */
+static int replay(unsigned long long key, const char* url, const struct HttpHandler* handler, void* context) {
+	char path[HTTPCACHE_PATH_BUFSIZE];
+	char storedUrl[HTTPCACHE_URL_BUFSIZE];
+	char etag[HTTPCACHE_VALIDATOR_BUFSIZE];
+	char modified[HTTPCACHE_VALIDATOR_BUFSIZE];
+	char buffer[REPLAY_BUFSIZE];
+	long long stored, expires;
+	size_t n;
+	FILE* file;
+	int failed;
+
+	entryPath(key, path);
+	file = fopen(path, "rb");
+	if(!file) {
+		return 1;
+	}
+	if(readHeader(file, storedUrl, &stored, &expires, etag, modified) != 0 || strcmp(storedUrl, url) != 0) {
+		fclose(file);
+		return 1;
+	}
+	while((n = fread(buffer, 1, REPLAY_BUFSIZE, file)) > 0) {
+		handler->onBody(context, buffer, n);
+	}
+	failed = ferror(file);
+	fclose(file);
+	handler->onDone(context, failed ? HTTP_ERROR_CLOSED : HTTP_OK, 200);
+	return 0;
+}
+
+/* Skips to the next comma separated Cache-Control directive */
+static const char* nextDirective(const char* p) {
+	p += strcspn(p, ",");
+	for(; *p == ',' || *p == ' ' || *p == '\t'; p++);
+	return p;
+}
+
+static void cacheHeader(void* context, const char* name, const char* value) {
+	struct CacheFetch* fetch = (struct CacheFetch*)context;
+	size_t nameLength = strlen(name);
+	const char* p;
+
+	if(nameLength == 4 && equalsIgnoreCase(name, "etag", 4)) {
+		if(strlen(value) < HTTPCACHE_VALIDATOR_BUFSIZE) {
+			strcpy(fetch->etag, value);
+		}
+	} else if(nameLength == 13 && equalsIgnoreCase(name, "last-modified", 13)) {
+		if(strlen(value) < HTTPCACHE_VALIDATOR_BUFSIZE) {
+			strcpy(fetch->modified, value);
+		}
+	} else if(nameLength == 13 && equalsIgnoreCase(name, "cache-control", 13)) {
+		for(p = value; *p; p = nextDirective(p)) {
+			if(equalsIgnoreCase(p, "no-store", 8) && strlen(p) >= 8) {
+				fetch->noStore = 1;
+			} else if(equalsIgnoreCase(p, "no-cache", 8) && strlen(p) >= 8) {
+				fetch->maxAge = 0;
+			} else if(equalsIgnoreCase(p, "max-age=", 8) && strlen(p) >= 8 && fetch->maxAge != 0) {
+				fetch->maxAge = strtoll(p + 8, NULL, 10);
+			}
+		}
+	}
+	if(fetch->handler->onHeader) {
+		fetch->handler->onHeader(fetch->context, name, value);
+	}
+}
+
+/* Opens the temporary file and writes the entry header. The response headers are all in by the first body bytes. */
+static int openTemp(struct CacheFetch* fetch) {
+	unsigned int counter;
+	long long now = (long long)time(NULL);
+
+	mutexLock(&mutex);
+	counter = tempCounter++;  /* Identical fetches with different validators may be written at the same time */
+	mutexUnlock(&mutex);
+	snprintf(fetch->tempPath, HTTPCACHE_PATH_BUFSIZE, "%s%016llx.%u" TEMP_SUFFIX, directory, fetch->key, counter);
+	fetch->file = fopen(fetch->tempPath, "wb");
+	if(!fetch->file) {
+		return 1;
+	}
+	fetch->expires = now + (fetch->maxAge >= 0 ? fetch->maxAge : HTTPCACHE_DEFAULT_TTL);
+	fprintf(fetch->file, FILE_MAGIC "\nurl %s\nstored %lld\nexpires %lld\n", fetch->url, now, fetch->expires);
+	if(fetch->etag[0]) {
+		fprintf(fetch->file, "etag %s\n", fetch->etag);
+	}
+	if(fetch->modified[0]) {
+		fprintf(fetch->file, "modified %s\n", fetch->modified);
+	}
+	fputc('\n', fetch->file);
+	return ferror(fetch->file) ? 1 : 0;
+}
+
+static void cacheBody(void* context, const char* data, size_t length) {
+	struct CacheFetch* fetch = (struct CacheFetch*)context;
+
+	fetch->handler->onBody(fetch->context, data, length);
+	if(fetch->noStore || fetch->failed) {
+		return;
+	}
+	if(!fetch->file && openTemp(fetch) != 0) {
+		fetch->failed = 1;
+		return;
+	}
+	if(fwrite(data, 1, length, fetch->file) != length) {
+		fetch->failed = 1;
+	}
+}
+
+/* Moves a complete temporary file into place and indexes it */
+static void commit(struct CacheFetch* fetch) {
+	char path[HTTPCACHE_PATH_BUFSIZE];
+	struct CacheEntry* entry;
+	unsigned long long size;
+
+	if(fflush(fetch->file) != 0 || syncFile(fetch->file) != 0) {
+		fclose(fetch->file);
+		remove(fetch->tempPath);
+		return;
+	}
+	size = (unsigned long long)ftell(fetch->file);
+	fclose(fetch->file);
+
+	mutexLock(&mutex);
+	entry = findEntry(fetch->key);
+	/* A full table needs a free slot before the file goes into place, or the file would be stored but not indexed */
+	if(!entry && entryCount == HTTPCACHE_MAX_ENTRIES && removeEntry(leastRecentlyUsed()) != 0) {
+		mutexUnlock(&mutex);
+		remove(fetch->tempPath);
+		return;
+	}
+	entryPath(fetch->key, path);
+	if(!replaceFile(fetch->tempPath, path)) {
+		mutexUnlock(&mutex);
+		remove(fetch->tempPath);
+		return;
+	}
+	if(!entry) {
+		entry = &entries[entryCount++];
+		entry->key = fetch->key;
+		entry->size = 0;
+	}
+	totalSize += size - entry->size;
+	entry->size = size;
+	entry->expires = fetch->expires;
+	entry->used = ++useClock;
+	strcpy(entry->etag, fetch->etag);
+	strcpy(entry->modified, fetch->modified);
+	evict();
+	mutexUnlock(&mutex);
+}
+
+static void cacheDone(void* context, enum HttpError error, int status);
+
+static const struct HttpHandler cacheHandler = { cacheBody, cacheDone, cacheHeader };
+
+static void cacheDone(void* context, enum HttpError error, int status) {
+	struct CacheFetch* fetch = (struct CacheFetch*)context;
+	struct CacheEntry* entry;
+
+	if(error == HTTP_OK && status == 304 && fetch->revalidating) {
+		/* Still current, it is fresh for as long as the 304 says */
+		mutexLock(&mutex);
+		entry = findEntry(fetch->key);
+		if(entry) {
+			entry->expires = (long long)time(NULL) + (fetch->maxAge >= 0 ? fetch->maxAge : HTTPCACHE_DEFAULT_TTL);
+		}
+		mutexUnlock(&mutex);
+		if(replay(fetch->key, fetch->url, fetch->handler, fetch->context) == 0) {
+			free(fetch);
+			return;
+		}
+
+		/*
+		 * The file went missing or is damaged, so there is nothing the 304 could
+		 * refer to. Drop the entry and fetch the full response without the
+		 * validators instead of passing the bodiless 304 on.
+		 */
+		mutexLock(&mutex);
+		entry = findEntry(fetch->key);
+		if(entry) {
+			removeEntry(entry);
+		}
+		mutexUnlock(&mutex);
+		fetch->revalidating = 0;
+		fetch->maxAge = -1;
+		fetch->noStore = 0;
+		fetch->etag[0] = '\0';
+		fetch->modified[0] = '\0';
+		error = http_get(fetch->url, &cacheHandler, fetch);
+		if(error == HTTP_OK) {
+			return;
+		}
+		status = 0;
+	}
+	if(fetch->file) {
+		if(error == HTTP_OK && status == 200 && !fetch->failed) {
+			commit(fetch);
+		} else {
+			fclose(fetch->file);
+			remove(fetch->tempPath);
+		}
+	}
+	fetch->handler->onDone(fetch->context, error, status);
+	free(fetch);
+}
+
+enum HttpError httpcache_get(const char* url, const struct HttpHandler* handler, void* context) {
+	char normalized[HTTPCACHE_URL_BUFSIZE];
+	char condition[CONDITION_BUFSIZE];
+	struct CacheFetch* fetch;
+	struct CacheEntry* entry;
+	unsigned long long key;
+	enum HttpError error;
+	int fresh = 0;
+
+	if(!opened || normalizeUrl(url, normalized) != 0) {
+		return http_get(url, handler, context);
+	}
+	key = hashUrl(normalized);
+	condition[0] = '\0';
+
+	mutexLock(&mutex);
+	entry = findEntry(key);
+	if(entry) {
+		entry->used = ++useClock;
+		fresh = (long long)time(NULL) < entry->expires;
+		if(!fresh && entry->etag[0]) {
+			snprintf(condition, CONDITION_BUFSIZE, "If-None-Match: %s\r\n", entry->etag);
+		}
+		if(!fresh && entry->modified[0]) {
+			snprintf(condition + strlen(condition), CONDITION_BUFSIZE - strlen(condition), "If-Modified-Since: %s\r\n", entry->modified);
+		}
+	}
+	mutexUnlock(&mutex);
+
+	if(fresh && replay(key, normalized, handler, context) == 0) {
+		return HTTP_OK;
+	}
+
+	fetch = (struct CacheFetch*)malloc(sizeof(struct CacheFetch));
+	if(!fetch) {
+		return HTTP_ERROR_QUEUE;
+	}
+	memset(fetch, 0, sizeof(*fetch));
+	fetch->handler = handler;
+	fetch->context = context;
+	fetch->key = key;
+	strcpy(fetch->url, normalized);
+	fetch->revalidating = condition[0] != '\0';
+	fetch->maxAge = -1;
+	error = http_getWithHeaders(url, condition, &cacheHandler, fetch);
+	if(error != HTTP_OK) {
+		free(fetch);
+	}
+	return error;
+}
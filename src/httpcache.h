@@ -0,0 +1,57 @@
+/*
+ * Search By - on-disk HTTP response cache
+ *
+ * Successful responses fetched through httpcache_get are kept as files in a
+ * directory under the config directory, named after a hash of the normalized
+ * URL. A fresh entry is replayed straight from its file on the calling thread
+ * without any network I/O. A stale entry with an ETag or Last-Modified date is
+ * revalidated with a conditional request and replayed from disk on a 304. If
+ * the file is gone by then, the entry is dropped and the URL fetched again
+ * without the validators.
+ *
+ * Freshness comes from Cache-Control max-age, no-cache and no-store, or
+ * HTTPCACHE_DEFAULT_TTL without them. Entries are written to a temporary file
+ * and renamed into place once complete, so a crash leaves either the old entry
+ * or none. When the files exceed the byte budget, the least recently used ones
+ * are deleted; an entry is only forgotten once its file is. Recency and revalidated expiry times are kept in memory only;
+ * after a restart entries start out ordered by when they were stored.
+ *
+ * Safe to call from any thread.
+ */
+
+#ifndef HTTPCACHE_H
+#define HTTPCACHE_H
+
+#include "http.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTPCACHE_DIRECTORY "search_by_cache"
+#define HTTPCACHE_MAX_ENTRIES 1024
+#define HTTPCACHE_DEFAULT_TTL 600  /* Seconds, if the response does not say */
+#define HTTPCACHE_VALIDATOR_BUFSIZE 128
+#define HTTPCACHE_PATH_BUFSIZE 512
+#define HTTPCACHE_URL_BUFSIZE (HTTP_HOST_BUFSIZE + HTTP_PATH_BUFSIZE + 16)
+
+/*
+ * Opens the cache directory in parent, creating it if needed, and indexes the
+ * entries already there. Returns 0 on success, 1 if the cache is unavailable,
+ * in which case httpcache_get always fetches.
+ */
+int httpcache_open(const char* parent, unsigned long long budget);
+
+void httpcache_close();
+
+/*
+ * Gets a URL through the cache. Works like http_get, except that a fresh
+ * entry calls the handler before httpcache_get returns, on the calling thread.
+ */
+enum HttpError httpcache_get(const char* url, const struct HttpHandler* handler, void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
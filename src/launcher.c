@@ -0,0 +1,190 @@
+/*
+ * Search By - background URL launcher
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "launcher.h"
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION launcher_mutex;
+typedef CONDITION_VARIABLE launcher_cond;
+#define mutexInit(m)     InitializeCriticalSection(m)
+#define mutexDestroy(m)  DeleteCriticalSection(m)
+#define mutexLock(m)     EnterCriticalSection(m)
+#define mutexUnlock(m)   LeaveCriticalSection(m)
+#define condInit(c)      InitializeConditionVariable(c)
+#define condDestroy(c)
+#define condWait(c, m)   SleepConditionVariableCS(c, m, INFINITE)
+#define condSignal(c)    WakeConditionVariable(c)
+#else
+typedef pthread_mutex_t launcher_mutex;
+typedef pthread_cond_t launcher_cond;
+#define mutexInit(m)     pthread_mutex_init(m, NULL)
+#define mutexDestroy(m)  pthread_mutex_destroy(m)
+#define mutexLock(m)     pthread_mutex_lock(m)
+#define mutexUnlock(m)   pthread_mutex_unlock(m)
+#define condInit(c)      pthread_cond_init(c, NULL)
+#define condDestroy(c)   pthread_cond_destroy(c)
+#define condWait(c, m)   pthread_cond_wait(c, m)
+#define condSignal(c)    pthread_cond_signal(c)
+#endif
+
+/* Bounded ring buffer of pending URLs, guarded by queueMutex */
+static char queue[LAUNCHER_QUEUE_SIZE][LAUNCHER_URL_BUFSIZE];
+static unsigned int queueHead = 0;  /* Next slot to pop */
+static unsigned int queueCount = 0;
+
+static launcher_mutex queueMutex;
+static launcher_cond queueCond;
+static int running = 0;
+static int stopping = 0;
+
+#ifdef _WIN32
+static HANDLE worker = NULL;
+#else
+static pthread_t worker;
+#endif
+
+#if !defined(_WIN32) && !defined(URL_OPENER)  /* The benchmarks build it with a stub opener */
+#ifdef __APPLE__
+#define URL_OPENER "open"
+#else
+#define URL_OPENER "xdg-open"
+#endif
+#endif
+
+/*
+ * Hands the URL straight to the desktop's URL handler. No shell is involved, so
+ * the URL needs no quoting or escaping of shell metacharacters like '&'.
+ */
+static void openUrl(const char* url) {
+#ifdef _WIN32
+	if((INT_PTR)ShellExecuteA(NULL, "open", url, NULL, NULL, SW_SHOWNORMAL) <= 32) {
+		printf("PLUGIN: launcher: failed to open %s\n", url);
+	}
+#else
+	char* argv[3];
+	pid_t pid;
+	int status;
+
+	argv[0] = URL_OPENER;
+	argv[1] = (char*)url;
+	argv[2] = NULL;
+	if(posix_spawnp(&pid, URL_OPENER, NULL, NULL, argv, environ) != 0) {
+		printf("PLUGIN: launcher: failed to spawn " URL_OPENER " for %s\n", url);
+		return;
+	}
+	waitpid(pid, &status, 0);  /* The opener hands off to the browser and exits right away */
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI workerMain(LPVOID arg) {
+#else
+static void* workerMain(void* arg) {
+#endif
+	char url[LAUNCHER_URL_BUFSIZE];
+
+#ifdef _WIN32
+	CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);  /* Required by ShellExecute */
+#endif
+	for(;;) {
+		mutexLock(&queueMutex);
+		while(queueCount == 0 && !stopping) {
+			condWait(&queueCond, &queueMutex);
+		}
+		if(queueCount == 0) {  /* Stopping and fully drained */
+			mutexUnlock(&queueMutex);
+			break;
+		}
+		memcpy(url, queue[queueHead], LAUNCHER_URL_BUFSIZE);
+		queueHead = (queueHead + 1) % LAUNCHER_QUEUE_SIZE;
+		queueCount--;
+		mutexUnlock(&queueMutex);
+
+		openUrl(url);
+	}
+#ifdef _WIN32
+	CoUninitialize();
+#endif
+	return 0;
+}
+
+int launcher_init() {
+	if(running) {
+		return 0;
+	}
+	queueHead = 0;
+	queueCount = 0;
+	stopping = 0;
+	mutexInit(&queueMutex);
+	condInit(&queueCond);
+
+#ifdef _WIN32
+	worker = CreateThread(NULL, 0, workerMain, NULL, 0, NULL);
+	if(!worker) {
+#else
+	if(pthread_create(&worker, NULL, workerMain, NULL) != 0) {
+#endif
+		printf("PLUGIN: launcher: failed to start worker thread\n");
+		condDestroy(&queueCond);
+		mutexDestroy(&queueMutex);
+		return 1;
+	}
+	running = 1;
+	return 0;
+}
+
+void launcher_shutdown() {
+	if(!running) {
+		return;
+	}
+	mutexLock(&queueMutex);
+	stopping = 1;
+	condSignal(&queueCond);
+	mutexUnlock(&queueMutex);
+
+#ifdef _WIN32
+	WaitForSingleObject(worker, INFINITE);
+	CloseHandle(worker);
+	worker = NULL;
+#else
+	pthread_join(worker, NULL);
+#endif
+	condDestroy(&queueCond);
+	mutexDestroy(&queueMutex);
+	running = 0;
+}
+
+int launcher_open(const char* url) {
+	size_t len = strlen(url);
+	unsigned int tail;
+
+	if(!running || len >= LAUNCHER_URL_BUFSIZE) {
+		return 1;
+	}
+
+	mutexLock(&queueMutex);
+	if(stopping || queueCount == LAUNCHER_QUEUE_SIZE) {
+		mutexUnlock(&queueMutex);
+		printf("PLUGIN: launcher: queue full, dropping %s\n", url);
+		return 1;
+	}
+	tail = (queueHead + queueCount) % LAUNCHER_QUEUE_SIZE;
+	memcpy(queue[tail], url, len + 1);
+	queueCount++;
+	condSignal(&queueCond);
+	mutexUnlock(&queueMutex);
+	return 0;
+}
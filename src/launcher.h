@@ -0,0 +1,36 @@
+/*
+ * Search By - background URL launcher
+ *
+ * Menu callbacks run on the TeamSpeak client thread. Spawning a browser from
+ * there stalls the UI, so the callbacks only enqueue the URL and a worker
+ * thread hands it to the platform URL handler (ShellExecute on Windows,
+ * xdg-open/open elsewhere) without going through a shell.
+ */
+
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LAUNCHER_QUEUE_SIZE 32
+#define LAUNCHER_URL_BUFSIZE 1024
+
+/* Starts the worker thread. Returns 0 on success, 1 on failure. */
+int launcher_init();
+
+/* Opens all queued URLs, then stops and joins the worker thread */
+void launcher_shutdown();
+
+/*
+ * Queues a URL for the worker thread and returns immediately.
+ * Returns 0 on success, 1 if the launcher is not running or the queue is full.
+ */
+int launcher_open(const char* url);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,448 @@
+/*
+ * Search By - fuzzy nickname index
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "nickindex.h"
+#include "editdist.h"
+#include "normalize.h"
+
+/*
+ * Every nickname is padded with two markers on each side before being cut into
+ * trigrams, so a nickname of length n has n + 2 trigrams and even one letter
+ * nicknames have some. One edit changes at most three of them, so a nickname
+ * within k edits of the term shares at least (distinct term trigrams - 3k).
+ */
+#define PAD '\x01'
+#define TRIGRAM(a, b, c) (((unsigned int)(unsigned char)(a) << 16) | ((unsigned int)(unsigned char)(b) << 8) | (unsigned int)(unsigned char)(c))
+#define MAX_TRIGRAMS (NICKINDEX_NICKNAME_BUFSIZE + 2)
+
+#define EMPTY 0xFFFFFFFFu
+
+struct PostingList {
+	unsigned int* ids;  /* Ascending, since IDs are handed out in order */
+	unsigned int count;
+	unsigned int capacity;
+};
+
+/* Distinct nicknames, stored back to back in one pool */
+static char* pool = NULL;
+static size_t poolUsed = 0;
+static size_t poolCapacity = 0;
+static unsigned int* offsets = NULL;
+static unsigned char* lengths = NULL;
+static unsigned int* tags = NULL;
+static unsigned int nicknameCount = 0;
+static unsigned int nicknameCapacity = 0;
+
+/* Open addressing set of nickname IDs, keyed by the nickname's hash */
+static unsigned int* nicknameSlots = NULL;
+static unsigned int nicknameSlotMask = 0;
+
+/* Open addressing map from trigram to its posting list */
+static unsigned int* trigramKeys = NULL;
+static unsigned int* trigramLists = NULL;
+static unsigned int trigramSlotMask = 0;
+static struct PostingList* lists = NULL;
+static unsigned int listCount = 0;
+static unsigned int listCapacity = 0;
+
+/* Per query state, kept around so queries do not allocate */
+static unsigned char* hits = NULL;  /* Indexed by nickname ID, zero outside of a query */
+static unsigned int* candidates = NULL;
+
+static unsigned int hashBytes(const char* s, size_t length) {
+	unsigned int hash = 2166136261u;
+	size_t i;
+
+	for(i = 0; i < length; ++i) {
+		hash ^= (unsigned char)s[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static unsigned int hashTrigram(unsigned int trigram) {
+	return (trigram * 2654435761u) >> 8;
+}
+
+/* Collects the distinct trigrams of a normalized nickname. Returns how many there are. */
+static unsigned int trigramsOf(const char* s, size_t length, unsigned int* out) {
+	char padded[NICKINDEX_NICKNAME_BUFSIZE + 4];
+	unsigned int count = 0;
+	unsigned int trigram;
+	size_t i;
+	unsigned int j;
+
+	padded[0] = PAD;
+	padded[1] = PAD;
+	memcpy(padded + 2, s, length);
+	padded[length + 2] = PAD;
+	padded[length + 3] = PAD;
+	for(i = 0; i < length + 2; ++i) {
+		trigram = TRIGRAM(padded[i], padded[i + 1], padded[i + 2]);
+		for(j = 0; j < count && out[j] != trigram; ++j);
+		if(j == count) {
+			out[count++] = trigram;
+		}
+	}
+	return count;
+}
+
+static int reserve(void** array, unsigned int* capacity, unsigned int needed, size_t elementSize) {
+	unsigned int newCapacity;
+	void* p;
+
+	if(needed <= *capacity) {
+		return 0;
+	}
+	newCapacity = *capacity ? *capacity * 2 : 4;
+	while(newCapacity < needed) {
+		newCapacity *= 2;
+	}
+	p = realloc(*array, (size_t)newCapacity * elementSize);
+	if(!p) {
+		return 1;
+	}
+	*array = p;
+	*capacity = newCapacity;
+	return 0;
+}
+
+static int findNickname(const char* s, size_t length, unsigned int hash, unsigned int* slot) {
+	unsigned int i, id;
+
+	for(i = hash & nicknameSlotMask; (id = nicknameSlots[i]) != EMPTY; i = (i + 1) & nicknameSlotMask) {
+		if(lengths[id] == length && memcmp(pool + offsets[id], s, length) == 0) {
+			*slot = i;
+			return (int)id;
+		}
+	}
+	*slot = i;
+	return -1;
+}
+
+static int resize(void** array, size_t size) {
+	void* p = realloc(*array, size);
+
+	if(!p) {
+		return 1;
+	}
+	*array = p;
+	return 0;
+}
+
+/* Grows all per nickname arrays together. The query arrays always hold one entry per nickname. */
+static int growNicknames() {
+	unsigned int newCapacity = nicknameCapacity ? nicknameCapacity * 2 : 1024;
+
+	if(resize((void**)&offsets, (size_t)newCapacity * sizeof(unsigned int)) != 0 ||
+	   resize((void**)&lengths, newCapacity) != 0 ||
+	   resize((void**)&tags, (size_t)newCapacity * sizeof(unsigned int)) != 0 ||
+	   resize((void**)&hits, newCapacity) != 0 ||
+	   resize((void**)&candidates, (size_t)newCapacity * sizeof(unsigned int)) != 0) {
+		return 1;
+	}
+	nicknameCapacity = newCapacity;
+	return 0;
+}
+
+/* Keeps the nickname set at most half full */
+static int growNicknameSlots() {
+	unsigned int newMask = nicknameSlotMask ? nicknameSlotMask * 2 + 1 : 1023;
+	unsigned int* newSlots;
+	unsigned int id, i;
+
+	newSlots = (unsigned int*)malloc(((size_t)newMask + 1) * sizeof(unsigned int));
+	if(!newSlots) {
+		return 1;
+	}
+	memset(newSlots, 0xFF, ((size_t)newMask + 1) * sizeof(unsigned int));
+	for(id = 0; id < nicknameCount; ++id) {
+		for(i = hashBytes(pool + offsets[id], lengths[id]) & newMask; newSlots[i] != EMPTY; i = (i + 1) & newMask);
+		newSlots[i] = id;
+	}
+	free(nicknameSlots);
+	nicknameSlots = newSlots;
+	nicknameSlotMask = newMask;
+	return 0;
+}
+
+static struct PostingList* findList(unsigned int trigram) {
+	unsigned int i;
+
+	if(!trigramKeys) {
+		return NULL;
+	}
+	for(i = hashTrigram(trigram) & trigramSlotMask; trigramKeys[i] != EMPTY; i = (i + 1) & trigramSlotMask) {
+		if(trigramKeys[i] == trigram) {
+			return &lists[trigramLists[i]];
+		}
+	}
+	return NULL;
+}
+
+static int growTrigramSlots() {
+	unsigned int newMask = trigramSlotMask ? trigramSlotMask * 2 + 1 : 4095;
+	unsigned int* newKeys;
+	unsigned int* newLists;
+	unsigned int i, j;
+
+	newKeys = (unsigned int*)malloc(((size_t)newMask + 1) * sizeof(unsigned int));
+	newLists = (unsigned int*)malloc(((size_t)newMask + 1) * sizeof(unsigned int));
+	if(!newKeys || !newLists) {
+		free(newKeys);
+		free(newLists);
+		return 1;
+	}
+	memset(newKeys, 0xFF, ((size_t)newMask + 1) * sizeof(unsigned int));
+	for(i = 0; trigramKeys && i <= trigramSlotMask; ++i) {
+		if(trigramKeys[i] == EMPTY) {
+			continue;
+		}
+		for(j = hashTrigram(trigramKeys[i]) & newMask; newKeys[j] != EMPTY; j = (j + 1) & newMask);
+		newKeys[j] = trigramKeys[i];
+		newLists[j] = trigramLists[i];
+	}
+	free(trigramKeys);
+	free(trigramLists);
+	trigramKeys = newKeys;
+	trigramLists = newLists;
+	trigramSlotMask = newMask;
+	return 0;
+}
+
+/* Appends the nickname ID to the trigram's posting list, creating the list if needed */
+static int post(unsigned int trigram, unsigned int id) {
+	struct PostingList* list;
+	unsigned int i;
+
+	if(!trigramKeys || (listCount + 1) * 2 > trigramSlotMask + 1) {
+		if(growTrigramSlots() != 0) {
+			return 1;
+		}
+	}
+	for(i = hashTrigram(trigram) & trigramSlotMask; trigramKeys[i] != EMPTY && trigramKeys[i] != trigram; i = (i + 1) & trigramSlotMask);
+	if(trigramKeys[i] == EMPTY) {
+		if(reserve((void**)&lists, &listCapacity, listCount + 1, sizeof(struct PostingList)) != 0) {
+			return 1;
+		}
+		memset(&lists[listCount], 0, sizeof(struct PostingList));
+		trigramKeys[i] = trigram;
+		trigramLists[i] = listCount++;
+	}
+	list = &lists[trigramLists[i]];
+	if(reserve((void**)&list->ids, &list->capacity, list->count + 1, sizeof(unsigned int)) != 0) {
+		return 1;
+	}
+	list->ids[list->count++] = id;
+	return 0;
+}
+
+int nickindex_add(const char* nickname, unsigned int tag) {
+	char s[NICKINDEX_NICKNAME_BUFSIZE];
+	unsigned int trigrams[MAX_TRIGRAMS];
+	unsigned int trigramCount, hash, slot, id, i;
+	size_t length = normalize_nickname(nickname, s, NICKINDEX_NICKNAME_BUFSIZE);
+	int found;
+
+	if(!nicknameSlots || (nicknameCount + 1) * 2 > nicknameSlotMask + 1) {
+		if(growNicknameSlots() != 0) {
+			return -1;
+		}
+	}
+	hash = hashBytes(s, length);
+	found = findNickname(s, length, hash, &slot);
+	if(found >= 0) {
+		tags[found] = tag;
+		return found;
+	}
+
+	id = nicknameCount;
+	if(id == nicknameCapacity && growNicknames() != 0) {
+		return -1;
+	}
+	hits[id] = 0;
+	if(poolUsed + length > poolCapacity) {
+		size_t newCapacity = poolCapacity ? poolCapacity * 2 : 65536;
+		if(resize((void**)&pool, newCapacity) != 0) {
+			return -1;
+		}
+		poolCapacity = newCapacity;
+	}
+
+	trigramCount = trigramsOf(s, length, trigrams);
+	for(i = 0; i < trigramCount; ++i) {
+		if(post(trigrams[i], id) != 0) {
+			/* Undo the postings made so far, the nickname is not added */
+			while(i-- > 0) {
+				findList(trigrams[i])->count--;
+			}
+			return -1;
+		}
+	}
+
+	memcpy(pool + poolUsed, s, length);
+	offsets[id] = (unsigned int)poolUsed;
+	lengths[id] = (unsigned char)length;
+	tags[id] = tag;
+	poolUsed += length;
+	nicknameSlots[slot] = id;
+	nicknameCount++;
+	return (int)id;
+}
+
+static int containsId(const struct PostingList* list, unsigned int id) {
+	unsigned int low = 0, high = list->count;
+
+	while(low < high) {
+		unsigned int mid = low + (high - low) / 2;
+		if(list->ids[mid] < id) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low < list->count && list->ids[low] == id;
+}
+
+/* Inserts into the matches array, which is kept sorted by distance and capped at maxMatches */
+static int addMatch(struct NickMatch* matches, int matchCount, int maxMatches, unsigned int id, unsigned int distance) {
+	int i;
+
+	if(matchCount == maxMatches) {
+		if(matches[matchCount - 1].distance <= distance) {
+			return matchCount;
+		}
+		matchCount--;
+	}
+	for(i = matchCount; i > 0 && matches[i - 1].distance > distance; --i) {
+		matches[i] = matches[i - 1];
+	}
+	matches[i].id = id;
+	matches[i].distance = distance;
+	return matchCount + 1;
+}
+
+static int byCount(const void* a, const void* b) {
+	unsigned int x = (*(const struct PostingList* const*)a)->count;
+	unsigned int y = (*(const struct PostingList* const*)b)->count;
+	return (x > y) - (x < y);
+}
+
+int nickindex_search(const char* term, unsigned int maxDistance, struct NickMatch* matches, int maxMatches) {
+	static const struct PostingList emptyList = { NULL, 0, 0 };
+	struct EditPattern pattern;
+	char s[NICKINDEX_NICKNAME_BUFSIZE];
+	unsigned int trigrams[MAX_TRIGRAMS];
+	const struct PostingList* termLists[MAX_TRIGRAMS];
+	unsigned int trigramCount, threshold, probeCount, candidateCount = 0;
+	unsigned int i, j, id, distance;
+	size_t length = normalize_nickname(term, s, NICKINDEX_NICKNAME_BUFSIZE);
+	int matchCount = 0;
+
+	if(maxMatches <= 0 || nicknameCount == 0) {
+		return 0;
+	}
+	trigramCount = trigramsOf(s, length, trigrams);
+	if(maxDistance > NICKINDEX_MAX_DISTANCE) {
+		maxDistance = NICKINDEX_MAX_DISTANCE;
+	}
+	/* Keep at least one trigram in common, otherwise every nickname is a candidate */
+	if(3 * maxDistance >= trigramCount) {
+		maxDistance = (trigramCount - 1) / 3;
+	}
+	threshold = trigramCount - 3 * maxDistance;
+
+	/*
+	 * A match is missing from at most trigramCount - threshold lists, so it is in
+	 * at least one of the shortest trigramCount - threshold + 1. Only those are
+	 * walked, the longer ones are probed by binary search per candidate.
+	 */
+	for(i = 0; i < trigramCount; ++i) {
+		termLists[i] = findList(trigrams[i]);
+		if(!termLists[i]) {
+			termLists[i] = &emptyList;
+		}
+	}
+	qsort(termLists, trigramCount, sizeof(termLists[0]), byCount);
+	probeCount = trigramCount - threshold + 1;
+
+	for(i = 0; i < probeCount; ++i) {
+		for(j = 0; j < termLists[i]->count; ++j) {
+			id = termLists[i]->ids[j];
+			if(hits[id]++ == 0) {
+				candidates[candidateCount++] = id;
+			}
+		}
+	}
+
+	editdist_compile(&pattern, s, length);
+	for(i = 0; i < candidateCount; ++i) {
+		unsigned int count;
+
+		id = candidates[i];
+		count = hits[id];
+		hits[id] = 0;
+		for(j = probeCount; j < trigramCount && count < threshold && count + (trigramCount - j) >= threshold; ++j) {
+			count += containsId(termLists[j], id);
+		}
+		if(count < threshold) {
+			continue;
+		}
+		distance = editdist_bounded(&pattern, pool + offsets[id], lengths[id], maxDistance);
+		if(distance <= maxDistance) {
+			matchCount = addMatch(matches, matchCount, maxMatches, id, distance);
+		}
+	}
+	return matchCount;
+}
+
+const char* nickindex_nickname(unsigned int id) {
+	static char nickname[NICKINDEX_NICKNAME_BUFSIZE];
+
+	if(id >= nicknameCount) {
+		return "";
+	}
+	memcpy(nickname, pool + offsets[id], lengths[id]);
+	nickname[lengths[id]] = 0;
+	return nickname;
+}
+
+unsigned int nickindex_tag(unsigned int id) {
+	return id < nicknameCount ? tags[id] : 0;
+}
+
+unsigned int nickindex_count() {
+	return nicknameCount;
+}
+
+void nickindex_clear() {
+	unsigned int i;
+
+	for(i = 0; i < listCount; ++i) {
+		free(lists[i].ids);
+	}
+	free(lists);
+	free(trigramKeys);
+	free(trigramLists);
+	free(nicknameSlots);
+	free(pool);
+	free(offsets);
+	free(lengths);
+	free(tags);
+	free(hits);
+	free(candidates);
+	lists = NULL;
+	listCount = listCapacity = 0;
+	trigramKeys = trigramLists = NULL;
+	trigramSlotMask = 0;
+	nicknameSlots = NULL;
+	nicknameSlotMask = 0;
+	pool = NULL;
+	poolUsed = poolCapacity = 0;
+	offsets = tags = candidates = NULL;
+	lengths = hits = NULL;
+	nicknameCount = nicknameCapacity = 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Search By - fuzzy nickname index
+ *
+ * A trigram inverted index over every distinct nickname the plugin has seen.
+ * A query collects the nicknames sharing enough trigrams with the term to be
+ * within the requested edit distance, then verifies each candidate with a
+ * bounded edit distance.
+ *
+ * Nicknames are matched by their normalize_nickname skeleton, so case and
+ * look-alike characters do not matter. Only used from the client callback
+ * thread, no locking.
+ */
+
+#ifndef NICKINDEX_H
+#define NICKINDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NICKINDEX_NICKNAME_BUFSIZE 128
+#define NICKINDEX_MAX_DISTANCE 3
+
+struct NickMatch {
+	unsigned int id;
+	unsigned int distance;
+};
+
+/*
+ * Adds a nickname, or finds it if it is already indexed, and sets its tag to
+ * the given value (the plugin stores the latest seen index record there).
+ * Returns the nickname ID, or -1 if out of memory.
+ */
+int nickindex_add(const char* nickname, unsigned int tag);
+
+/*
+ * Finds up to maxMatches nicknames within maxDistance edits of term, closest
+ * first. maxDistance is capped at NICKINDEX_MAX_DISTANCE, and lowered for very
+ * short terms where fewer edits already match almost anything.
+ * Returns the number of matches.
+ */
+int nickindex_search(const char* term, unsigned int maxDistance, struct NickMatch* matches, int maxMatches);
+
+/* Returns the indexed skeleton of a nickname */
+const char* nickindex_nickname(unsigned int id);
+
+unsigned int nickindex_tag(unsigned int id);
+
+/* Number of distinct nicknames */
+unsigned int nickindex_count();
+
+/* Frees the whole index */
+void nickindex_clear();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
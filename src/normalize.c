@@ -0,0 +1,238 @@
+/*
+ * Search By - nickname normalization
+ */
+
+#include <string.h>
+#include "normalize.h"
+
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define NORMALIZE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define REMOVED 0
+
+/* Base letters of U+00C0..U+00FF and U+0100..U+017F, '.' where there is none */
+static const char latin1Base[] = "AAAAAA.CEEEEIIIIDNOOOOO.OUUUUY..aaaaaa.ceeeeiiiidnooooo.ouuuuy.y";
+static const char latinExtendedABase[] =
+	"AaAaAaCcCcCcCcDdDdEeEeEeEeEeGgGgGgGgHhHhIiIiIiIiIi..JjKkkLlLlLlLlLlNnNnNnn..OoOoOo..RrRrRrSsSsSsSsTtTtTtUuUuUuUuUuUuWwYyYZzZzZzs";
+
+struct Confusable {
+	unsigned int codepoint;
+	char prototype;
+};
+
+/* Sorted by code point. Capitals map to capitals, the case fold runs afterwards. */
+static const struct Confusable confusables[] = {
+	{ 0x00D7, 'x' }, { 0x0131, 'i' }, { 0x01C0, 'l' }, { 0x0251, 'a' }, { 0x0261, 'g' },
+	{ 0x0391, 'A' }, { 0x0392, 'B' }, { 0x0395, 'E' }, { 0x0396, 'Z' }, { 0x0397, 'H' },
+	{ 0x0399, 'l' }, { 0x039A, 'K' }, { 0x039C, 'M' }, { 0x039D, 'N' }, { 0x039F, 'O' },
+	{ 0x03A1, 'P' }, { 0x03A4, 'T' }, { 0x03A5, 'Y' }, { 0x03A7, 'X' }, { 0x03B1, 'a' },
+	{ 0x03B9, 'i' }, { 0x03BD, 'v' }, { 0x03BF, 'o' }, { 0x03C1, 'p' }, { 0x03C5, 'u' },
+	{ 0x03F2, 'c' }, { 0x03F3, 'j' }, { 0x0405, 'S' }, { 0x0406, 'l' }, { 0x0408, 'J' },
+	{ 0x0410, 'A' }, { 0x0412, 'B' }, { 0x0415, 'E' }, { 0x041A, 'K' }, { 0x041C, 'M' },
+	{ 0x041D, 'H' }, { 0x041E, 'O' }, { 0x0420, 'P' }, { 0x0421, 'C' }, { 0x0422, 'T' },
+	{ 0x0425, 'X' }, { 0x0430, 'a' }, { 0x0435, 'e' }, { 0x043E, 'o' }, { 0x0440, 'p' },
+	{ 0x0441, 'c' }, { 0x0443, 'y' }, { 0x0445, 'x' }, { 0x0455, 's' }, { 0x0456, 'i' },
+	{ 0x0458, 'j' }, { 0x04BB, 'h' }, { 0x04C0, 'l' }, { 0x04CF, 'l' }, { 0x0501, 'd' },
+	{ 0x051B, 'q' }, { 0x051D, 'w' }, { 0x2113, 'l' }, { 0x2160, 'l' }, { 0x2170, 'i' },
+	{ 0x217C, 'l' }
+};
+
+#define CONFUSABLE_COUNT (sizeof(confusables) / sizeof(confusables[0]))
+
+/* ASCII homoglyphs and case, the whole mapping for ASCII input */
+static unsigned char foldAscii(unsigned char c) {
+	if(c == 'I' || c == '1' || c == '|') {
+		return 'l';
+	}
+	if(c == '0') {
+		return 'o';
+	}
+	if(c >= 'A' && c <= 'Z') {
+		return (unsigned char)(c + ('a' - 'A'));
+	}
+	return c;
+}
+
+static int isRemoved(unsigned int c) {
+	return (c >= 0x0300 && c <= 0x036F) ||  /* Combining diacritical marks */
+	       c == 0x00AD || c == 0x034F ||
+	       (c >= 0x200B && c <= 0x200F) || (c >= 0x202A && c <= 0x202E) || (c >= 0x2060 && c <= 0x2064) ||
+	       (c >= 0xFE00 && c <= 0xFE0F) || c == 0xFEFF;
+}
+
+static int isSpace(unsigned int c) {
+	return c == 0x00A0 || (c >= 0x2000 && c <= 0x200A) || c == 0x202F || c == 0x205F || c == 0x3000;
+}
+
+static unsigned int findConfusable(unsigned int c) {
+	size_t low = 0, high = CONFUSABLE_COUNT;
+
+	while(low < high) {
+		size_t mid = low + (high - low) / 2;
+		if(confusables[mid].codepoint < c) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return (low < CONFUSABLE_COUNT && confusables[low].codepoint == c) ? (unsigned int)(unsigned char)confusables[low].prototype : c;
+}
+
+/* Simple case fold of the Latin, Greek and Cyrillic letters left after the other steps */
+static unsigned int foldCase(unsigned int c) {
+	if((c >= 0x00C0 && c <= 0x00DE && c != 0x00D7) || (c >= 0x0391 && c <= 0x03AB && c != 0x03A2) || (c >= 0x0410 && c <= 0x042F)) {
+		return c + 0x20;
+	}
+	if(c >= 0x0400 && c <= 0x040F) {
+		return c + 0x50;
+	}
+	if(c == 0x0132 || c == 0x014A || c == 0x0152) {
+		return c + 1;
+	}
+	return c;
+}
+
+/* Maps one code point to its skeleton, REMOVED if it is dropped */
+static unsigned int normalizeCodepoint(unsigned int c) {
+	char base;
+
+	if(c >= 0xFF01 && c <= 0xFF5E) {  /* Fullwidth ASCII */
+		return foldAscii((unsigned char)(c - 0xFEE0));
+	}
+	if(isRemoved(c)) {
+		return REMOVED;
+	}
+	if(isSpace(c)) {
+		return ' ';
+	}
+	if(c >= 0x00C0 && c <= 0x017F) {
+		base = c < 0x0100 ? latin1Base[c - 0x00C0] : latinExtendedABase[c - 0x0100];
+		if(base != '.') {
+			return foldAscii((unsigned char)base);
+		}
+	}
+	c = findConfusable(c);
+	return c < 0x80 ? foldAscii((unsigned char)c) : foldCase(c);
+}
+
+/* Decodes one UTF-8 sequence. Invalid or truncated sequences decode as a single '?' byte. */
+static unsigned int decode(const unsigned char* s, size_t* length) {
+	unsigned int c = s[0];
+	size_t n, i;
+
+	if(c >= 0xF0 && c <= 0xF4) {
+		n = 4;
+		c &= 0x07;
+	} else if(c >= 0xE0 && c <= 0xEF) {
+		n = 3;
+		c &= 0x0F;
+	} else if(c >= 0xC2 && c <= 0xDF) {
+		n = 2;
+		c &= 0x1F;
+	} else {
+		*length = 1;
+		return '?';
+	}
+	for(i = 1; i < n; ++i) {
+		if((s[i] & 0xC0) != 0x80) {
+			*length = 1;
+			return '?';
+		}
+		c = (c << 6) | (s[i] & 0x3F);
+	}
+	/* Overlong forms and surrogates */
+	if((n == 3 && (c < 0x800 || (c >= 0xD800 && c <= 0xDFFF))) || (n == 4 && (c < 0x10000 || c > 0x10FFFF))) {
+		*length = 1;
+		return '?';
+	}
+	*length = n;
+	return c;
+}
+
+static size_t encodedLength(unsigned int c) {
+	return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+static void encode(unsigned int c, unsigned char* out) {
+	if(c < 0x80) {
+		out[0] = (unsigned char)c;
+	} else if(c < 0x800) {
+		out[0] = (unsigned char)(0xC0 | (c >> 6));
+		out[1] = (unsigned char)(0x80 | (c & 0x3F));
+	} else if(c < 0x10000) {
+		out[0] = (unsigned char)(0xE0 | (c >> 12));
+		out[1] = (unsigned char)(0x80 | ((c >> 6) & 0x3F));
+		out[2] = (unsigned char)(0x80 | (c & 0x3F));
+	} else {
+		out[0] = (unsigned char)(0xF0 | (c >> 18));
+		out[1] = (unsigned char)(0x80 | ((c >> 12) & 0x3F));
+		out[2] = (unsigned char)(0x80 | ((c >> 6) & 0x3F));
+		out[3] = (unsigned char)(0x80 | (c & 0x3F));
+	}
+}
+
+#ifdef NORMALIZE_SSE2
+/* foldAscii on 16 bytes known to be ASCII */
+static __m128i foldAscii16(__m128i x) {
+	const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(x, _mm_set1_epi8('Z' + 1)));
+	const __m128i toL = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('I')), _mm_cmpeq_epi8(x, _mm_set1_epi8('1'))),
+	                                 _mm_cmpeq_epi8(x, _mm_set1_epi8('|')));
+	const __m128i toO = _mm_cmpeq_epi8(x, _mm_set1_epi8('0'));
+	__m128i folded = _mm_or_si128(x, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+
+	folded = _mm_andnot_si128(_mm_or_si128(toL, toO), folded);
+	folded = _mm_or_si128(folded, _mm_and_si128(toL, _mm_set1_epi8('l')));
+	return _mm_or_si128(folded, _mm_and_si128(toO, _mm_set1_epi8('o')));
+}
+#endif
+
+size_t normalize_nickname(const char* str, char* out, size_t outSize) {
+	const unsigned char* s = (const unsigned char*)str;
+	unsigned char* o = (unsigned char*)out;
+	size_t length = strlen(str);
+	size_t i = 0, used = 0, n, size;
+	unsigned int c;
+
+	if(outSize == 0) {
+		return 0;
+	}
+	while(i < length) {
+#ifdef NORMALIZE_SSE2
+		/* Nicknames are mostly ASCII, fold 16 bytes at a time while there is no multibyte sequence */
+		while(i + 16 <= length && used + 16 < outSize) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+			if(_mm_movemask_epi8(x) != 0) {
+				break;
+			}
+			_mm_storeu_si128((__m128i*)(o + used), foldAscii16(x));
+			i += 16;
+			used += 16;
+		}
+		if(i >= length) {
+			break;
+		}
+#endif
+		if(s[i] < 0x80) {
+			if(used + 1 >= outSize) {
+				break;
+			}
+			o[used++] = foldAscii(s[i++]);
+			continue;
+		}
+		c = normalizeCodepoint(decode(s + i, &n));
+		i += n;
+		if(c == REMOVED) {
+			continue;
+		}
+		size = encodedLength(c);
+		if(used + size >= outSize) {
+			break;
+		}
+		encode(c, o + used);
+		used += size;
+	}
+	o[used] = '\0';
+	return used;
+}
@@ -0,0 +1,33 @@
+/*
+ * Search By - nickname normalization
+ *
+ * Reduces a UTF-8 nickname to a skeleton, so nicknames that look alike compare
+ * equal: fullwidth forms become ASCII, accents and invisible characters are
+ * dropped, common homoglyphs (Cyrillic and Greek look-alikes, '1' and 'I' for
+ * 'l', '0' for 'o', after Unicode TR39) map to one prototype, and the result is
+ * case folded.
+ *
+ * The skeleton is only for comparing nicknames; it is never shown or sent anywhere.
+ */
+
+#ifndef NORMALIZE_H
+#define NORMALIZE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Writes the skeleton of str into out, NUL terminated and cut at a character
+ * boundary if it does not fit. The skeleton is never longer than str.
+ * Returns its length.
+ */
+size_t normalize_nickname(const char* str, char* out, size_t outSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
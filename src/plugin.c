@@ -20,6 +20,26 @@
 #include "public_rare_definitions.h"
 #include "ts3_functions.h"
 #include "plugin.h"
+#include "launcher.h"
+#include "providers.h"
+#include "encode.h"
+#include "scratch.h"
+#include "searchurl.h"
+#include "searchpage.h"
+#include "addrcache.h"
+#include "clientcache.h"
+#include "resolver.h"
+#include "seenindex.h"
+#include "nickindex.h"
+#include "protect.h"
+#include "normalize.h"
+#include "configwatch.h"
+#include "http.h"
+#include "extract.h"
+#include "httpcache.h"
+#include "recent.h"
+#include "stats.h"
+#include "clientqueue.h"
 
 static struct TS3Functions ts3Functions;
 
@@ -38,6 +58,26 @@ static struct TS3Functions ts3Functions;
 #define SERVERINFO_BUFSIZE 256
 #define CHANNELINFO_BUFSIZE 512
 #define RETURNCODE_BUFSIZE 128
+#define TERM_BUFSIZE SEARCHURL_TERM_BUFSIZE
+#define MESSAGE_BUFSIZE 512
+#define NICK_MATCH_COUNT 20
+#define FIND_RESULT_COUNT 50
+#define BATCH_MATCH_COUNT 5
+#define FETCH_TITLE_BUFSIZE 128
+#define FETCH_RECORD_COUNT 10
+#define FETCH_CACHE_BUDGET (16ULL * 1024 * 1024)  /* Bytes of fetched pages kept in the config directory */
+
+#define CHANNEL_PAGE_FILENAME "search_by_channel.html"
+#define CLIENT_PAGE_FILENAME "search_by_client.html"
+#define BATCH_PAGE_FILENAME "search_by_batch.html"
+
+#define SEARCH_URL_BUFSIZE SEARCHURL_BUFSIZE
+typedef char searchUrlFitsLauncherQueue[(SEARCH_URL_BUFSIZE <= LAUNCHER_URL_BUFSIZE) ? 1 : -1];
+typedef char providersFitStats[(PROVIDER_COUNT + 1 <= STATS_MAX_PROVIDERS) ? 1 : -1];  /* The built-in providers, then all others */
+typedef char searchFitsRecent[(SEARCH_URL_BUFSIZE <= RECENT_URL_BUFSIZE && TERM_BUFSIZE <= RECENT_TERM_BUFSIZE) ? 1 : -1];
+
+/* Scratch memory of one menu event: term, URL and message, each rounded up to 8 bytes */
+#define SCRATCH_BUFSIZE (TERM_BUFSIZE + SEARCH_URL_BUFSIZE + MESSAGE_BUFSIZE + 3 * 8)
 
 #define PLUGIN_NAME "Search By"
 #define PLUGIN_AUTHOR "Bluscream"
@@ -46,6 +86,37 @@ static struct TS3Functions ts3Functions;
 
 static char* pluginID = NULL;
 
+/* Providers plus About and the channel client search */
+#define MENU_COUNT (PROVIDER_COUNT + 2)
+
+/* Everything handed to the client by ts3plugin_initMenus, allocated as a single block */
+struct MenuBlock {
+	struct PluginMenuItem* items[MENU_COUNT + 1];  /* NULL terminated, must stay the first member */
+	struct PluginMenuItem itemData[MENU_COUNT];
+	char icon[PLUGIN_MENU_BUFSZ];
+};
+
+/* Pointers into a MenuBlock handed to the client: every item, the item array and the icon */
+#define MENU_BLOCK_POINTERS (MENU_COUNT + 2)
+
+/*
+ * All menu memory is one MenuBlock, see ts3plugin_initMenus. The client frees every item, the
+ * item array and the icon separately, in any order. Each release of a pointer into the block is
+ * counted and the block is freed with the last one, then menuBlock is cleared, so pointers are
+ * only recognized as part of it while it is allocated.
+ */
+static struct MenuBlock* menuBlock = NULL;
+static unsigned int menuBlockOutstanding = 0;
+
+/* The provider config file, compiled again by the watcher thread whenever it changes */
+static char providersPath[PATH_BUFSIZE + sizeof(PROVIDERS_FILENAME)];
+
+/* Set once the nickname index holds every seen user, see buildNickIndex */
+static int nickIndexBuilt = 0;
+
+/* What /searchby fetch pulls from providers without an extraction profile */
+static struct ExtractProfile titleProfile;
+
 #ifdef _WIN32
 /* Helper function to convert wchar_T to Utf-8 encoded strings on Windows */
 static int wcharToUtf8(const wchar_t* str, char** result) {
@@ -59,6 +130,39 @@ static int wcharToUtf8(const wchar_t* str, char** result) {
 }
 #endif
 
+/* Runs on the client thread after a reload, between callbacks, when no search holds the replaced table anymore */
+static void reclaimProviders(struct ClientTask* task, int discard) {
+	if(!discard) {
+		providers_reclaim();
+	}
+	free(task);
+}
+
+/* Called on the config watcher thread when the provider file changed. Searches pick up the new table on their next lookup. */
+static void reloadProviders() {
+	struct ClientTask* task;
+
+	if(providers_load(providersPath) == 0) {
+		printf("PLUGIN: reloaded %s\n", providersPath);
+		task = (struct ClientTask*)malloc(sizeof(struct ClientTask));
+		if(task) {
+			task->run = reclaimProviders;
+			clientqueue_post(task);
+		}
+	} else {
+		printf("PLUGIN: cannot reload %s, keeping the previous providers\n", providersPath);
+	}
+}
+
+/* Called on the client thread for each nickname the protect worker flagged */
+static void printImpersonator(const struct ProtectMatch* match) {
+	char message[MESSAGE_BUFSIZE];
+
+	snprintf(message, MESSAGE_BUFSIZE, "Possible impersonator: \"%s\" (UID %s) is %u edits away from protected nickname \"%s\"",
+	         match->nickname, match->uid, match->distance, match->protectedName);
+	ts3Functions.printMessage((uint64)match->server, message, PLUGIN_MESSAGE_TARGET_SERVER);
+}
+
 /*********************************** Required functions ************************************/
 /*
  * If any of these required functions is not implemented, TS3 will refuse to load the plugin
@@ -117,6 +221,8 @@ int ts3plugin_init() {
     char resourcesPath[PATH_BUFSIZE];
     char configPath[PATH_BUFSIZE];
 	char pluginPath[PATH_BUFSIZE];
+	char seenIndexPath[PATH_BUFSIZE + sizeof(SEENINDEX_FILENAME)];
+	char protectedPath[PATH_BUFSIZE + sizeof(PROTECT_FILENAME)];
 
     /* Your plugin init code here */
     printf("PLUGIN: init\n");
@@ -130,6 +236,48 @@ int ts3plugin_init() {
 
 	printf("PLUGIN: App path: %s\nResources path: %s\nConfig path: %s\nPlugin path: %s\n", appPath, resourcesPath, configPath, pluginPath);
 
+	/* Browser launches run on a worker thread so menu clicks never block the client */
+	if(launcher_init() != 0) {
+		return 1;
+	}
+
+	/* Inline result fetches are optional, the browser searches work without them */
+	clientqueue_init();
+	if(http_init() != 0) {
+		printf("PLUGIN: cannot start the HTTP engine, /searchby fetch is unavailable\n");
+	} else if(httpcache_open(configPath, FETCH_CACHE_BUDGET) != 0) {
+		printf("PLUGIN: cannot open the cache directory, fetched pages are not cached\n");
+	}
+	extract_initProfile(&titleProfile);
+	extract_addField(&titleProfile, "title", "<title>", "</title>");
+
+	snprintf(providersPath, sizeof(providersPath), "%s%s", configPath, PROVIDERS_FILENAME);
+	if(providers_load(providersPath) != 0) {
+		http_shutdown();
+		httpcache_close();
+		launcher_shutdown();
+		return 1;
+	}
+	if(configwatch_start(configPath, PROVIDERS_FILENAME, reloadProviders) != 0) {
+		printf("PLUGIN: cannot watch %s, changes apply when the plugin is reloaded\n", providersPath);
+	}
+
+	/* The seen users index is optional, searches work without it */
+	snprintf(seenIndexPath, sizeof(seenIndexPath), "%s%s", configPath, SEENINDEX_FILENAME);
+	if(seenindex_open(seenIndexPath) != 0) {
+		printf("PLUGIN: cannot open %s, seen users are not recorded\n", seenIndexPath);
+	}
+
+	/* Impersonation checks run on their own thread, matches come back through the client queue */
+	snprintf(protectedPath, sizeof(protectedPath), "%s%s", configPath, PROTECT_FILENAME);
+	if(protect_init(printImpersonator) != 0) {
+		printf("PLUGIN: protected nicknames are not checked\n");
+	} else if(protect_load(protectedPath) != 0) {
+		printf("PLUGIN: cannot read %s\n", protectedPath);
+	} else {
+		printf("PLUGIN: %u protected nicknames, %u lines without a UID ignored\n", protect_count(), protect_ignored());
+	}
+
     return 0;  /* 0 = success, 1 = failure, -2 = failure but client will not show a "failed to load" warning */
 	/* -2 is a very special case and should only be used if a plugin displays a dialog (e.g. overlay) asking the user to disable
 	 * the plugin again, avoiding the show another dialog by the client telling the user the plugin failed to load.
@@ -147,6 +295,24 @@ void ts3plugin_shutdown() {
 	 * TeamSpeak client will most likely crash (DLL removed but dialog from DLL code still open).
 	 */
 
+	configwatch_stop();
+	http_shutdown();
+	httpcache_close();
+	protect_shutdown();
+	clientqueue_shutdown();
+	launcher_shutdown();
+	providers_free();
+	addrcache_clear();
+	clientcache_clear();
+	resolver_clear();
+	seenindex_close();
+	nickindex_clear();
+	nickIndexBuilt = 0;
+	recent_clear();
+	free(menuBlock);  /* Menus the client never released */
+	menuBlock = NULL;
+	menuBlockOutstanding = 0;
+
 	/* Free pluginID if we registered it */
 	if(pluginID) {
 		free(pluginID);
@@ -162,6 +328,13 @@ void ts3plugin_registerPluginID(const char* id) {
 }
 
 void ts3plugin_freeMemory(void* data) {
+	if(menuBlock && (char*)data >= (char*)menuBlock && (char*)data < (char*)(menuBlock + 1)) {
+		if(--menuBlockOutstanding == 0) {
+			free(menuBlock);
+			menuBlock = NULL;
+		}
+		return;
+	}
 	free(data);
 }
 //
@@ -174,45 +347,14 @@ int ts3plugin_requestAutoload() {
 	return 1;  /* 1 = request autoloaded, 0 = do not request autoload */
 }
 //
-///* Helper function to create a menu item */
-static struct PluginMenuItem* createMenuItem(enum PluginMenuType type, int id, const char* text, const char* icon) {
-	struct PluginMenuItem* menuItem = (struct PluginMenuItem*)malloc(sizeof(struct PluginMenuItem));
+/* Helper function to fill in a menu item */
+static void setMenuItem(struct PluginMenuItem* menuItem, enum PluginMenuType type, int id, const char* text, const char* icon) {
 	menuItem->type = type;
 	menuItem->id = id;
 	_strcpy(menuItem->text, PLUGIN_MENU_BUFSZ, text);
 	_strcpy(menuItem->icon, PLUGIN_MENU_BUFSZ, icon);
-	return menuItem;
 }
-//
-///* Some makros to make the code to create menu items a bit more readable */
-#define BEGIN_CREATE_MENUS(x) const size_t sz = x + 1; size_t n = 0; *menuItems = (struct PluginMenuItem**)malloc(sizeof(struct PluginMenuItem*) * sz);
-#define CREATE_MENU_ITEM(a, b, c, d) (*menuItems)[n++] = createMenuItem(a, b, c, d);
-#define END_CREATE_MENUS (*menuItems)[n++] = NULL; assert(n == sz);
-//
-///*
-// * Menu IDs for this plugin. Pass these IDs when creating a menuitem to the TS3 client. When the menu item is triggered,
-// * ts3plugin_onMenuItemEvent will be called passing the menu ID of the triggered menu item.
-// * These IDs are freely choosable by the plugin author. It's not really needed to use an enum, it just looks prettier.
-// */
-enum {
-	MENU_ID_CLIENT_1 = 1,
-		MENU_ID_CLIENT_2,
-		MENU_ID_CLIENT_3,
-		MENU_ID_CLIENT_4,
-		MENU_ID_CLIENT_5,
-		MENU_ID_CLIENT_6,
-		MENU_ID_CLIENT_7,
-		MENU_ID_CLIENT_8,
-		MENU_ID_CLIENT_9,
-		MENU_ID_GLOBAL_1,
-		MENU_ID_GLOBAL_2,
-		MENU_ID_GLOBAL_3,
-		MENU_ID_GLOBAL_4,
-		MENU_ID_GLOBAL_5,
-		MENU_ID_GLOBAL_6,
-		MENU_ID_GLOBAL_7
-};
-//
+
 ///*
 // * Initialize plugin menus.
 // * This function is called after ts3plugin_init and ts3plugin_registerPluginID. A pluginID is required for plugin menus to work.
@@ -237,313 +379,1234 @@ void ts3plugin_initMenus(struct PluginMenuItem*** menuItems, char** menuIcon) {
 	 * e.g. for "test_plugin.dll", icon "1.png" is loaded from <TeamSpeak 3 Client install dir>\plugins\test_plugin\1.png
 	 */
 
-	BEGIN_CREATE_MENUS(16);  /* IMPORTANT: Number of menu items must be correct! */
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, "Nickname (TSViewer)", "name.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_2, "Nickname (GameTracker)", "name.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_3, "Nickname (TS3Index)", "name.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_4, "Nickname (Google)", "name.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_5, "Profile (GameTracker)", "name.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_6, "UID (TS3Index)", "id.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_7, "UID (Google)", "id.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_8, "Owner (TSViewer)", "admin.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_9, "DBID (mtG)", "id.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_1, "Name (TSViewer)", "name.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_2, "Name (GameTracker)", "name.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_3, "Name (Google)", "name.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_4, "IP (TSViewer)", "ip.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_5, "IP (GameTracker)", "ip.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_6, "IP (Google)", "ip.png");
-	CREATE_MENU_ITEM(PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_7, "About", "about.png");
-	END_CREATE_MENUS;  /* Includes an assert checking if the number of menu items matched */
+	struct MenuBlock* block;
+	size_t i;
+
+	/* Built from the built-in providers only, the client never asks again, so the provider file cannot change the menus */
+
+	/* One allocation for the item array, the items and the icon, released through ts3plugin_freeMemory */
+	block = (struct MenuBlock*)malloc(sizeof(struct MenuBlock));
+	if(!block) {
+		*menuItems = NULL;
+		*menuIcon = NULL;
+		return;
+	}
+	free(menuBlock);  /* The client asks once per load, an earlier block it kept is not in use anymore */
+	menuBlock = block;
+	menuBlockOutstanding = MENU_BLOCK_POINTERS;
+
+	for(i = 0; i < PROVIDER_COUNT; i++) {
+		setMenuItem(&block->itemData[i], providers[i].menuType, providers[i].menuID, providers[i].text, providers[i].icon);
+	}
+	setMenuItem(&block->itemData[i++], PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_ABOUT, "About", "about.png");
+	setMenuItem(&block->itemData[i++], PLUGIN_MENU_TYPE_CHANNEL, MENU_ID_CHANNEL_SEARCH_CLIENTS, "Search all clients", "search.png");
+	assert(i == MENU_COUNT);
+	for(i = 0; i < MENU_COUNT; i++) {
+		block->items[i] = &block->itemData[i];
+	}
+	block->items[MENU_COUNT] = NULL;
+	*menuItems = block->items;
 
 	/*
 	 * Specify an optional icon for the plugin. This icon is used for the plugins submenu within context and main menus
 	 * If unused, set menuIcon to NULL
 	 */
-	*menuIcon = (char*)malloc(PLUGIN_MENU_BUFSZ * sizeof(char));
+	*menuIcon = block->icon;
 	_strcpy(*menuIcon, PLUGIN_MENU_BUFSZ, "search.png");
 
 
 }
 
-/* Converts a hex character to its integer value */
-char from_hex(char ch) {
-	return isdigit(ch) ? ch - '0' : tolower(ch) - 'a' + 10;
+/*
+ * Shows a message to the user: a message box on Windows, a line in the current tab elsewhere.
+ * This keeps the plugin buildable and usable on clients without the Win32 API.
+ */
+static void showMessage(const char* text, const char* title, int isError) {
+#ifdef _WIN32
+	MessageBoxA(0, text, title, isError ? MB_ICONERROR : MB_ICONINFORMATION);
+#else
+	char message[MESSAGE_BUFSIZE];
+	snprintf(message, MESSAGE_BUFSIZE, "%s%s: %s", isError ? "[color=red]" : "", title, text);
+	if(isError) {
+		strncat(message, "[/color]", MESSAGE_BUFSIZE - strlen(message) - 1);
+	}
+	ts3Functions.printMessageToCurrentTab(message);
+#endif
 }
 
-/* Converts an integer value to its hex character*/
-char to_hex(char code) {
-	static char hex[] = "0123456789abcdef";
-	return hex[code & 15];
+/* Copies a term, truncating overlong values. This keeps the term within the bound buildSearchUrl relies on. */
+static void copyTerm(char* term, size_t termSize, const char* value) {
+	size_t length = strlen(value);
+	if(length >= termSize) {
+		length = termSize - 1;
+	}
+	memcpy(term, value, length);
+	term[length] = '\0';
 }
 
-/* Returns a url-encoded version of str */
-/* IMPORTANT: be sure to free() the returned string after use */
-char *url_encode(char *str) {
-	char *pstr = str, *buf = malloc(strlen(str) * 3 + 1), *pbuf = buf;
-	while (*pstr) {
-		if (isalnum(*pstr) || *pstr == '-' || *pstr == '_' || *pstr == '.' || *pstr == '~')
-			*pbuf++ = *pstr;
-		else if (*pstr == ' ')
-			*pbuf++ = '+';
-		else
-			*pbuf++ = '%', *pbuf++ = to_hex(*pstr >> 4), *pbuf++ = to_hex(*pstr & 15);
-		pstr++;
+/*
+ * Returns the address of a server, resolved once per connection and cached until its connection status changes.
+ * Not every server reports its IP, so this falls back to the raw property 76 and then the address we connected to.
+ */
+static const char* getServerAddress(uint64 serverConnectionHandlerID) {
+	anyID myID;
+	char* data = NULL;
+	const char* address;
+
+	address = addrcache_get(serverConnectionHandlerID);
+	if(address) {
+		return address;
 	}
-	*pbuf = '\0';
-	return buf;
+
+	if(ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_IP, &data) != ERROR_ok) {
+		return NULL;
+	}
+	if(data[0] == '\0') {
+		ts3Functions.freeMemory(data);
+		if(ts3Functions.getServerVariableAsString(serverConnectionHandlerID, 76, &data) != ERROR_ok) {
+			return NULL;
+		}
+	}
+	if(data[0] == '\0') {
+		ts3Functions.freeMemory(data);
+		if(ts3Functions.getClientID(serverConnectionHandlerID, &myID) != ERROR_ok ||
+		   ts3Functions.getConnectionVariableAsString(serverConnectionHandlerID, myID, 6, &data) != ERROR_ok) {
+			return NULL;
+		}
+	}
+
+	if(data[0] != '\0') {
+		addrcache_put(serverConnectionHandlerID, data);
+	}
+	ts3Functions.freeMemory(data);
+	return addrcache_get(serverConnectionHandlerID);
 }
 
-void ts3plugin_onMenuItemEvent(uint64 serverConnectionHandlerID, enum PluginMenuType type, int menuItemID, uint64 selectedItemID) {
-	anyID myID;
-	char* Data;
-	char string_s[150];
-	char url[100];
-	int DataINT;
-	switch (type) {
-		case PLUGIN_MENU_TYPE_GLOBAL:
-			if (ts3Functions.getClientID(serverConnectionHandlerID, &myID) != ERROR_ok) {
-				MessageBoxA(0, "Cant get your clientID. Are you connected to a server?", PLUGIN_NAME " - Error", MB_ICONERROR);
+/*
+ * Fetches the search term of a provider into term. Nicknames are passed as they are, not as their
+ * normalize_nickname skeleton: the sites search for the real nickname.
+ * Returns 0 on success, 1 if the variable could not be read.
+ */
+static int getSearchTerm(uint64 serverConnectionHandlerID, enum ProviderSource source, uint64 selectedItemID, char* term, size_t termSize) {
+	const struct ClientTable* clients;
+	char* data = NULL;
+	const char* address;
+	int dataInt;
+	int row = -1;
+
+	/* Client variables are read from the snapshot cache when the client is in it */
+	if(source == PROVIDER_SOURCE_CLIENT_NICKNAME || source == PROVIDER_SOURCE_CLIENT_UID || source == PROVIDER_SOURCE_CLIENT_DBID) {
+		row = clientcache_find(serverConnectionHandlerID, (anyID)selectedItemID);
+	}
+	if(row >= 0) {
+		clients = clientcache_table(serverConnectionHandlerID);
+		switch(source) {
+			case PROVIDER_SOURCE_CLIENT_NICKNAME:
+				copyTerm(term, termSize, clients->nicknames[row]);
+				return 0;
+			case PROVIDER_SOURCE_CLIENT_UID:
+				copyTerm(term, termSize, clients->uids[row]);
+				return 0;
+			default:
+				if(clients->databaseIDs[row] != 0) {  /* 0 = not known yet when the client was cached */
+					snprintf(term, termSize, "%llu", (unsigned long long)clients->databaseIDs[row]);
+					return 0;
+				}
 				break;
+		}
+	}
+
+	switch(source) {
+		case PROVIDER_SOURCE_CLIENT_NICKNAME:
+			if(ts3Functions.getClientVariableAsString(serverConnectionHandlerID, (anyID)selectedItemID, CLIENT_NICKNAME, &data) != ERROR_ok) {
+				return 1;
 			}
-			switch (menuItemID) {
-				case MENU_ID_GLOBAL_1:
-					if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_NAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start http://www.tsviewer.com/index.php?page=search^&action=ausgabe%26suchbereich=name^&suchinhalt=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-					break;
-				case MENU_ID_GLOBAL_2:
-					if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_NAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start http://www.gametracker.com/search/?query=");
-					strcat(url, Data);
-					strcpy(string_s, "Searching for \"[color=black][u]");
-					strcat(string_s, Data);
-					strcat(string_s, "[/color]\"");
-					ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-					break;
-				case MENU_ID_GLOBAL_3:
-					if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_NAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start https://www.google.com/search?q=");
-					strcat(url, Data);
-					strcpy(string_s, "Searching for \"[color=black][u]");
-					strcat(string_s, Data);
-					strcat(string_s, "[/color]\"");
-					ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-					free(Data);
-					break;
-				case MENU_ID_GLOBAL_4:
-					if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_IP, &Data) == ERROR_ok) {
-						if (!Data || Data[0] == '\0') {
-							if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, 76, &Data) == ERROR_ok) {
-								if (!Data || Data[0] == '\0') {
-									ts3Functions.getConnectionVariableAsString(serverConnectionHandlerID, myID, 6, &Data);
-								}
-							}
-						}
-					}
-					strcpy(url, "start http://www.tsviewer.com/index.php?page=search^&action=ausgabe^&suchbereich=ip^&suchinhalt=");
-					strcat(url, Data);
-					strcpy(string_s, "Searching for \"[color=black][u]");
-					strcat(string_s, Data);
-					strcat(string_s, "[/color]\"");
-					ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-					break;
-				case MENU_ID_GLOBAL_5:
-					if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_IP, &Data) == ERROR_ok) {
-						if (!Data || Data[0] == '\0') {
-							if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, 76, &Data) == ERROR_ok) {
-								if (!Data || Data[0] == '\0') {
-									ts3Functions.getConnectionVariableAsString(serverConnectionHandlerID, myID, 6, &Data);
-								}
-							}
-						}
-					}
-					strcpy(url, "start http://www.gametracker.com/search/?query=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-					break;
-				case MENU_ID_GLOBAL_6:
-					if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_IP, &Data) == ERROR_ok) {
-						if (!Data || Data[0] == '\0') {
-							if (ts3Functions.getServerVariableAsString(serverConnectionHandlerID, 76, &Data) == ERROR_ok) {
-								if (!Data || Data[0] == '\0') {
-									ts3Functions.getConnectionVariableAsString(serverConnectionHandlerID, myID, 6, &Data);
-								}
-							}
-						}
-					}
-					strcpy(url, "start https://www.google.com/search?q=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-					break;
-				case MENU_ID_GLOBAL_7:
-					MessageBoxA(0, PLUGIN_NAME " v" PLUGIN_VERSION " developed by " PLUGIN_AUTHOR " (" PLUGIN_CONTACT ")", "About " PLUGIN_NAME, MB_ICONINFORMATION);
-					break;
-				default:
-					break;
+			break;
+		case PROVIDER_SOURCE_CLIENT_UID:
+			if(ts3Functions.getClientVariableAsString(serverConnectionHandlerID, (anyID)selectedItemID, CLIENT_UNIQUE_IDENTIFIER, &data) != ERROR_ok) {
+				return 1;
 			}
 			break;
-		case PLUGIN_MENU_TYPE_CLIENT:
-			switch (menuItemID) {
-				case MENU_ID_CLIENT_1:
-					if (ts3Functions.getClientVariableAsString(serverConnectionHandlerID, selectedItemID, CLIENT_NICKNAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start http://www.tsviewer.com/index.php?page=search^&action=ausgabe_user^&nickname=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-					break;
-				case MENU_ID_CLIENT_2:
-					if (ts3Functions.getClientVariableAsString(serverConnectionHandlerID, selectedItemID, CLIENT_NICKNAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start http://www.gametracker.com/search/?search_by=online_offline_player^&query=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-					break;
-				case MENU_ID_CLIENT_3:
-					if (ts3Functions.getClientVariableAsString(serverConnectionHandlerID, selectedItemID, CLIENT_NICKNAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start http://ts3index.com/?page=searchclient^&nickname=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-					break;
-				case MENU_ID_CLIENT_4:
-					if (ts3Functions.getClientVariableAsString(serverConnectionHandlerID, selectedItemID, CLIENT_NICKNAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start https://www.google.com/search?q=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-					break;
-				case MENU_ID_CLIENT_5:
-					if (ts3Functions.getClientVariableAsString(serverConnectionHandlerID, selectedItemID, CLIENT_NICKNAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start http://www.gametracker.com/search/?search_by=profile_username^&query=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-					break;
-				case MENU_ID_CLIENT_6:
-					if (ts3Functions.getClientVariableAsString(serverConnectionHandlerID, selectedItemID, CLIENT_UNIQUE_IDENTIFIER, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start http://ts3index.com/?page=searchclient^&uid=");
-					strcat(url, Data);
-					strcpy(string_s, "Searching for \"[color=black][u]");
-					strcat(string_s, Data);
-					strcat(string_s, "[/color]\"");
-					ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-					//if (MessageBox(NULL, ("Text" + clientUID + "more Text").c_str(), "Title", MB_YESNO) == 6)
-					//MessageBoxA(0, "Test", PLUGIN_NAME, MB_ICONINFORMATION);
-					//ShellExecuteA(NULL, "open", url.c_str(), NULL, NULL, SW_SHOWNORMAL);
-					free(Data);
-					break;
-				case MENU_ID_CLIENT_7:
-					if (ts3Functions.getClientVariableAsString(serverConnectionHandlerID, selectedItemID, CLIENT_UNIQUE_IDENTIFIER, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start https://www.google.com/search?q=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-					break;
-				case MENU_ID_CLIENT_8:
-					if (ts3Functions.getClientVariableAsString(serverConnectionHandlerID, selectedItemID, CLIENT_NICKNAME, &Data) != ERROR_ok) {
-						return;
-					}
-					Data = url_encode(Data);
-					strcpy(url, "start http://www.tsviewer.com/index.php?page=search^&action=ausgabe^&suchbereich=ansprechpartner^&suchinhalt=");
-					strcat(url, Data);
-										strcpy(string_s, "Searching for \"[color=black][u]");
-										strcat(string_s, Data);
-										strcat(string_s, "[/color]\"");
-										ts3Functions.printMessageToCurrentTab(string_s);
-					system(url);
-										free(Data);
-										break;
-				case MENU_ID_CLIENT_9:
-					if (ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, selectedItemID, CLIENT_DATABASE_ID, &DataINT) != ERROR_ok) {
-						return;
-					}
-					char d[15];
-					strcpy(url, "start https://www.mtg-esport.de/viewpage.php?page_id=7^&pki=");
-					itoa(DataINT, d,10);
-					
-					strcat(url, d);
-					system(url);
-					//ts3Functions.logMessage(url, LogLevel_DEBUG, "bla", 0);
-					break;
-				default:
-					break;
+		case PROVIDER_SOURCE_CLIENT_DBID:
+			if(ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, (anyID)selectedItemID, CLIENT_DATABASE_ID, &dataInt) != ERROR_ok) {
+				return 1;
+			}
+			snprintf(term, termSize, "%d", dataInt);
+			return 0;
+		case PROVIDER_SOURCE_SERVER_NAME:
+			if(ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_NAME, &data) != ERROR_ok) {
+				return 1;
 			}
 			break;
+		case PROVIDER_SOURCE_SERVER_IP:
+			address = getServerAddress(serverConnectionHandlerID);
+			if(!address) {
+				return 1;
+			}
+			copyTerm(term, termSize, address);
+			return 0;
 		default:
+			return 1;
+	}
+
+	copyTerm(term, termSize, data);
+	ts3Functions.freeMemory(data);
+	return 0;
+}
+
+/*
+ * Adds a section with every client provider search to a search page. terms holds the client's terms indexed by
+ * source, a source is only used if its bit is set in available. The section is headed by the nickname or the UID.
+ */
+static void addClientSearches(struct SearchPage* page, char terms[PROVIDER_SOURCE_COUNT][TERM_BUFSIZE], unsigned int available) {
+	const struct ProviderTable* table = providers_current();
+	char url[SEARCH_URL_BUFSIZE];
+	unsigned int p;
+
+	if(available & (1u << PROVIDER_SOURCE_CLIENT_NICKNAME)) {
+		searchpage_addSection(page, terms[PROVIDER_SOURCE_CLIENT_NICKNAME]);
+	} else {
+		searchpage_addSection(page, terms[PROVIDER_SOURCE_CLIENT_UID]);
+	}
+	for(p = 0; p < table->count; p++) {
+		const struct ProviderTemplate* provider = &table->templates[p];
+		if(provider->source >= PROVIDER_SOURCE_SERVER_NAME || !(available & (1u << provider->source))) {
+			continue;
+		}
+		searchurl_build(provider, terms[provider->source], url);
+		searchpage_addLink(page, provider->text, url);
+	}
+}
+
+/*
+ * Announces a provider search for a term, which must fit TERM_BUFSIZE, and opens its URL. The message comes from scratch.
+ * Returns 0 if the URL was queued for the browser, 1 if not.
+ */
+static int launchSearch(struct Scratch* scratch, const struct ProviderTemplate* provider, const char* term, const char* url) {
+	char* message = scratch_alloc(scratch, MESSAGE_BUFSIZE);
+	stats_ticks started;
+
+	snprintf(message, MESSAGE_BUFSIZE, "Searching for \"[color=black][u]%s[/u][/color]\"", term);
+	ts3Functions.printMessageToCurrentTab(message);
+	started = stats_now();
+	if(launcher_open(url) != 0) {
+		stats_error(searchurl_statsSlot(provider), STATS_ERROR_LAUNCH);
+		return 1;
+	}
+	stats_record(searchurl_statsSlot(provider), STATS_STAGE_LAUNCH, started);
+	return 0;
+}
+
+static void openSearch(struct Scratch* scratch, const struct ProviderTemplate* provider, const char* term) {
+	char* url = scratch_alloc(scratch, SEARCH_URL_BUFSIZE);
+
+	searchurl_build(provider, term, url);
+	launchSearch(scratch, provider, term, url);
+}
+
+/*
+ * Writes one local page with every client search for all clients in a channel and opens it with a single launch.
+ * Each term is fetched once per client and shared by all providers using it.
+ */
+static void searchChannelClients(uint64 serverConnectionHandlerID, uint64 channelID) {
+	static const enum ProviderSource clientSources[] = { PROVIDER_SOURCE_CLIENT_NICKNAME, PROVIDER_SOURCE_CLIENT_UID, PROVIDER_SOURCE_CLIENT_DBID };
+	anyID* clients;
+	char* channelName;
+	char configPath[PATH_BUFSIZE];
+	char title[MESSAGE_BUFSIZE];
+	char message[MESSAGE_BUFSIZE];
+	char terms[PROVIDER_SOURCE_COUNT][TERM_BUFSIZE];
+	struct SearchPage page;
+	unsigned int available;
+	int count = 0;
+	size_t i, s;
+
+	if(ts3Functions.getChannelClientList(serverConnectionHandlerID, channelID, &clients) != ERROR_ok) {
+		showMessage("Cant get the clients of this channel.", PLUGIN_NAME " - Error", 1);
+		return;
+	}
+	if(ts3Functions.getChannelVariableAsString(serverConnectionHandlerID, channelID, CHANNEL_NAME, &channelName) == ERROR_ok) {
+		snprintf(title, MESSAGE_BUFSIZE, "Clients in %.200s", channelName);
+		ts3Functions.freeMemory(channelName);
+	} else {
+		_strcpy(title, MESSAGE_BUFSIZE, "Clients in channel");
+	}
+
+	ts3Functions.getConfigPath(configPath, PATH_BUFSIZE);
+	if(searchpage_begin(&page, configPath, CHANNEL_PAGE_FILENAME, title) != 0) {
+		ts3Functions.freeMemory(clients);
+		showMessage("Cant write the search page to the config directory.", PLUGIN_NAME " - Error", 1);
+		return;
+	}
+
+	for(i = 0; clients[i]; i++) {
+		available = 0;
+		for(s = 0; s < sizeof(clientSources) / sizeof(clientSources[0]); s++) {
+			if(getSearchTerm(serverConnectionHandlerID, clientSources[s], clients[i], terms[clientSources[s]], TERM_BUFSIZE) == 0) {
+				available |= 1u << clientSources[s];
+			}
+		}
+		if(!(available & (1u << PROVIDER_SOURCE_CLIENT_NICKNAME))) {
+			continue;
+		}
+		addClientSearches(&page, terms, available);
+		count++;
+	}
+	ts3Functions.freeMemory(clients);
+
+	if(searchpage_end(&page) != 0) {
+		showMessage("Cant write the search page to the config directory.", PLUGIN_NAME " - Error", 1);
+		return;
+	}
+	snprintf(message, MESSAGE_BUFSIZE, "Opening searches for %d clients", count);
+	ts3Functions.printMessageToCurrentTab(message);
+	launcher_open(page.path);
+}
+
+void ts3plugin_onMenuItemEvent(uint64 serverConnectionHandlerID, enum PluginMenuType type, int menuItemID, uint64 selectedItemID) {
+	const struct SearchProvider* provider;
+	const struct ProviderTable* table;
+	const struct ProviderTemplate* search;
+	stats_ticks started;
+	anyID myID;
+	char scratchBuffer[SCRATCH_BUFSIZE];  /* All temporary buffers of a search, no heap allocations */
+	struct Scratch scratch;
+	char* term;
+	char* url;
+
+	clientqueue_run();
+
+	if(type == PLUGIN_MENU_TYPE_GLOBAL && menuItemID == MENU_ID_GLOBAL_ABOUT) {
+		showMessage(PLUGIN_NAME " v" PLUGIN_VERSION " developed by " PLUGIN_AUTHOR " (" PLUGIN_CONTACT ")", "About " PLUGIN_NAME, 0);
+		return;
+	}
+
+	if(type == PLUGIN_MENU_TYPE_CHANNEL && menuItemID == MENU_ID_CHANNEL_SEARCH_CLIENTS) {
+		searchChannelClients(serverConnectionHandlerID, selectedItemID);
+		return;
+	}
+
+	provider = providers_find(menuItemID);
+	if(!provider || provider->menuType != type) {
+		return;
+	}
+
+	if(type == PLUGIN_MENU_TYPE_GLOBAL && ts3Functions.getClientID(serverConnectionHandlerID, &myID) != ERROR_ok) {
+		showMessage("Cant get your clientID. Are you connected to a server?", PLUGIN_NAME " - Error", 1);
+		return;
+	}
+
+	scratch_init(&scratch, scratchBuffer, SCRATCH_BUFSIZE);
+	term = scratch_alloc(&scratch, TERM_BUFSIZE);
+	started = stats_now();
+	if(getSearchTerm(serverConnectionHandlerID, provider->source, selectedItemID, term, TERM_BUFSIZE) != 0) {
+		stats_error((unsigned int)menuItemID - 1, STATS_ERROR_TERM);
+		return;
+	}
+	stats_record((unsigned int)menuItemID - 1, STATS_STAGE_TERM, started);
+
+	/*
+	 * Double clicks and repeated menu use are dropped, the same search shortly after reuses its URL.
+	 * Only searches that reached the launcher are remembered, a retry of one that did not is opened.
+	 */
+	table = providers_current();
+	search = providers_template(table, menuItemID);
+	url = scratch_alloc(&scratch, SEARCH_URL_BUFSIZE);
+	switch(recent_lookup(menuItemID, table->generation, term, url, SEARCH_URL_BUFSIZE)) {
+	case RECENT_DUPLICATE:
+		return;
+	case RECENT_HIT:
+		if(launchSearch(&scratch, search, term, url) != 0) {
+			recent_forget(menuItemID, term);
+		}
+		break;
+	default:
+		searchurl_build(search, term, url);
+		if(launchSearch(&scratch, search, term, url) == 0) {
+			recent_store(menuItemID, table->generation, term, url);
+		}
+		break;
+	}
+}
+
+/************************** Offline client resolution ***************************/
+
+/* Prints what is known about a resolved client and opens a page with all client searches for it */
+static void openResolvedClient(uint64 serverConnectionHandlerID, const struct ResolvedClient* client) {
+	char configPath[PATH_BUFSIZE];
+	char message[MESSAGE_BUFSIZE];
+	char terms[PROVIDER_SOURCE_COUNT][TERM_BUFSIZE];
+	unsigned int available = (1u << PROVIDER_SOURCE_CLIENT_UID) | (1u << PROVIDER_SOURCE_CLIENT_DBID);
+	struct SearchPage page;
+
+	copyTerm(terms[PROVIDER_SOURCE_CLIENT_UID], TERM_BUFSIZE, client->uid);
+	snprintf(terms[PROVIDER_SOURCE_CLIENT_DBID], TERM_BUFSIZE, "%llu", (unsigned long long)client->databaseID);
+	if(client->nickname[0]) {
+		copyTerm(terms[PROVIDER_SOURCE_CLIENT_NICKNAME], TERM_BUFSIZE, client->nickname);
+		available |= 1u << PROVIDER_SOURCE_CLIENT_NICKNAME;
+	}
+
+	snprintf(message, MESSAGE_BUFSIZE, "%s: nickname \"%s\", database ID %s", client->uid, client->nickname, terms[PROVIDER_SOURCE_CLIENT_DBID]);
+	ts3Functions.printMessageToCurrentTab(message);
+
+	ts3Functions.getConfigPath(configPath, PATH_BUFSIZE);
+	if(searchpage_begin(&page, configPath, CLIENT_PAGE_FILENAME, "Client searches") != 0) {
+		showMessage("Cant write the search page to the config directory.", PLUGIN_NAME " - Error", 1);
+		return;
+	}
+	addClientSearches(&page, terms, available);
+	if(searchpage_end(&page) == 0) {
+		launcher_open(page.path);
+	}
+}
+
+/*
+ * Resolves a client by UID or database ID and opens its searches. Cached results are used right away, otherwise
+ * the name is requested from the server and the searches open when the reply is confirmed in onServerErrorEvent.
+ */
+static void resolveClient(uint64 serverConnectionHandlerID, enum ResolverKey keyType, const char* uid, uint64 databaseID) {
+	const struct ResolvedClient* client;
+	struct ResolverRequest request;
+	unsigned int error;
+	time_t now = time(NULL);
+
+	client = keyType == RESOLVER_KEY_UID ? resolver_findUid(serverConnectionHandlerID, uid, now) : resolver_findDatabaseID(serverConnectionHandlerID, databaseID, now);
+	if(client && (client->nickname[0] || keyType == RESOLVER_KEY_DATABASE_ID)) {
+		openResolvedClient(serverConnectionHandlerID, client);
+		return;
+	}
+	if(!pluginID) {
+		return;
+	}
+
+	memset(&request, 0, sizeof(request));
+	request.serverConnectionHandlerID = serverConnectionHandlerID;
+	request.keyType = keyType;
+	request.databaseID = databaseID;
+	request.issuedAt = now;
+	if(uid) {
+		copyTerm(request.uid, RESOLVER_UID_BUFSIZE, uid);
+	}
+	ts3Functions.createReturnCode(pluginID, request.returnCode, RESOLVER_RETURNCODE_BUFSIZE);
+	if(resolver_addRequest(&request) != 0) {
+		ts3Functions.printMessageToCurrentTab("Too many lookups in progress, try again in a moment.");
+		return;
+	}
+
+	if(keyType == RESOLVER_KEY_UID) {
+		error = ts3Functions.requestClientNamefromUID(serverConnectionHandlerID, uid, request.returnCode);
+	} else {
+		error = ts3Functions.requestClientNamefromDBID(serverConnectionHandlerID, databaseID, request.returnCode);
+	}
+	if(error != ERROR_ok) {
+		resolver_takeRequest(request.returnCode, &request);
+		ts3Functions.printMessageToCurrentTab("Cant send the lookup to the server. Are you connected?");
+	}
+}
+
+/* Finishes a resolver request once the server confirmed or rejected it. Returns 1 if the return code was ours. */
+static int finishResolveRequest(const char* returnCode, unsigned int error, const char* errorMessage) {
+	const struct ResolvedClient* client;
+	struct ResolverRequest request;
+	char message[MESSAGE_BUFSIZE];
+	time_t now = time(NULL);
+
+	if(resolver_takeRequest(returnCode, &request) != 0) {
+		return 0;
+	}
+	client = request.keyType == RESOLVER_KEY_UID ? resolver_findUid(request.serverConnectionHandlerID, request.uid, now)
+	                                             : resolver_findDatabaseID(request.serverConnectionHandlerID, request.databaseID, now);
+	if(error == ERROR_ok && client) {
+		openResolvedClient(request.serverConnectionHandlerID, client);
+	} else {
+		snprintf(message, MESSAGE_BUFSIZE, "[color=red]Lookup failed: %.200s[/color]", error == ERROR_ok ? "no such client" : errorMessage);
+		ts3Functions.printMessageToCurrentTab(message);
+	}
+	return 1;
+}
+
+/************************** Chat commands ***************************/
+
+struct PluginCommand {
+	const char* name;
+	const char* usage;
+	void (*handler)(uint64 serverConnectionHandlerID, const char* args);
+};
+
+static void commandUid(uint64 serverConnectionHandlerID, const char* args) {
+	if(*args == '\0') {
+		ts3Functions.printMessageToCurrentTab("Usage: /searchby uid <unique id>");
+		return;
+	}
+	resolveClient(serverConnectionHandlerID, RESOLVER_KEY_UID, args, 0);
+}
+
+static void commandDbid(uint64 serverConnectionHandlerID, const char* args) {
+	char* end;
+	unsigned long long databaseID = strtoull(args, &end, 10);
+	if(end == args || *end != '\0') {
+		ts3Functions.printMessageToCurrentTab("Usage: /searchby dbid <database id>");
+		return;
+	}
+	resolveClient(serverConnectionHandlerID, RESOLVER_KEY_DATABASE_ID, NULL, (uint64)databaseID);
+}
+
+static void commandSeen(uint64 serverConnectionHandlerID, const char* args) {
+	const struct SeenRecord* record;
+	char message[MESSAGE_BUFSIZE];
+	int index, count = 0;
+
+	for(index = seenindex_findUid(args, -1); index >= 0; index = seenindex_findUid(args, index)) {
+		record = seenindex_get((unsigned int)index);
+		if(!record) {
+			break;
+		}
+		snprintf(message, MESSAGE_BUFSIZE, "\"%s\" (database ID %llu) on server %s, seen %u times",
+		         record->nickname, (unsigned long long)record->databaseID, record->serverUid, record->sightings);
+		ts3Functions.printMessageToCurrentTab(message);
+		count++;
+	}
+	if(count == 0) {
+		ts3Functions.printMessageToCurrentTab("This UID has not been seen yet.");
+	}
+}
+
+/* Indexes the nicknames of all seen users, on first use. From then on recordSighting keeps it current. */
+static void buildNickIndex() {
+	const struct SeenRecord* record;
+	unsigned int index;
+
+	for(index = 0; (record = seenindex_get(index)) != NULL; index++) {
+		nickindex_add(record->nickname, index);
+	}
+	nickIndexBuilt = 1;
+}
+
+/* Edit distance allowed for a fuzzy nickname search, more typos are likely in longer nicknames */
+static unsigned int nickDistance(size_t length) {
+	return length <= 4 ? 1 : length <= 8 ? 2 : 3;
+}
+
+static void commandNick(uint64 serverConnectionHandlerID, const char* args) {
+	struct NickMatch matches[NICK_MATCH_COUNT];
+	const struct SeenRecord* record;
+	char message[MESSAGE_BUFSIZE];
+	size_t length = strlen(args);
+	int count, i;
+
+	if(length == 0) {
+		ts3Functions.printMessageToCurrentTab("Usage: /searchby nick <nickname>");
+		return;
+	}
+	if(!nickIndexBuilt) {
+		buildNickIndex();
+	}
+
+	count = nickindex_search(args, nickDistance(length), matches, NICK_MATCH_COUNT);
+	for(i = 0; i < count; i++) {
+		record = seenindex_get(nickindex_tag(matches[i].id));
+		if(!record) {
+			continue;
+		}
+		snprintf(message, MESSAGE_BUFSIZE, "\"%s\" (UID %s, %u edits away)", record->nickname, record->uid, matches[i].distance);
+		ts3Functions.printMessageToCurrentTab(message);
+	}
+	if(count == 0) {
+		ts3Functions.printMessageToCurrentTab("No similar nickname has been seen yet.");
+	}
+}
+
+/*
+ * Prints the cached clients of one server whose UID is the term or whose nickname skeleton contains
+ * the term's skeleton, at most limit of them. Returns how many were printed.
+ */
+static int findOnServer(uint64 serverConnectionHandlerID, const char* term, const char* skeleton, int limit) {
+	const struct ClientTable* table = clientcache_table(serverConnectionHandlerID);
+	char nickname[CLIENTCACHE_NICKNAME_BUFSIZE];
+	char message[MESSAGE_BUFSIZE];
+	char* serverName = NULL;
+	unsigned int row;
+	int count = 0;
+
+	if(!table) {
+		return 0;
+	}
+	for(row = 0; row < table->count && count < limit; row++) {
+		if(strcmp(table->uids[row], term) != 0) {
+			normalize_nickname(table->nicknames[row], nickname, sizeof(nickname));
+			if(!strstr(nickname, skeleton)) {
+				continue;
+			}
+		}
+		if(count == 0 && ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_NAME, &serverName) != ERROR_ok) {
+			serverName = NULL;
+		}
+		snprintf(message, MESSAGE_BUFSIZE, "%s: \"%s\" (UID %s)", serverName ? serverName : table->serverUid, table->nicknames[row], table->uids[row]);
+		ts3Functions.printMessageToCurrentTab(message);
+		count++;
+	}
+	if(serverName) {
+		ts3Functions.freeMemory(serverName);
+	}
+	return count;
+}
+
+/*
+ * Scans the snapshot cache of every open server tab, one after another. Ten tabs of a thousand
+ * clients take about a millisecond when nothing matches, see find/ in searchby_bench, a small part
+ * of a 16 ms frame. Starting and joining a thread per tab alone costs a third of that, and the
+ * cache belongs to this thread, so a fan-out would gain little over the sequential scan.
+ */
+static void commandFind(uint64 serverConnectionHandlerID, const char* args) {
+	char skeleton[TERM_BUFSIZE];
+	uint64* servers;
+	int count = 0;
+	size_t i;
+
+	if(*args == '\0') {
+		ts3Functions.printMessageToCurrentTab("Usage: /searchby find <nickname or unique id>");
+		return;
+	}
+	if(ts3Functions.getServerConnectionHandlerList(&servers) != ERROR_ok) {
+		return;
+	}
+	normalize_nickname(args, skeleton, sizeof(skeleton));
+	for(i = 0; servers[i] && count < FIND_RESULT_COUNT; i++) {
+		count += findOnServer(servers[i], args, skeleton, FIND_RESULT_COUNT - count);
+	}
+	ts3Functions.freeMemory(servers);
+	if(count == 0) {
+		ts3Functions.printMessageToCurrentTab("No client on any open server matches.");
+	}
+}
+
+/* A UID is the base64 of a 20 byte SHA-1 hash: 28 characters, the last one padding */
+static int looksLikeUid(const char* term) {
+	return strlen(term) == 28 && term[27] == '=';
+}
+
+/* Adds a section for one batch term to the report: the client searches, then what the seen users index knows */
+static void addBatchTerm(struct SearchPage* page, const char* term) {
+	char terms[PROVIDER_SOURCE_COUNT][TERM_BUFSIZE];
+	char text[MESSAGE_BUFSIZE];
+	struct NickMatch matches[BATCH_MATCH_COUNT];
+	const struct SeenRecord* record;
+	int index, count, i;
+
+	if(looksLikeUid(term)) {
+		copyTerm(terms[PROVIDER_SOURCE_CLIENT_UID], TERM_BUFSIZE, term);
+		addClientSearches(page, terms, 1u << PROVIDER_SOURCE_CLIENT_UID);
+		for(index = seenindex_findUid(term, -1); index >= 0; index = seenindex_findUid(term, index)) {
+			record = seenindex_get((unsigned int)index);
+			if(!record) {
+				break;
+			}
+			snprintf(text, MESSAGE_BUFSIZE, "Seen as \"%s\" (database ID %llu) on server %s, %u times",
+			         record->nickname, (unsigned long long)record->databaseID, record->serverUid, record->sightings);
+			searchpage_addText(page, text);
+		}
+		return;
+	}
+
+	copyTerm(terms[PROVIDER_SOURCE_CLIENT_NICKNAME], TERM_BUFSIZE, term);
+	addClientSearches(page, terms, 1u << PROVIDER_SOURCE_CLIENT_NICKNAME);
+	count = nickindex_search(term, nickDistance(strlen(term)), matches, BATCH_MATCH_COUNT);
+	for(i = 0; i < count; i++) {
+		record = seenindex_get(nickindex_tag(matches[i].id));
+		if(!record) {
+			continue;
+		}
+		snprintf(text, MESSAGE_BUFSIZE, "Seen similar nickname \"%s\" (UID %s)", record->nickname, record->uid);
+		searchpage_addText(page, text);
+	}
+}
+
+/*
+ * Streams a file of terms, one per line, into a single search page: each line is read, looked up and
+ * written out before the next is read, so lists of any length need no more memory than one line.
+ */
+static void commandBatch(uint64 serverConnectionHandlerID, const char* args) {
+	char configPath[PATH_BUFSIZE];
+	char line[TERM_BUFSIZE];
+	char message[MESSAGE_BUFSIZE];
+	struct SearchPage page;
+	FILE* file;
+	char* term;
+	size_t length;
+	int count = 0;
+	int c;
+
+	if(*args == '\0') {
+		ts3Functions.printMessageToCurrentTab("Usage: /searchby batch <file>");
+		return;
+	}
+	file = fopen(args, "r");
+	if(!file) {
+		snprintf(message, MESSAGE_BUFSIZE, "Cant open %.400s", args);
+		ts3Functions.printMessageToCurrentTab(message);
+		return;
+	}
+	ts3Functions.getConfigPath(configPath, PATH_BUFSIZE);
+	if(searchpage_begin(&page, configPath, BATCH_PAGE_FILENAME, "Batch searches") != 0) {
+		fclose(file);
+		showMessage("Cant write the search page to the config directory.", PLUGIN_NAME " - Error", 1);
+		return;
+	}
+	if(!nickIndexBuilt) {
+		buildNickIndex();
+	}
+
+	while(fgets(line, sizeof(line), file)) {
+		length = strcspn(line, "\r\n");
+		if(line[length] == '\0' && !feof(file)) {
+			while((c = fgetc(file)) != EOF && c != '\n');  /* Overlong line, the term is cut like any other */
+		}
+		while(length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t')) {
+			length--;
+		}
+		line[length] = '\0';
+		for(term = line; *term == ' ' || *term == '\t'; term++);
+		if(*term == '\0' || *term == '#') {
+			continue;
+		}
+		addBatchTerm(&page, term);
+		count++;
+	}
+	fclose(file);
+
+	if(searchpage_end(&page) != 0) {
+		showMessage("Cant write the search page to the config directory.", PLUGIN_NAME " - Error", 1);
+		return;
+	}
+	snprintf(message, MESSAGE_BUFSIZE, "Opening searches for %d terms", count);
+	ts3Functions.printMessageToCurrentTab(message);
+	launcher_open(page.path);
+}
+
+/*
+ * One inline fetch, owned by the HTTP engine or the cache until fetchDone hands it to the client
+ * thread. The engine thread only fills in the struct, fetchFinish prints and records it.
+ */
+struct Fetch {
+	struct ClientTask task;  /* First member, fetchFinish gets the fetch back from it */
+	char keyword[COMMAND_BUFSIZE];
+	char term[TERM_BUFSIZE];
+	unsigned long long bytes;
+	unsigned int records;
+	unsigned int provider;  /* Statistics slot */
+	stats_ticks started;
+	stats_ticks elapsed;  /* Until the end of the response */
+	enum HttpError error;
+	int status;
+	char title[FETCH_TITLE_BUFSIZE];
+	char lines[FETCH_RECORD_COUNT][MESSAGE_BUFSIZE];  /* The first records, formatted for the chat tab */
+	struct Extractor extractor;  /* Consumes the body as it arrives, nothing of it is kept */
+	const struct ProviderTable* table;  /* Pinned, the extraction profile lives in it */
+};
+
+/* Ends a fetch on the client thread, where the provider table it pinned may be freed now */
+static void fetchRelease(struct Fetch* fetch) {
+	providers_unpin(fetch->table);
+	free(fetch);
+	providers_reclaim();
+}
+
+/* Formats an extracted record, or keeps the page title to print it with the summary */
+static void fetchRecord(void* context, const struct ExtractProfile* profile, const struct ExtractRecord* record) {
+	struct Fetch* fetch = (struct Fetch*)context;
+	char* message;
+	size_t length, needed;
+	unsigned int i;
+
+	if(profile == &titleProfile) {
+		snprintf(fetch->title, FETCH_TITLE_BUFSIZE, "%.*s", FETCH_TITLE_BUFSIZE - 1, record->values[0]);
+		return;
+	}
+	if(++fetch->records > FETCH_RECORD_COUNT) {
+		return;
+	}
+	message = fetch->lines[fetch->records - 1];
+	length = snprintf(message, MESSAGE_BUFSIZE, "%.64s:", fetch->keyword);
+	for(i = 0; i < profile->fieldCount; i++) {
+		if(!(record->present & (1u << i))) {
+			continue;
+		}
+		needed = 1 + strlen(profile->fields[i].name) + 1 + strlen(record->values[i]);
+		if(length + needed >= MESSAGE_BUFSIZE) {
 			break;
+		}
+		length += snprintf(message + length, MESSAGE_BUFSIZE - length, " %s=%s", profile->fields[i].name, record->values[i]);
+	}
+}
+
+static void fetchBody(void* context, const char* data, size_t length) {
+	struct Fetch* fetch = (struct Fetch*)context;
+
+	fetch->bytes += length;
+	extract_feed(&fetch->extractor, data, length);
+}
+
+/* Runs on the client thread: records the fetch in the statistics, prints what it found and frees it */
+static void fetchFinish(struct ClientTask* task, int discard) {
+	struct Fetch* fetch = (struct Fetch*)task;
+	char message[MESSAGE_BUFSIZE];
+	unsigned int i;
+
+	if(discard) {
+		fetchRelease(fetch);
+		return;
+	}
+	if(fetch->error == HTTP_OK && fetch->status < 400) {
+		stats_recordElapsed(fetch->provider, STATS_STAGE_FETCH, fetch->elapsed);
+	} else if(fetch->error != HTTP_ERROR_CANCELLED) {
+		stats_error(fetch->provider, STATS_ERROR_FETCH);
+	}
+	if(fetch->error == HTTP_OK) {
+		for(i = 0; i < fetch->records && i < FETCH_RECORD_COUNT; i++) {
+			ts3Functions.printMessageToCurrentTab(fetch->lines[i]);
+		}
+		if(fetch->extractor.profile == &titleProfile) {
+			snprintf(message, MESSAGE_BUFSIZE, "%.64s \"%.200s\": HTTP %d, %llu bytes, \"%s\"", fetch->keyword, fetch->term, fetch->status, fetch->bytes, fetch->title);
+		} else {
+			snprintf(message, MESSAGE_BUFSIZE, "%.64s \"%.200s\": HTTP %d, %llu bytes, %u records", fetch->keyword, fetch->term, fetch->status, fetch->bytes, fetch->records);
+		}
+		ts3Functions.printMessageToCurrentTab(message);
+	} else if(fetch->error != HTTP_ERROR_CANCELLED) {
+		snprintf(message, MESSAGE_BUFSIZE, "%.64s \"%.200s\": %s", fetch->keyword, fetch->term, http_errorText(fetch->error));
+		ts3Functions.printMessageToCurrentTab(message);
+	}
+	fetchRelease(fetch);
+}
+
+/* Runs on the HTTP engine thread, or right away for cached pages. Calls nothing of the client, the result waits for the client thread. */
+static void fetchDone(void* context, enum HttpError error, int status) {
+	struct Fetch* fetch = (struct Fetch*)context;
+
+	fetch->elapsed = stats_now() - fetch->started;
+	fetch->error = error;
+	fetch->status = status;
+	if(error == HTTP_OK) {
+		extract_end(&fetch->extractor);
 	}
-}
\ No newline at end of file
+	fetch->task.run = fetchFinish;
+	clientqueue_post(&fetch->task);
+}
+
+static const struct HttpHandler fetchHandler = { fetchBody, fetchDone, NULL };
+
+/* Fetches a provider's page for a term in the background instead of opening it in the browser */
+static void commandFetch(uint64 serverConnectionHandlerID, const char* args) {
+	const struct ProviderTable* table;
+	const struct ProviderTemplate* provider;
+	char keyword[COMMAND_BUFSIZE];
+	char url[SEARCH_URL_BUFSIZE];
+	char message[MESSAGE_BUFSIZE];
+	struct Fetch* fetch;
+	const char* term;
+	size_t length = strcspn(args, " ");
+	enum HttpError error;
+
+	for(term = args + length; *term == ' '; term++);
+	if(length == 0 || length >= COMMAND_BUFSIZE || *term == '\0') {
+		ts3Functions.printMessageToCurrentTab("Usage: /searchby fetch <provider> <term>");
+		return;
+	}
+	memcpy(keyword, args, length);
+	keyword[length] = '\0';
+	table = providers_current();
+	provider = providers_findKeyword(table, keyword);
+	if(!provider) {
+		snprintf(message, MESSAGE_BUFSIZE, "Unknown provider %s", keyword);
+		ts3Functions.printMessageToCurrentTab(message);
+		return;
+	}
+
+	fetch = (struct Fetch*)malloc(sizeof(struct Fetch));
+	if(!fetch) {
+		return;
+	}
+	copyTerm(fetch->keyword, COMMAND_BUFSIZE, provider->keyword);
+	copyTerm(fetch->term, TERM_BUFSIZE, term);
+	fetch->bytes = 0;
+	fetch->records = 0;
+	fetch->title[0] = '\0';
+	fetch->table = table;
+	providers_pin(table);
+	extract_begin(&fetch->extractor, provider->profile ? provider->profile : &titleProfile, fetchRecord, fetch);
+	searchurl_build(provider, fetch->term, url);
+	snprintf(message, MESSAGE_BUFSIZE, "Fetching \"[color=black][u]%.200s[/u][/color]\" from %.64s", fetch->term, provider->keyword);
+	ts3Functions.printMessageToCurrentTab(message);
+
+	/* A cached page is handled before this returns, its result is queued like any other and printed right away */
+	fetch->provider = searchurl_statsSlot(provider);
+	fetch->started = stats_now();
+	error = httpcache_get(url, &fetchHandler, fetch);
+	if(error != HTTP_OK) {
+		stats_error(searchurl_statsSlot(provider), STATS_ERROR_FETCH);
+		snprintf(message, MESSAGE_BUFSIZE, "Cant fetch %.64s: %s", provider->keyword, http_errorText(error));
+		ts3Functions.printMessageToCurrentTab(message);
+		providers_unpin(table);
+		free(fetch);
+		return;
+	}
+	clientqueue_run();
+}
+
+/* Shows the recent searches counters, or changes the duplicate window */
+static void commandCache(uint64 serverConnectionHandlerID, const char* args) {
+	struct RecentStats stats;
+	char message[MESSAGE_BUFSIZE];
+	char* end;
+	unsigned long window;
+
+	if(strncmp(args, "window ", 7) == 0) {
+		window = strtoul(args + 7, &end, 10);
+		if(end == args + 7 || *end != '\0') {
+			ts3Functions.printMessageToCurrentTab("Usage: /searchby cache [window <milliseconds> | clear]");
+			return;
+		}
+		recent_setWindow((unsigned int)window);
+	} else if(strcmp(args, "clear") == 0) {
+		recent_clear();
+	} else if(*args) {
+		ts3Functions.printMessageToCurrentTab("Usage: /searchby cache [window <milliseconds> | clear]");
+		return;
+	}
+
+	recent_stats(&stats);
+	snprintf(message, MESSAGE_BUFSIZE, "Recent searches: %u of %u kept, %llu hits, %llu misses, %llu duplicates dropped, %llu evicted, window %u ms",
+	         stats.count, RECENT_CAPACITY, stats.hits, stats.misses, stats.duplicates, stats.evictions, recent_window());
+	ts3Functions.printMessageToCurrentTab(message);
+}
+
+static void printStatsLine(void* context, const char* line) {
+	FILE* file = (FILE*)context;
+
+	ts3Functions.printMessageToCurrentTab(line);
+	if(file) {
+		fprintf(file, "%s\n", line);
+	}
+}
+
+/* Prints the latency percentiles and error counts of every provider, and writes them to a file if one is given */
+static void commandStats(uint64 serverConnectionHandlerID, const char* args) {
+	const char* names[PROVIDER_COUNT + 1];
+	char message[MESSAGE_BUFSIZE];
+	FILE* file = NULL;
+	unsigned int i;
+
+	if(strcmp(args, "clear") == 0) {
+		stats_clear();
+		ts3Functions.printMessageToCurrentTab("Statistics cleared.");
+		return;
+	}
+	if(*args) {
+		file = fopen(args, "w");
+		if(!file) {
+			snprintf(message, MESSAGE_BUFSIZE, "Cant write %.400s", args);
+			ts3Functions.printMessageToCurrentTab(message);
+			return;
+		}
+	}
+	for(i = 0; i < PROVIDER_COUNT; i++) {
+		names[i] = providers[i].keyword;
+	}
+	names[PROVIDER_COUNT] = "custom";
+	if(stats_report(names, PROVIDER_COUNT + 1, printStatsLine, file) == 0) {
+		ts3Functions.printMessageToCurrentTab("No searches recorded yet.");
+	}
+	if(file) {
+		fclose(file);
+		snprintf(message, MESSAGE_BUFSIZE, "Statistics written to %.400s", args);
+		ts3Functions.printMessageToCurrentTab(message);
+	}
+}
+
+static const struct PluginCommand commands[] = {
+	{ "uid",   "uid <unique id> - look up a client by UID, also when offline",                commandUid },
+	{ "dbid",  "dbid <database id> - look up a client by database ID",                        commandDbid },
+	{ "seen",  "seen <unique id> - list the nicknames and servers a UID was seen with",       commandSeen },
+	{ "nick",  "nick <nickname> - list seen users with a similar nickname",                   commandNick },
+	{ "find",  "find <nickname or unique id> - find a client on all open servers",            commandFind },
+	{ "batch", "batch <file> - write one page with the searches for every line of a file",    commandBatch },
+	{ "fetch", "fetch <provider> <term> - fetch a provider's result page and list what it found here", commandFetch },
+	{ "cache", "cache [window <ms> | clear] - show the recent searches counters, or change the double click window", commandCache },
+	{ "stats", "stats [file | clear] - show search latency percentiles and errors per provider, and write them to a file", commandStats }
+};
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+/* Plugin command keyword. Return NULL or "" if not used. */
+const char* ts3plugin_commandKeyword() {
+	return "searchby";
+}
+
+/* Plugin processes console command. Return 0 if plugin handled the command, 1 if not handled. */
+int ts3plugin_processCommand(uint64 serverConnectionHandlerID, const char* command) {
+	const struct ProviderTable* table;
+	const struct ProviderTemplate* provider;
+	char name[COMMAND_BUFSIZE];
+	char message[MESSAGE_BUFSIZE];
+	char scratchBuffer[SCRATCH_BUFSIZE];
+	struct Scratch scratch;
+	const char* args;
+	char* term;
+	size_t length, used, i;
+
+	/* Queued tasks may replace and reclaim tables, so the table is only taken afterwards */
+	clientqueue_run();
+	table = providers_current();
+
+	while(*command == ' ') {
+		command++;
+	}
+	length = strcspn(command, " ");
+	args = command + length;
+	while(*args == ' ') {
+		args++;
+	}
+
+	if(length < COMMAND_BUFSIZE) {
+		memcpy(name, command, length);
+		name[length] = '\0';
+		for(i = 0; i < COMMAND_COUNT; i++) {
+			if(strcmp(name, commands[i].name) == 0) {
+				commands[i].handler(serverConnectionHandlerID, args);
+				return 0;
+			}
+		}
+		provider = providers_findKeyword(table, name);
+		if(provider && *args) {
+			scratch_init(&scratch, scratchBuffer, SCRATCH_BUFSIZE);
+			term = scratch_alloc(&scratch, TERM_BUFSIZE);
+			copyTerm(term, TERM_BUFSIZE, args);
+			openSearch(&scratch, provider, term);
+			return 0;
+		}
+	}
+
+	ts3Functions.printMessageToCurrentTab("Usage:");
+	for(i = 0; i < COMMAND_COUNT; i++) {
+		snprintf(message, MESSAGE_BUFSIZE, "/searchby %s", commands[i].usage);
+		ts3Functions.printMessageToCurrentTab(message);
+	}
+	used = (size_t)snprintf(message, MESSAGE_BUFSIZE, "/searchby <provider> <term> - search a provider, one of:");
+	for(i = 0; i < table->count && used + strlen(table->templates[i].keyword) + 1 < MESSAGE_BUFSIZE; i++) {
+		used += (size_t)snprintf(message + used, MESSAGE_BUFSIZE - used, " %s", table->templates[i].keyword);
+	}
+	ts3Functions.printMessageToCurrentTab(message);
+	return 0;
+}
+
+/************************** Client snapshot cache ***************************/
+
+/* Adds a cached client to the persistent seen users index */
+static void recordSighting(uint64 serverConnectionHandlerID, anyID clientID) {
+	const struct ClientTable* table = clientcache_table(serverConnectionHandlerID);
+	const int row = clientcache_find(serverConnectionHandlerID, clientID);
+	int index;
+
+	if(row < 0) {
+		return;
+	}
+	index = seenindex_record(table->uids[row], table->serverUid, table->nicknames[row], table->databaseIDs[row], (uint64)time(NULL));
+	if(index >= 0 && nickIndexBuilt) {
+		nickindex_add(table->nicknames[row], (unsigned int)index);
+	} else if(index < 0 && seenindex_count() == 0 && nickIndexBuilt) {
+		/* The index was closed after failing to grow, its nicknames no longer point at records */
+		nickindex_clear();
+		nickIndexBuilt = 0;
+	}
+}
+
+/* Queues a cached client's nickname for the protected nicknames check, see protect.h */
+static void checkImpersonation(uint64 serverConnectionHandlerID, anyID clientID) {
+	const struct ClientTable* table = clientcache_table(serverConnectionHandlerID);
+	const int row = clientcache_find(serverConnectionHandlerID, clientID);
+
+	if(row < 0) {
+		return;
+	}
+	if(protect_submit(serverConnectionHandlerID, clientID, table->nicknames[row], table->uids[row]) != 0) {
+		printf("PLUGIN: protect queue full, \"%s\" is not checked\n", table->nicknames[row]);
+	}
+}
+
+/* Reads a client's variables from the client library into the snapshot cache */
+static void cacheClient(uint64 serverConnectionHandlerID, anyID clientID, uint64 channelID) {
+	char* nickname;
+	char* uid;
+	int databaseID;
+
+	if(ts3Functions.getClientVariableAsString(serverConnectionHandlerID, clientID, CLIENT_NICKNAME, &nickname) != ERROR_ok) {
+		return;
+	}
+	if(ts3Functions.getClientVariableAsString(serverConnectionHandlerID, clientID, CLIENT_UNIQUE_IDENTIFIER, &uid) != ERROR_ok) {
+		ts3Functions.freeMemory(nickname);
+		return;
+	}
+	if(ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, clientID, CLIENT_DATABASE_ID, &databaseID) != ERROR_ok) {
+		databaseID = 0;
+	}
+	clientcache_set(serverConnectionHandlerID, clientID, channelID, nickname, uid, (uint64)databaseID);
+	ts3Functions.freeMemory(nickname);
+	ts3Functions.freeMemory(uid);
+	recordSighting(serverConnectionHandlerID, clientID);
+	checkImpersonation(serverConnectionHandlerID, clientID);
+}
+
+/* Fills the snapshot cache with every client visible on a server, used once the connection is established */
+static void cacheServerClients(uint64 serverConnectionHandlerID) {
+	anyID* clients;
+	char* serverUid;
+	uint64 channelID;
+	size_t i;
+
+	clientcache_clearServer(serverConnectionHandlerID);
+	if(ts3Functions.getServerVariableAsString(serverConnectionHandlerID, VIRTUALSERVER_UNIQUE_IDENTIFIER, &serverUid) == ERROR_ok) {
+		clientcache_setServerUid(serverConnectionHandlerID, serverUid);
+		ts3Functions.freeMemory(serverUid);
+	}
+	if(ts3Functions.getClientList(serverConnectionHandlerID, &clients) != ERROR_ok) {
+		return;
+	}
+	for(i = 0; clients[i]; i++) {
+		if(ts3Functions.getChannelOfClient(serverConnectionHandlerID, clients[i], &channelID) == ERROR_ok) {
+			cacheClient(serverConnectionHandlerID, clients[i], channelID);
+		}
+	}
+	ts3Functions.freeMemory(clients);
+}
+
+/* Shared by all events which move a client into, within or out of our view */
+static void trackClientMove(uint64 serverConnectionHandlerID, anyID clientID, uint64 newChannelID, int visibility) {
+	if(visibility == LEAVE_VISIBILITY) {
+		clientcache_remove(serverConnectionHandlerID, clientID);
+	} else if(visibility == ENTER_VISIBILITY || clientcache_setChannel(serverConnectionHandlerID, clientID, newChannelID) != 0) {
+		cacheClient(serverConnectionHandlerID, clientID, newChannelID);
+	}
+}
+
+/* Re-reads a client's nickname after it changed */
+static void refreshClientNickname(uint64 serverConnectionHandlerID, anyID clientID) {
+	const int row = clientcache_find(serverConnectionHandlerID, clientID);
+	char* nickname;
+	uint64 channelID;
+	int changed;
+
+	if(row < 0) {
+		if(ts3Functions.getChannelOfClient(serverConnectionHandlerID, clientID, &channelID) == ERROR_ok) {
+			cacheClient(serverConnectionHandlerID, clientID, channelID);
+		}
+		return;
+	}
+	if(ts3Functions.getClientVariableAsString(serverConnectionHandlerID, clientID, CLIENT_NICKNAME, &nickname) == ERROR_ok) {
+		/* Update events also fire for talk status, away and the like, only a rename is a new sighting to check */
+		changed = strncmp(clientcache_table(serverConnectionHandlerID)->nicknames[row], nickname, CLIENTCACHE_NICKNAME_BUFSIZE - 1) != 0;
+		clientcache_setNickname(serverConnectionHandlerID, clientID, nickname);
+		ts3Functions.freeMemory(nickname);
+		if(changed) {
+			recordSighting(serverConnectionHandlerID, clientID);
+			checkImpersonation(serverConnectionHandlerID, clientID);
+		}
+	}
+}
+
+/************************** TeamSpeak callbacks ***************************/
+
+/*
+ * Callbacks first run what background threads queued for the client thread, see clientqueue.h.
+ * Talk status changes and tab switches have nothing else to do, they are here so results do
+ * not wait long for a callback on a quiet server.
+ */
+
+void ts3plugin_onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus, unsigned int errorNumber) {
+	clientqueue_run();
+
+	/* Reconnects may land on a different address, resolve it again on the next search */
+	addrcache_invalidate(serverConnectionHandlerID);
+
+	if(newStatus == STATUS_CONNECTION_ESTABLISHED) {
+		cacheServerClients(serverConnectionHandlerID);
+	} else if(newStatus == STATUS_DISCONNECTED) {
+		clientcache_clearServer(serverConnectionHandlerID);
+		resolver_clearServer(serverConnectionHandlerID);
+	}
+}
+
+void ts3plugin_onUpdateClientEvent(uint64 serverConnectionHandlerID, anyID clientID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier) {
+	clientqueue_run();
+	refreshClientNickname(serverConnectionHandlerID, clientID);
+}
+
+void ts3plugin_onTalkStatusChangeEvent(uint64 serverConnectionHandlerID, int status, int isReceivedWhisper, anyID clientID) {
+	clientqueue_run();
+}
+
+void ts3plugin_currentServerConnectionChanged(uint64 serverConnectionHandlerID) {
+	clientqueue_run();
+}
+
+void ts3plugin_onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, const char* moveMessage) {
+	clientqueue_run();
+	trackClientMove(serverConnectionHandlerID, clientID, newChannelID, visibility);
+}
+
+void ts3plugin_onClientMoveSubscriptionEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility) {
+	clientqueue_run();
+	trackClientMove(serverConnectionHandlerID, clientID, newChannelID, visibility);
+}
+
+void ts3plugin_onClientMoveTimeoutEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, const char* timeoutMessage) {
+	clientqueue_run();
+	trackClientMove(serverConnectionHandlerID, clientID, newChannelID, visibility);
+}
+
+void ts3plugin_onClientMoveMovedEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID moverID, const char* moverName, const char* moverUniqueIdentifier, const char* moveMessage) {
+	clientqueue_run();
+	trackClientMove(serverConnectionHandlerID, clientID, newChannelID, visibility);
+}
+
+void ts3plugin_onClientKickFromChannelEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, const char* kickMessage) {
+	clientqueue_run();
+	trackClientMove(serverConnectionHandlerID, clientID, newChannelID, visibility);
+}
+
+void ts3plugin_onClientKickFromServerEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, const char* kickMessage) {
+	clientqueue_run();
+	trackClientMove(serverConnectionHandlerID, clientID, newChannelID, visibility);
+}
+
+void ts3plugin_onClientBanFromServerEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, uint64 time, const char* kickMessage) {
+	clientqueue_run();
+	trackClientMove(serverConnectionHandlerID, clientID, newChannelID, visibility);
+}
+
+void ts3plugin_onClientDisplayNameChanged(uint64 serverConnectionHandlerID, anyID clientID, const char* displayName, const char* uniqueClientIdentifier) {
+	/* The display name may be a local alias, the cache keeps the real nickname searches need */
+	clientqueue_run();
+	refreshClientNickname(serverConnectionHandlerID, clientID);
+}
+
+int ts3plugin_onServerErrorEvent(uint64 serverConnectionHandlerID, const char* errorMessage, unsigned int error, const char* returnCode, const char* extraMessage) {
+	clientqueue_run();
+	if(returnCode && finishResolveRequest(returnCode, error, errorMessage)) {
+		return 1;  /* Our own request, the client does not need to show the result */
+	}
+	return 0;  /* Let the client handle everything else */
+}
+
+void ts3plugin_onClientDBIDfromUIDEvent(uint64 serverConnectionHandlerID, const char* uniqueClientIdentifier, uint64 clientDatabaseID) {
+	clientqueue_run();
+	resolver_store(serverConnectionHandlerID, uniqueClientIdentifier, clientDatabaseID, NULL, time(NULL));
+}
+
+void ts3plugin_onClientNamefromUIDEvent(uint64 serverConnectionHandlerID, const char* uniqueClientIdentifier, uint64 clientDatabaseID, const char* clientNickName) {
+	clientqueue_run();
+	resolver_store(serverConnectionHandlerID, uniqueClientIdentifier, clientDatabaseID, clientNickName, time(NULL));
+}
+
+void ts3plugin_onClientNamefromDBIDEvent(uint64 serverConnectionHandlerID, const char* uniqueClientIdentifier, uint64 clientDatabaseID, const char* clientNickName) {
+	clientqueue_run();
+	resolver_store(serverConnectionHandlerID, uniqueClientIdentifier, clientDatabaseID, clientNickName, time(NULL));
+}
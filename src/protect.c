@@ -0,0 +1,429 @@
+/*
+ * Search By - protected nicknames
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "protect.h"
+#include "clientqueue.h"
+#include "editdist.h"
+#include "normalize.h"
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION protect_mutex;
+typedef CONDITION_VARIABLE protect_cond;
+#define mutexInit(m)     InitializeCriticalSection(m)
+#define mutexDestroy(m)  DeleteCriticalSection(m)
+#define mutexLock(m)     EnterCriticalSection(m)
+#define mutexUnlock(m)   LeaveCriticalSection(m)
+#define condInit(c)      InitializeConditionVariable(c)
+#define condDestroy(c)
+#define condWait(c, m)   SleepConditionVariableCS(c, m, INFINITE)
+#define condSignal(c)    WakeConditionVariable(c)
+#else
+typedef pthread_mutex_t protect_mutex;
+typedef pthread_cond_t protect_cond;
+#define mutexInit(m)     pthread_mutex_init(m, NULL)
+#define mutexDestroy(m)  pthread_mutex_destroy(m)
+#define mutexLock(m)     pthread_mutex_lock(m)
+#define mutexUnlock(m)   pthread_mutex_unlock(m)
+#define condInit(c)      pthread_cond_init(c, NULL)
+#define condDestroy(c)   pthread_cond_destroy(c)
+#define condWait(c, m)   pthread_cond_wait(c, m)
+#define condSignal(c)    pthread_cond_signal(c)
+#endif
+
+struct ProtectedName {
+	struct EditPattern pattern;  /* Skeleton of the nickname, used if it does not fit a batch */
+	int batched;
+	size_t skeletonLength;
+	unsigned int maxDistance;
+	char nickname[PROTECT_NICKNAME_BUFSIZE];
+	char uid[PROTECT_UID_BUFSIZE];
+};
+
+/* Four skeletons of similar length compared in one pass, and the names they belong to */
+struct NameBatch {
+	struct EditBatch batch;
+	unsigned int names[EDITDIST_BATCH_LANES];
+	size_t shortest, longest;  /* Skeleton lengths, a nickname further off than PROTECT_MAX_DISTANCE skips the batch */
+};
+
+/* A nickname waiting for the worker */
+struct Job {
+	unsigned long long server;
+	unsigned int client;
+	char nickname[PROTECT_NICKNAME_BUFSIZE];
+	char uid[PROTECT_UID_BUFSIZE];
+};
+
+/* A match on its way to the client thread */
+struct MatchTask {
+	struct ClientTask task;  /* First, the queue hands back this pointer */
+	struct ProtectMatch match;
+};
+
+/* The list, written on the client thread under listMutex and read by the worker under it */
+static struct ProtectedName* names = NULL;
+static unsigned int nameCount = 0;
+static struct NameBatch* batches = NULL;
+static unsigned int batchCount = 0;
+static unsigned int ignoredCount = 0;
+static protect_mutex listMutex;
+
+/* Bounded ring buffer of pending checks, guarded by queueMutex */
+static struct Job queue[PROTECT_QUEUE_SIZE];
+static unsigned int queueHead = 0;
+static unsigned int queueCount = 0;
+static protect_mutex queueMutex;
+static protect_cond queueCond;
+static int running = 0;
+static int stopping = 0;
+static void (*matchCallback)(const struct ProtectMatch* match) = NULL;
+
+#ifdef _WIN32
+static HANDLE worker = NULL;
+#else
+static pthread_t worker;
+#endif
+
+static void copyField(char* dest, size_t destSize, const char* src, size_t length) {
+	if(length >= destSize) {
+		length = destSize - 1;
+	}
+	memcpy(dest, src, length);
+	dest[length] = '\0';
+}
+
+/* Keeps the closest name, the first one listed on a tie */
+static void consider(unsigned int index, unsigned int d, const char* uid, int* found, unsigned int* best) {
+	if(strcmp(names[index].uid, uid) == 0) {
+		return;  /* The real owner */
+	}
+	if(d <= names[index].maxDistance && (d < *best || (d == *best && (int)index < *found))) {
+		*best = d;
+		*found = (int)index;
+	}
+}
+
+/* protect_check with listMutex held */
+static int checkLocked(const char* nickname, const char* uid, unsigned int* distance) {
+	char folded[PROTECT_NICKNAME_BUFSIZE];
+	size_t length;
+	unsigned int distances[EDITDIST_BATCH_LANES];
+	unsigned int i, lane, best = (unsigned int)-1;
+	int found = -1;
+
+	if(nameCount == 0) {
+		return -1;
+	}
+	length = normalize_nickname(nickname, folded, PROTECT_NICKNAME_BUFSIZE);
+	for(i = 0; i < batchCount; ++i) {
+		if(length + PROTECT_MAX_DISTANCE < batches[i].shortest || length > batches[i].longest + PROTECT_MAX_DISTANCE) {
+			continue;
+		}
+		editdist_batch(&batches[i].batch, folded, length, PROTECT_MAX_DISTANCE, distances);
+		for(lane = 0; lane < batches[i].batch.count; ++lane) {
+			consider(batches[i].names[lane], distances[lane], uid, &found, &best);
+		}
+	}
+	for(i = 0; i < nameCount; ++i) {
+		if(!names[i].batched) {
+			consider(i, editdist_bounded(&names[i].pattern, folded, length, names[i].maxDistance), uid, &found, &best);
+		}
+	}
+	if(found >= 0) {
+		*distance = best;
+	}
+	return found;
+}
+
+static void runMatch(struct ClientTask* task, int discard) {
+	struct MatchTask* matchTask = (struct MatchTask*)task;
+
+	if(!discard && matchCallback) {
+		matchCallback(&matchTask->match);
+	}
+	free(matchTask);
+}
+
+/* Checks a job and posts a match to the client thread */
+static void checkJob(const struct Job* job) {
+	struct MatchTask* matchTask;
+	unsigned int distance;
+	int index;
+
+	mutexLock(&listMutex);
+	index = checkLocked(job->nickname, job->uid, &distance);
+	if(index < 0) {
+		mutexUnlock(&listMutex);
+		return;
+	}
+	matchTask = (struct MatchTask*)malloc(sizeof(struct MatchTask));
+	if(!matchTask) {
+		mutexUnlock(&listMutex);
+		return;
+	}
+	strcpy(matchTask->match.protectedName, names[index].nickname);
+	mutexUnlock(&listMutex);
+
+	matchTask->task.run = runMatch;
+	matchTask->match.server = job->server;
+	matchTask->match.client = job->client;
+	strcpy(matchTask->match.nickname, job->nickname);
+	strcpy(matchTask->match.uid, job->uid);
+	matchTask->match.distance = distance;
+	clientqueue_post(&matchTask->task);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI workerMain(LPVOID arg) {
+#else
+static void* workerMain(void* arg) {
+#endif
+	struct Job job;
+
+	for(;;) {
+		mutexLock(&queueMutex);
+		while(queueCount == 0 && !stopping) {
+			condWait(&queueCond, &queueMutex);
+		}
+		if(stopping) {
+			mutexUnlock(&queueMutex);
+			break;
+		}
+		job = queue[queueHead];
+		queueHead = (queueHead + 1) % PROTECT_QUEUE_SIZE;
+		queueCount--;
+		mutexUnlock(&queueMutex);
+
+		checkJob(&job);
+	}
+	return 0;
+}
+
+int protect_init(void (*onMatch)(const struct ProtectMatch* match)) {
+	if(running) {
+		return 0;
+	}
+	matchCallback = onMatch;
+	queueHead = 0;
+	queueCount = 0;
+	stopping = 0;
+	mutexInit(&listMutex);
+	mutexInit(&queueMutex);
+	condInit(&queueCond);
+
+#ifdef _WIN32
+	worker = CreateThread(NULL, 0, workerMain, NULL, 0, NULL);
+	if(!worker) {
+#else
+	if(pthread_create(&worker, NULL, workerMain, NULL) != 0) {
+#endif
+		printf("PLUGIN: protect: failed to start worker thread\n");
+		condDestroy(&queueCond);
+		mutexDestroy(&queueMutex);
+		mutexDestroy(&listMutex);
+		return 1;
+	}
+	running = 1;
+	return 0;
+}
+
+void protect_shutdown() {
+	if(!running) {
+		return;
+	}
+	mutexLock(&queueMutex);
+	stopping = 1;
+	condSignal(&queueCond);
+	mutexUnlock(&queueMutex);
+
+#ifdef _WIN32
+	WaitForSingleObject(worker, INFINITE);
+	CloseHandle(worker);
+	worker = NULL;
+#else
+	pthread_join(worker, NULL);
+#endif
+	condDestroy(&queueCond);
+	mutexDestroy(&queueMutex);
+	mutexDestroy(&listMutex);
+
+	free(names);
+	free(batches);
+	names = NULL;
+	batches = NULL;
+	nameCount = 0;
+	batchCount = 0;
+	ignoredCount = 0;
+	running = 0;
+}
+
+/* Adds a line to a list being built. Returns 0 on success or if the line is ignored, 1 if out of memory. */
+static int addName(struct ProtectedName** list, unsigned int* count, unsigned int* capacity, const char* line) {
+	char folded[PROTECT_NICKNAME_BUFSIZE];
+	struct ProtectedName* name;
+	const size_t nicknameLength = strcspn(line, "\t");
+	const char* uid = line[nicknameLength] ? line + nicknameLength + 1 : "";
+	size_t length;
+
+	if(nicknameLength == 0 || uid[0] == '\0') {
+		ignoredCount++;
+		return 0;
+	}
+	if(*count == *capacity) {
+		unsigned int newCapacity = *capacity ? *capacity * 2 : 16;
+		struct ProtectedName* p = (struct ProtectedName*)realloc(*list, newCapacity * sizeof(struct ProtectedName));
+		if(!p) {
+			return 1;
+		}
+		*list = p;
+		*capacity = newCapacity;
+	}
+	name = &(*list)[*count];
+	copyField(name->nickname, PROTECT_NICKNAME_BUFSIZE, line, nicknameLength);
+	copyField(name->uid, PROTECT_UID_BUFSIZE, uid, strlen(uid));
+	length = normalize_nickname(name->nickname, folded, PROTECT_NICKNAME_BUFSIZE);
+	editdist_compile(&name->pattern, folded, length);
+	name->skeletonLength = length;
+	name->batched = length > 0 && length <= EDITDIST_BATCH_MAX;
+	name->maxDistance = length <= 4 ? 1 : PROTECT_MAX_DISTANCE;
+	(*count)++;
+	return 0;
+}
+
+/* Packs the skeletons that fit into batches, shortest first so the lengths in a batch are close. Returns 0 on success, 1 if out of memory. */
+static int buildBatches(const struct ProtectedName* list, unsigned int count, struct NameBatch** result, unsigned int* built) {
+	char folded[PROTECT_NICKNAME_BUFSIZE];
+	struct NameBatch* batch;
+	unsigned int i, fitting = 0;
+	size_t length, target;
+
+	*result = NULL;
+	*built = 0;
+	for(i = 0; i < count; ++i) {
+		fitting += list[i].batched;
+	}
+	if(fitting == 0) {
+		return 0;
+	}
+	*result = (struct NameBatch*)malloc(((fitting + EDITDIST_BATCH_LANES - 1) / EDITDIST_BATCH_LANES) * sizeof(struct NameBatch));
+	if(!*result) {
+		return 1;
+	}
+	batch = *result;
+	editdist_batchClear(&batch->batch);
+	for(target = 1; target <= EDITDIST_BATCH_MAX; ++target) {
+		for(i = 0; i < count; ++i) {
+			if(!list[i].batched || list[i].skeletonLength != target) {
+				continue;
+			}
+			length = normalize_nickname(list[i].nickname, folded, PROTECT_NICKNAME_BUFSIZE);
+			if(batch->batch.count == EDITDIST_BATCH_LANES) {
+				editdist_batchClear(&(++batch)->batch);
+			}
+			if(batch->batch.count == 0) {
+				batch->shortest = length;
+			}
+			batch->longest = length;
+			batch->names[editdist_batchAdd(&batch->batch, folded, length)] = i;
+		}
+	}
+	*built = (unsigned int)(batch - *result) + 1;
+	return 0;
+}
+
+int protect_load(const char* path) {
+	char line[PROTECT_NICKNAME_BUFSIZE + PROTECT_UID_BUFSIZE + 2];
+	struct ProtectedName* newNames = NULL;
+	struct NameBatch* newBatches = NULL;
+	unsigned int newCount = 0, newCapacity = 0, newBatchCount = 0;
+	int failed = 0;
+	FILE* file;
+
+	ignoredCount = 0;
+	file = fopen(path, "r");
+	if(file) {
+		while(!failed && fgets(line, sizeof(line), file)) {
+			line[strcspn(line, "\r\n")] = '\0';
+			if(line[0] == '\0' || line[0] == '#') {
+				continue;
+			}
+			failed = addName(&newNames, &newCount, &newCapacity, line);
+		}
+		fclose(file);
+	}
+	if(!failed) {
+		failed = buildBatches(newNames, newCount, &newBatches, &newBatchCount);
+	}
+	if(failed) {
+		free(newNames);
+		free(newBatches);
+		newNames = NULL;
+		newBatches = NULL;
+		newCount = 0;
+		newBatchCount = 0;
+	}
+
+	mutexLock(&listMutex);
+	free(names);
+	free(batches);
+	names = newNames;
+	nameCount = newCount;
+	batches = newBatches;
+	batchCount = newBatchCount;
+	mutexUnlock(&listMutex);
+	return failed;
+}
+
+int protect_submit(unsigned long long server, unsigned int client, const char* nickname, const char* uid) {
+	struct Job* job;
+
+	/* nameCount is only written by protect_load on this same thread */
+	if(!running || nameCount == 0) {
+		return 0;
+	}
+	mutexLock(&queueMutex);
+	if(stopping || queueCount == PROTECT_QUEUE_SIZE) {
+		mutexUnlock(&queueMutex);
+		return 1;
+	}
+	job = &queue[(queueHead + queueCount) % PROTECT_QUEUE_SIZE];
+	job->server = server;
+	job->client = client;
+	copyField(job->nickname, PROTECT_NICKNAME_BUFSIZE, nickname, strlen(nickname));
+	copyField(job->uid, PROTECT_UID_BUFSIZE, uid, strlen(uid));
+	queueCount++;
+	condSignal(&queueCond);
+	mutexUnlock(&queueMutex);
+	return 0;
+}
+
+int protect_check(const char* nickname, const char* uid, unsigned int* distance) {
+	int found;
+
+	mutexLock(&listMutex);
+	found = checkLocked(nickname, uid, distance);
+	mutexUnlock(&listMutex);
+	return found;
+}
+
+const char* protect_name(int index) {
+	return (index >= 0 && (unsigned int)index < nameCount) ? names[index].nickname : "";
+}
+
+unsigned int protect_count() {
+	return nameCount;
+}
+
+unsigned int protect_ignored() {
+	return ignoredCount;
+}
@@ -0,0 +1,80 @@
+/*
+ * Search By - protected nicknames
+ *
+ * A list of nicknames, usually the server's admins, that other users should not
+ * be able to imitate. It is read from PROTECT_FILENAME in the config directory:
+ * one nickname per line, followed by a tab and the UID of its real owner, who is
+ * never flagged. Lines without a UID are ignored, the owner could not be told
+ * apart from an impersonator. Lines starting with '#' are ignored.
+ *
+ * Nicknames are compared by their normalize_nickname skeleton, so look-alike
+ * characters do not get around the list. Skeletons of up to EDITDIST_BATCH_MAX
+ * bytes are grouped by length and checked four at a time with editdist_batch.
+ *
+ * Joins and renames are only queued by the callbacks. A worker thread checks
+ * them and posts every match to the client thread through clientqueue, so a
+ * join storm never waits on the list. The list is loaded on the client thread
+ * and guarded by a mutex while the worker reads it.
+ */
+
+#ifndef PROTECT_H
+#define PROTECT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PROTECT_FILENAME "search_by_protected.txt"
+#define PROTECT_NICKNAME_BUFSIZE 128
+#define PROTECT_UID_BUFSIZE 32
+#define PROTECT_MAX_DISTANCE 2  /* Short nicknames allow only one edit */
+#define PROTECT_QUEUE_SIZE 1024
+
+struct ProtectMatch {
+	unsigned long long server;
+	unsigned int client;
+	char nickname[PROTECT_NICKNAME_BUFSIZE];
+	char uid[PROTECT_UID_BUFSIZE];
+	char protectedName[PROTECT_NICKNAME_BUFSIZE];
+	unsigned int distance;
+};
+
+/*
+ * Starts the worker thread with an empty list. onMatch is called on the client
+ * thread, from clientqueue_run, for every queued nickname that matched. Returns
+ * 0 on success, 1 on failure. Must be called before any other function.
+ */
+int protect_init(void (*onMatch)(const struct ProtectMatch* match));
+
+/* Stops the worker thread, dropping the checks still queued, and frees the list */
+void protect_shutdown();
+
+/* Replaces the list with the file's contents. A missing file is an empty list. Returns 0 on success, 1 on failure. */
+int protect_load(const char* path);
+
+/*
+ * Queues a nickname for the worker thread and returns immediately. Returns 0 if
+ * it was queued or the list is empty, 1 if the queue is full and it was dropped.
+ */
+int protect_submit(unsigned long long server, unsigned int client, const char* nickname, const char* uid);
+
+/*
+ * Checks a nickname against the list on the calling thread. Returns the index
+ * of the closest protected nickname within its allowed distance and stores the
+ * distance, or returns -1.
+ */
+int protect_check(const char* nickname, const char* uid, unsigned int* distance);
+
+/* Names by index, only valid until the next protect_load */
+const char* protect_name(int index);
+
+unsigned int protect_count();
+
+/* Lines of the last protect_load skipped for lacking a UID */
+unsigned int protect_ignored();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,317 @@
+/*
+ * Search By - search provider registry
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "providers.h"
+
+#ifdef _WIN32
+#define loadTable(p)                      ((struct ProviderTable*)InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL))
+#define storeTable(p, table)              InterlockedExchangePointer((PVOID volatile*)(p), (table))
+#define exchangeTable(p, table)           ((struct ProviderTable*)InterlockedExchangePointer((PVOID volatile*)(p), (table)))
+#define compareExchangeTable(p, old, new) (InterlockedCompareExchangePointer((PVOID volatile*)(p), (new), (old)) == (old))
+#else
+#define loadTable(p)                      __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define storeTable(p, table)              __atomic_store_n(p, table, __ATOMIC_RELEASE)
+#define exchangeTable(p, table)           __atomic_exchange_n(p, table, __ATOMIC_ACQ_REL)
+#define compareExchangeTable(p, old, new) __atomic_compare_exchange_n(p, &(old), new, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#endif
+
+/* Must be kept in menu ID order, providers_find indexes this table directly */
+const struct SearchProvider providers[PROVIDER_COUNT] = {
+	{ MENU_ID_CLIENT_1, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_NICKNAME, PROVIDER_ENCODING_URL,  "tsviewer",           "Nickname (TSViewer)",    "name.png",  PROVIDER_URL("http://www.tsviewer.com/index.php?page=search&action=ausgabe_user&nickname=") },
+	{ MENU_ID_CLIENT_2, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_NICKNAME, PROVIDER_ENCODING_URL,  "gametracker",        "Nickname (GameTracker)", "name.png",  PROVIDER_URL("http://www.gametracker.com/search/?search_by=online_offline_player&query=") },
+	{ MENU_ID_CLIENT_3, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_NICKNAME, PROVIDER_ENCODING_URL,  "ts3index",           "Nickname (TS3Index)",    "name.png",  PROVIDER_URL("http://ts3index.com/?page=searchclient&nickname=") },
+	{ MENU_ID_CLIENT_4, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_NICKNAME, PROVIDER_ENCODING_URL,  "google",             "Nickname (Google)",      "name.png",  PROVIDER_URL("https://www.google.com/search?q=") },
+	{ MENU_ID_CLIENT_5, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_NICKNAME, PROVIDER_ENCODING_URL,  "gtprofile",          "Profile (GameTracker)",  "name.png",  PROVIDER_URL("http://www.gametracker.com/search/?search_by=profile_username&query=") },
+	{ MENU_ID_CLIENT_6, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_UID,      PROVIDER_ENCODING_URL,  "ts3index-uid",       "UID (TS3Index)",         "id.png",    PROVIDER_URL("http://ts3index.com/?page=searchclient&uid=") },
+	{ MENU_ID_CLIENT_7, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_UID,      PROVIDER_ENCODING_URL,  "google-uid",         "UID (Google)",           "id.png",    PROVIDER_URL("https://www.google.com/search?q=") },
+	{ MENU_ID_CLIENT_8, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_NICKNAME, PROVIDER_ENCODING_URL,  "owner",              "Owner (TSViewer)",       "admin.png", PROVIDER_URL("http://www.tsviewer.com/index.php?page=search&action=ausgabe&suchbereich=ansprechpartner&suchinhalt=") },
+	{ MENU_ID_CLIENT_9, PLUGIN_MENU_TYPE_CLIENT, PROVIDER_SOURCE_CLIENT_DBID,     PROVIDER_ENCODING_NONE, "mtg",                "DBID (mtG)",             "id.png",    PROVIDER_URL("https://www.mtg-esport.de/viewpage.php?page_id=7&pki=") },
+	{ MENU_ID_GLOBAL_1, PLUGIN_MENU_TYPE_GLOBAL, PROVIDER_SOURCE_SERVER_NAME,     PROVIDER_ENCODING_URL,  "tsviewer-server",    "Name (TSViewer)",        "name.png",  PROVIDER_URL("http://www.tsviewer.com/index.php?page=search&action=ausgabe&suchbereich=name&suchinhalt=") },
+	{ MENU_ID_GLOBAL_2, PLUGIN_MENU_TYPE_GLOBAL, PROVIDER_SOURCE_SERVER_NAME,     PROVIDER_ENCODING_URL,  "gametracker-server", "Name (GameTracker)",     "name.png",  PROVIDER_URL("http://www.gametracker.com/search/?query=") },
+	{ MENU_ID_GLOBAL_3, PLUGIN_MENU_TYPE_GLOBAL, PROVIDER_SOURCE_SERVER_NAME,     PROVIDER_ENCODING_URL,  "google-server",      "Name (Google)",          "name.png",  PROVIDER_URL("https://www.google.com/search?q=") },
+	{ MENU_ID_GLOBAL_4, PLUGIN_MENU_TYPE_GLOBAL, PROVIDER_SOURCE_SERVER_IP,       PROVIDER_ENCODING_NONE, "tsviewer-ip",        "IP (TSViewer)",          "ip.png",    PROVIDER_URL("http://www.tsviewer.com/index.php?page=search&action=ausgabe&suchbereich=ip&suchinhalt=") },
+	{ MENU_ID_GLOBAL_5, PLUGIN_MENU_TYPE_GLOBAL, PROVIDER_SOURCE_SERVER_IP,       PROVIDER_ENCODING_NONE, "gametracker-ip",     "IP (GameTracker)",       "ip.png",    PROVIDER_URL("http://www.gametracker.com/search/?query=") },
+	{ MENU_ID_GLOBAL_6, PLUGIN_MENU_TYPE_GLOBAL, PROVIDER_SOURCE_SERVER_IP,       PROVIDER_ENCODING_NONE, "google-ip",          "IP (Google)",            "ip.png",    PROVIDER_URL("https://www.google.com/search?q=") }
+};
+
+const struct SearchProvider* providers_find(int menuID) {
+	if(menuID < 1 || menuID >= MENU_ID_PROVIDER_END) {
+		return NULL;
+	}
+	return &providers[menuID - 1];
+}
+
+/* Only replaced by providers_load, read by searches on any thread */
+static struct ProviderTable* current = NULL;
+
+/* Replaced tables linked through their retired field, pushed by providers_load and taken by providers_reclaim */
+static struct ProviderTable* retiredTables = NULL;
+
+/* Of the last table built, only written by providers_load */
+static unsigned long long lastGeneration = 0;
+
+static const char* const sourceNames[PROVIDER_SOURCE_COUNT] = { "nickname", "uid", "dbid", "servername", "ip" };
+
+/* Reads the whole file into a malloc'ed buffer. Returns NULL and a size of 0 if there is no file. */
+static char* readFile(const char* path, size_t* size) {
+	char* content;
+	FILE* file = fopen(path, "rb");
+
+	*size = 0;
+	if(!file) {
+		return NULL;
+	}
+	content = (char*)malloc(PROVIDERS_FILE_MAX + 1);
+	if(content) {
+		*size = fread(content, 1, PROVIDERS_FILE_MAX, file);
+		content[*size] = '\0';
+	}
+	fclose(file);
+	return content;
+}
+
+/* Splits a line at the next tab, returns the field and moves line past it */
+static char* nextField(char** line) {
+	char* field = *line;
+	char* tab = strchr(field, '\t');
+
+	if(tab) {
+		*tab = '\0';
+		*line = tab + 1;
+	} else {
+		*line = field + strlen(field);
+	}
+	return field;
+}
+
+static struct ProviderTemplate* findKeyword(struct ProviderTemplate* templates, unsigned int count, const char* keyword) {
+	unsigned int i;
+
+	for(i = 0; i < count; i++) {
+		if(strcmp(templates[i].keyword, keyword) == 0) {
+			return &templates[i];
+		}
+	}
+	return NULL;
+}
+
+/* Compiles one config line into the table, which has room for it. Returns 0 on success, 1 if the line is invalid. */
+static int compileLine(struct ProviderTable* table, char* line) {
+	struct ProviderTemplate* t;
+	char* keyword = nextField(&line);
+	char* url = nextField(&line);
+	char* sourceName = nextField(&line);
+	char* text = nextField(&line);
+	char* placeholder = strstr(url, PROVIDERS_TERM_PLACEHOLDER);
+	size_t prefixLength = placeholder ? (size_t)(placeholder - url) : strlen(url);
+	const char* suffix = placeholder ? placeholder + sizeof(PROVIDERS_TERM_PLACEHOLDER) - 1 : "";
+	size_t suffixLength = strlen(suffix);
+	int source = PROVIDER_SOURCE_CLIENT_NICKNAME;
+
+	if(*keyword == '\0' || prefixLength == 0 || prefixLength + suffixLength > PROVIDER_URL_MAX) {
+		return 1;
+	}
+	if(*sourceName) {
+		for(source = 0; source < PROVIDER_SOURCE_COUNT && strcmp(sourceNames[source], sourceName) != 0; source++);
+		if(source == PROVIDER_SOURCE_COUNT) {
+			return 1;
+		}
+	}
+
+	t = findKeyword(table->templates, table->count, keyword);
+	if(!t) {
+		t = &table->templates[table->count++];
+		t->menuID = 0;
+		t->source = (enum ProviderSource)source;
+		t->encoding = (source == PROVIDER_SOURCE_CLIENT_DBID || source == PROVIDER_SOURCE_SERVER_IP) ? PROVIDER_ENCODING_NONE : PROVIDER_ENCODING_URL;
+		t->keyword = keyword;
+		t->text = keyword;
+		t->profile = NULL;
+	}
+	if(*text) {
+		t->text = text;
+	}
+	t->prefix = url;
+	t->prefixLength = (unsigned int)prefixLength;
+	t->suffix = suffix;
+	t->suffixLength = (unsigned int)suffixLength;
+	return 0;
+}
+
+/*
+ * Compiles an extraction line into the profile of its provider, taking a new
+ * profile from the table's block if the provider has none yet. Returns 0 on
+ * success, 1 if the line is invalid.
+ */
+static int compileExtract(struct ProviderTable* table, char* line, struct ExtractProfile* profiles, unsigned int* profileCount) {
+	struct ProviderTemplate* t;
+	struct ExtractProfile* profile;
+	char* keyword = nextField(&line);
+	char* name = nextField(&line);
+	char* before = nextField(&line);
+	char* after = nextField(&line);
+
+	t = findKeyword(table->templates, table->count, keyword);
+	if(!t) {
+		return 1;
+	}
+	profile = (struct ExtractProfile*)t->profile;  /* Points into this table's block, still being built */
+	if(!profile) {
+		profile = &profiles[(*profileCount)++];
+		extract_initProfile(profile);
+		t->profile = profile;
+	}
+	return extract_addField(profile, name, before, after);
+}
+
+/* Pushes a table onto the retired list, from any thread */
+static void retire(struct ProviderTable* table) {
+	struct ProviderTable* head;
+
+	if(!table) {
+		return;
+	}
+	do {
+		head = loadTable(&retiredTables);
+		table->retired = head;
+	} while(!compareExchangeTable(&retiredTables, head, table));
+}
+
+int providers_load(const char* path) {
+	struct ProviderTable* table;
+	struct ExtractProfile* profiles;
+	char* content;
+	char* strings;
+	char* line;
+	char* end;
+	size_t size, lineCount = 1, extractCount = 0, i;
+	unsigned int lineNumber = 0, profileCount = 0;
+
+	content = readFile(path, &size);
+	for(i = 0; i < size; i++) {
+		lineCount += content[i] == '\n';
+		extractCount += content[i] == PROVIDERS_EXTRACT_PREFIX && (i == 0 || content[i - 1] == '\n');
+	}
+
+	/* One block: the table, its templates, the extraction profiles, then the file content the templates point into */
+	table = (struct ProviderTable*)malloc(sizeof(struct ProviderTable) + (PROVIDER_COUNT + lineCount) * sizeof(struct ProviderTemplate) +
+		extractCount * sizeof(struct ExtractProfile) + size + 1);
+	if(!table) {
+		free(content);
+		return 1;
+	}
+	table->templates = (struct ProviderTemplate*)(table + 1);
+	table->count = PROVIDER_COUNT;
+	profiles = (struct ExtractProfile*)(table->templates + PROVIDER_COUNT + lineCount);
+	strings = (char*)(profiles + extractCount);
+	if(size) {
+		memcpy(strings, content, size);
+	}
+	strings[size] = '\0';
+	free(content);
+
+	for(i = 0; i < PROVIDER_COUNT; i++) {
+		struct ProviderTemplate* t = &table->templates[i];
+		t->menuID = providers[i].menuID;
+		t->source = providers[i].source;
+		t->encoding = providers[i].encoding;
+		t->keyword = providers[i].keyword;
+		t->text = providers[i].text;
+		t->prefix = providers[i].url;
+		t->prefixLength = (unsigned int)providers[i].urlLength;
+		t->suffix = "";
+		t->suffixLength = 0;
+		t->profile = NULL;
+	}
+
+	for(line = strings; *line; line = end) {
+		end = line + strcspn(line, "\n");
+		if(*end) {
+			*end++ = '\0';
+		}
+		lineNumber++;
+		line[strcspn(line, "\r")] = '\0';
+		if(*line == '\0' || *line == '#') {
+			continue;
+		}
+		if(*line == PROVIDERS_EXTRACT_PREFIX) {
+			if(compileExtract(table, line + 1, profiles, &profileCount) != 0) {
+				printf("PLUGIN: %s:%u: invalid extraction field, ignored\n", path, lineNumber);
+			}
+		} else if(compileLine(table, line) != 0) {
+			printf("PLUGIN: %s:%u: invalid provider, ignored\n", path, lineNumber);
+		}
+	}
+
+	/* The client thread may still be using the old table, it is freed by providers_reclaim on that thread */
+	table->generation = ++lastGeneration;
+	table->pins = 0;
+	retire(exchangeTable(&current, table));
+	return 0;
+}
+
+const struct ProviderTable* providers_current() {
+	return loadTable(&current);
+}
+
+const struct ProviderTemplate* providers_template(const struct ProviderTable* table, int menuID) {
+	if(menuID < 1 || menuID >= MENU_ID_PROVIDER_END) {
+		return NULL;
+	}
+	return &table->templates[menuID - 1];
+}
+
+const struct ProviderTemplate* providers_findKeyword(const struct ProviderTable* table, const char* keyword) {
+	return findKeyword(table->templates, table->count, keyword);
+}
+
+void providers_pin(const struct ProviderTable* table) {
+	((struct ProviderTable*)table)->pins++;
+}
+
+void providers_unpin(const struct ProviderTable* table) {
+	((struct ProviderTable*)table)->pins--;
+}
+
+void providers_reclaim() {
+	struct ProviderTable* table = exchangeTable(&retiredTables, NULL);
+	struct ProviderTable* next;
+
+	for(; table; table = next) {
+		next = table->retired;
+		if(table->pins) {
+			retire(table);
+		} else {
+			free(table);
+		}
+	}
+}
+
+unsigned int providers_retired() {
+	const struct ProviderTable* table;
+	unsigned int count = 0;
+
+	for(table = loadTable(&retiredTables); table; table = table->retired) {
+		count++;
+	}
+	return count;
+}
+
+void providers_free() {
+	struct ProviderTable* table = exchangeTable(&current, NULL);
+	struct ProviderTable* next;
+
+	free(table);
+	for(table = exchangeTable(&retiredTables, NULL); table; table = next) {
+		next = table->retired;
+		free(table);
+	}
+}
@@ -0,0 +1,185 @@
+/*
+ * Search By - search provider registry
+ *
+ * Every search menu item is one entry in a table describing where the search
+ * term comes from, how it is encoded and which URL it is appended to. The
+ * menus and the /searchby chat commands are all driven by this table.
+ *
+ * Searches do not read the table directly but a compiled ProviderTable: the
+ * built-in providers, with URLs overridden and providers added by
+ * PROVIDERS_FILENAME in the config directory. A changed file is compiled into
+ * a new table which then replaces the current one in a single atomic pointer
+ * store, so a search always sees either the old or the new table in full.
+ *
+ * Tables are used by the client thread within one callback, or pinned by work
+ * that outlives it, like a /searchby fetch. A replaced table is kept until
+ * providers_reclaim runs on the client thread between callbacks and finds it
+ * unpinned. Tables get increasing generations, which other modules compare
+ * instead of table addresses, since a freed table's address can come back.
+ *
+ * The menus are static: TeamSpeak asks for them once when the plugin loads,
+ * so they always list the built-in providers with their built-in texts and
+ * icons. The file changes the URLs they open, but adds no menu items; added
+ * providers are only reachable through /searchby and the search pages.
+ *
+ * File format, one provider per line, fields separated by tabs:
+ *   keyword  url  [source]  [menu text]
+ * The term replaces "{term}" in the URL, or is appended if there is none.
+ * A built-in keyword only overrides the URL. Other keywords add a provider
+ * for /searchby and the search pages; source is one of nickname, uid, dbid,
+ * servername or ip and defaults to nickname. Lines starting with '#' are
+ * ignored.
+ *
+ * Lines starting with '@' tell /searchby fetch what to pull out of a
+ * provider's result page, see extract.h:
+ *   @keyword  field  before  after
+ *   @keyword  record  marker
+ * The provider must be built-in or defined on an earlier line.
+ */
+
+#ifndef PROVIDERS_H
+#define PROVIDERS_H
+
+#include <stddef.h>
+#include "plugin_definitions.h"
+#include "extract.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Where a provider takes its search term from */
+enum ProviderSource {
+	PROVIDER_SOURCE_CLIENT_NICKNAME = 0,
+	PROVIDER_SOURCE_CLIENT_UID,
+	PROVIDER_SOURCE_CLIENT_DBID,
+	PROVIDER_SOURCE_SERVER_NAME,
+	PROVIDER_SOURCE_SERVER_IP,
+	PROVIDER_SOURCE_COUNT
+};
+
+/* How the search term is put into the URL */
+enum ProviderEncoding {
+	PROVIDER_ENCODING_NONE = 0,  /* Appended as is, for numbers and addresses */
+	PROVIDER_ENCODING_URL        /* Appended url-encoded */
+};
+
+struct SearchProvider {
+	int menuID;
+	enum PluginMenuType menuType;
+	enum ProviderSource source;
+	enum ProviderEncoding encoding;
+	const char* keyword;  /* Chat command, /searchby <keyword> <term> */
+	const char* text;  /* Menu text */
+	const char* icon;  /* Menu icon */
+	const char* url;   /* The search term is appended to this */
+	size_t urlLength;  /* strlen(url), known at compile time, see PROVIDER_URL */
+};
+
+/* Longest provider URL, checked at compile time for every table entry and when the config file is compiled */
+#define PROVIDER_URL_MAX 128
+
+#define PROVIDERS_FILENAME "search_by_providers.txt"
+#define PROVIDERS_FILE_MAX 65536
+#define PROVIDERS_TERM_PLACEHOLDER "{term}"
+#define PROVIDERS_EXTRACT_PREFIX '@'
+
+/* A provider compiled for building URLs: prefix, the term, then suffix */
+struct ProviderTemplate {
+	int menuID;  /* 0 for providers only defined in the config file */
+	enum ProviderSource source;
+	enum ProviderEncoding encoding;
+	const char* keyword;
+	const char* text;
+	const char* prefix;
+	const char* suffix;
+	unsigned int prefixLength;
+	unsigned int suffixLength;  /* prefixLength + suffixLength <= PROVIDER_URL_MAX */
+	const struct ExtractProfile* profile;  /* Fields of the result page, NULL if none are configured */
+};
+
+struct ProviderTable {
+	struct ProviderTable* retired;  /* Next in the list of replaced tables waiting to be freed */
+	unsigned long long generation;  /* 1 for the first table, one more for each reload */
+	unsigned int pins;  /* Client thread only, see providers_pin */
+	struct ProviderTemplate* templates;  /* The built-in providers first, in menu ID order */
+	unsigned int count;
+};
+
+/*
+ * Expands to the url and urlLength initializers of a table entry. Fails to
+ * compile if the literal is longer than PROVIDER_URL_MAX.
+ */
+#define PROVIDER_URL(s) s, (sizeof(s) - 1) + 0 * sizeof(char[(sizeof(s) - 1 <= PROVIDER_URL_MAX) ? 1 : -1])
+
+/*
+ * Menu IDs for this plugin. Pass these IDs when creating a menuitem to the TS3 client. When the menu item is triggered,
+ * ts3plugin_onMenuItemEvent will be called passing the menu ID of the triggered menu item.
+ * Provider IDs start at 1 and are contiguous, so a provider is found by indexing the table with its menu ID.
+ */
+enum {
+	MENU_ID_CLIENT_1 = 1,
+	MENU_ID_CLIENT_2,
+	MENU_ID_CLIENT_3,
+	MENU_ID_CLIENT_4,
+	MENU_ID_CLIENT_5,
+	MENU_ID_CLIENT_6,
+	MENU_ID_CLIENT_7,
+	MENU_ID_CLIENT_8,
+	MENU_ID_CLIENT_9,
+	MENU_ID_GLOBAL_1,
+	MENU_ID_GLOBAL_2,
+	MENU_ID_GLOBAL_3,
+	MENU_ID_GLOBAL_4,
+	MENU_ID_GLOBAL_5,
+	MENU_ID_GLOBAL_6,
+	MENU_ID_PROVIDER_END,  /* One past the last provider menu ID */
+	MENU_ID_GLOBAL_ABOUT = MENU_ID_PROVIDER_END,
+	MENU_ID_CHANNEL_SEARCH_CLIENTS
+};
+
+#define PROVIDER_COUNT (MENU_ID_PROVIDER_END - 1)
+
+extern const struct SearchProvider providers[PROVIDER_COUNT];
+
+/* Returns the provider for a menu ID, or NULL if the ID does not belong to a provider */
+const struct SearchProvider* providers_find(int menuID);
+
+/*
+ * Compiles the built-in providers and the config file at path into a new table
+ * and makes it current. A missing file means only the built-in providers;
+ * invalid lines are skipped. Returns 0 on success, 1 if the table is unchanged.
+ * Must not be called from two threads at once.
+ */
+int providers_load(const char* path);
+
+/* Returns the current table, never NULL once providers_load succeeded. Safe from any thread. */
+const struct ProviderTable* providers_current();
+
+/* Returns the template of a built-in provider's menu ID, or NULL */
+const struct ProviderTemplate* providers_template(const struct ProviderTable* table, int menuID);
+
+/* Returns the template with the given chat command keyword, or NULL */
+const struct ProviderTemplate* providers_findKeyword(const struct ProviderTable* table, const char* keyword);
+
+/* Keeps a table from being freed after it is replaced, until as many providers_unpin calls. Client thread only. */
+void providers_pin(const struct ProviderTable* table);
+void providers_unpin(const struct ProviderTable* table);
+
+/*
+ * Frees the replaced tables that are not pinned. Only called from the client
+ * thread between callbacks, when no search of the thread holds a table.
+ */
+void providers_reclaim();
+
+/* Replaced tables not freed yet. Client thread only. */
+unsigned int providers_retired();
+
+/* Frees the current and all replaced tables. No search may be running. */
+void providers_free();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * Search By - recent menu searches
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <string.h>
+#include "recent.h"
+
+#define NO_SLOT 0xFFFF
+
+struct RecentEntry {
+	unsigned long long hash;    /* Of menu ID and term, 0 marks a free slot */
+	unsigned long long opened;  /* When the browser was last sent to the URL */
+	unsigned long long generation;  /* Of the provider table the URL was built from */
+	int menuID;
+	unsigned short newer;       /* Use order, towards newest */
+	unsigned short older;
+	char term[RECENT_TERM_BUFSIZE];
+	char url[RECENT_URL_BUFSIZE];
+};
+
+static struct RecentEntry slots[RECENT_SLOTS];
+static unsigned short newest = NO_SLOT;
+static unsigned short oldest = NO_SLOT;
+static unsigned int count = 0;
+static unsigned int window = RECENT_DEFAULT_WINDOW_MS;
+static struct RecentStats stats;
+
+static unsigned long long nowMs() {
+#ifdef _WIN32
+	return GetTickCount64();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000 + (unsigned long long)ts.tv_nsec / 1000000;
+#endif
+}
+
+/* FNV-1a over the menu ID and the term, never 0 */
+static unsigned long long hashSearch(int menuID, const char* term) {
+	unsigned long long hash = 14695981039346656037ULL ^ (unsigned int)menuID;
+
+	hash *= 1099511628211ULL;
+	for(; *term; term++) {
+		hash ^= (unsigned char)*term;
+		hash *= 1099511628211ULL;
+	}
+	return hash ? hash : 1;
+}
+
+static void unlinkSlot(unsigned short slot) {
+	struct RecentEntry* e = &slots[slot];
+
+	if(e->newer != NO_SLOT) slots[e->newer].older = e->older; else newest = e->older;
+	if(e->older != NO_SLOT) slots[e->older].newer = e->newer; else oldest = e->newer;
+}
+
+static void linkNewest(unsigned short slot) {
+	struct RecentEntry* e = &slots[slot];
+
+	e->newer = NO_SLOT;
+	e->older = newest;
+	if(newest != NO_SLOT) slots[newest].newer = slot; else oldest = slot;
+	newest = slot;
+}
+
+/* Moves an entry to another slot, keeping its place in the use order */
+static void relocate(unsigned short from, unsigned short to) {
+	struct RecentEntry* e = &slots[to];
+
+	*e = slots[from];
+	if(e->newer != NO_SLOT) slots[e->newer].older = to; else newest = to;
+	if(e->older != NO_SLOT) slots[e->older].newer = to; else oldest = to;
+	slots[from].hash = 0;
+}
+
+/* Frees a slot, shifting later entries of the probe sequence back so no lookup stops early */
+static void removeSlot(unsigned short slot) {
+	unsigned short hole = slot, next, home;
+
+	unlinkSlot(slot);
+	slots[slot].hash = 0;
+	for(next = (hole + 1) & (RECENT_SLOTS - 1); slots[next].hash; next = (next + 1) & (RECENT_SLOTS - 1)) {
+		home = (unsigned short)(slots[next].hash & (RECENT_SLOTS - 1));
+		/* The entry may fill the hole if its home slot is not between the hole and where it is now */
+		if(((next - home) & (RECENT_SLOTS - 1)) >= ((next - hole) & (RECENT_SLOTS - 1))) {
+			relocate(next, hole);
+			hole = next;
+		}
+	}
+	count--;
+}
+
+/* Returns the slot of a search, or NO_SLOT */
+static unsigned short findSlot(unsigned long long hash, int menuID, const char* term) {
+	unsigned short slot;
+
+	for(slot = (unsigned short)(hash & (RECENT_SLOTS - 1)); slots[slot].hash; slot = (slot + 1) & (RECENT_SLOTS - 1)) {
+		if(slots[slot].hash == hash && slots[slot].menuID == menuID && strcmp(slots[slot].term, term) == 0) {
+			return slot;
+		}
+	}
+	return NO_SLOT;
+}
+
+enum RecentResult recent_lookup(int menuID, unsigned long long generation, const char* term, char* url, size_t urlSize) {
+	unsigned short slot = findSlot(hashSearch(menuID, term), menuID, term);
+	unsigned long long now = nowMs();
+	struct RecentEntry* e;
+	size_t length;
+
+	if(slot == NO_SLOT) {
+		stats.misses++;
+		return RECENT_MISS;
+	}
+	e = &slots[slot];
+	if(e->generation != generation) {  /* Built from providers that were reloaded since */
+		removeSlot(slot);
+		stats.misses++;
+		return RECENT_MISS;
+	}
+	unlinkSlot(slot);
+	linkNewest(slot);
+	if(now - e->opened < window) {
+		stats.duplicates++;
+		return RECENT_DUPLICATE;
+	}
+	length = strlen(e->url);
+	if(length >= urlSize) {
+		stats.misses++;
+		return RECENT_MISS;
+	}
+	memcpy(url, e->url, length + 1);
+	e->opened = now;
+	stats.hits++;
+	return RECENT_HIT;
+}
+
+void recent_store(int menuID, unsigned long long generation, const char* term, const char* url) {
+	unsigned long long hash = hashSearch(menuID, term);
+	size_t termLength = strlen(term), urlLength = strlen(url);
+	unsigned short slot;
+	struct RecentEntry* e;
+
+	if(termLength >= RECENT_TERM_BUFSIZE || urlLength >= RECENT_URL_BUFSIZE) {
+		return;
+	}
+	slot = findSlot(hash, menuID, term);
+	if(slot != NO_SLOT) {
+		removeSlot(slot);
+	} else if(count == RECENT_CAPACITY) {
+		removeSlot(oldest);
+		stats.evictions++;
+	}
+
+	for(slot = (unsigned short)(hash & (RECENT_SLOTS - 1)); slots[slot].hash; slot = (slot + 1) & (RECENT_SLOTS - 1));
+	e = &slots[slot];
+	e->hash = hash;
+	e->opened = nowMs();
+	e->generation = generation;
+	e->menuID = menuID;
+	memcpy(e->term, term, termLength + 1);
+	memcpy(e->url, url, urlLength + 1);
+	linkNewest(slot);
+	count++;
+}
+
+void recent_forget(int menuID, const char* term) {
+	unsigned short slot = findSlot(hashSearch(menuID, term), menuID, term);
+
+	if(slot != NO_SLOT) {
+		removeSlot(slot);
+	}
+}
+
+void recent_setWindow(unsigned int milliseconds) {
+	window = milliseconds;
+}
+
+unsigned int recent_window() {
+	return window;
+}
+
+void recent_stats(struct RecentStats* out) {
+	*out = stats;
+	out->count = count;
+}
+
+void recent_clear() {
+	unsigned int i;
+
+	for(i = 0; i < RECENT_SLOTS; i++) {
+		slots[i].hash = 0;
+	}
+	newest = oldest = NO_SLOT;
+	count = 0;
+	memset(&stats, 0, sizeof(stats));
+}
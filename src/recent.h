@@ -0,0 +1,71 @@
+/*
+ * Search By - recent menu searches
+ *
+ * A small LRU of the searches opened from the menus, keyed by menu ID and the
+ * resolved search term. A search repeated within the duplicate window, like a
+ * double click, is dropped instead of opening another browser tab. Outside the
+ * window the URL is taken from the entry instead of being encoded again.
+ *
+ * Entries live in a fixed open-addressing table with linear probing and are
+ * linked in use order, so lookups, inserts and evicting the least recently used
+ * entry take constant time. An entry only matches the provider table
+ * generation it was built from, a reloaded provider file makes every entry a
+ * miss.
+ *
+ * Only used from the client callback thread, no locking.
+ */
+
+#ifndef RECENT_H
+#define RECENT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RECENT_CAPACITY 64
+#define RECENT_SLOTS 128  /* Power of two, at most half full */
+#define RECENT_TERM_BUFSIZE 256
+#define RECENT_URL_BUFSIZE 1024
+#define RECENT_DEFAULT_WINDOW_MS 2000
+
+enum RecentResult {
+	RECENT_MISS = 0,
+	RECENT_HIT,       /* The URL was copied from the entry */
+	RECENT_DUPLICATE  /* Opened within the duplicate window, nothing is copied */
+};
+
+struct RecentStats {
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long duplicates;
+	unsigned long long evictions;
+	unsigned int count;
+};
+
+/*
+ * Looks up a search. A hit or duplicate makes the entry the most recently
+ * used one, a hit also restarts its duplicate window.
+ */
+enum RecentResult recent_lookup(int menuID, unsigned long long generation, const char* term, char* url, size_t urlSize);
+
+/* Adds a search that missed, evicting the least recently used one if the table is full */
+void recent_store(int menuID, unsigned long long generation, const char* term, const char* url);
+
+/* Drops a search, so the next lookup misses. Used when it could not be opened after all. */
+void recent_forget(int menuID, const char* term);
+
+void recent_setWindow(unsigned int milliseconds);
+unsigned int recent_window();
+
+void recent_stats(struct RecentStats* stats);
+
+/* Forgets all searches and resets the counters */
+void recent_clear();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
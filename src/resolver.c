@@ -0,0 +1,117 @@
+/*
+ * Search By - UID/database ID resolution cache
+ */
+
+#include <string.h>
+#include "resolver.h"
+
+static struct ResolvedClient cache[RESOLVER_CACHE_SIZE];
+static struct ResolverRequest requests[RESOLVER_MAX_PENDING];
+
+static void copyField(char* dest, size_t destSize, const char* src) {
+	size_t length = strlen(src);
+	if(length >= destSize) {
+		length = destSize - 1;
+	}
+	memcpy(dest, src, length);
+	dest[length] = '\0';
+}
+
+static int isFresh(const struct ResolvedClient* entry, time_t now) {
+	return entry->serverConnectionHandlerID != 0 && now - entry->resolvedAt < RESOLVER_TTL_SECONDS;
+}
+
+const struct ResolvedClient* resolver_findUid(uint64 serverConnectionHandlerID, const char* uid, time_t now) {
+	int i;
+	for(i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+		if(cache[i].serverConnectionHandlerID == serverConnectionHandlerID && isFresh(&cache[i], now) && strcmp(cache[i].uid, uid) == 0) {
+			return &cache[i];
+		}
+	}
+	return NULL;
+}
+
+const struct ResolvedClient* resolver_findDatabaseID(uint64 serverConnectionHandlerID, uint64 databaseID, time_t now) {
+	int i;
+	for(i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+		if(cache[i].serverConnectionHandlerID == serverConnectionHandlerID && isFresh(&cache[i], now) && cache[i].databaseID == databaseID) {
+			return &cache[i];
+		}
+	}
+	return NULL;
+}
+
+void resolver_store(uint64 serverConnectionHandlerID, const char* uid, uint64 databaseID, const char* nickname, time_t now) {
+	struct ResolvedClient* entry = NULL;
+	struct ResolvedClient* victim = NULL;
+	int i;
+
+	/* Reuse the entry of the same client, else a free one, else the least recently resolved one */
+	for(i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+		if(cache[i].serverConnectionHandlerID == serverConnectionHandlerID && strcmp(cache[i].uid, uid) == 0) {
+			entry = &cache[i];
+			break;
+		}
+		if(cache[i].serverConnectionHandlerID == 0) {
+			if(!victim || victim->serverConnectionHandlerID != 0) {
+				victim = &cache[i];
+			}
+		} else if(!victim || (victim->serverConnectionHandlerID != 0 && cache[i].resolvedAt < victim->resolvedAt)) {
+			victim = &cache[i];
+		}
+	}
+	if(!entry) {
+		entry = victim;
+		entry->nickname[0] = '\0';
+	}
+
+	entry->serverConnectionHandlerID = serverConnectionHandlerID;
+	copyField(entry->uid, RESOLVER_UID_BUFSIZE, uid);
+	entry->databaseID = databaseID;
+	if(nickname) {
+		copyField(entry->nickname, RESOLVER_NICKNAME_BUFSIZE, nickname);
+	}
+	entry->resolvedAt = now;
+}
+
+int resolver_addRequest(const struct ResolverRequest* request) {
+	int i;
+	for(i = 0; i < RESOLVER_MAX_PENDING; i++) {
+		if(requests[i].serverConnectionHandlerID == 0 || request->issuedAt - requests[i].issuedAt >= RESOLVER_TIMEOUT_SECONDS) {
+			requests[i] = *request;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int resolver_takeRequest(const char* returnCode, struct ResolverRequest* request) {
+	int i;
+	for(i = 0; i < RESOLVER_MAX_PENDING; i++) {
+		if(requests[i].serverConnectionHandlerID != 0 && strcmp(requests[i].returnCode, returnCode) == 0) {
+			*request = requests[i];
+			requests[i].serverConnectionHandlerID = 0;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void resolver_clearServer(uint64 serverConnectionHandlerID) {
+	int i;
+	for(i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+		if(cache[i].serverConnectionHandlerID == serverConnectionHandlerID) {
+			cache[i].serverConnectionHandlerID = 0;
+		}
+	}
+	for(i = 0; i < RESOLVER_MAX_PENDING; i++) {
+		if(requests[i].serverConnectionHandlerID == serverConnectionHandlerID) {
+			requests[i].serverConnectionHandlerID = 0;
+		}
+	}
+}
+
+void resolver_clear() {
+	memset(cache, 0, sizeof(cache));
+	memset(requests, 0, sizeof(requests));
+}
@@ -0,0 +1,80 @@
+/*
+ * Search By - UID/database ID resolution cache
+ *
+ * Results of requestClientNamefromUID, requestClientNamefromDBID and
+ * requestClientDBIDfromUID are cached per server connection for
+ * RESOLVER_TTL_SECONDS, and the requests in flight are remembered by their
+ * return code until the server confirms or rejects them.
+ *
+ * This module only keeps the bookkeeping; plugin.c issues the requests and
+ * feeds the replies in. Only used from the client callback thread, no locking.
+ */
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <time.h>
+#include "public_definitions.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESOLVER_CACHE_SIZE 256
+#define RESOLVER_MAX_PENDING 32
+#define RESOLVER_TTL_SECONDS 600
+#define RESOLVER_TIMEOUT_SECONDS 30
+#define RESOLVER_UID_BUFSIZE 32
+#define RESOLVER_NICKNAME_BUFSIZE 128
+#define RESOLVER_RETURNCODE_BUFSIZE 128
+
+struct ResolvedClient {
+	uint64 serverConnectionHandlerID;  /* 0 = unused entry */
+	char uid[RESOLVER_UID_BUFSIZE];
+	uint64 databaseID;
+	char nickname[RESOLVER_NICKNAME_BUFSIZE];  /* Empty if only the database ID is known */
+	time_t resolvedAt;
+};
+
+enum ResolverKey {
+	RESOLVER_KEY_UID = 0,
+	RESOLVER_KEY_DATABASE_ID
+};
+
+struct ResolverRequest {
+	uint64 serverConnectionHandlerID;  /* 0 = unused slot */
+	char returnCode[RESOLVER_RETURNCODE_BUFSIZE];
+	enum ResolverKey keyType;
+	char uid[RESOLVER_UID_BUFSIZE];    /* Key when keyType is RESOLVER_KEY_UID */
+	uint64 databaseID;                 /* Key when keyType is RESOLVER_KEY_DATABASE_ID */
+	time_t issuedAt;
+};
+
+/* Return a fresh cached result, or NULL if there is none */
+const struct ResolvedClient* resolver_findUid(uint64 serverConnectionHandlerID, const char* uid, time_t now);
+const struct ResolvedClient* resolver_findDatabaseID(uint64 serverConnectionHandlerID, uint64 databaseID, time_t now);
+
+/* Stores a reply. nickname may be NULL if the reply did not include it. */
+void resolver_store(uint64 serverConnectionHandlerID, const char* uid, uint64 databaseID, const char* nickname, time_t now);
+
+/*
+ * Remembers a request sent with the given return code. Requests older than
+ * RESOLVER_TIMEOUT_SECONDS are dropped to make room. Returns 0 on success,
+ * 1 if too many requests are in flight.
+ */
+int resolver_addRequest(const struct ResolverRequest* request);
+
+/* Removes the request with the given return code and copies it to request. Returns 0 if found, 1 if not. */
+int resolver_takeRequest(const char* returnCode, struct ResolverRequest* request);
+
+/* Drops cached results and requests of one server connection */
+void resolver_clearServer(uint64 serverConnectionHandlerID);
+
+/* Drops everything */
+void resolver_clear();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
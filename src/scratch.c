@@ -0,0 +1,25 @@
+/*
+ * Search By - per call scratch memory
+ */
+
+#include "scratch.h"
+
+void scratch_init(struct Scratch* scratch, char* buffer, size_t size) {
+	scratch->base = buffer;
+	scratch->size = size;
+	scratch->used = 0;
+}
+
+char* scratch_alloc(struct Scratch* scratch, size_t size) {
+	char* result;
+
+	if(size > scratch->size - scratch->used) {
+		return NULL;
+	}
+	result = scratch->base + scratch->used;
+	scratch->used += (size + 7) & ~(size_t)7;  /* Keep the next piece 8 byte aligned */
+	if(scratch->used > scratch->size) {
+		scratch->used = scratch->size;
+	}
+	return result;
+}
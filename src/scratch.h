@@ -0,0 +1,33 @@
+/*
+ * Search By - per call scratch memory
+ *
+ * Hands out pieces of a caller provided buffer, usually a local array, so a
+ * callback can get all its temporary buffers without touching the heap.
+ * Everything is released at once when the buffer goes out of scope.
+ */
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct Scratch {
+	char* base;
+	size_t size;
+	size_t used;
+};
+
+void scratch_init(struct Scratch* scratch, char* buffer, size_t size);
+
+/* Returns size bytes of scratch memory, or NULL if the buffer is exhausted */
+char* scratch_alloc(struct Scratch* scratch, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Search By - local HTML result pages
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "searchpage.h"
+
+/* Writes text with the HTML special characters escaped, copying unescaped runs in one go */
+static void writeEscaped(FILE* file, const char* text) {
+	const char* run = text;
+	const char* p;
+
+	for(p = text; *p; p++) {
+		const char* entity;
+		switch(*p) {
+			case '&':  entity = "&amp;";  break;
+			case '<':  entity = "&lt;";   break;
+			case '>':  entity = "&gt;";   break;
+			case '"':  entity = "&quot;"; break;
+			case '\'': entity = "&#39;";  break;
+			default:   continue;
+		}
+		fwrite(run, 1, (size_t)(p - run), file);
+		fputs(entity, file);
+		run = p + 1;
+	}
+	fwrite(run, 1, (size_t)(p - run), file);
+}
+
+int searchpage_begin(struct SearchPage* page, const char* directory, const char* fileName, const char* title) {
+	static char buffer[64 * 1024];  /* Pages are written from the client thread only */
+
+	if(snprintf(page->path, SEARCHPAGE_PATH_BUFSIZE, "%s%s", directory, fileName) >= SEARCHPAGE_PATH_BUFSIZE) {
+		return 1;
+	}
+	page->file = fopen(page->path, "wb");
+	if(!page->file) {
+		return 1;
+	}
+	setvbuf(page->file, buffer, _IOFBF, sizeof(buffer));
+	page->sectionOpen = 0;
+
+	fputs("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>", page->file);
+	writeEscaped(page->file, title);
+	fputs("</title>\n</head>\n<body>\n<h1>", page->file);
+	writeEscaped(page->file, title);
+	fputs("</h1>\n", page->file);
+	return 0;
+}
+
+static void closeSection(struct SearchPage* page) {
+	if(page->sectionOpen) {
+		fputs("</ul>\n", page->file);
+		page->sectionOpen = 0;
+	}
+}
+
+void searchpage_addSection(struct SearchPage* page, const char* heading) {
+	closeSection(page);
+	fputs("<h2>", page->file);
+	writeEscaped(page->file, heading);
+	fputs("</h2>\n<ul>\n", page->file);
+	page->sectionOpen = 1;
+}
+
+void searchpage_addLink(struct SearchPage* page, const char* text, const char* url) {
+	fputs("<li><a href=\"", page->file);
+	writeEscaped(page->file, url);
+	fputs("\">", page->file);
+	writeEscaped(page->file, text);
+	fputs("</a></li>\n", page->file);
+}
+
+void searchpage_addText(struct SearchPage* page, const char* text) {
+	fputs("<li>", page->file);
+	writeEscaped(page->file, text);
+	fputs("</li>\n", page->file);
+}
+
+int searchpage_end(struct SearchPage* page) {
+	int failed;
+
+	closeSection(page);
+	fputs("</body>\n</html>\n", page->file);
+	failed = ferror(page->file);
+	if(fclose(page->file) != 0) {
+		failed = 1;
+	}
+	page->file = NULL;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Search By - local HTML result pages
+ *
+ * Batch searches write all their search links into one local HTML page which
+ * is then opened with a single launch, instead of opening one browser tab per
+ * search.
+ */
+
+#ifndef SEARCHPAGE_H
+#define SEARCHPAGE_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEARCHPAGE_PATH_BUFSIZE 512
+
+struct SearchPage {
+	FILE* file;
+	char path[SEARCHPAGE_PATH_BUFSIZE];
+	int sectionOpen;
+};
+
+/*
+ * Creates (or overwrites) directory/fileName and writes the page header.
+ * directory must end with a path separator, as returned by getConfigPath.
+ * Returns 0 on success, 1 on failure.
+ */
+int searchpage_begin(struct SearchPage* page, const char* directory, const char* fileName, const char* title);
+
+/* Starts a new section, e.g. one per client. Text is HTML-escaped. */
+void searchpage_addSection(struct SearchPage* page, const char* heading);
+
+/* Adds a link to the current section. Text and url are HTML-escaped. */
+void searchpage_addLink(struct SearchPage* page, const char* text, const char* url);
+
+/* Adds a plain text line to the current section. Text is HTML-escaped. */
+void searchpage_addText(struct SearchPage* page, const char* text);
+
+/* Writes the page footer and closes the file. Returns 0 on success, 1 if any write failed. */
+int searchpage_end(struct SearchPage* page);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
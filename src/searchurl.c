@@ -0,0 +1,38 @@
+/*
+ * Search By - search URL building
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "encode.h"
+#include "stats.h"
+#include "searchurl.h"
+
+unsigned int searchurl_statsSlot(const struct ProviderTemplate* provider) {
+	return provider->menuID > 0 ? (unsigned int)provider->menuID - 1 : PROVIDER_COUNT;
+}
+
+/* Prefix and suffix lengths are precomputed by the compiled template, so nothing is scanned for its end */
+size_t searchurl_build(const struct ProviderTemplate* provider, const char* term, char* url) {
+	const size_t termLength = strlen(term);
+	const stats_ticks started = stats_now();
+	stats_ticks encodeStarted;
+	size_t length;
+
+	assert(termLength < SEARCHURL_TERM_BUFSIZE);
+	memcpy(url, provider->prefix, provider->prefixLength);
+	length = provider->prefixLength;
+	if(provider->encoding == PROVIDER_ENCODING_URL) {
+		encodeStarted = stats_now();
+		length += url_encode_into(term, termLength, url + length, SEARCHURL_BUFSIZE - length);
+		stats_record(searchurl_statsSlot(provider), STATS_STAGE_ENCODE, encodeStarted);
+	} else {
+		memcpy(url + length, term, termLength);
+		length += termLength;
+	}
+	memcpy(url + length, provider->suffix, provider->suffixLength);
+	length += provider->suffixLength;
+	url[length] = '\0';
+	stats_record(searchurl_statsSlot(provider), STATS_STAGE_URL, started);
+	return length;
+}
@@ -0,0 +1,39 @@
+/*
+ * Search By - search URL building
+ *
+ * Writes a provider's URL with a search term into a caller's buffer: the
+ * compiled template's prefix, the term encoded in place, then the suffix. The
+ * time taken is recorded in the search statistics of the provider.
+ *
+ * Only used from the client callback thread, like the statistics.
+ */
+
+#ifndef SEARCHURL_H
+#define SEARCHURL_H
+
+#include <stddef.h>
+#include "providers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEARCHURL_TERM_BUFSIZE 256
+
+/* Provider URL plus a fully url-encoded term buffer (every byte becomes %XX) */
+#define SEARCHURL_BUFSIZE (PROVIDER_URL_MAX + 3 * (SEARCHURL_TERM_BUFSIZE - 1) + 1)
+
+/* Statistics slot of a provider, providers only defined in the config file share the last one */
+unsigned int searchurl_statsSlot(const struct ProviderTemplate* provider);
+
+/*
+ * Writes the provider URL with the term into url, which must hold SEARCHURL_BUFSIZE
+ * bytes. The term must fit SEARCHURL_TERM_BUFSIZE. Returns the length of the URL.
+ */
+size_t searchurl_build(const struct ProviderTemplate* provider, const char* term, char* url);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * Search By - persistent index of seen users
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "seenindex.h"
+
+static const char magic[8] = "SBSEEN\0";
+
+/* The mapped file, NULL if closed */
+static char* mapping = NULL;
+static size_t mappingSize = 0;
+#ifdef _WIN32
+static HANDLE file = INVALID_HANDLE_VALUE;
+static HANDLE fileMapping = NULL;
+#else
+static int file = -1;
+#endif
+
+#define HEADER ((struct SeenHeader*)mapping)
+#define BUCKETS ((unsigned int*)(mapping + sizeof(struct SeenHeader)))
+#define RECORDS ((struct SeenRecord*)(mapping + sizeof(struct SeenHeader) + SEENINDEX_BUCKET_COUNT * sizeof(unsigned int)))
+
+typedef char seenRecordIs256Bytes[(sizeof(struct SeenRecord) == 256) ? 1 : -1];
+
+static size_t fileSizeFor(unsigned int recordCapacity) {
+	return sizeof(struct SeenHeader) + SEENINDEX_BUCKET_COUNT * sizeof(unsigned int) + (size_t)recordCapacity * sizeof(struct SeenRecord);
+}
+
+static void unmapFile() {
+	if(!mapping) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(mapping);
+	CloseHandle(fileMapping);
+	fileMapping = NULL;
+#else
+	munmap(mapping, mappingSize);
+#endif
+	mapping = NULL;
+	mappingSize = 0;
+}
+
+/* Maps the file at the given size, growing the file if it is smaller. Returns 0 on success, 1 on failure. */
+static int mapFile(size_t size) {
+#ifdef _WIN32
+	fileMapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)size, NULL);
+	if(!fileMapping) {
+		return 1;
+	}
+	mapping = (char*)MapViewOfFile(fileMapping, FILE_MAP_WRITE, 0, 0, size);
+	if(!mapping) {
+		CloseHandle(fileMapping);
+		fileMapping = NULL;
+		return 1;
+	}
+#else
+	struct stat st;
+	void* p;
+
+	if(fstat(file, &st) != 0) {
+		return 1;
+	}
+	if((size_t)st.st_size < size && ftruncate(file, (off_t)size) != 0) {
+		return 1;
+	}
+	p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if(p == MAP_FAILED) {
+		return 1;
+	}
+	mapping = (char*)p;
+#endif
+	mappingSize = size;
+	return 0;
+}
+
+static int headerIsValid(size_t actualFileSize) {
+	return memcmp(HEADER->magic, magic, sizeof(magic)) == 0 &&
+	       HEADER->version == SEENINDEX_VERSION &&
+	       HEADER->bucketCount == SEENINDEX_BUCKET_COUNT &&
+	       HEADER->recordCount <= HEADER->recordCapacity &&
+	       fileSizeFor(HEADER->recordCapacity) <= actualFileSize;
+}
+
+int seenindex_open(const char* path) {
+	size_t size;
+#ifdef _WIN32
+	LARGE_INTEGER fileSize;
+#else
+	struct stat st;
+#endif
+
+	if(mapping) {
+		return 0;
+	}
+
+#ifdef _WIN32
+	file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE) {
+		return 1;
+	}
+	if(!GetFileSizeEx(file, &fileSize)) {
+		seenindex_close();
+		return 1;
+	}
+	size = (size_t)fileSize.QuadPart;
+#else
+	file = open(path, O_RDWR | O_CREAT, 0644);
+	if(file < 0) {
+		return 1;
+	}
+	if(fstat(file, &st) != 0) {
+		seenindex_close();
+		return 1;
+	}
+	size = (size_t)st.st_size;
+#endif
+
+	/* An existing index is used as is, only its header is looked at */
+	if(size >= fileSizeFor(0)) {
+		if(mapFile(size) != 0) {
+			seenindex_close();
+			return 1;
+		}
+		if(headerIsValid(size)) {
+			return 0;
+		}
+		printf("PLUGIN: seen index %s is invalid, starting a new one\n", path);
+		unmapFile();
+	}
+
+	/* New or unusable file: lay out an empty index. The fresh file area reads as zeros, so all buckets are empty. */
+#ifdef _WIN32
+	SetFilePointer(file, 0, NULL, FILE_BEGIN);
+	SetEndOfFile(file);
+#else
+	if(ftruncate(file, 0) != 0) {
+		seenindex_close();
+		return 1;
+	}
+#endif
+	if(mapFile(fileSizeFor(SEENINDEX_INITIAL_CAPACITY)) != 0) {
+		seenindex_close();
+		return 1;
+	}
+	memcpy(HEADER->magic, magic, sizeof(magic));
+	HEADER->version = SEENINDEX_VERSION;
+	HEADER->bucketCount = SEENINDEX_BUCKET_COUNT;
+	HEADER->recordCount = 0;
+	HEADER->recordCapacity = SEENINDEX_INITIAL_CAPACITY;
+	return 0;
+}
+
+void seenindex_close() {
+	unmapFile();
+#ifdef _WIN32
+	if(file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+#else
+	if(file >= 0) {
+		close(file);
+		file = -1;
+	}
+#endif
+}
+
+/* FNV-1a */
+static unsigned int hashUid(const char* uid) {
+	unsigned int hash = 2166136261u;
+	while(*uid) {
+		hash = (hash ^ (unsigned char)*uid++) * 16777619u;
+	}
+	return hash;
+}
+
+static void copyField(char* dest, size_t destSize, const char* src) {
+	size_t length = strlen(src);
+	if(length >= destSize) {
+		length = destSize - 1;
+	}
+	memcpy(dest, src, length);
+	memset(dest + length, 0, destSize - length);
+}
+
+/* Doubles the record capacity. Returns 0 on success, 1 on failure, in which case the index is closed. */
+static int grow() {
+	const unsigned int capacity = HEADER->recordCapacity * 2;
+	if(capacity < HEADER->recordCapacity) {
+		return 1;
+	}
+	unmapFile();
+	if(mapFile(fileSizeFor(capacity)) != 0) {
+		seenindex_close();
+		return 1;
+	}
+	HEADER->recordCapacity = capacity;
+	return 0;
+}
+
+int seenindex_record(const char* uid, const char* serverUid, const char* nickname, uint64 databaseID, uint64 now) {
+	struct SeenRecord* record;
+	unsigned int bucket, index, limit;
+
+	if(!mapping || !uid[0]) {
+		return -1;
+	}
+
+	bucket = hashUid(uid) & (SEENINDEX_BUCKET_COUNT - 1);
+	for(limit = HEADER->recordCount, index = BUCKETS[bucket]; index && index <= limit; index = record->next) {
+		record = &RECORDS[index - 1];
+		limit = index - 1;
+		if(strncmp(record->uid, uid, SEENINDEX_UID_BUFSIZE - 1) == 0 &&
+		   strncmp(record->serverUid, serverUid, SEENINDEX_UID_BUFSIZE - 1) == 0 &&
+		   strncmp(record->nickname, nickname, SEENINDEX_NICKNAME_BUFSIZE - 1) == 0) {
+			record->sightings++;
+			record->lastSeen = now;
+			if(databaseID) {
+				record->databaseID = databaseID;
+			}
+			return (int)(index - 1);
+		}
+	}
+
+	if(HEADER->recordCount == HEADER->recordCapacity && grow() != 0) {
+		return -1;
+	}
+
+	/* Write the record completely before linking it in, a crash in between only loses this record */
+	index = HEADER->recordCount;
+	record = &RECORDS[index];
+	memset(record, 0, sizeof(struct SeenRecord));
+	copyField(record->uid, SEENINDEX_UID_BUFSIZE, uid);
+	copyField(record->serverUid, SEENINDEX_UID_BUFSIZE, serverUid);
+	copyField(record->nickname, SEENINDEX_NICKNAME_BUFSIZE, nickname);
+	record->databaseID = databaseID;
+	record->firstSeen = now;
+	record->lastSeen = now;
+	record->sightings = 1;
+	record->next = BUCKETS[bucket] <= index ? BUCKETS[bucket] : 0;
+	HEADER->recordCount = index + 1;
+	BUCKETS[bucket] = index + 1;
+	return (int)index;
+}
+
+unsigned int seenindex_count() {
+	return mapping ? HEADER->recordCount : 0;
+}
+
+const struct SeenRecord* seenindex_get(unsigned int index) {
+	if(!mapping || index >= HEADER->recordCount) {
+		return NULL;
+	}
+	return &RECORDS[index];
+}
+
+int seenindex_findUid(const char* uid, int after) {
+	unsigned int index, limit;
+
+	if(!mapping) {
+		return -1;
+	}
+	if(after < 0) {
+		limit = HEADER->recordCount;
+		index = BUCKETS[hashUid(uid) & (SEENINDEX_BUCKET_COUNT - 1)];
+	} else if((unsigned int)after < HEADER->recordCount) {
+		limit = (unsigned int)after;
+		index = RECORDS[after].next;
+	} else {
+		return -1;
+	}
+	for(; index && index <= limit; index = RECORDS[index - 1].next) {
+		if(strncmp(RECORDS[index - 1].uid, uid, SEENINDEX_UID_BUFSIZE - 1) == 0) {
+			return (int)(index - 1);
+		}
+		limit = index - 1;
+	}
+	return -1;
+}
@@ -0,0 +1,84 @@
+/*
+ * Search By - persistent index of seen users
+ *
+ * Every nickname/UID/database ID/server combination the plugin sees is kept in
+ * a file in the config directory, which is memory-mapped instead of read. Opening
+ * it only validates the header, and lookups touch just the pages they need, so
+ * startup time and memory use do not grow with the number of records.
+ *
+ * File layout: a SeenHeader, a hash table of SEENINDEX_BUCKET_COUNT record
+ * indices keyed by UID, then the fixed-size records in the order they were
+ * added. Records of the same bucket are chained through SeenRecord.next.
+ * A bucket only points at existing records and a chain only at older records,
+ * so chains always end. A link breaking that rule, which only a damaged file
+ * can have, ends the chain.
+ *
+ * Only used from the client callback thread, no locking.
+ */
+
+#ifndef SEENINDEX_H
+#define SEENINDEX_H
+
+#include "public_definitions.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEENINDEX_FILENAME "search_by_seen.db"
+#define SEENINDEX_VERSION 1
+#define SEENINDEX_BUCKET_COUNT (1u << 20)  /* Power of two, 4 MiB of buckets */
+#define SEENINDEX_INITIAL_CAPACITY 4096
+#define SEENINDEX_UID_BUFSIZE 32
+#define SEENINDEX_NICKNAME_BUFSIZE 128
+
+struct SeenHeader {
+	char magic[8];
+	unsigned int version;
+	unsigned int bucketCount;
+	unsigned int recordCount;
+	unsigned int recordCapacity;  /* Records the file has room for */
+	unsigned int reserved[10];
+};
+
+struct SeenRecord {
+	unsigned int next;       /* Next record in the bucket chain, index + 1, 0 = end */
+	unsigned int sightings;
+	uint64 databaseID;
+	uint64 firstSeen;        /* Seconds since the epoch */
+	uint64 lastSeen;
+	char uid[SEENINDEX_UID_BUFSIZE];
+	char serverUid[SEENINDEX_UID_BUFSIZE];
+	char nickname[SEENINDEX_NICKNAME_BUFSIZE];
+	char reserved[32];       /* Pads the record to 256 bytes */
+};
+
+/* Opens or creates the index file. Returns 0 on success, 1 on failure. */
+int seenindex_open(const char* path);
+
+void seenindex_close();
+
+/*
+ * Records a sighting of a client. A new record is added the first time a UID
+ * shows up on a server or under a nickname, later sightings update it.
+ * Returns the record index, or -1 if the index is not open or cannot grow.
+ */
+int seenindex_record(const char* uid, const char* serverUid, const char* nickname, uint64 databaseID, uint64 now);
+
+/* Number of records */
+unsigned int seenindex_count();
+
+/* Returns a record, valid until the next seenindex_record call */
+const struct SeenRecord* seenindex_get(unsigned int index);
+
+/*
+ * Returns the index of the first record of a UID, or -1 if there is none.
+ * Pass the previous result as after to get the next one, or -1 to start.
+ */
+int seenindex_findUid(const char* uid, int after);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * Search By - search latency statistics
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <intrin.h>
+#else
+#include <time.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "stats.h"
+
+#define SUB_COUNT (1u << STATS_SUB_BITS)
+#define MAX_VALUE ((1ULL << STATS_MAX_BITS) - 1)
+
+struct Histogram {
+	unsigned long long count;
+	unsigned long long max;
+	unsigned int buckets[STATS_BUCKET_COUNT];
+};
+
+static struct Histogram histograms[STATS_MAX_PROVIDERS][STATS_STAGE_COUNT];
+static unsigned long long errors[STATS_MAX_PROVIDERS][STATS_ERROR_COUNT];
+
+static const char* const stageNames[STATS_STAGE_COUNT] = { "term", "encode", "url", "launch", "fetch" };
+static const char* const errorNames[STATS_ERROR_COUNT] = { "term", "launch", "fetch" };
+
+stats_ticks stats_now() {
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (stats_ticks)counter.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (stats_ticks)ts.tv_sec * 1000000000ULL + (stats_ticks)ts.tv_nsec;
+#endif
+}
+
+static unsigned int highestBit(unsigned long long value) {
+#ifdef _WIN32
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return (unsigned int)index;
+#else
+	return 63u - (unsigned int)__builtin_clzll(value);
+#endif
+}
+
+static unsigned int bucketIndex(unsigned long long value) {
+	unsigned int shift;
+
+	if(value < SUB_COUNT) {
+		return (unsigned int)value;
+	}
+	shift = highestBit(value) - STATS_SUB_BITS;
+	return ((shift + 1) << STATS_SUB_BITS) + (unsigned int)(value >> shift) - SUB_COUNT;
+}
+
+/* The largest value counted in a bucket */
+static unsigned long long bucketHighest(unsigned int index) {
+	unsigned int shift;
+
+	if(index < SUB_COUNT) {
+		return index;
+	}
+	shift = (index >> STATS_SUB_BITS) - 1;
+	return ((((unsigned long long)(index & (SUB_COUNT - 1)) + SUB_COUNT + 1) << shift) - 1);
+}
+
+void stats_record(unsigned int provider, enum StatsStage stage, stats_ticks start) {
+	stats_recordElapsed(provider, stage, stats_now() - start);
+}
+
+void stats_recordElapsed(unsigned int provider, enum StatsStage stage, stats_ticks elapsed) {
+	struct Histogram* h = &histograms[provider][stage];
+
+	if(elapsed > MAX_VALUE) {
+		elapsed = MAX_VALUE;
+	}
+	h->buckets[bucketIndex(elapsed)]++;
+	h->count++;
+	if(elapsed > h->max) {
+		h->max = elapsed;
+	}
+}
+
+void stats_error(unsigned int provider, enum StatsError error) {
+	errors[provider][error]++;
+}
+
+/* Returns the value below which the given per mille of the samples are */
+static unsigned long long percentile(const struct Histogram* h, unsigned int perMille) {
+	unsigned long long target = (h->count * perMille + 999) / 1000, seen = 0;
+	unsigned int i;
+
+	for(i = 0; i < STATS_BUCKET_COUNT; i++) {
+		seen += h->buckets[i];
+		if(seen >= target && seen > 0) {
+			return bucketHighest(i) < h->max ? bucketHighest(i) : h->max;
+		}
+	}
+	return h->max;
+}
+
+static double ticksToNanoseconds(unsigned long long ticks) {
+#ifdef _WIN32
+	static LARGE_INTEGER frequency;
+	if(frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	return (double)ticks * 1e9 / (double)frequency.QuadPart;
+#else
+	return (double)ticks;
+#endif
+}
+
+/* Formats a duration with a unit that keeps it short */
+static void formatDuration(unsigned long long ticks, char* out, size_t outSize) {
+	double ns = ticksToNanoseconds(ticks);
+
+	if(ns < 1e3) {
+		snprintf(out, outSize, "%.0fns", ns);
+	} else if(ns < 1e6) {
+		snprintf(out, outSize, "%.1fus", ns / 1e3);
+	} else if(ns < 1e9) {
+		snprintf(out, outSize, "%.1fms", ns / 1e6);
+	} else {
+		snprintf(out, outSize, "%.2fs", ns / 1e9);
+	}
+}
+
+unsigned int stats_report(const char* const* names, unsigned int nameCount, void (*print)(void* context, const char* line), void* context) {
+	static const unsigned int perMille[] = { 500, 900, 990, 999 };
+	char line[STATS_LINE_BUFSIZE];
+	char values[5][16];
+	unsigned int p, s, e, i, lines = 0;
+	unsigned long long total;
+
+	for(p = 0; p < nameCount && p < STATS_MAX_PROVIDERS; p++) {
+		for(s = 0; s < STATS_STAGE_COUNT; s++) {
+			const struct Histogram* h = &histograms[p][s];
+			if(h->count == 0) {
+				continue;
+			}
+			for(i = 0; i < 4; i++) {
+				formatDuration(percentile(h, perMille[i]), values[i], sizeof(values[i]));
+			}
+			formatDuration(h->max, values[4], sizeof(values[4]));
+			snprintf(line, STATS_LINE_BUFSIZE, "%.64s %s: %llu, p50 %s, p90 %s, p99 %s, p99.9 %s, max %s",
+			         names[p], stageNames[s], h->count, values[0], values[1], values[2], values[3], values[4]);
+			print(context, line);
+			lines++;
+		}
+
+		total = 0;
+		for(e = 0; e < STATS_ERROR_COUNT; e++) {
+			total += errors[p][e];
+		}
+		if(total > 0) {
+			snprintf(line, STATS_LINE_BUFSIZE, "%.64s errors: %s %llu, %s %llu, %s %llu", names[p],
+			         errorNames[0], errors[p][0], errorNames[1], errors[p][1], errorNames[2], errors[p][2]);
+			print(context, line);
+			lines++;
+		}
+	}
+	return lines;
+}
+
+void stats_clear() {
+	memset(histograms, 0, sizeof(histograms));
+	memset(errors, 0, sizeof(errors));
+}
@@ -0,0 +1,74 @@
+/*
+ * Search By - search latency statistics
+ *
+ * Every provider has a latency histogram per search stage and a counter per
+ * kind of error. The histograms are log-linear like HdrHistogram: values below
+ * 2^STATS_SUB_BITS ticks get a bucket each, above that every power of two is
+ * split into 2^STATS_SUB_BITS linear buckets, so a bucket is at most 1/16 of
+ * its value wide. Recording a sample is a bit scan and an increment, no
+ * allocation or locking.
+ *
+ * Times are taken in ticks of the high-resolution timer, QueryPerformanceCounter
+ * on Windows and CLOCK_MONOTONIC nanoseconds elsewhere, and only converted to
+ * time units when reported.
+ *
+ * Only the client callback thread records samples and errors, so nothing is
+ * locked. Fetches finish on the HTTP engine thread, they measure their time
+ * there and record it once the client thread picks them up, see clientqueue.h.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STATS_MAX_PROVIDERS 16
+#define STATS_SUB_BITS 4
+#define STATS_MAX_BITS 40  /* Longer durations are counted as 2^40 - 1 ticks */
+#define STATS_BUCKET_COUNT ((STATS_MAX_BITS - STATS_SUB_BITS + 1) << STATS_SUB_BITS)
+#define STATS_LINE_BUFSIZE 256
+
+typedef unsigned long long stats_ticks;
+
+enum StatsStage {
+	STATS_STAGE_TERM = 0,  /* Reading the client or server variable */
+	STATS_STAGE_ENCODE,    /* Url-encoding the term */
+	STATS_STAGE_URL,       /* Building the whole URL, encoding included */
+	STATS_STAGE_LAUNCH,    /* Handing the URL to the launcher */
+	STATS_STAGE_FETCH,     /* An inline fetch, from the request to the end of the response */
+	STATS_STAGE_COUNT
+};
+
+enum StatsError {
+	STATS_ERROR_TERM = 0,  /* The variable could not be read */
+	STATS_ERROR_LAUNCH,    /* The launcher queue was full */
+	STATS_ERROR_FETCH,     /* The fetch failed or the provider answered with an error status */
+	STATS_ERROR_COUNT
+};
+
+stats_ticks stats_now();
+
+/* Records the time since start, taken with stats_now */
+void stats_record(unsigned int provider, enum StatsStage stage, stats_ticks start);
+
+/* Records a duration measured earlier, for samples taken on another thread */
+void stats_recordElapsed(unsigned int provider, enum StatsStage stage, stats_ticks elapsed);
+
+void stats_error(unsigned int provider, enum StatsError error);
+
+/*
+ * Calls print with one line per provider and stage that has samples, with the
+ * percentiles, and one line per provider that had errors. names holds the
+ * provider names. Returns the number of lines.
+ */
+unsigned int stats_report(const char* const* names, unsigned int nameCount, void (*print)(void* context, const char* line), void* context);
+
+void stats_clear();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Search By - heap allocation counter for tests
+ */
+
+#include <stddef.h>
+#include "allochook.h"
+
+#ifdef SEARCHBY_ALLOC_HOOK
+
+static __thread int counting = 0;
+static __thread unsigned int allocations = 0;
+static __thread unsigned int frees = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+char* __real_strdup(const char* s);
+void __real_free(void* p);
+
+void* __wrap_malloc(size_t size) {
+	allocations += counting;
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+	allocations += counting;
+	return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+	allocations += counting;
+	return __real_realloc(p, size);
+}
+
+char* __wrap_strdup(const char* s) {
+	allocations += counting;
+	return __real_strdup(s);
+}
+
+void __wrap_free(void* p) {
+	frees += counting && p;
+	__real_free(p);
+}
+
+int allochook_available() {
+	return 1;
+}
+
+#else
+
+static int counting = 0;
+static unsigned int allocations = 0;
+static unsigned int frees = 0;
+
+int allochook_available() {
+	return 0;
+}
+
+#endif
+
+void allochook_begin() {
+	allocations = 0;
+	frees = 0;
+	counting = 1;
+}
+
+unsigned int allochook_end() {
+	counting = 0;
+	return allocations;
+}
+
+unsigned int allochook_frees() {
+	return frees;
+}
@@ -0,0 +1,34 @@
+/*
+ * Search By - heap allocation counter for tests
+ *
+ * Where the linker can wrap symbols (GNU ld and lld), the test programs are
+ * linked with malloc, calloc, realloc, strdup and free wrapped, so every call
+ * the plugin and its modules make is counted. Allocations inside the C library,
+ * like those of fopen, are not seen. Only calls from the thread that started
+ * counting are counted.
+ */
+
+#ifndef ALLOCHOOK_H
+#define ALLOCHOOK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Returns 1 if allocations are counted in this build, tests asserting counts should skip otherwise */
+int allochook_available();
+
+/* Starts counting on the calling thread from 0 */
+void allochook_begin();
+
+/* Stops counting and returns the number of allocations since allochook_begin */
+unsigned int allochook_end();
+
+/* Number of free calls with a non-NULL pointer between the last allochook_begin and allochook_end */
+unsigned int allochook_frees();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+/*
+ * Search By - benchmark runner
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <direct.h>
+#define snprintf sprintf_s
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define MAX_FILTERS 16
+#define MAX_DIRECTORIES 16
+#define DIRECTORY_BUFSIZE 512
+
+static double minTime = 0.5;  /* Seconds */
+static const char* filters[MAX_FILTERS];
+static int filterCount = 0;
+static volatile const void* sink;
+static char directories[MAX_DIRECTORIES][DIRECTORY_BUFSIZE];  /* Without the trailing separator */
+static int directoryCount = 0;
+
+unsigned long long bench_now() {
+#ifdef _WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	if(frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+	return (unsigned long long)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+/* Remembers a directory for removeDirectories, path ends with a separator */
+static void keepDirectory(const char* path) {
+	size_t length = strlen(path);
+
+	if(directoryCount < MAX_DIRECTORIES && length > 0 && length <= DIRECTORY_BUFSIZE) {
+		memcpy(directories[directoryCount], path, length - 1);
+		directories[directoryCount][length - 1] = '\0';
+		directoryCount++;
+	}
+}
+
+int bench_tempDirectory(char* path, size_t pathSize, const char* name) {
+#ifdef _WIN32
+	char base[MAX_PATH];
+	GetTempPathA(MAX_PATH, base);
+	snprintf(path, pathSize, "%ssearchby_bench_%s_%lu\\", base, name, GetCurrentProcessId());
+	if(_mkdir(path) != 0) {
+		return 1;
+	}
+#else
+	snprintf(path, pathSize, "/tmp/searchby_bench_%s_XXXXXX", name);
+	if(!mkdtemp(path)) {
+		return 1;
+	}
+	strncat(path, "/", pathSize - strlen(path) - 1);
+#endif
+	keepDirectory(path);
+	return 0;
+}
+
+#ifdef _WIN32
+static void removeTree(const char* path) {
+	char pattern[MAX_PATH];
+	char child[MAX_PATH];
+	WIN32_FIND_DATAA entry;
+	HANDLE find;
+
+	snprintf(pattern, MAX_PATH, "%s\\*", path);
+	find = FindFirstFileA(pattern, &entry);
+	if(find != INVALID_HANDLE_VALUE) {
+		do {
+			if(strcmp(entry.cFileName, ".") == 0 || strcmp(entry.cFileName, "..") == 0) {
+				continue;
+			}
+			snprintf(child, MAX_PATH, "%s\\%s", path, entry.cFileName);
+			if(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+				removeTree(child);
+			} else {
+				DeleteFileA(child);
+			}
+		} while(FindNextFileA(find, &entry));
+		FindClose(find);
+	}
+	RemoveDirectoryA(path);
+}
+#else
+static void removeTree(const char* path) {
+	char child[DIRECTORY_BUFSIZE];
+	struct dirent* entry;
+	struct stat info;
+	DIR* directory = opendir(path);
+
+	if(directory) {
+		while((entry = readdir(directory)) != NULL) {
+			if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+				continue;
+			}
+			if(snprintf(child, sizeof(child), "%s/%s", path, entry->d_name) >= (int)sizeof(child)) {
+				continue;
+			}
+			if(lstat(child, &info) == 0 && S_ISDIR(info.st_mode)) {
+				removeTree(child);
+			} else {
+				unlink(child);
+			}
+		}
+		closedir(directory);
+	}
+	rmdir(path);
+}
+#endif
+
+/* Removes the directories of bench_tempDirectory with everything the suites wrote into them */
+static void removeDirectories() {
+	int i;
+
+	for(i = 0; i < directoryCount; i++) {
+		removeTree(directories[i]);
+	}
+	directoryCount = 0;
+}
+
+void bench_pause(struct BenchState* state) {
+	state->pausedAt = bench_now();
+}
+
+void bench_resume(struct BenchState* state) {
+	state->paused += bench_now() - state->pausedAt;
+}
+
+void bench_use(const void* p) {
+	sink = p;
+}
+
+int bench_selected(const char* prefix) {
+	int i;
+
+	if(filterCount == 0) {
+		return 1;
+	}
+	for(i = 0; i < filterCount; i++) {
+		/* Either could be the more specific one: "menu" selects "menu/uid", "menu/uid" needs the "menu" setup */
+		if(strstr(prefix, filters[i]) || strncmp(filters[i], prefix, strlen(prefix)) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int matches(const char* name) {
+	int i;
+
+	if(filterCount == 0) {
+		return 1;
+	}
+	for(i = 0; i < filterCount; i++) {
+		if(strstr(name, filters[i])) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void bench_run(const char* name, bench_fn function) {
+	struct BenchState state;
+	unsigned long long started, elapsed;
+	double perIteration, seconds;
+
+	if(!matches(name)) {
+		return;
+	}
+	state.iterations = 1;
+	for(;;) {
+		state.bytesPerIteration = 0;
+		state.itemsPerIteration = 0;
+		state.paused = 0;
+		started = bench_now();
+		function(&state);
+		elapsed = bench_now() - started;
+		seconds = (double)elapsed / 1e9;
+		if(seconds >= minTime || state.iterations >= 1000000000ULL) {
+			break;
+		}
+		/* Aim a bit past the minimum time, but grow at most 100 times per step */
+		if(elapsed == 0) {
+			state.iterations *= 100;
+		} else {
+			double next = (double)state.iterations * minTime * 1.4 / seconds;
+			if(next > (double)state.iterations * 100) {
+				next = (double)state.iterations * 100;
+			}
+			state.iterations = (unsigned long long)next + 1;
+		}
+	}
+
+	perIteration = (double)(elapsed - state.paused) / (double)state.iterations;
+	printf("%-48s %12llu %14.1f ns", name, state.iterations, perIteration);
+	if(state.bytesPerIteration) {
+		printf(" %10.1f MB/s", (double)state.bytesPerIteration * 1e3 / perIteration);
+	}
+	if(state.itemsPerIteration) {
+		printf(" %10.3f M items/s", (double)state.itemsPerIteration * 1e3 / perIteration);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+	int i;
+
+	for(i = 1; i < argc; i++) {
+		if(strncmp(argv[i], "--min-time=", 11) == 0) {
+			minTime = atof(argv[i] + 11);
+		} else if(filterCount < MAX_FILTERS) {
+			filters[filterCount++] = argv[i];
+		}
+	}
+	printf("%-48s %12s %17s\n", "Benchmark", "Iterations", "Time");
+	bench_plugin();
+	bench_encode();
+	bench_protect();
+	bench_nickindex();
+	bench_normalize();
+	bench_extract();
+	bench_launcher();
+	bench_clientcache();
+	removeDirectories();
+	return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Search By - benchmark runner
+ *
+ * A benchmark is a function running its operation state->iterations times.
+ * The runner calls it with growing iteration counts until one run takes the
+ * minimum time, then reports the time per operation, and the throughput if the
+ * benchmark set how many bytes or items one operation handles.
+ *
+ * Usage: searchby_bench [--min-time=<seconds>] [filter...]
+ * Only benchmarks whose name contains one of the filters are run.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct BenchState {
+	unsigned long long iterations;
+	unsigned long long bytesPerIteration;  /* For MB/s, 0 if not meaningful */
+	unsigned long long itemsPerIteration;  /* For items/s, 0 if not meaningful */
+	unsigned long long paused;    /* Nanoseconds between bench_pause and bench_resume, not counted */
+	unsigned long long pausedAt;
+};
+
+typedef void (*bench_fn)(struct BenchState* state);
+
+/* Runs a benchmark if its name passes the filters */
+void bench_run(const char* name, bench_fn function);
+
+/* Returns 1 if a benchmark of that name would run, so suites can skip expensive setups */
+int bench_selected(const char* prefix);
+
+/* Nanoseconds of a monotonic clock */
+unsigned long long bench_now();
+
+/*
+ * Stops and restarts the clock around work a benchmark needs between its
+ * operations, like draining a queue. Paused time still counts towards the
+ * minimum time of a run, so such benchmarks run fewer iterations.
+ */
+void bench_pause(struct BenchState* state);
+void bench_resume(struct BenchState* state);
+
+/*
+ * Creates a fresh directory for a suite's files and writes its path, ending with a separator. Returns 0 on success.
+ * The directory and everything in it is removed when all suites ran.
+ */
+int bench_tempDirectory(char* path, size_t pathSize, const char* name);
+
+/* Keeps the compiler from dropping a computation whose result is unused */
+void bench_use(const void* p);
+
+/* The suites, one per area, see bench_*.c */
+void bench_plugin();
+void bench_encode();
+void bench_protect();
+void bench_nickindex();
+void bench_normalize();
+void bench_extract();
+void bench_launcher();
+void bench_clientcache();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
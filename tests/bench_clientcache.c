@@ -0,0 +1,98 @@
+/*
+ * Search By - client snapshot cache benchmarks
+ *
+ * One iteration replays a busy server: REPLAY_CLIENTS clients join, each of
+ * them renames once, then all of them leave again.
+ */
+
+#include <stdio.h>
+#include "ts3mock.h"
+#include "clientlib_publicdefinitions.h"
+#include "plugin.h"
+#include "clientcache.h"
+#include "bench.h"
+
+#define SERVER 1
+#define MY_ID 1
+#define CHANNEL 7
+#define REPLAY_CLIENTS 5000
+#define FIRST_CLIENT 2
+
+static char nicknames[REPLAY_CLIENTS][32];
+static char renamed[REPLAY_CLIENTS][32];
+static char uids[REPLAY_CLIENTS][32];
+static struct MockClient* mockClients[REPLAY_CLIENTS];
+
+/* The table alone, as the callbacks update it */
+static void benchCacheReplay(struct BenchState* state) {
+	unsigned long long i;
+	unsigned int n;
+
+	for(i = 0; i < state->iterations; i++) {
+		for(n = 0; n < REPLAY_CLIENTS; n++) {
+			clientcache_set(SERVER, (anyID)(FIRST_CLIENT + n), CHANNEL + n % 16, nicknames[n], uids[n], 1000 + n);
+		}
+		for(n = 0; n < REPLAY_CLIENTS; n++) {
+			clientcache_setNickname(SERVER, (anyID)(FIRST_CLIENT + n), renamed[n]);
+		}
+		for(n = 0; n < REPLAY_CLIENTS; n++) {
+			clientcache_remove(SERVER, (anyID)(FIRST_CLIENT + n));
+		}
+	}
+	state->itemsPerIteration = 3 * REPLAY_CLIENTS;
+}
+
+/* The same replay through the plugin's callbacks, which also record sightings and queue impersonation checks */
+static void benchEventReplay(struct BenchState* state) {
+	unsigned long long i;
+	unsigned int n;
+
+	for(i = 0; i < state->iterations; i++) {
+		for(n = 0; n < REPLAY_CLIENTS; n++) {
+			snprintf(mockClients[n]->nickname, sizeof(mockClients[n]->nickname), "%s", nicknames[n]);
+			ts3plugin_onClientMoveEvent(SERVER, (anyID)(FIRST_CLIENT + n), 0, mockClients[n]->channel, ENTER_VISIBILITY, "");
+		}
+		for(n = 0; n < REPLAY_CLIENTS; n++) {
+			snprintf(mockClients[n]->nickname, sizeof(mockClients[n]->nickname), "%s", renamed[n]);
+			ts3plugin_onUpdateClientEvent(SERVER, (anyID)(FIRST_CLIENT + n), 0, "", "");
+		}
+		for(n = 0; n < REPLAY_CLIENTS; n++) {
+			ts3plugin_onClientMoveEvent(SERVER, (anyID)(FIRST_CLIENT + n), mockClients[n]->channel, 0, LEAVE_VISIBILITY, "");
+		}
+	}
+	state->itemsPerIteration = 3 * REPLAY_CLIENTS;
+	mock_clearMessages();
+}
+
+void bench_clientcache() {
+	char configPath[256];
+	unsigned int n;
+
+	if(!bench_selected("clientcache/") || bench_tempDirectory(configPath, sizeof(configPath), "clientcache") != 0) {
+		return;
+	}
+	for(n = 0; n < REPLAY_CLIENTS; n++) {
+		snprintf(nicknames[n], sizeof(nicknames[n]), "[Clan] Player %04u", n);
+		snprintf(renamed[n], sizeof(renamed[n]), "[Clan] Player %04u | AFK", n);
+		snprintf(uids[n], sizeof(uids[n]), "rQ0V1g4uGJm1xrhgBbzKycI%04u=", n);
+	}
+	bench_run("clientcache/replay/5000", benchCacheReplay);
+	clientcache_clear();
+
+	/* The client library knows every client up front, the events decide what the plugin sees */
+	mock_reset(configPath);
+	mock_install();
+	ts3plugin_registerPluginID("bench_clientcache");
+	if(ts3plugin_init() != 0) {
+		printf("ts3plugin_init failed\n");
+		return;
+	}
+	mock_addServer(SERVER, "Benchmark Server", "benchserveruid=", MY_ID);
+	mock_addClient(SERVER, MY_ID, CHANNEL, "Myself", "myuid=", 1);
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_CONNECTION_ESTABLISHED, 0);
+	for(n = 0; n < REPLAY_CLIENTS; n++) {
+		mockClients[n] = mock_addClient(SERVER, (anyID)(FIRST_CLIENT + n), CHANNEL + n % 16, nicknames[n], uids[n], (int)(1000 + n));
+	}
+	bench_run("clientcache/events/replay/5000", benchEventReplay);
+	ts3plugin_shutdown();
+}
@@ -0,0 +1,163 @@
+/*
+ * Search By - url encoding benchmarks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "encode.h"
+#include "providers.h"
+#include "searchurl.h"
+#include "bench.h"
+
+#define CORPUS_SIZE 4096
+
+static const char* const samples[] = {
+	"Bluscream", "[Clan] Player Name", "xX_Sniper_Xx", "Müller", "Ж Dmitry Ж", "Admin | AFK", "rQ0V1g4uGJm1xrhgBbzKycIgNsw=",
+	"Some Very Long Nickname With Spaces", "ニックネーム", "guest1234", "TeamSpeak ][ Server", "ÄÖÜ äöü ß"
+};
+
+#define SAMPLE_COUNT (sizeof(samples) / sizeof(samples[0]))
+
+static const char* corpus[CORPUS_SIZE];
+static size_t corpusLengths[CORPUS_SIZE];
+static size_t corpusBytes;
+
+static void buildCorpus() {
+	unsigned int i;
+
+	corpusBytes = 0;
+	for(i = 0; i < CORPUS_SIZE; i++) {
+		corpus[i] = samples[(i * 7) % SAMPLE_COUNT];
+		corpusLengths[i] = strlen(corpus[i]);
+		corpusBytes += corpusLengths[i];
+	}
+}
+
+static void benchEncode(struct BenchState* state) {
+	unsigned long long i;
+	char* encoded;
+
+	for(i = 0; i < state->iterations; i++) {
+		encoded = url_encode(corpus[i % CORPUS_SIZE]);
+		bench_use(encoded);
+		free(encoded);
+	}
+	state->bytesPerIteration = corpusBytes / CORPUS_SIZE;
+}
+
+static void benchEncodeInto(struct BenchState* state) {
+	char out[256];
+	unsigned long long i;
+	size_t n;
+
+	for(i = 0; i < state->iterations; i++) {
+		n = i % CORPUS_SIZE;
+		url_encode_into(corpus[n], corpusLengths[n], out, sizeof(out));
+		bench_use(out);
+	}
+	state->bytesPerIteration = corpusBytes / CORPUS_SIZE;
+}
+
+/* Channel descriptions and pasted links are far longer than nicknames and mostly copied as is */
+static char longText[4096];
+
+static void benchEncodeLong(struct BenchState* state) {
+	static char out[3 * sizeof(longText)];
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		url_encode_into(longText, sizeof(longText) - 1, out, sizeof(out));
+		bench_use(out);
+	}
+	state->bytesPerIteration = sizeof(longText) - 1;
+}
+
+static void buildLongText() {
+	static const char words[] = "Welcome_to_the_server.Please-read~the_rules_before-joining_any_channel.";
+	size_t i;
+
+	for(i = 0; i < sizeof(longText) - 1; i++) {
+		longText[i] = i % 97 == 96 ? ' ' : words[i % (sizeof(words) - 1)];
+	}
+	longText[sizeof(longText) - 1] = '\0';
+}
+
+/* Search URLs of the nickname providers */
+#define URL_PROVIDERS 6
+
+static const struct ProviderTemplate* urlProviders[URL_PROVIDERS];
+
+/* How the menu callbacks built URLs before the templates: copy the prefix, then let strcat find the end of it */
+static void benchUrlStrcat(struct BenchState* state) {
+	char url[SEARCHURL_BUFSIZE];
+	unsigned long long i;
+	char* encoded;
+
+	for(i = 0; i < state->iterations; i++) {
+		encoded = url_encode(corpus[i % CORPUS_SIZE]);
+		strcpy(url, urlProviders[i % URL_PROVIDERS]->prefix);
+		strcat(url, encoded);
+		free(encoded);
+		bench_use(url);
+	}
+	state->itemsPerIteration = 1;
+}
+
+/*
+ * The plugin's searchurl_build: lengths known up front, the term encoded straight into the buffer.
+ * It also times itself for the statistics, on machines with a slow clock its four clock reads dominate.
+ */
+static void benchUrlTemplate(struct BenchState* state) {
+	char url[SEARCHURL_BUFSIZE];
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		searchurl_build(urlProviders[i % URL_PROVIDERS], corpus[i % CORPUS_SIZE], url);
+		bench_use(url);
+	}
+	state->itemsPerIteration = 1;
+}
+
+static int loadUrlProviders() {
+	static const int menuIDs[URL_PROVIDERS] = { MENU_ID_CLIENT_1, MENU_ID_CLIENT_2, MENU_ID_CLIENT_3, MENU_ID_CLIENT_4, MENU_ID_CLIENT_5, MENU_ID_CLIENT_8 };
+	unsigned int i;
+
+	if(providers_load("") != 0) {  /* No config file, the built-in providers */
+		return 1;
+	}
+	for(i = 0; i < URL_PROVIDERS; i++) {
+		urlProviders[i] = providers_template(providers_current(), menuIDs[i]);
+		if(!urlProviders[i]) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void bench_encode() {
+	static const char* const levels[] = { "scalar", "sse2", "avx2" };
+	const int best = url_encode_level();
+	char name[64];
+	int simd;
+
+	buildCorpus();
+	buildLongText();
+	bench_run("encode/url_encode/nicknames", benchEncode);
+	for(simd = ENCODE_LEVEL_SCALAR; simd <= ENCODE_LEVEL_AVX2; simd++) {
+		if(url_encode_setLevel(simd) != 0) {
+			continue;
+		}
+		snprintf(name, sizeof(name), "encode/url_encode_into/nicknames/%s", levels[simd]);
+		bench_run(name, benchEncodeInto);
+		snprintf(name, sizeof(name), "encode/url_encode_into/4k-text/%s", levels[simd]);
+		bench_run(name, benchEncodeLong);
+	}
+	url_encode_setLevel(best);
+
+	if(bench_selected("url/") && loadUrlProviders() == 0) {
+		bench_run("url/build/strcat", benchUrlStrcat);
+		bench_run("url/build/template", benchUrlTemplate);
+		providers_free();
+	}
+}
@@ -0,0 +1,124 @@
+/*
+ * Search By - streaming field extractor benchmarks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "extract.h"
+#include "bench.h"
+
+#define PAGE_ROWS 4000
+#define CHUNK_SIZES 4096
+
+static char* page;
+static size_t pageLength;
+static unsigned int chunkSizes[CHUNK_SIZES];
+static struct ExtractProfile profile;
+static unsigned int recordCount;
+
+static void onRecord(void* context, const struct ExtractProfile* profile, const struct ExtractRecord* record) {
+	recordCount++;
+}
+
+/* A player search result page: boilerplate and scripts around a table with one row per player */
+static int buildPage() {
+	static const char header[] =
+		"<!DOCTYPE html><html><head><title>Player search - TeamSpeak 3 Server List</title>"
+		"<script type=\"text/javascript\">var rows = document.getElementsByTagName('tr'); for(var i = 0; i < rows.length; i++) {}</script>"
+		"<link rel=\"stylesheet\" href=\"/css/main.css\"></head><body><div id=\"nav\"><a href=\"/\">Home</a> | <a href=\"/search/\">Search</a></div>"
+		"<table class=\"table_lst\"><tr><th>Name</th><th>Server</th><th>Last seen</th></tr>\n";
+	const size_t capacity = sizeof(header) + PAGE_ROWS * 512;
+	unsigned int i;
+
+	page = malloc(capacity);
+	if(!page) {
+		return 1;
+	}
+	pageLength = (size_t)snprintf(page, capacity, "%s", header);
+	for(i = 0; i < PAGE_ROWS; i++) {
+		pageLength += (size_t)snprintf(page + pageLength, capacity - pageLength,
+			"<tr class=\"row%u\"><td class=\"c01\"><img src=\"/images/flags/de.gif\" alt=\"\"></td>"
+			"<td class=\"c02\"><a href=\"/player/%u/\">[Clan] Player N&auml;me %u</a></td>"
+			"<td class=\"c03\"><a href=\"/server/%u/\">Gaming Community #%u &amp; Friends</a></td>"
+			"<td class=\"c04\">2016-%02u-%02u %02u:%02u</td></tr>\n",
+			i % 2, 100000 + i, i, 5000 + i % 97, i % 97, 1 + i % 12, 1 + i % 28, i % 24, i % 60);
+	}
+	pageLength += (size_t)snprintf(page + pageLength, capacity - pageLength, "</table><div id=\"footer\">&copy; 2016</div></body></html>");
+	return 0;
+}
+
+static void extractPage(struct BenchState* state, unsigned int sizeMask, unsigned int fixedSize) {
+	struct Extractor extractor;
+	unsigned long long i;
+	unsigned int chunk = 0;
+	size_t offset, size;
+
+	for(i = 0; i < state->iterations; i++) {
+		recordCount = 0;
+		extract_begin(&extractor, &profile, onRecord, NULL);
+		for(offset = 0; offset < pageLength; offset += size) {
+			size = fixedSize ? fixedSize : 1 + (chunkSizes[chunk++ % CHUNK_SIZES] & sizeMask);
+			if(size > pageLength - offset) {
+				size = pageLength - offset;
+			}
+			extract_feed(&extractor, page + offset, size);
+		}
+		extract_end(&extractor);
+	}
+	bench_use(&recordCount);
+	state->bytesPerIteration = pageLength;
+	state->itemsPerIteration = PAGE_ROWS;
+}
+
+static void benchWhole(struct BenchState* state) {
+	extractPage(state, 0, (unsigned int)pageLength);
+}
+
+/* Full TCP segments */
+static void benchSegments(struct BenchState* state) {
+	extractPage(state, 0, 1460);
+}
+
+/* 1 to 16384 bytes, as recv hands them over on a busy connection */
+static void benchRandomChunks(struct BenchState* state) {
+	extractPage(state, 16383, 0);
+}
+
+/* 1 to 64 bytes, so most markers are split */
+static void benchTinyChunks(struct BenchState* state) {
+	extractPage(state, 63, 0);
+}
+
+void bench_extract() {
+	unsigned long long randomState = 0x2545F4914F6CDD1DULL;
+	unsigned int i;
+
+	if(!bench_selected("extract/")) {
+		return;
+	}
+	if(buildPage() != 0) {
+		printf("out of memory\n");
+		return;
+	}
+	for(i = 0; i < CHUNK_SIZES; i++) {
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 7;
+		randomState ^= randomState << 17;
+		chunkSizes[i] = (unsigned int)(randomState >> 32);
+	}
+	extract_initProfile(&profile);
+	extract_addField(&profile, EXTRACT_RECORD_FIELD, "<tr class=\"row", NULL);
+	extract_addField(&profile, "name", "<td class=\"c02\">", "</td>");
+	extract_addField(&profile, "server", "<td class=\"c03\">", "</td>");
+	extract_addField(&profile, "seen", "<td class=\"c04\">", "</td>");
+
+	bench_run("extract/whole-page", benchWhole);
+	if(recordCount) {
+		printf("%u records from a page of %lu bytes\n", recordCount, (unsigned long)pageLength);
+	}
+	bench_run("extract/segments-1460", benchSegments);
+	bench_run("extract/random-chunks-1-16384", benchRandomChunks);
+	bench_run("extract/random-chunks-1-64", benchTinyChunks);
+	free(page);
+}
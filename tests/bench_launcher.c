@@ -0,0 +1,154 @@
+/*
+ * Search By - URL launch benchmarks
+ *
+ * The benchmarks spawn a stub opener that exits at once, its path is set
+ * by the build in SEARCHBY_STUB_OPENER. POSIX only.
+ *
+ * The queued handler benchmark runs the real launcher, src/launcher.c built a
+ * second time with the stub opener and its functions renamed to queue_launcher_*,
+ * see tests/CMakeLists.txt. The mock client passes the plugin's URLs on to it.
+ */
+
+#ifndef _WIN32
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "launcher.h"
+#include "ts3mock.h"
+#include "clientlib_publicdefinitions.h"
+#include "plugin.h"
+#include "providers.h"
+#include "recent.h"
+#include "bench.h"
+
+#define SERVER 1
+#define MY_ID 1
+#define CHANNEL 7
+#define CLIENT 2
+#define COMMAND_BUFSIZE 2048
+#define URL "http://www.tsviewer.com/index.php?page=search&action=ausgabe_user&nickname=Player%20Name"
+
+#if !defined(_WIN32) && defined(SEARCHBY_STUB_OPENER)
+
+int queue_launcher_init();
+void queue_launcher_shutdown();
+int queue_launcher_open(const char* url);
+
+/* How the menu callbacks opened URLs before the launcher: the shell runs the opener and the callback waits for it */
+static void systemOpen(const char* url) {
+	char command[COMMAND_BUFSIZE];
+
+	snprintf(command, sizeof(command), "'%s' '%s'", SEARCHBY_STUB_OPENER, url);
+	if(system(command) != 0) {
+		printf("cannot run %s\n", SEARCHBY_STUB_OPENER);
+	}
+}
+
+/* Spawn to return through the shell, which then starts the opener */
+static void benchSpawnSystem(struct BenchState* state) {
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		systemOpen(URL);
+	}
+}
+
+/* Spawn to return of the opener alone with an argument vector, as the launcher's worker does */
+static void benchSpawnDirect(struct BenchState* state) {
+	char* argv[3];
+	unsigned long long i;
+	pid_t pid;
+	int status;
+
+	argv[0] = SEARCHBY_STUB_OPENER;
+	argv[1] = URL;
+	argv[2] = NULL;
+	for(i = 0; i < state->iterations; i++) {
+		if(posix_spawn(&pid, SEARCHBY_STUB_OPENER, NULL, NULL, argv, environ) != 0) {
+			printf("cannot spawn %s\n", SEARCHBY_STUB_OPENER);
+			return;
+		}
+		waitpid(pid, &status, 0);
+	}
+}
+
+/*
+ * The callback only queues the URL for the launcher's worker, which spawns the opener meanwhile. After each
+ * queue full of clicks the clock stops while the worker drains it, so no click is dropped.
+ */
+static void benchHandlerQueued(struct BenchState* state) {
+	unsigned long long i;
+
+	if(queue_launcher_init() != 0) {
+		return;
+	}
+	mock_setLauncher(queue_launcher_open);
+	for(i = 0; i < state->iterations; i++) {
+		ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, CLIENT);
+		if(i % LAUNCHER_QUEUE_SIZE == LAUNCHER_QUEUE_SIZE - 1) {
+			bench_pause(state);
+			queue_launcher_shutdown();  /* Opens what is queued */
+			queue_launcher_init();
+			bench_resume(state);
+		}
+	}
+	bench_pause(state);
+	queue_launcher_shutdown();
+	bench_resume(state);
+	mock_setLauncher(NULL);
+	mock_clearMessages();
+}
+
+/* The same click, with the callback also spawning the opener through a shell before it returns */
+static void benchHandlerSynchronous(struct BenchState* state) {
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, CLIENT);
+		systemOpen(mock_lastLaunch());
+	}
+	mock_clearLaunches();
+	mock_clearMessages();
+}
+
+void bench_launcher() {
+	char configPath[256];
+
+	if(!bench_selected("launch/")) {
+		return;
+	}
+	bench_run("launch/spawn/system", benchSpawnSystem);
+	bench_run("launch/spawn/posix_spawn", benchSpawnDirect);
+
+	if(!bench_selected("launch/handler/") || bench_tempDirectory(configPath, sizeof(configPath), "launch") != 0) {
+		return;
+	}
+	mock_reset(configPath);
+	mock_install();
+	ts3plugin_registerPluginID("bench_launcher");
+	if(ts3plugin_init() != 0) {
+		printf("ts3plugin_init failed\n");
+		return;
+	}
+	mock_addServer(SERVER, "Benchmark Server", "benchserveruid=", MY_ID);
+	mock_addClient(SERVER, MY_ID, CHANNEL, "Myself", "myuid=", 1);
+	mock_addClient(SERVER, CLIENT, CHANNEL, "[Clan] Player Name", "rQ0V1g4uGJm1xrhgBbzKycI0000=", 1000);
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_CONNECTION_ESTABLISHED, 0);
+	recent_setWindow(0);  /* Repeated clicks on the same client are searches, not double clicks */
+
+	bench_run("launch/handler/queued", benchHandlerQueued);
+	bench_run("launch/handler/synchronous-system", benchHandlerSynchronous);
+
+	ts3plugin_shutdown();
+}
+
+#else
+
+void bench_launcher() {
+}
+
+#endif
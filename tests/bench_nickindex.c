@@ -0,0 +1,151 @@
+/*
+ * Search By - fuzzy nickname index benchmarks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "editdist.h"
+#include "nickindex.h"
+#include "normalize.h"
+#include "bench.h"
+
+#define NICKNAME_COUNT 1000000
+#define TERM_COUNT 256
+
+static const char* const syllables[] = {
+	"ka", "ri", "to", "mo", "shi", "dra", "gon", "xx", "pro", "sniper", "wolf", "dark", "lord", "king", "ice", "fire",
+	"zer", "ghost", "el", "an", "ar", "is", "on", "ul", "max", "tom", "lee", "nik", "sam", "rex", "vex", "nova"
+};
+
+#define SYLLABLE_COUNT (sizeof(syllables) / sizeof(syllables[0]))
+
+static char (*nicknames)[32];
+static char (*skeletons)[32];
+static unsigned char* skeletonLengths;
+static char terms[TERM_COUNT][32];
+static unsigned long long randomState = 0x2545F4914F6CDD1DULL;
+
+static unsigned int nextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 7;
+	randomState ^= randomState << 17;
+	return (unsigned int)(randomState >> 32);
+}
+
+/* Two to four syllables and sometimes a number, like the nicknames on a public server */
+static void makeNickname(char* nickname, size_t size) {
+	unsigned int parts = 2 + nextRandom() % 3;
+	size_t used = 0;
+
+	while(parts-- > 0 && used < size - 8) {
+		used += snprintf(nickname + used, size - used, "%s", syllables[nextRandom() % SYLLABLE_COUNT]);
+	}
+	if(nextRandom() % 2) {
+		snprintf(nickname + used, size - used, "%u", nextRandom() % 1000);
+	}
+}
+
+/* Indexes every nickname from scratch */
+static void benchBuild(struct BenchState* state) {
+	unsigned long long i;
+	unsigned int n;
+
+	for(i = 0; i < state->iterations; i++) {
+		nickindex_clear();
+		for(n = 0; n < NICKNAME_COUNT; n++) {
+			nickindex_add(nicknames[n], n);
+		}
+	}
+	state->itemsPerIteration = NICKNAME_COUNT;
+}
+
+static void search(struct BenchState* state, unsigned int maxDistance) {
+	struct NickMatch matches[16];
+	unsigned long long i;
+	int found = 0;
+
+	for(i = 0; i < state->iterations; i++) {
+		found += nickindex_search(terms[i % TERM_COUNT], maxDistance, matches, 16);
+	}
+	bench_use(&found);
+}
+
+static void benchSearch1(struct BenchState* state) {
+	search(state, 1);
+}
+
+static void benchSearch2(struct BenchState* state) {
+	search(state, 2);
+}
+
+static void benchSearch3(struct BenchState* state) {
+	search(state, 3);
+}
+
+/* What the index saves: the bounded kernel over every nickname */
+static void benchScan(struct BenchState* state) {
+	static struct EditPattern pattern;
+	char skeleton[NICKINDEX_NICKNAME_BUFSIZE];
+	unsigned long long i;
+	unsigned int n, found = 0;
+	size_t length;
+
+	for(i = 0; i < state->iterations; i++) {
+		length = normalize_nickname(terms[i % TERM_COUNT], skeleton, sizeof(skeleton));
+		editdist_compile(&pattern, skeleton, length);
+		for(n = 0; n < NICKNAME_COUNT; n++) {
+			found += editdist_bounded(&pattern, skeletons[n], skeletonLengths[n], 2) <= 2;
+		}
+	}
+	bench_use(&found);
+	state->itemsPerIteration = NICKNAME_COUNT;
+}
+
+void bench_nickindex() {
+	unsigned int i, n;
+	size_t length;
+
+	if(!bench_selected("nickindex/")) {
+		return;
+	}
+	nicknames = malloc(NICKNAME_COUNT * sizeof(*nicknames));
+	skeletons = malloc(NICKNAME_COUNT * sizeof(*skeletons));
+	skeletonLengths = malloc(NICKNAME_COUNT);
+	if(!nicknames || !skeletons || !skeletonLengths) {
+		printf("out of memory\n");
+		free(nicknames);
+		free(skeletons);
+		free(skeletonLengths);
+		return;
+	}
+	for(i = 0; i < NICKNAME_COUNT; i++) {
+		makeNickname(nicknames[i], sizeof(nicknames[i]));
+		skeletonLengths[i] = (unsigned char)normalize_nickname(nicknames[i], skeletons[i], sizeof(skeletons[i]));
+	}
+	/* Seen nicknames with a typo or two */
+	for(i = 0; i < TERM_COUNT; i++) {
+		memcpy(terms[i], nicknames[nextRandom() % NICKNAME_COUNT], sizeof(terms[i]));
+		length = strlen(terms[i]);
+		for(n = nextRandom() % 3; n > 0; n--) {
+			terms[i][nextRandom() % length] = (char)('a' + nextRandom() % 26);
+		}
+	}
+
+	bench_run("nickindex/build/1M", benchBuild);
+	if(nickindex_count() == 0) {
+		for(i = 0; i < NICKNAME_COUNT; i++) {
+			nickindex_add(nicknames[i], i);
+		}
+	}
+	printf("%u distinct of %u nicknames\n", nickindex_count(), NICKNAME_COUNT);
+	bench_run("nickindex/search-1/1M", benchSearch1);
+	bench_run("nickindex/search-2/1M", benchSearch2);
+	bench_run("nickindex/search-3/1M", benchSearch3);
+	bench_run("nickindex/scan-2/1M", benchScan);
+
+	nickindex_clear();
+	free(nicknames);
+	free(skeletons);
+	free(skeletonLengths);
+}
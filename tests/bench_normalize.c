@@ -0,0 +1,75 @@
+/*
+ * Search By - nickname normalization benchmarks
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "normalize.h"
+#include "bench.h"
+
+#define CORPUS_SIZE 4096
+
+static const char* const asciiSamples[] = {
+	"Bluscream", "[Clan] Player Name", "xX_Sniper_Xx", "Admin | AFK", "guest1234", "Some Very Long Nickname With Spaces",
+	"TeamSpeak Server Owner", "DarkLord_1987", "ICE", "The Quick Brown Fox Jumps"
+};
+
+/* Cyrillic and Greek look-alikes, fullwidth forms, accents, combining marks and scripts outside the tables */
+static const char* const unicodeSamples[] = {
+	"\xd0\x90\xd0\xb4\xd0\xbc\xd0\xb8\xd0\xbd \xd0\x96\xd0\xb5\xd0\xbd\xd1\x8f",
+	"\xce\x91\xce\xb4\xce\xbc\xce\xb9\xce\xbd \xce\xa3\xce\x9f\xce\xa6\xce\x99\xce\x91",
+	"\xef\xbc\xa1\xef\xbd\x84\xef\xbd\x8d\xef\xbd\x89\xef\xbd\x8e\xef\xbc\xbf\xef\xbc\x91",
+	"M\xc3\xbcller \xc3\x84\xc3\x96\xc3\x9c \xc5\x81\xc3\xb3" "d\xc5\xba",
+	"Ade\xcc\x81m\xe2\x80\x8b\xe2\x80\xae" "adm\xc3\xaf" "n",
+	"\xe3\x83\x8b\xe3\x83\x83\xe3\x82\xaf\xe3\x83\x8d\xe3\x83\xbc\xe3\x83\xa0",
+	"\xd0\xa1\xd0\xb5\xd1\x80\xd0\xb2\xd0\xb5\xd1\x80 \xd0\x9e\xd0\xb2\xd0\xbd\xd0\xb5\xd1\x80",
+	"\xf0\x9f\x98\x80 Gamer \xf0\x9f\x8e\xae"
+};
+
+struct Corpus {
+	const char* nicknames[CORPUS_SIZE];
+	size_t bytes;
+};
+
+static struct Corpus ascii;
+static struct Corpus unicode;
+
+static void buildCorpus(struct Corpus* corpus, const char* const* samples, unsigned int sampleCount) {
+	unsigned int i;
+
+	corpus->bytes = 0;
+	for(i = 0; i < CORPUS_SIZE; i++) {
+		corpus->nicknames[i] = samples[(i * 7) % sampleCount];
+		corpus->bytes += strlen(corpus->nicknames[i]);
+	}
+}
+
+static void normalizeCorpus(struct BenchState* state, const struct Corpus* corpus) {
+	char out[256];
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		normalize_nickname(corpus->nicknames[i % CORPUS_SIZE], out, sizeof(out));
+		bench_use(out);
+	}
+	state->bytesPerIteration = corpus->bytes / CORPUS_SIZE;
+	state->itemsPerIteration = 1;
+}
+
+static void benchAscii(struct BenchState* state) {
+	normalizeCorpus(state, &ascii);
+}
+
+static void benchUnicode(struct BenchState* state) {
+	normalizeCorpus(state, &unicode);
+}
+
+void bench_normalize() {
+	if(!bench_selected("normalize/")) {
+		return;
+	}
+	buildCorpus(&ascii, asciiSamples, sizeof(asciiSamples) / sizeof(asciiSamples[0]));
+	buildCorpus(&unicode, unicodeSamples, sizeof(unicodeSamples) / sizeof(unicodeSamples[0]));
+	bench_run("normalize/ascii", benchAscii);
+	bench_run("normalize/unicode", benchUnicode);
+}
@@ -0,0 +1,250 @@
+/*
+ * Search By - benchmarks of the plugin callbacks against the mock client
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <stdio.h>
+#include "ts3mock.h"
+#include "clientlib_publicdefinitions.h"
+#include "plugin.h"
+#include "providers.h"
+#include "recent.h"
+#include "bench.h"
+
+#define SERVER 1
+#define MY_ID 1
+#define CHANNEL 7
+#define CLIENT_COUNT 128  /* Twice the recent searches, cycling through all of them never hits */
+#define HIT_CLIENT_COUNT 32
+#define FIND_SERVER_COUNT 10  /* The most tabs people keep open */
+#define FIND_CLIENT_COUNT 1000
+
+static void menuEvents(struct BenchState* state, int menuID, unsigned int clientCount) {
+	unsigned long long i;
+	unsigned int client = 0;
+
+	for(i = 0; i < state->iterations; i++) {
+		ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, menuID, (uint64)(2 + client));
+		if(++client == clientCount) {
+			client = 0;
+		}
+	}
+	mock_clearLaunches();
+	mock_clearMessages();
+}
+
+static void benchNicknameMiss(struct BenchState* state) {
+	menuEvents(state, MENU_ID_CLIENT_1, CLIENT_COUNT);
+}
+
+static void benchNicknameHit(struct BenchState* state) {
+	menuEvents(state, MENU_ID_CLIENT_1, HIT_CLIENT_COUNT);
+}
+
+static void benchUidMiss(struct BenchState* state) {
+	menuEvents(state, MENU_ID_CLIENT_6, CLIENT_COUNT);
+}
+
+static void benchDatabaseIDMiss(struct BenchState* state) {
+	menuEvents(state, MENU_ID_CLIENT_9, CLIENT_COUNT);
+}
+
+static void globalMenuEvents(struct BenchState* state, int menuID) {
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_GLOBAL, menuID, 0);
+	}
+	mock_clearLaunches();
+	mock_clearMessages();
+}
+
+static void benchServerName(struct BenchState* state) {
+	globalMenuEvents(state, MENU_ID_GLOBAL_1);
+}
+
+static void benchServerIp(struct BenchState* state) {
+	globalMenuEvents(state, MENU_ID_GLOBAL_4);
+}
+
+static void benchChannelSearch(struct BenchState* state) {
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CHANNEL, MENU_ID_CHANNEL_SEARCH_CLIENTS, CHANNEL);
+	}
+	state->itemsPerIteration = CLIENT_COUNT + 1;
+	mock_clearLaunches();
+	mock_clearMessages();
+}
+
+static void benchInitMenus(struct BenchState* state) {
+	struct PluginMenuItem** items;
+	char* icon;
+	unsigned long long i;
+	unsigned int m;
+
+	for(i = 0; i < state->iterations; i++) {
+		ts3plugin_initMenus(&items, &icon);
+		for(m = 0; items[m]; m++) {
+			ts3plugin_freeMemory(items[m]);
+		}
+		ts3plugin_freeMemory(items);
+		ts3plugin_freeMemory(icon);
+	}
+}
+
+static void findCommands(struct BenchState* state, const char* command) {
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		ts3plugin_processCommand(1, command);
+		mock_clearMessages();
+	}
+	state->itemsPerIteration = FIND_SERVER_COUNT * FIND_CLIENT_COUNT;
+}
+
+/* Nothing matches, every nickname of every tab is normalized and searched */
+static void benchFindMiss(struct BenchState* state) {
+	findCommands(state, "find Nobody Here");
+}
+
+/* A UID on the last tab, found only after all the others were scanned */
+static void benchFindUid(struct BenchState* state) {
+	findCommands(state, "find rQ0V1g4uGJm1xrhgBbzKy090999=");
+}
+
+/* Everyone matches, the scan stops at the result limit */
+static void benchFindEveryone(struct BenchState* state) {
+	findCommands(state, "find player");
+}
+
+#ifdef _WIN32
+static DWORD WINAPI idleThread(LPVOID parameter) {
+	return 0;
+}
+#else
+static void* idleThread(void* parameter) {
+	return NULL;
+}
+#endif
+
+/* The least a fan-out would add to every find: starting and joining one thread per tab that does nothing */
+static void benchThreadPerServer(struct BenchState* state) {
+#ifdef _WIN32
+	HANDLE threads[FIND_SERVER_COUNT];
+#else
+	pthread_t threads[FIND_SERVER_COUNT];
+#endif
+	unsigned long long i;
+	unsigned int n;
+
+	for(i = 0; i < state->iterations; i++) {
+		for(n = 0; n < FIND_SERVER_COUNT; n++) {
+#ifdef _WIN32
+			threads[n] = CreateThread(NULL, 0, idleThread, NULL, 0, NULL);
+#else
+			pthread_create(&threads[n], NULL, idleThread, NULL);
+#endif
+		}
+		for(n = 0; n < FIND_SERVER_COUNT; n++) {
+#ifdef _WIN32
+			WaitForSingleObject(threads[n], INFINITE);
+			CloseHandle(threads[n]);
+#else
+			pthread_join(threads[n], NULL);
+#endif
+		}
+	}
+}
+
+/* /searchby find over ten tabs of a thousand clients each, against the 16 ms of a frame */
+static void findSuite() {
+	char configPath[256];
+	char nickname[64];
+	char uid[32];
+	char name[32];
+	unsigned int server, i;
+
+	if(!bench_selected("find/") || bench_tempDirectory(configPath, sizeof(configPath), "find") != 0) {
+		return;
+	}
+	mock_reset(configPath);
+	mock_install();
+	ts3plugin_registerPluginID("bench_plugin");
+	if(ts3plugin_init() != 0) {
+		printf("ts3plugin_init failed\n");
+		return;
+	}
+	for(server = 1; server <= FIND_SERVER_COUNT; server++) {
+		snprintf(name, sizeof(name), "Benchmark Server %u", server);
+		snprintf(uid, sizeof(uid), "benchserver%02u=", server);
+		mock_addServer(server, name, uid, MY_ID);
+		mock_addClient(server, MY_ID, CHANNEL, "Myself", "myuid=", 1);
+		for(i = 0; i < FIND_CLIENT_COUNT; i++) {
+			snprintf(nickname, sizeof(nickname), "[Clan] Player N\xc3\xa4me %02u%04u", server, i);
+			snprintf(uid, sizeof(uid), "rQ0V1g4uGJm1xrhgBbzKy%02u%04u=", server - 1, i);
+			mock_addClient(server, (anyID)(2 + i), CHANNEL, nickname, uid, (int)(1000 + i));
+		}
+		ts3plugin_onConnectStatusChangeEvent(server, STATUS_CONNECTION_ESTABLISHED, 0);
+	}
+
+	bench_run("find/miss/10x1000", benchFindMiss);
+	bench_run("find/uid/10x1000", benchFindUid);
+	bench_run("find/everyone/10x1000", benchFindEveryone);
+	bench_run("find/thread-per-server", benchThreadPerServer);
+
+	ts3plugin_shutdown();
+}
+
+static void menuSuite() {
+	char configPath[256];
+	char nickname[64];
+	char uid[32];
+	unsigned int i;
+
+	if(!bench_selected("menu")) {
+		return;
+	}
+	if(bench_tempDirectory(configPath, sizeof(configPath), "plugin") != 0) {
+		printf("cannot create a temporary directory\n");
+		return;
+	}
+	mock_reset(configPath);
+	mock_install();
+	ts3plugin_registerPluginID("bench_plugin");
+	if(ts3plugin_init() != 0) {
+		printf("ts3plugin_init failed\n");
+		return;
+	}
+	snprintf(mock_addServer(SERVER, "Benchmark Server", "benchserveruid=", MY_ID)->ip, 64, "192.0.2.10");
+	mock_addClient(SERVER, MY_ID, CHANNEL, "Myself", "myuid=", 1);
+	for(i = 0; i < CLIENT_COUNT; i++) {
+		snprintf(nickname, sizeof(nickname), "[Clan] Player N\xc3\xa4me %03u", i);
+		snprintf(uid, sizeof(uid), "rQ0V1g4uGJm1xrhgBbzKycI%04u=", i);
+		mock_addClient(SERVER, (anyID)(2 + i), CHANNEL, nickname, uid, (int)(1000 + i));
+	}
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_CONNECTION_ESTABLISHED, 0);
+	recent_setWindow(0);  /* Repeated clicks on the same client are searches, not double clicks */
+
+	bench_run("menu/client-nickname/miss", benchNicknameMiss);
+	bench_run("menu/client-nickname/hit", benchNicknameHit);
+	bench_run("menu/client-uid/miss", benchUidMiss);
+	bench_run("menu/client-dbid/miss", benchDatabaseIDMiss);
+	bench_run("menu/server-name/hit", benchServerName);
+	bench_run("menu/server-ip/hit", benchServerIp);
+	bench_run("menu/channel-search", benchChannelSearch);
+	bench_run("menus/init", benchInitMenus);
+
+	ts3plugin_shutdown();
+}
+
+void bench_plugin() {
+	menuSuite();
+	findSuite();
+}
@@ -0,0 +1,108 @@
+/*
+ * Search By - protected nickname benchmarks
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "clientqueue.h"
+#include "editdist.h"
+#include "normalize.h"
+#include "protect.h"
+#include "bench.h"
+
+#define NAME_COUNT 32
+
+static const char* const joins[] = {
+	"Bluscream", "[Clan] Player Name", "xX_Sniper_Xx", "Müller", "Admin | AFK", "Moderat0r", "guest1234",
+	"Some Very Long Nickname With Spaces", "ニックネーム", "Server Owner", "TeamSpeak ][ Server", "Guardian_7"
+};
+
+#define JOIN_SAMPLES (sizeof(joins) / sizeof(joins[0]))
+
+/* Protected names are as long as the nicknames joining, so lengths alone rule few of them out */
+static const char* const staff[] = { "Admin", "Moderator", "Owner", "Bluscrean", "Guardian_", "SniperX", "Support", "Sergeant" };
+
+#define STAFF_SAMPLES (sizeof(staff) / sizeof(staff[0]))
+
+static char names[NAME_COUNT][32];
+static struct EditPattern patterns[NAME_COUNT];
+
+/* The whole list through protect_check, four names per editdist_batch pass */
+static void benchCheck(struct BenchState* state) {
+	unsigned long long i;
+	unsigned int distance;
+	int found = 0;
+
+	for(i = 0; i < state->iterations; i++) {
+		found += protect_check(joins[i % JOIN_SAMPLES], "benchuid=", &distance);
+	}
+	bench_use(&found);
+	state->itemsPerIteration = 1;
+}
+
+/* The same list one name at a time with the bounded single pattern kernel */
+static void benchSingle(struct BenchState* state) {
+	char skeleton[PROTECT_NICKNAME_BUFSIZE];
+	unsigned long long i;
+	unsigned int n, found = 0;
+	size_t length;
+
+	for(i = 0; i < state->iterations; i++) {
+		length = normalize_nickname(joins[i % JOIN_SAMPLES], skeleton, PROTECT_NICKNAME_BUFSIZE);
+		for(n = 0; n < NAME_COUNT; n++) {
+			found += editdist_bounded(&patterns[n], skeleton, length, PROTECT_MAX_DISTANCE);
+		}
+	}
+	bench_use(&found);
+	state->itemsPerIteration = 1;
+}
+
+/* What a join costs the callback thread */
+static void benchSubmit(struct BenchState* state) {
+	unsigned long long i;
+
+	for(i = 0; i < state->iterations; i++) {
+		protect_submit(1, (unsigned int)i, joins[i % JOIN_SAMPLES], "benchuid=");
+		if(i % 256 == 255) {
+			clientqueue_run();
+		}
+	}
+	clientqueue_run();
+	state->itemsPerIteration = 1;
+}
+
+void bench_protect() {
+	char directory[256];
+	char path[320];
+	char skeleton[PROTECT_NICKNAME_BUFSIZE];
+	unsigned int i;
+	size_t length;
+	FILE* file;
+
+	if(!bench_selected("protect/") || bench_tempDirectory(directory, sizeof(directory), "protect") != 0) {
+		return;
+	}
+	snprintf(path, sizeof(path), "%s%s", directory, PROTECT_FILENAME);
+	file = fopen(path, "wb");
+	if(!file) {
+		return;
+	}
+	for(i = 0; i < NAME_COUNT; i++) {
+		snprintf(names[i], sizeof(names[i]), "%s%c", staff[i % STAFF_SAMPLES], (char)('a' + i / STAFF_SAMPLES));
+		fprintf(file, "%s\tuid%u=\n", names[i], i);
+		length = normalize_nickname(names[i], skeleton, PROTECT_NICKNAME_BUFSIZE);
+		editdist_compile(&patterns[i], skeleton, length);
+	}
+	fclose(file);
+
+	clientqueue_init();
+	if(protect_init(NULL) != 0 || protect_load(path) != 0) {
+		clientqueue_shutdown();
+		return;
+	}
+	bench_run("protect/check/32-names", benchCheck);
+	bench_run("protect/single-kernel/32-names", benchSingle);
+	bench_run("protect/submit", benchSubmit);
+	protect_shutdown();
+	clientqueue_shutdown();
+}
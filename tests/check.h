@@ -0,0 +1,161 @@
+/*
+ * Search By - test assertions
+ *
+ * Every test program is a plain main() calling its test functions. A failed
+ * CHECK prints the location and counts the failure but the test goes on, so one
+ * run shows every broken expectation. CHECK_EXIT() returns the exit code for
+ * ctest.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <direct.h>
+#else
+#include <dirent.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#define inline __inline
+#endif
+
+static int checkFailures = 0;
+static int checkCount = 0;
+
+#define CHECK(condition) do { \
+	checkCount++; \
+	if(!(condition)) { \
+		checkFailures++; \
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+	} \
+} while(0)
+
+#define CHECK_EQ(actual, expected) do { \
+	const long long checkActual = (long long)(actual), checkExpected = (long long)(expected); \
+	checkCount++; \
+	if(checkActual != checkExpected) { \
+		checkFailures++; \
+		printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, checkActual, checkExpected); \
+	} \
+} while(0)
+
+#define CHECK_STR(actual, expected) do { \
+	const char* checkActual = (actual); \
+	const char* checkExpected = (expected); \
+	checkCount++; \
+	if(!checkActual || strcmp(checkActual, checkExpected) != 0) { \
+		checkFailures++; \
+		printf("%s:%d: %s is \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, checkActual ? checkActual : "(null)", checkExpected); \
+	} \
+} while(0)
+
+#define RUN(test) do { \
+	const int failuresBefore = checkFailures; \
+	test(); \
+	printf("%-40s %s\n", #test, checkFailures == failuresBefore ? "ok" : "FAILED"); \
+} while(0)
+
+#define CHECK_EXIT() (printf("%d checks, %d failed\n", checkCount, checkFailures), checkFailures ? 1 : 0)
+
+/* Small xorshift generator, tests must not depend on the platform's rand() */
+static unsigned long long checkRandomState = 0x9E3779B97F4A7C15ULL;
+
+static inline unsigned int checkRandom() {
+	checkRandomState ^= checkRandomState << 13;
+	checkRandomState ^= checkRandomState >> 7;
+	checkRandomState ^= checkRandomState << 17;
+	return (unsigned int)(checkRandomState >> 32);
+}
+
+/* Creates a fresh directory for the files of a test and writes its path, ending with a separator, to path */
+static inline int checkTempDirectory(char* path, size_t pathSize, const char* name) {
+#ifdef _WIN32
+	char base[MAX_PATH];
+	GetTempPathA(MAX_PATH, base);
+	sprintf_s(path, pathSize, "%ssearchby_%s_%lu\\", base, name, GetCurrentProcessId());
+	return _mkdir(path) == 0 ? 0 : 1;
+#else
+	snprintf(path, pathSize, "/tmp/searchby_%s_XXXXXX", name);
+	if(!mkdtemp(path)) {
+		return 1;
+	}
+	strncat(path, "/", pathSize - strlen(path) - 1);
+	return 0;
+#endif
+}
+
+#ifdef _WIN32
+static inline void checkRemoveTree(const char* path) {
+	char pattern[MAX_PATH];
+	char child[MAX_PATH];
+	WIN32_FIND_DATAA entry;
+	HANDLE find;
+
+	sprintf_s(pattern, MAX_PATH, "%s\\*", path);
+	find = FindFirstFileA(pattern, &entry);
+	if(find != INVALID_HANDLE_VALUE) {
+		do {
+			if(strcmp(entry.cFileName, ".") == 0 || strcmp(entry.cFileName, "..") == 0) {
+				continue;
+			}
+			sprintf_s(child, MAX_PATH, "%s\\%s", path, entry.cFileName);
+			if(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+				checkRemoveTree(child);
+			} else {
+				DeleteFileA(child);
+			}
+		} while(FindNextFileA(find, &entry));
+		FindClose(find);
+	}
+	RemoveDirectoryA(path);
+}
+#else
+static inline void checkRemoveTree(const char* path) {
+	char child[512];
+	struct dirent* entry;
+	struct stat info;
+	DIR* directory = opendir(path);
+
+	if(directory) {
+		while((entry = readdir(directory)) != NULL) {
+			if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+				continue;
+			}
+			if(snprintf(child, sizeof(child), "%s/%s", path, entry->d_name) >= (int)sizeof(child)) {
+				continue;
+			}
+			if(lstat(child, &info) == 0 && S_ISDIR(info.st_mode)) {
+				checkRemoveTree(child);
+			} else {
+				unlink(child);
+			}
+		}
+		closedir(directory);
+	}
+	rmdir(path);
+}
+#endif
+
+/* Removes a directory of checkTempDirectory with everything the test wrote into it */
+static inline void checkRemoveTempDirectory(const char* path) {
+	char directory[512];
+	size_t length = strlen(path);
+
+	/* Without the trailing separator */
+	if(length == 0 || length >= sizeof(directory)) {
+		return;
+	}
+	memcpy(directory, path, length - 1);
+	directory[length - 1] = '\0';
+	checkRemoveTree(directory);
+}
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ * Search By - local HTTP server for tests
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "httpstub.h"
+
+#define REQUEST_BUFSIZE 8192
+#define BODY_BUFSIZE 8192
+
+static const char* const routes[HTTPSTUB_ROUTE_COUNT] = { "/page", "/records", "/chunked", "/close", "/slow", "/etag", "/nostore", "/trickle", NULL };
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int hits[HTTPSTUB_ROUTE_COUNT];  /* The last one counts unknown routes */
+static unsigned int connections = 0;
+static char lastRequest[REQUEST_BUFSIZE];
+static int listener = -1;
+
+static int sendAll(int fd, const char* data, size_t length) {
+	ssize_t sent;
+
+	while(length > 0) {
+		sent = send(fd, data, length, MSG_NOSIGNAL);
+		if(sent <= 0) {
+			return 1;
+		}
+		data += sent;
+		length -= (size_t)sent;
+	}
+	return 0;
+}
+
+static int sendText(int fd, const char* text) {
+	return sendAll(fd, text, strlen(text));
+}
+
+/* Sends a complete response with Content-Length */
+static int respond(int fd, const char* status, const char* headers, const char* body) {
+	char head[1024];
+
+	snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: text/html\r\nContent-Length: %u\r\n%s\r\n", status, (unsigned int)strlen(body), headers);
+	return sendText(fd, head) || sendText(fd, body);
+}
+
+/* Sends one byte per segment, so the client gets every line and chunk in pieces */
+static int trickle(int fd, const char* text) {
+	const int on = 1;
+
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	for(; *text; text++) {
+		if(sendAll(fd, text, 1) != 0) {
+			return 1;
+		}
+		usleep(1000);
+	}
+	return 0;
+}
+
+/* Answers one request, returns 1 if the connection is to be closed */
+static int serve(int fd, const char* request) {
+	char path[256];
+	char body[BODY_BUFSIZE];
+	size_t length, half;
+	unsigned int route, i;
+
+	if(sscanf(request, "GET %255s", path) != 1) {
+		return 1;
+	}
+	path[strcspn(path, "?")] = '\0';
+	for(route = 0; routes[route] && strcmp(routes[route], path) != 0; route++);
+
+	pthread_mutex_lock(&mutex);
+	hits[route]++;
+	snprintf(lastRequest, sizeof(lastRequest), "%s", request);
+	pthread_mutex_unlock(&mutex);
+
+	switch(route) {
+		case 0:
+			return respond(fd, "200 OK", "Cache-Control: max-age=60\r\n", "<html><head><title>Stub page</title></head><body>Hello</body></html>");
+		case 1:
+			length = (size_t)snprintf(body, sizeof(body), "<html><head><title>Records</title></head><body><ul>");
+			for(i = 0; i < 12; i++) {
+				length += (size_t)snprintf(body + length, sizeof(body) - length, "<li><b>name%u</b><i>value%u</i></li>", i, i);
+			}
+			snprintf(body + length, sizeof(body) - length, "</ul></body></html>");
+			return respond(fd, "200 OK", "", body);
+		case 2:
+			return sendText(fd, "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nTransfer-Encoding: chunked\r\n\r\n"
+			                    "6\r\n<html>\r\n" "9\r\n<head><ti\r\n" "8\r\ntle>Chun\r\n" "a\r\nked</title\r\n" "8\r\n></head>\r\n"
+			                    "1;ext=1\r\nx\r\n" "0\r\n\r\n");
+		case 3:
+			sendText(fd, "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nConnection: close\r\n\r\n<title>Closed</title>until the end");
+			return 1;
+		case 4:
+			snprintf(body, sizeof(body), "<html><head><title>Slow page</title></head><body>%0500d</body></html>", 0);
+			length = strlen(body);
+			half = length / 2;
+			snprintf(path, sizeof(path), "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: %u\r\n\r\n", (unsigned int)length);
+			if(sendText(fd, path) || sendAll(fd, body, half)) {
+				return 1;
+			}
+			usleep(300 * 1000);
+			return sendAll(fd, body + half, length - half);
+		case 5:
+			if(strstr(request, "\r\nIf-None-Match: \"v1\"\r\n")) {
+				return sendText(fd, "HTTP/1.1 304 Not Modified\r\nETag: \"v1\"\r\nCache-Control: no-cache\r\n\r\n");
+			}
+			return respond(fd, "200 OK", "ETag: \"v1\"\r\nCache-Control: no-cache\r\n", "<html><head><title>Tagged</title></head></html>");
+		case 6:
+			return respond(fd, "200 OK", "Cache-Control: no-store\r\n", "<html><head><title>Not stored</title></head></html>");
+		case 7:
+			return trickle(fd, "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nTransfer-Encoding: chunked\r\n\r\n"
+			                   "1B;name=\"value\"\r\n<html><head><title>Trickled" "\r\n" "0008\r\n</title>\r\n"
+			                   "0\r\nX-Trailer: ignored\r\n\r\n");
+		default:
+			return respond(fd, "404 Not Found", "", "<html><head><title>Not found</title></head></html>");
+	}
+}
+
+static void* connectionThread(void* argument) {
+	const int fd = (int)(size_t)argument;
+	char request[REQUEST_BUFSIZE];
+	size_t length = 0, used;
+	ssize_t received;
+	char* end;
+
+	for(;;) {
+		received = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+		if(received <= 0) {
+			break;
+		}
+		length += (size_t)received;
+		request[length] = '\0';
+		/* Requests can arrive back to back in one read */
+		while((end = strstr(request, "\r\n\r\n")) != NULL) {
+			end[2] = '\0';
+			if(serve(fd, request) != 0) {
+				close(fd);
+				return NULL;
+			}
+			used = (size_t)(end + 4 - request);
+			memmove(request, request + used, length - used + 1);
+			length -= used;
+		}
+		if(length == sizeof(request) - 1) {
+			break;
+		}
+	}
+	close(fd);
+	return NULL;
+}
+
+static void* acceptThread(void* argument) {
+	pthread_t thread;
+	int fd;
+
+	for(;;) {
+		fd = accept(listener, NULL, NULL);
+		if(fd < 0) {
+			continue;
+		}
+		pthread_mutex_lock(&mutex);
+		connections++;
+		pthread_mutex_unlock(&mutex);
+		if(pthread_create(&thread, NULL, connectionThread, (void*)(size_t)fd) != 0) {
+			close(fd);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+	return NULL;
+}
+
+unsigned short httpstub_start() {
+	struct sockaddr_in address;
+	socklen_t addressLength = sizeof(address);
+	pthread_t thread;
+
+	listener = socket(AF_INET, SOCK_STREAM, 0);
+	if(listener < 0) {
+		return 0;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	if(bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0 ||
+	   getsockname(listener, (struct sockaddr*)&address, &addressLength) != 0) {
+		close(listener);
+		return 0;
+	}
+	if(pthread_create(&thread, NULL, acceptThread, NULL) != 0) {
+		close(listener);
+		return 0;
+	}
+	pthread_detach(thread);
+	return ntohs(address.sin_port);
+}
+
+unsigned int httpstub_hits(const char* route) {
+	unsigned int i, count = 0;
+
+	pthread_mutex_lock(&mutex);
+	for(i = 0; i < HTTPSTUB_ROUTE_COUNT; i++) {
+		if(!route || (routes[i] && strcmp(routes[i], route) == 0)) {
+			count += hits[i];
+		}
+	}
+	pthread_mutex_unlock(&mutex);
+	return count;
+}
+
+unsigned int httpstub_connections() {
+	unsigned int count;
+
+	pthread_mutex_lock(&mutex);
+	count = connections;
+	pthread_mutex_unlock(&mutex);
+	return count;
+}
+
+void httpstub_lastRequest(char* out, size_t outSize) {
+	pthread_mutex_lock(&mutex);
+	snprintf(out, outSize, "%s", lastRequest);
+	pthread_mutex_unlock(&mutex);
+}
+
+void httpstub_reset() {
+	pthread_mutex_lock(&mutex);
+	memset(hits, 0, sizeof(hits));
+	connections = 0;
+	lastRequest[0] = '\0';
+	pthread_mutex_unlock(&mutex);
+}
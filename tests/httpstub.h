@@ -0,0 +1,53 @@
+/*
+ * Search By - local HTTP server for tests
+ *
+ * Serves a few fixed routes on 127.0.0.1 from background threads, so the HTTP
+ * engine, the cache and /searchby fetch can be tested without the network.
+ * Connections are kept alive unless a route closes them. Every request is
+ * counted per route.
+ *
+ * Routes, the query string is ignored:
+ *   /page      200 with a title, Content-Length, cacheable for a minute
+ *   /records   200 with 12 <li> records of a name and a value
+ *   /chunked   200 with chunked encoding, the title split across chunks
+ *   /close     200 without length, the end of the body is the end of the connection
+ *   /slow      200 sent in two halves 300 ms apart
+ *   /etag      200 with ETag "v1" and no-cache, 304 if the request has If-None-Match: "v1"
+ *   /nostore   200 with Cache-Control: no-store
+ *   /trickle   200 with chunk extensions, padded sizes and a trailer, sent one byte at a time
+ *   anything else is a 404
+ *
+ * POSIX only.
+ */
+
+#ifndef HTTPSTUB_H
+#define HTTPSTUB_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTPSTUB_ROUTE_COUNT 9
+
+/* Starts the server on a free port. Returns the port, or 0 on failure. */
+unsigned short httpstub_start();
+
+/* Requests for a route like "/page", or all requests if route is NULL */
+unsigned int httpstub_hits(const char* route);
+
+/* Accepted connections */
+unsigned int httpstub_connections();
+
+/* Copies the request line and headers of the last request */
+void httpstub_lastRequest(char* out, size_t outSize);
+
+/* Zeroes the counters */
+void httpstub_reset();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,10 @@
+/*
+ * Search By - stand-in for the desktop URL opener
+ *
+ * The launcher benchmarks spawn this instead of xdg-open, so they measure the
+ * cost of starting a process and not the browser. Exits at once.
+ */
+
+int main(int argc, char** argv) {
+	return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Search By - resolved server address cache tests
+ */
+
+#include "check.h"
+#include "addrcache.h"
+
+static void testPutGet() {
+	addrcache_clear();
+	CHECK(addrcache_get(1) == NULL);
+	addrcache_put(1, "192.0.2.1");
+	addrcache_put(2, "ts.example.com");
+	CHECK_STR(addrcache_get(1), "192.0.2.1");
+	CHECK_STR(addrcache_get(2), "ts.example.com");
+	addrcache_put(1, "192.0.2.99");
+	CHECK_STR(addrcache_get(1), "192.0.2.99");
+}
+
+static void testRejected() {
+	char address[ADDRCACHE_ADDRESS_BUFSIZE + 1];
+
+	addrcache_clear();
+	addrcache_put(0, "192.0.2.1");  /* Handler IDs start at 1 */
+	CHECK(addrcache_get(0) == NULL);
+	memset(address, 'a', ADDRCACHE_ADDRESS_BUFSIZE);
+	address[ADDRCACHE_ADDRESS_BUFSIZE] = '\0';
+	addrcache_put(3, address);
+	CHECK(addrcache_get(3) == NULL);
+}
+
+/* Removing entries from the middle of probe sequences keeps every other entry reachable */
+static void testInvalidate() {
+	char address[32];
+	uint64 id;
+
+	addrcache_clear();
+	for(id = 1; id < ADDRCACHE_SIZE; id++) {
+		snprintf(address, sizeof(address), "10.0.0.%u", (unsigned int)id);
+		addrcache_put(id, address);
+	}
+	for(id = 1; id < ADDRCACHE_SIZE; id += 2) {
+		addrcache_invalidate(id);
+	}
+	addrcache_invalidate(1000);  /* Unknown IDs are ignored */
+	for(id = 1; id < ADDRCACHE_SIZE; id++) {
+		if(id % 2) {
+			CHECK(addrcache_get(id) == NULL);
+		} else {
+			snprintf(address, sizeof(address), "10.0.0.%u", (unsigned int)id);
+			CHECK_STR(addrcache_get(id), address);
+		}
+	}
+}
+
+/* One slot always stays free so lookups of unknown IDs end */
+static void testFull() {
+	uint64 id;
+
+	addrcache_clear();
+	for(id = 1; id <= ADDRCACHE_SIZE; id++) {
+		addrcache_put(id, "192.0.2.1");
+	}
+	CHECK(addrcache_get(ADDRCACHE_SIZE - 1) != NULL);
+	CHECK(addrcache_get(ADDRCACHE_SIZE) == NULL);
+	CHECK(addrcache_get(12345) == NULL);
+	addrcache_invalidate(1);
+	addrcache_put(ADDRCACHE_SIZE, "192.0.2.2");
+	CHECK_STR(addrcache_get(ADDRCACHE_SIZE), "192.0.2.2");
+	addrcache_clear();
+}
+
+int main() {
+	RUN(testPutGet);
+	RUN(testRejected);
+	RUN(testInvalidate);
+	RUN(testFull);
+	return CHECK_EXIT();
+}
@@ -0,0 +1,118 @@
+/*
+ * Search By - client snapshot cache tests
+ */
+
+#include "check.h"
+#include "clientcache.h"
+
+static void testSetAndFind() {
+	const struct ClientTable* table;
+	int row;
+
+	clientcache_clear();
+	CHECK(clientcache_table(1) == NULL);
+	CHECK_EQ(clientcache_find(1, 5), -1);
+	CHECK_EQ(clientcache_set(1, 5, 10, "Alice", "aliceuid=", 42), 0);
+	CHECK_EQ(clientcache_set(1, 6, 11, "Bob", "bobuid=", 0), 0);
+
+	table = clientcache_table(1);
+	CHECK(table != NULL);
+	CHECK_EQ(table->count, 2);
+	row = clientcache_find(1, 5);
+	CHECK(row >= 0);
+	CHECK_STR(table->nicknames[row], "Alice");
+	CHECK_STR(table->uids[row], "aliceuid=");
+	CHECK_EQ(table->databaseIDs[row], 42);
+	CHECK_EQ(table->channelIDs[row], 10);
+	CHECK_EQ(table->clientIDs[row], 5);
+
+	/* Setting a cached client replaces its fields instead of adding a row */
+	CHECK_EQ(clientcache_set(1, 5, 12, "Alice2", "aliceuid=", 43), 0);
+	CHECK_EQ(clientcache_table(1)->count, 2);
+	row = clientcache_find(1, 5);
+	CHECK_STR(clientcache_table(1)->nicknames[row], "Alice2");
+	CHECK_EQ(clientcache_table(1)->channelIDs[row], 12);
+}
+
+static void testUpdates() {
+	const struct ClientTable* table;
+
+	clientcache_clear();
+	clientcache_set(1, 5, 10, "Alice", "aliceuid=", 42);
+	CHECK_EQ(clientcache_setNickname(1, 5, "Alicia"), 0);
+	CHECK_EQ(clientcache_setChannel(1, 5, 99), 0);
+	CHECK_EQ(clientcache_setNickname(1, 6, "Nobody"), 1);
+	CHECK_EQ(clientcache_setChannel(2, 5, 99), 1);
+	table = clientcache_table(1);
+	CHECK_STR(table->nicknames[clientcache_find(1, 5)], "Alicia");
+	CHECK_EQ(table->channelIDs[clientcache_find(1, 5)], 99);
+
+	CHECK_EQ(clientcache_setServerUid(1, "serveruid="), 0);
+	CHECK_STR(clientcache_table(1)->serverUid, "serveruid=");
+}
+
+/* Removing a row moves the last one into its place, every other client stays findable */
+static void testRemove() {
+	const struct ClientTable* table;
+	char nickname[32];
+	anyID id;
+
+	clientcache_clear();
+	for(id = 1; id <= 1000; id++) {
+		snprintf(nickname, sizeof(nickname), "Client%u", (unsigned int)id);
+		CHECK_EQ(clientcache_set(1, id, 1, nickname, "uid=", id), 0);
+	}
+	for(id = 1; id <= 1000; id += 3) {
+		clientcache_remove(1, id);
+	}
+	clientcache_remove(1, 5000);
+	table = clientcache_table(1);
+	CHECK_EQ(table->count, 666);
+	for(id = 1; id <= 1000; id++) {
+		if((id - 1) % 3 == 0) {
+			CHECK_EQ(clientcache_find(1, id), -1);
+		} else {
+			snprintf(nickname, sizeof(nickname), "Client%u", (unsigned int)id);
+			CHECK_STR(table->nicknames[clientcache_find(1, id)], nickname);
+			CHECK_EQ(table->databaseIDs[clientcache_find(1, id)], id);
+		}
+	}
+}
+
+static void testServers() {
+	clientcache_clear();
+	clientcache_set(1, 5, 1, "Alice", "aliceuid=", 1);
+	clientcache_set(2, 5, 1, "Other Alice", "otheruid=", 2);
+	CHECK_STR(clientcache_table(1)->nicknames[clientcache_find(1, 5)], "Alice");
+	CHECK_STR(clientcache_table(2)->nicknames[clientcache_find(2, 5)], "Other Alice");
+	clientcache_clearServer(1);
+	CHECK(clientcache_table(1) == NULL);
+	CHECK_EQ(clientcache_find(1, 5), -1);
+	CHECK_EQ(clientcache_find(2, 5), 0);
+	clientcache_clear();
+	CHECK(clientcache_table(2) == NULL);
+}
+
+/* Overlong values are cut, never overflow the fixed columns */
+static void testTruncation() {
+	char nickname[CLIENTCACHE_NICKNAME_BUFSIZE * 2];
+	const struct ClientTable* table;
+
+	clientcache_clear();
+	memset(nickname, 'n', sizeof(nickname) - 1);
+	nickname[sizeof(nickname) - 1] = '\0';
+	clientcache_set(1, 1, 1, nickname, "0123456789012345678901234567890123456789", 0);
+	table = clientcache_table(1);
+	CHECK_EQ(strlen(table->nicknames[0]), CLIENTCACHE_NICKNAME_BUFSIZE - 1);
+	CHECK_EQ(strlen(table->uids[0]), CLIENTCACHE_UID_BUFSIZE - 1);
+	clientcache_clear();
+}
+
+int main() {
+	RUN(testSetAndFind);
+	RUN(testUpdates);
+	RUN(testRemove);
+	RUN(testServers);
+	RUN(testTruncation);
+	return CHECK_EXIT();
+}
@@ -0,0 +1,206 @@
+/*
+ * Search By - edit distance tests
+ */
+
+#include "check.h"
+#include "editdist.h"
+
+static unsigned int distance(const char* a, const char* b, unsigned int maxDistance) {
+	static struct EditPattern pattern;
+
+	editdist_compile(&pattern, a, strlen(a));
+	return editdist_bounded(&pattern, b, strlen(b), maxDistance);
+}
+
+/* The textbook dynamic programming table, one row at a time */
+static unsigned int referenceDistance(const char* a, size_t aLength, const char* b, size_t bLength) {
+	unsigned int row[EDITDIST_PATTERN_MAX + 1];
+	unsigned int diagonal, above, best;
+	size_t i, j;
+
+	for(j = 0; j <= bLength; j++) {
+		row[j] = (unsigned int)j;
+	}
+	for(i = 1; i <= aLength; i++) {
+		diagonal = row[0];
+		row[0] = (unsigned int)i;
+		for(j = 1; j <= bLength; j++) {
+			above = row[j];
+			best = diagonal + (a[i - 1] != b[j - 1]);
+			if(above + 1 < best) {
+				best = above + 1;
+			}
+			if(row[j - 1] + 1 < best) {
+				best = row[j - 1] + 1;
+			}
+			row[j] = best;
+			diagonal = above;
+		}
+	}
+	return row[bLength];
+}
+
+static void testKnownDistances() {
+	CHECK_EQ(distance("kitten", "sitting", 10), 3);
+	CHECK_EQ(distance("sitting", "kitten", 10), 3);
+	CHECK_EQ(distance("admin", "admin", 3), 0);
+	CHECK_EQ(distance("admin", "admln", 3), 1);
+	CHECK_EQ(distance("admin", "amdin", 3), 2);
+	CHECK_EQ(distance("", "abc", 5), 3);
+	CHECK_EQ(distance("abc", "", 5), 3);
+	CHECK_EQ(distance("flaw", "lawn", 5), 2);
+}
+
+/* Past the bound the result is maxDistance + 1, whatever the real distance is */
+static void testBound() {
+	CHECK_EQ(distance("kitten", "sitting", 2), 3);
+	CHECK_EQ(distance("abcdef", "uvwxyz", 1), 2);
+	CHECK_EQ(distance("abcdef", "abcdef", 0), 0);
+	CHECK_EQ(distance("abcdef", "abcdeg", 0), 1);
+}
+
+/* Patterns over 64 bytes span several words */
+static void testLongPatterns() {
+	char a[EDITDIST_PATTERN_MAX + 1];
+	char b[EDITDIST_PATTERN_MAX + 1];
+	unsigned int i;
+
+	for(i = 0; i < EDITDIST_PATTERN_MAX; i++) {
+		a[i] = (char)('a' + i % 26);
+	}
+	a[EDITDIST_PATTERN_MAX] = '\0';
+	memcpy(b, a, sizeof(a));
+	CHECK_EQ(distance(a, b, 3), 0);
+	b[10] = '#';
+	b[70] = '#';
+	CHECK_EQ(distance(a, b, 3), 2);
+	b[127] = '\0';
+	CHECK_EQ(distance(a, b, 3), 3);
+	CHECK_EQ(distance(a, b, 2), 3);
+}
+
+/*
+ * Random pairs on small alphabets, so there is something to match, from empty up to patterns of
+ * several words, agree with the table for every bound
+ */
+static void testAgainstReference() {
+	static struct EditPattern pattern;
+	char a[EDITDIST_PATTERN_MAX];
+	char b[EDITDIST_PATTERN_MAX];
+	unsigned int round, i, alphabet, expected, bound, mismatches = 0;
+	size_t aLength, bLength;
+
+	for(round = 0; round < 3000; round++) {
+		alphabet = 2 + round % 6;
+		aLength = round % 3 == 0 ? checkRandom() % (EDITDIST_PATTERN_MAX + 1) : checkRandom() % 40;
+		for(i = 0; i < aLength; i++) {
+			a[i] = (char)('a' + checkRandom() % alphabet);
+		}
+		/* Mostly a copy with a few edits, sometimes unrelated */
+		if(round % 4 == 0) {
+			bLength = checkRandom() % (EDITDIST_PATTERN_MAX + 1);
+			for(i = 0; i < bLength; i++) {
+				b[i] = (char)('a' + checkRandom() % alphabet);
+			}
+		} else {
+			memcpy(b, a, aLength);
+			bLength = aLength;
+			for(i = checkRandom() % 6; i > 0; i--) {
+				if(bLength > 0) {
+					b[checkRandom() % bLength] = (char)('a' + checkRandom() % alphabet);
+				}
+			}
+			if(bLength > 0 && round % 3 == 1) {
+				bLength--;
+			}
+		}
+		expected = referenceDistance(a, aLength, b, bLength);
+		editdist_compile(&pattern, a, aLength);
+		for(bound = 0; bound <= 8; bound++) {
+			if(editdist_bounded(&pattern, b, bLength, bound) != (expected <= bound ? expected : bound + 1)) {
+				mismatches++;
+			}
+		}
+		if(editdist_bounded(&pattern, b, bLength, EDITDIST_PATTERN_MAX) != expected) {
+			mismatches++;
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+}
+
+/* Every lane of a batch agrees with the single pattern kernel, including partly filled batches */
+static void testBatchMatchesSingle() {
+	static struct EditBatch batch;
+	static struct EditPattern patterns[EDITDIST_BATCH_LANES];
+	char words[EDITDIST_BATCH_LANES][EDITDIST_BATCH_MAX];
+	char text[100];
+	unsigned int distances[EDITDIST_BATCH_LANES];
+	unsigned int round, lane, count, i, textLength, bound, mismatches = 0;
+	size_t lengths[EDITDIST_BATCH_LANES];
+
+	for(round = 0; round < 2000; round++) {
+		count = 1 + checkRandom() % EDITDIST_BATCH_LANES;
+		editdist_batchClear(&batch);
+		for(lane = 0; lane < count; lane++) {
+			lengths[lane] = 1 + checkRandom() % EDITDIST_BATCH_MAX;
+			for(i = 0; i < lengths[lane]; i++) {
+				words[lane][i] = (char)('a' + checkRandom() % 4);
+			}
+			editdist_compile(&patterns[lane], words[lane], lengths[lane]);
+			CHECK_EQ(editdist_batchAdd(&batch, words[lane], lengths[lane]), lane);
+		}
+		textLength = round % 4 ? lengths[0] - lengths[0] / 4 + checkRandom() % (lengths[0] / 2 + 1) : checkRandom() % sizeof(text);
+		for(i = 0; i < textLength; i++) {
+			text[i] = (char)('a' + checkRandom() % 4);
+		}
+		bound = round % 2 ? 200 : checkRandom() % 8;
+		editdist_batch(&batch, text, textLength, bound, distances);
+		for(lane = 0; lane < count; lane++) {
+			if(distances[lane] != editdist_bounded(&patterns[lane], text, textLength, bound)) {
+				mismatches++;
+			}
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+}
+
+static void testBatchLimits() {
+	static struct EditBatch batch;
+	char longPattern[EDITDIST_BATCH_MAX + 1];
+	unsigned int distances[EDITDIST_BATCH_LANES];
+	unsigned int lane;
+
+	memset(longPattern, 'x', sizeof(longPattern));
+	editdist_batchClear(&batch);
+	CHECK_EQ(editdist_batchAdd(&batch, "", 0), -1);
+	CHECK_EQ(editdist_batchAdd(&batch, longPattern, sizeof(longPattern)), -1);
+	CHECK_EQ(editdist_batchAdd(&batch, longPattern, EDITDIST_BATCH_MAX), 0);
+	for(lane = 1; lane < EDITDIST_BATCH_LANES; lane++) {
+		CHECK_EQ(editdist_batchAdd(&batch, "admin", 5), lane);
+	}
+	CHECK_EQ(editdist_batchAdd(&batch, "admin", 5), -1);
+	editdist_batch(&batch, "admln", 5, 100, distances);
+	CHECK_EQ(distances[0], EDITDIST_BATCH_MAX);
+	CHECK_EQ(distances[1], 1);
+	editdist_batch(&batch, "admln", 5, 0, distances);
+	CHECK_EQ(distances[0], 1);
+	CHECK_EQ(distances[1], 1);
+	editdist_batch(&batch, "", 0, 100, distances);
+	CHECK_EQ(distances[EDITDIST_BATCH_LANES - 1], 5);
+
+	/* A partly filled batch stops as soon as its used lanes are past the bound */
+	editdist_batchClear(&batch);
+	CHECK_EQ(editdist_batchAdd(&batch, "admin", 5), 0);
+	editdist_batch(&batch, "zzzzzzzzzz", 10, 2, distances);
+	CHECK_EQ(distances[0], 3);
+}
+
+int main() {
+	RUN(testKnownDistances);
+	RUN(testBound);
+	RUN(testLongPatterns);
+	RUN(testAgainstReference);
+	RUN(testBatchMatchesSingle);
+	RUN(testBatchLimits);
+	return CHECK_EXIT();
+}
@@ -0,0 +1,159 @@
+/*
+ * Search By - url encoding tests
+ */
+
+#include <stdlib.h>
+#include "check.h"
+#include "encode.h"
+
+static const struct {
+	const char* in;
+	const char* out;
+} vectors[] = {
+	{ "", "" },
+	{ "abcXYZ019", "abcXYZ019" },
+	{ "-_.~", "-_.~" },
+	{ "a b", "a+b" },
+	{ "Foo&Bar=1", "Foo%26Bar%3d1" },
+	{ "100%", "100%25" },
+	{ "[TAG] Nick", "%5bTAG%5d+Nick" },
+	{ "\xc3\xbc", "%c3%bc" },
+	{ "rQ0V1g4uGJm1xrhgBbzKycIgNsw=", "rQ0V1g4uGJm1xrhgBbzKycIgNsw%3d" },
+	{ "ThisIsALongerNicknameOf32Bytes!!", "ThisIsALongerNicknameOf32Bytes%21%21" }
+};
+
+#define VECTOR_COUNT (sizeof(vectors) / sizeof(vectors[0]))
+
+static void testEncode() {
+	unsigned int i;
+	char* encoded;
+
+	for(i = 0; i < VECTOR_COUNT; i++) {
+		encoded = url_encode(vectors[i].in);
+		CHECK_STR(encoded, vectors[i].out);
+		free(encoded);
+	}
+}
+
+static void testEncodedLength() {
+	unsigned int i;
+
+	for(i = 0; i < VECTOR_COUNT; i++) {
+		CHECK_EQ(url_encoded_length(vectors[i].in, strlen(vectors[i].in)), strlen(vectors[i].out));
+	}
+}
+
+static void testEncodeInto() {
+	char out[128];
+	unsigned int i;
+
+	for(i = 0; i < VECTOR_COUNT; i++) {
+		CHECK_EQ(url_encode_into(vectors[i].in, strlen(vectors[i].in), out, sizeof(out)), strlen(vectors[i].out));
+		CHECK_STR(out, vectors[i].out);
+	}
+}
+
+/* A buffer without room for the terminator is left alone, the required length still comes back */
+static void testEncodeIntoTooSmall() {
+	char out[8] = "unused";
+
+	CHECK_EQ(url_encode_into("a&b c", 5, out, 7), 7);
+	CHECK_STR(out, "unused");
+	CHECK_EQ(url_encode_into("a&b c", 5, out, 8), 7);
+	CHECK_STR(out, "a%26b+c");
+}
+
+/* Straightforward encoder the vectorized ones are compared with */
+static size_t referenceEncode(const unsigned char* in, size_t length, char* out) {
+	static const char hex[] = "0123456789abcdef";
+	size_t i, o = 0;
+
+	for(i = 0; i < length; i++) {
+		if((in[i] >= 'a' && in[i] <= 'z') || (in[i] >= 'A' && in[i] <= 'Z') || (in[i] >= '0' && in[i] <= '9') ||
+		   in[i] == '-' || in[i] == '_' || in[i] == '.' || in[i] == '~') {
+			out[o++] = (char)in[i];
+		} else if(in[i] == ' ') {
+			out[o++] = '+';
+		} else {
+			out[o++] = '%';
+			out[o++] = hex[in[i] >> 4];
+			out[o++] = hex[in[i] & 15];
+		}
+	}
+	out[o] = '\0';
+	return o;
+}
+
+/* Random bytes, mostly ones that are copied so whole blocks take the fast path too */
+static void randomBytes(unsigned char* buffer, size_t length) {
+	static const char clean[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.~";
+	const unsigned int dirtyPercent = checkRandom() % 4 == 0 ? 0 : checkRandom() % 50;
+	size_t i;
+
+	for(i = 0; i < length; i++) {
+		if(checkRandom() % 100 < dirtyPercent) {
+			buffer[i] = (unsigned char)checkRandom();
+		} else {
+			buffer[i] = (unsigned char)clean[checkRandom() % (sizeof(clean) - 1)];
+		}
+	}
+}
+
+/* Encodes length bytes at offset in a buffer whose following bytes all need escaping, so reading past the input shows */
+static void compareWithReference(const unsigned char* input, size_t offset, size_t length) {
+	unsigned char buffer[256];
+	char expected[3 * 256 + 1];
+	char actual[3 * 256 + 1];
+	size_t expectedLength;
+
+	memset(buffer, '%', sizeof(buffer));
+	memcpy(buffer + offset, input, length);
+	expectedLength = referenceEncode(buffer + offset, length, expected);
+	CHECK_EQ(url_encoded_length((const char*)buffer + offset, length), expectedLength);
+	CHECK_EQ(url_encode_into((const char*)buffer + offset, length, actual, sizeof(actual)), expectedLength);
+	CHECK(strcmp(actual, expected) == 0);
+}
+
+/* Every instruction set the CPU has, on random inputs at every block tail length and alignment */
+static void testLevelsMatchReference() {
+	static const char* const names[] = { "scalar", "SSE2", "AVX2" };
+	const int best = url_encode_level();
+	unsigned char input[160];
+	int simd;
+	size_t length, offset;
+	unsigned int round, position;
+
+	for(simd = ENCODE_LEVEL_SCALAR; simd <= ENCODE_LEVEL_AVX2; simd++) {
+		if(url_encode_setLevel(simd) != 0) {
+			printf("  %s not available, skipped\n", names[simd]);
+			continue;
+		}
+		for(round = 0; round < 20; round++) {
+			for(length = 0; length <= 96; length++) {
+				for(offset = 0; offset < 32; offset++) {
+					randomBytes(input, length);
+					compareWithReference(input, offset, length);
+				}
+			}
+		}
+		/* A single byte to escape at every position of an otherwise clean input */
+		for(length = 1; length <= 96; length++) {
+			for(position = 0; position < length; position++) {
+				memset(input, 'a', length);
+				input[position] = position % 2 ? ' ' : 0xFF;
+				compareWithReference(input, position % 32, length);
+			}
+		}
+	}
+	CHECK_EQ(url_encode_setLevel(ENCODE_LEVEL_AVX2 + 1), 1);
+	CHECK_EQ(url_encode_setLevel(best), 0);
+}
+
+int main() {
+	RUN(testEncode);
+	RUN(testEncodedLength);
+	RUN(testEncodeInto);
+	RUN(testEncodeIntoTooSmall);
+	RUN(testLevelsMatchReference);
+	return CHECK_EXIT();
+}
@@ -0,0 +1,182 @@
+/*
+ * Search By - streaming field extractor tests
+ */
+
+#include "check.h"
+#include "extract.h"
+
+#define MAX_RECORDS 16
+
+static struct ExtractRecord records[MAX_RECORDS];
+static unsigned int recordCount;
+
+static void onRecord(void* context, const struct ExtractProfile* profile, const struct ExtractRecord* record) {
+	if(recordCount < MAX_RECORDS) {
+		records[recordCount] = *record;
+	}
+	recordCount++;
+}
+
+static void extractAll(const struct ExtractProfile* profile, const char* page) {
+	struct Extractor extractor;
+
+	recordCount = 0;
+	extract_begin(&extractor, profile, onRecord, NULL);
+	extract_feed(&extractor, page, strlen(page));
+	extract_end(&extractor);
+}
+
+static void testTitle() {
+	struct ExtractProfile profile;
+
+	extract_initProfile(&profile);
+	CHECK_EQ(extract_addField(&profile, "title", "<title>", "</title>"), 0);
+	extractAll(&profile, "<html><head><title>  Search\n results &amp; more  </title></head><title>second</title></html>");
+	CHECK_EQ(recordCount, 1);
+	CHECK_EQ(records[0].present, 1);
+	CHECK_STR(records[0].values[0], "Search results & more");  /* Only the first value of a record counts */
+}
+
+static void testRecords() {
+	static const char page[] =
+		"<table><tr class=\"row\"><td class=\"name\">Alice</td><td class=\"seen\">today</td></tr>"
+		"<tr class=\"row\"><td class=\"seen\">yesterday</td><td class=\"name\"><b>Bob</b> &lt;3</td></tr>"
+		"<tr class=\"row\"><td>nothing here</td></tr>"
+		"<tr class=\"row\"><td class=\"name\">Carl &#233;&#x263A;</td></table>";
+	struct ExtractProfile profile;
+
+	extract_initProfile(&profile);
+	CHECK_EQ(extract_addField(&profile, "record", "<tr class=\"row\">", NULL), 0);
+	CHECK_EQ(extract_addField(&profile, "name", "<td class=\"name\">", "</td>"), 0);
+	CHECK_EQ(extract_addField(&profile, "seen", "<td class=\"seen\">", "</td>"), 0);
+	CHECK_EQ(profile.fieldCount, 2);
+	extractAll(&profile, page);
+
+	CHECK_EQ(recordCount, 3);  /* Rows without any field are not records */
+	CHECK_EQ(records[0].present, 3);
+	CHECK_STR(records[0].values[0], "Alice");
+	CHECK_STR(records[0].values[1], "today");
+	CHECK_STR(records[1].values[0], "Bob <3");
+	CHECK_STR(records[1].values[1], "yesterday");
+	CHECK_EQ(records[2].present, 1);
+	CHECK_STR(records[2].values[0], "Carl \xc3\xa9\xe2\x98\xba");
+}
+
+static void testInvalidFields() {
+	struct ExtractProfile profile;
+	char name[16];
+	int i;
+
+	extract_initProfile(&profile);
+	CHECK_EQ(extract_addField(&profile, "name", "", "</td>"), 1);
+	CHECK_EQ(extract_addField(&profile, "name", "<td>", ""), 1);
+	CHECK_EQ(extract_addField(&profile, "", "<td>", "</td>"), 1);
+	for(i = 0; i < EXTRACT_MAX_FIELDS; i++) {
+		snprintf(name, sizeof(name), "f%d", i);
+		CHECK_EQ(extract_addField(&profile, name, "<td>", "</td>"), 0);
+	}
+	CHECK_EQ(extract_addField(&profile, "more", "<td>", "</td>"), 1);
+	CHECK_EQ(extract_addField(&profile, "f3", "<th>", "</th>"), 0);  /* Replaces the markers */
+	CHECK_EQ(profile.fieldCount, EXTRACT_MAX_FIELDS);
+}
+
+/* Near misses of every marker, so the automata fall back in the middle of a match, and an entity to split */
+static const char splitPage[] =
+	"<tr class=\"ro<tr class=\"row\"><td class=\"nam<td class=\"name\">Al&amp;ice</t</td>"
+	"<td class=\"seen\"><b>today</b></td></td></tr><tr class=\"row\"><td class=\"name\">&lt;Bob&gt;</td>";
+
+static void setUpSplitProfile(struct ExtractProfile* profile) {
+	extract_initProfile(profile);
+	extract_addField(profile, "record", "<tr class=\"row\">", NULL);
+	extract_addField(profile, "name", "<td class=\"name\">", "</td>");
+	extract_addField(profile, "seen", "<td class=\"seen\">", "</td>");
+}
+
+/* Returns 1 if the records equal those of the page fed in one piece */
+static int sameRecords(const struct ExtractRecord* expected, unsigned int expectedCount) {
+	unsigned int i, field;
+
+	if(recordCount != expectedCount) {
+		return 0;
+	}
+	for(i = 0; i < expectedCount; i++) {
+		if(records[i].present != expected[i].present) {
+			return 0;
+		}
+		for(field = 0; field < EXTRACT_MAX_FIELDS; field++) {
+			if((expected[i].present & (1u << field)) && strcmp(records[i].values[field], expected[i].values[field]) != 0) {
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/* Every way to cut the page into three chunks, empty ones included, and one byte at a time */
+static void testSplitAtEveryByte() {
+	struct ExtractRecord expected[MAX_RECORDS];
+	struct ExtractProfile profile;
+	struct Extractor extractor;
+	const size_t length = sizeof(splitPage) - 1;
+	unsigned int expectedCount, mismatches = 0;
+	size_t first, second, i;
+
+	setUpSplitProfile(&profile);
+	extractAll(&profile, splitPage);
+	CHECK_EQ(recordCount, 2);
+	CHECK_STR(records[0].values[0], "Al&ice");
+	CHECK_STR(records[0].values[1], "today");
+	CHECK_STR(records[1].values[0], "<Bob>");
+	expectedCount = recordCount;
+	memcpy(expected, records, sizeof(expected));
+
+	for(first = 0; first <= length; first++) {
+		for(second = first; second <= length; second++) {
+			recordCount = 0;
+			extract_begin(&extractor, &profile, onRecord, NULL);
+			extract_feed(&extractor, splitPage, first);
+			extract_feed(&extractor, splitPage + first, second - first);
+			extract_feed(&extractor, splitPage + second, length - second);
+			extract_end(&extractor);
+			mismatches += !sameRecords(expected, expectedCount);
+		}
+	}
+	recordCount = 0;
+	extract_begin(&extractor, &profile, onRecord, NULL);
+	for(i = 0; i < length; i++) {
+		extract_feed(&extractor, splitPage + i, 1);
+	}
+	extract_end(&extractor);
+	mismatches += !sameRecords(expected, expectedCount);
+	CHECK_EQ(mismatches, 0);
+}
+
+/* Values longer than the buffer are cut, and a value whose end never shows up is dropped */
+static void testLongValues() {
+	static char page[EXTRACT_VALUE_BUFSIZE * 40];
+	struct ExtractProfile profile;
+	size_t length;
+
+	extract_initProfile(&profile);
+	extract_addField(&profile, "v", "<v>", "</v>");
+	length = (size_t)snprintf(page, sizeof(page), "<v>");
+	memset(page + length, 'x', EXTRACT_VALUE_BUFSIZE * 2);
+	strcpy(page + length + EXTRACT_VALUE_BUFSIZE * 2, "</v>");
+	extractAll(&profile, page);
+	CHECK_EQ(recordCount, 1);
+	CHECK_EQ(strlen(records[0].values[0]), EXTRACT_VALUE_BUFSIZE - 1);
+
+	memset(page + length, 'x', sizeof(page) - length - 1);
+	page[sizeof(page) - 1] = '\0';
+	extractAll(&profile, page);
+	CHECK_EQ(recordCount, 0);
+}
+
+int main() {
+	RUN(testTitle);
+	RUN(testRecords);
+	RUN(testInvalidFields);
+	RUN(testSplitAtEveryByte);
+	RUN(testLongValues);
+	return CHECK_EXIT();
+}
@@ -0,0 +1,158 @@
+/*
+ * Search By - /searchby fetch tests against the local HTTP server
+ */
+
+#include <time.h>
+#include <unistd.h>
+#include "check.h"
+#include "ts3mock.h"
+#include "plugin.h"
+#include "providers.h"
+#include "httpstub.h"
+
+#define SERVER 1
+#define WAIT_MS 5000
+
+static char configPath[256];
+static unsigned short port;
+
+static int writeProviders();
+
+static void sleepMs(unsigned int milliseconds) {
+	usleep(milliseconds * 1000);
+}
+
+/* Waits until the server saw count requests for a route, then a bit longer for the engine to finish */
+static int waitForHits(const char* route, unsigned int count) {
+	unsigned int waited;
+
+	for(waited = 0; waited < WAIT_MS && httpstub_hits(route) < count; waited += 10) {
+		sleepMs(10);
+	}
+	sleepMs(200);
+	return httpstub_hits(route) >= count;
+}
+
+/* Gives the plugin client callbacks until text was printed */
+static int waitForMessage(const char* text) {
+	unsigned int waited;
+
+	for(waited = 0; waited < WAIT_MS; waited += 10) {
+		ts3plugin_onTalkStatusChangeEvent(SERVER, 0, 0, 2);
+		if(mock_printed(text)) {
+			return 1;
+		}
+		sleepMs(10);
+	}
+	return 0;
+}
+
+/* The response arrives on the engine thread, but only the next client callback prints it */
+static void testResultWaitsForClientThread() {
+	mock_clearMessages();
+	ts3plugin_processCommand(SERVER, "fetch stub first");
+	CHECK(mock_printed("Fetching"));
+	CHECK(waitForHits("/page", 1));
+	CHECK(!mock_printed("HTTP 200"));
+	CHECK(waitForMessage("stub \"first\": HTTP 200, 68 bytes, \"Stub page\""));
+	CHECK_EQ(mock_offThreadCalls(), 0);
+}
+
+/* A page in the cache is printed before the command returns */
+static void testCachedResult() {
+	const unsigned int hits = httpstub_hits("/page");
+
+	mock_clearMessages();
+	ts3plugin_processCommand(SERVER, "fetch stub first");
+	CHECK(mock_printed("stub \"first\": HTTP 200, 68 bytes, \"Stub page\""));
+	CHECK_EQ(httpstub_hits("/page"), hits);
+}
+
+static void testRecords() {
+	mock_clearMessages();
+	ts3plugin_processCommand(SERVER, "fetch recs list");
+	CHECK(waitForMessage("recs \"list\": HTTP 200"));
+	CHECK(mock_printed("recs \"list\": HTTP 200, "));
+	CHECK(mock_printed(", 12 records"));
+	CHECK(mock_printed("recs: name=name0 value=value0"));
+	CHECK(mock_printed("recs: name=name9 value=value9"));
+	CHECK(!mock_printed("name=name10"));  /* Only the first records are printed */
+	CHECK_EQ(mock_offThreadCalls(), 0);
+}
+
+/* Fetch times and errors reach the statistics through the client thread too */
+static void testStatistics() {
+	mock_clearMessages();
+	ts3plugin_processCommand(SERVER, "fetch gone term");
+	CHECK(waitForMessage("gone \"term\": HTTP 404"));
+	mock_clearMessages();
+	ts3plugin_processCommand(SERVER, "stats");
+	CHECK(mock_printed("custom fetch: 3, "));
+	CHECK(mock_printed("custom errors: term 0, launch 0, fetch 1"));
+	CHECK_EQ(mock_offThreadCalls(), 0);
+}
+
+/* A reload while a fetch is running keeps the old table, with the fetch's extraction profile, until the fetch is done */
+static void testReloadDuringFetch() {
+	unsigned int waited;
+
+	mock_clearMessages();
+	CHECK_EQ(providers_retired(), 0);
+	ts3plugin_processCommand(SERVER, "fetch slow term");
+	CHECK(writeProviders() == 0);
+	for(waited = 0; waited < WAIT_MS && providers_retired() == 0; waited += 10) {
+		sleepMs(10);
+	}
+	CHECK_EQ(providers_retired(), 1);
+	ts3plugin_onTalkStatusChangeEvent(SERVER, 0, 0, 2);  /* Runs the reclaim the reload queued */
+	CHECK(!mock_printed("slow \"term\": HTTP"));
+	CHECK_EQ(providers_retired(), 1);
+
+	CHECK(waitForMessage("slow \"term\": HTTP 200"));
+	CHECK_EQ(providers_retired(), 0);
+	CHECK_EQ(mock_offThreadCalls(), 0);
+}
+
+static int writeProviders() {
+	char path[512];
+	FILE* file;
+
+	snprintf(path, sizeof(path), "%ssearch_by_providers.txt", configPath);
+	file = fopen(path, "w");
+	if(!file) {
+		return 1;
+	}
+	fprintf(file, "stub\thttp://127.0.0.1:%u/page?q={term}\n", port);
+	fprintf(file, "recs\thttp://127.0.0.1:%u/records?q={term}\n", port);
+	fprintf(file, "@recs\trecord\t<li>\n@recs\tname\t<b>\t</b>\n@recs\tvalue\t<i>\t</i>\n");
+	fprintf(file, "gone\thttp://127.0.0.1:%u/missing?q={term}\n", port);
+	fprintf(file, "slow\thttp://127.0.0.1:%u/slow?q={term}\n@slow\ttitle\t<title>\t</title>\n", port);
+	fclose(file);
+	return 0;
+}
+
+int main() {
+	port = httpstub_start();
+	if(port == 0 || checkTempDirectory(configPath, sizeof(configPath), "fetch") != 0 || writeProviders() != 0) {
+		printf("cannot set up the server or the config directory\n");
+		return 1;
+	}
+	mock_reset(configPath);
+	mock_install();
+	mock_addServer(SERVER, "Test Server", "serveruid=", 1);
+	ts3plugin_registerPluginID("test_fetch");
+	if(ts3plugin_init() != 0) {
+		printf("ts3plugin_init failed\n");
+		return 1;
+	}
+
+	RUN(testResultWaitsForClientThread);
+	RUN(testCachedResult);
+	RUN(testRecords);
+	RUN(testStatistics);
+	RUN(testReloadDuringFetch);
+
+	ts3plugin_shutdown();
+	checkRemoveTempDirectory(configPath);
+	return CHECK_EXIT();
+}
@@ -0,0 +1,201 @@
+/*
+ * Search By - HTTP engine tests against the local HTTP server
+ */
+
+#include <time.h>
+#include <unistd.h>
+#include "check.h"
+#include "http.h"
+#include "httpstub.h"
+
+#define WAIT_MS 8000
+
+/* What one request got, written on the engine thread until done is set */
+struct Response {
+	char body[4096];
+	size_t length;
+	enum HttpError error;
+	int status;
+	unsigned long long doneMs;
+	int done;
+};
+
+static char base[64];
+
+static unsigned long long nowMs() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000 + (unsigned long long)ts.tv_nsec / 1000000;
+}
+
+static void responseBody(void* context, const char* data, size_t length) {
+	struct Response* response = (struct Response*)context;
+
+	if(response->length + length < sizeof(response->body)) {
+		memcpy(response->body + response->length, data, length);
+		response->length += length;
+	}
+}
+
+static void responseDone(void* context, enum HttpError error, int status) {
+	struct Response* response = (struct Response*)context;
+
+	response->error = error;
+	response->status = status;
+	response->doneMs = nowMs();
+	__atomic_store_n(&response->done, 1, __ATOMIC_RELEASE);
+}
+
+static const struct HttpHandler responseHandler = { responseBody, responseDone, NULL };
+
+/* Queues a request for a route of the stub. Returns the http_getWithHeaders result. */
+static enum HttpError submit(const char* route, const char* headers, struct Response* response) {
+	char url[128];
+
+	memset(response, 0, sizeof(*response));
+	snprintf(url, sizeof(url), "%s%s", base, route);
+	return http_getWithHeaders(url, headers, &responseHandler, response);
+}
+
+/* Waits until the response is done. Returns 1 if it completed in time. */
+static int waitFor(struct Response* response) {
+	unsigned int waited;
+
+	for(waited = 0; waited < WAIT_MS && !__atomic_load_n(&response->done, __ATOMIC_ACQUIRE); waited += 5) {
+		usleep(5 * 1000);
+	}
+	return __atomic_load_n(&response->done, __ATOMIC_ACQUIRE);
+}
+
+static int get(const char* route, struct Response* response) {
+	return submit(route, NULL, response) == HTTP_OK && waitFor(response);
+}
+
+/* Every test starts with a fresh engine, so each has the full burst of its host's token bucket */
+static void setUp() {
+	http_shutdown();
+	http_init();
+	httpstub_reset();
+}
+
+static void testChunked() {
+	struct Response response;
+
+	setUp();
+	CHECK(get("/chunked", &response));
+	CHECK_EQ(response.error, HTTP_OK);
+	CHECK_EQ(response.status, 200);
+	response.body[response.length] = '\0';
+	CHECK_STR(response.body, "<html><head><title>Chunked</title></head>x");
+}
+
+/* Sizes with extensions and leading zeros, and a trailer, each line arriving in one byte pieces */
+static void testTrickledChunks() {
+	struct Response response;
+
+	setUp();
+	CHECK(get("/trickle", &response));
+	CHECK_EQ(response.error, HTTP_OK);
+	CHECK_EQ(response.status, 200);
+	response.body[response.length] = '\0';
+	CHECK_STR(response.body, "<html><head><title>Trickled</title>");
+
+	/* The trailer ended the response, the connection is reused for the next one */
+	CHECK(get("/page", &response));
+	CHECK_EQ(response.status, 200);
+	CHECK_EQ(response.length, 68);
+	CHECK_EQ(httpstub_connections(), 1);
+}
+
+static void testCloseDelimited() {
+	struct Response response;
+
+	setUp();
+	CHECK(get("/close", &response));
+	CHECK_EQ(response.error, HTTP_OK);
+	response.body[response.length] = '\0';
+	CHECK_STR(response.body, "<title>Closed</title>until the end");
+}
+
+static void testErrors() {
+	struct Response response;
+
+	setUp();
+	CHECK(get("/missing", &response));
+	CHECK_EQ(response.error, HTTP_OK);
+	CHECK_EQ(response.status, 404);
+	CHECK_EQ(http_get("https://127.0.0.1/", &responseHandler, &response), HTTP_ERROR_URL);
+	CHECK_EQ(http_get("ftp://127.0.0.1/", &responseHandler, &response), HTTP_ERROR_URL);
+}
+
+/* Requests for a URL already in flight share its response, unless their headers differ */
+static void testSingleFlight() {
+	struct Response responses[4];
+	unsigned int i;
+
+	setUp();
+	for(i = 0; i < 3; i++) {
+		CHECK_EQ(submit("/slow", NULL, &responses[i]), HTTP_OK);
+	}
+	CHECK_EQ(submit("/slow", "X-Other: 1\r\n", &responses[3]), HTTP_OK);
+	for(i = 0; i < 4; i++) {
+		CHECK(waitFor(&responses[i]));
+		CHECK_EQ(responses[i].error, HTTP_OK);
+		CHECK_EQ(responses[i].status, 200);
+		CHECK_EQ(responses[i].length, responses[0].length);
+	}
+	CHECK(responses[0].length > 500);
+	CHECK_EQ(httpstub_hits("/slow"), 2);
+}
+
+/* HTTP_RATE_BURST requests go out at once, the others one per HTTP_RATE_INTERVAL_MS in submit order */
+static void testPacing() {
+	struct Response responses[HTTP_RATE_BURST + 2];
+	char route[32];
+	unsigned long long started;
+	unsigned int i;
+
+	setUp();
+	started = nowMs();
+	for(i = 0; i < HTTP_RATE_BURST + 2; i++) {
+		snprintf(route, sizeof(route), "/page?%u", i);  /* Distinct URLs, nothing is shared */
+		CHECK_EQ(submit(route, NULL, &responses[i]), HTTP_OK);
+	}
+	for(i = 0; i < HTTP_RATE_BURST + 2; i++) {
+		CHECK(waitFor(&responses[i]));
+		CHECK_EQ(responses[i].status, 200);
+	}
+	for(i = 0; i < HTTP_RATE_BURST; i++) {
+		CHECK(responses[i].doneMs - started < HTTP_RATE_INTERVAL_MS / 2);
+	}
+	CHECK(responses[HTTP_RATE_BURST].doneMs - started >= HTTP_RATE_INTERVAL_MS - 50);
+	CHECK(responses[HTTP_RATE_BURST + 1].doneMs - started >= 2 * HTTP_RATE_INTERVAL_MS - 50);
+	CHECK(responses[HTTP_RATE_BURST + 1].doneMs - started < 4 * HTTP_RATE_INTERVAL_MS);
+	CHECK(responses[HTTP_RATE_BURST].doneMs <= responses[HTTP_RATE_BURST + 1].doneMs);
+	CHECK_EQ(httpstub_hits("/page"), HTTP_RATE_BURST + 2);
+}
+
+int main() {
+	unsigned short port = httpstub_start();
+
+	if(port == 0) {
+		printf("cannot start the HTTP server\n");
+		return 1;
+	}
+	snprintf(base, sizeof(base), "http://127.0.0.1:%u", port);
+	if(http_init() != 0) {
+		printf("cannot start the HTTP engine\n");
+		return 1;
+	}
+
+	RUN(testChunked);
+	RUN(testTrickledChunks);
+	RUN(testCloseDelimited);
+	RUN(testErrors);
+	RUN(testSingleFlight);
+	RUN(testPacing);
+
+	http_shutdown();
+	return CHECK_EXIT();
+}
@@ -0,0 +1,212 @@
+/*
+ * Search By - HTTP cache tests against the local HTTP server
+ */
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include "check.h"
+#include "http.h"
+#include "httpcache.h"
+#include "httpstub.h"
+
+#define WAIT_MS 5000
+
+/* What one fetch got, written on the engine thread until done is set */
+struct Response {
+	char body[4096];
+	size_t length;
+	enum HttpError error;
+	int status;
+	int done;
+};
+
+static char configPath[256];
+static char base[64];
+
+static void responseBody(void* context, const char* data, size_t length) {
+	struct Response* response = (struct Response*)context;
+
+	if(response->length + length < sizeof(response->body)) {
+		memcpy(response->body + response->length, data, length);
+		response->length += length;
+	}
+}
+
+static void responseDone(void* context, enum HttpError error, int status) {
+	struct Response* response = (struct Response*)context;
+
+	response->error = error;
+	response->status = status;
+	__atomic_store_n(&response->done, 1, __ATOMIC_RELEASE);
+}
+
+static const struct HttpHandler responseHandler = { responseBody, responseDone, NULL };
+
+/* Gets a route of the stub through the cache and waits for the response. Returns 1 if it completed. */
+static int get(const char* route, struct Response* response) {
+	char url[128];
+	unsigned int waited;
+
+	memset(response, 0, sizeof(*response));
+	snprintf(url, sizeof(url), "%s%s", base, route);
+	if(httpcache_get(url, &responseHandler, response) != HTTP_OK) {
+		return 0;
+	}
+	for(waited = 0; waited < WAIT_MS && !__atomic_load_n(&response->done, __ATOMIC_ACQUIRE); waited += 10) {
+		usleep(10 * 1000);
+	}
+	return __atomic_load_n(&response->done, __ATOMIC_ACQUIRE);
+}
+
+/* The file an entry is stored in, the FNV-1a hash of the normalized URL */
+static void cacheFile(const char* directory, const char* route, char* path, size_t pathSize) {
+	char url[128];
+	unsigned long long hash = 14695981039346656037ULL;
+	const char* p;
+
+	snprintf(url, sizeof(url), "%s%s", base, route);
+	for(p = url; *p; p++) {
+		hash ^= (unsigned char)*p;
+		hash *= 1099511628211ULL;
+	}
+	snprintf(path, pathSize, "%s" HTTPCACHE_DIRECTORY "/%016llx.cache", directory, hash);
+}
+
+static int exists(const char* path) {
+	struct stat info;
+
+	return stat(path, &info) == 0;
+}
+
+static void testFreshReplay() {
+	struct Response response;
+	unsigned int hits;
+
+	CHECK(get("/page", &response));
+	CHECK_EQ(response.status, 200);
+	hits = httpstub_hits("/page");
+	CHECK(get("/page", &response));
+	CHECK_EQ(response.status, 200);
+	CHECK_EQ(response.length, 68);
+	CHECK_EQ(httpstub_hits("/page"), hits);
+}
+
+static void testRevalidation() {
+	struct Response response;
+	char request[1024];
+
+	httpstub_reset();
+	CHECK(get("/etag", &response));
+	CHECK_EQ(response.status, 200);
+	CHECK(response.length > 0);
+
+	/* no-cache makes the entry stale at once, the 304 replays it from disk */
+	CHECK(get("/etag", &response));
+	CHECK_EQ(response.error, HTTP_OK);
+	CHECK_EQ(response.status, 200);
+	CHECK(response.length > 0);
+	CHECK_EQ(httpstub_hits("/etag"), 2);
+	httpstub_lastRequest(request, sizeof(request));
+	CHECK(strstr(request, "If-None-Match: \"v1\"") != NULL);
+}
+
+/* A 304 for an entry whose file is gone fetches the full response again instead of passing on an empty 304 */
+static void testRevalidationWithoutFile() {
+	struct Response response;
+	char path[512];
+	char request[1024];
+
+	httpstub_reset();
+	cacheFile(configPath, "/etag", path, sizeof(path));
+	CHECK(exists(path));
+	CHECK_EQ(remove(path), 0);
+
+	CHECK(get("/etag", &response));
+	CHECK_EQ(response.error, HTTP_OK);
+	CHECK_EQ(response.status, 200);
+	CHECK(response.length > 0);
+	CHECK_EQ(httpstub_hits("/etag"), 2);
+	httpstub_lastRequest(request, sizeof(request));
+	CHECK(strstr(request, "If-None-Match") == NULL);
+	CHECK(exists(path));  /* Stored again */
+}
+
+/* An entry is only forgotten once its file is deleted, until then it is evicted again on every store */
+static void testUndeletableEntry() {
+	struct Response response;
+	char directory[320];
+	char first[512], second[512], third[512], blocker[600];
+	struct stat info;
+	FILE* file;
+
+	/* One /page entry in a cache of its own tells the entry size */
+	snprintf(directory, sizeof(directory), "%ssized/", configPath);
+	CHECK_EQ(mkdir(directory, 0700), 0);
+	httpcache_close();
+	CHECK_EQ(httpcache_open(directory, 1 << 20), 0);
+	CHECK(get("/page?a", &response));
+	cacheFile(directory, "/page?a", first, sizeof(first));
+	CHECK_EQ(stat(first, &info), 0);
+	httpcache_close();
+
+	/* Room for one and a half entries */
+	snprintf(directory, sizeof(directory), "%sbudget/", configPath);
+	CHECK_EQ(mkdir(directory, 0700), 0);
+	CHECK_EQ(httpcache_open(directory, (unsigned long long)info.st_size * 3 / 2), 0);
+	cacheFile(directory, "/page?a", first, sizeof(first));
+	cacheFile(directory, "/page?b", second, sizeof(second));
+	cacheFile(directory, "/page?c", third, sizeof(third));
+	CHECK(get("/page?a", &response));
+	CHECK(exists(first));
+
+	/* A non-empty directory in place of the file cannot be removed, even by root */
+	CHECK_EQ(remove(first), 0);
+	CHECK_EQ(mkdir(first, 0700), 0);
+	snprintf(blocker, sizeof(blocker), "%s/blocker", first);
+	file = fopen(blocker, "wb");
+	CHECK(file != NULL);
+	if(file) {
+		fclose(file);
+	}
+	CHECK(get("/page?b", &response));
+	CHECK(exists(first));
+	CHECK(exists(second));
+
+	/* Once it can be deleted, the next store evicts it, oldest first */
+	CHECK_EQ(remove(blocker), 0);
+	CHECK(get("/page?c", &response));
+	CHECK(!exists(first));
+	CHECK(!exists(second));
+	CHECK(exists(third));
+	httpcache_close();
+	CHECK_EQ(httpcache_open(configPath, 1 << 20), 0);
+}
+
+int main() {
+	unsigned short port;
+
+	if(checkTempDirectory(configPath, sizeof(configPath), "httpcache") != 0) {
+		printf("cannot create a temporary directory\n");
+		return 1;
+	}
+	port = httpstub_start();
+	if(port == 0) {
+		printf("cannot start the HTTP server\n");
+		return 1;
+	}
+	snprintf(base, sizeof(base), "http://127.0.0.1:%u", port);
+	if(http_init() != 0 || httpcache_open(configPath, 1 << 20) != 0) {
+		printf("cannot start the HTTP engine or open the cache\n");
+		return 1;
+	}
+
+	RUN(testFreshReplay);
+	RUN(testRevalidation);
+	RUN(testRevalidationWithoutFile);
+	RUN(testUndeletableEntry);
+
+	httpcache_close();
+	http_shutdown();
+	checkRemoveTempDirectory(configPath);
+	return CHECK_EXIT();
+}
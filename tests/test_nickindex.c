@@ -0,0 +1,188 @@
+/*
+ * Search By - fuzzy nickname index tests
+ */
+
+#include "check.h"
+#include "editdist.h"
+#include "nickindex.h"
+
+static const char* const nicknames[] = {
+	"Administrator", "Admin", "Moderator", "xXSniperXx", "PlayerOne", "PlayerTwo", "Bob", "Alice", "Guest1234", "Guest4321"
+};
+
+#define NICKNAME_COUNT (sizeof(nicknames) / sizeof(nicknames[0]))
+
+static void addAll() {
+	unsigned int i;
+
+	nickindex_clear();
+	for(i = 0; i < NICKNAME_COUNT; i++) {
+		CHECK_EQ(nickindex_add(nicknames[i], 100 + i), i);
+	}
+}
+
+/* Returns the tag of a match with the given skeleton and distance, or -1 */
+static int findMatch(const struct NickMatch* matches, int count, const char* skeleton, unsigned int distance) {
+	int i;
+
+	for(i = 0; i < count; i++) {
+		if(strcmp(nickindex_nickname(matches[i].id), skeleton) == 0 && matches[i].distance == distance) {
+			return (int)nickindex_tag(matches[i].id);
+		}
+	}
+	return -1;
+}
+
+static void testExactAndFuzzy() {
+	struct NickMatch matches[16];
+	int count, i;
+
+	addAll();
+	CHECK_EQ(nickindex_count(), NICKNAME_COUNT);
+
+	count = nickindex_search("PlayerOne", 0, matches, 16);
+	CHECK_EQ(count, 1);
+	CHECK_EQ(findMatch(matches, count, "playerone", 0), 104);
+
+	count = nickindex_search("PlayerOme", 2, matches, 16);
+	CHECK_EQ(findMatch(matches, count, "playerone", 1), 104);
+	CHECK_EQ(findMatch(matches, count, "playertwo", 2), -1);  /* Three edits away */
+
+	count = nickindex_search("Guest1243", 2, matches, 16);
+	CHECK_EQ(findMatch(matches, count, "guestl234", 2), 108);
+
+	/* Closest first */
+	count = nickindex_search("Administrater", 3, matches, 16);
+	CHECK(count >= 1);
+	CHECK_STR(nickindex_nickname(matches[0].id), "administrator");
+	for(i = 1; i < count; i++) {
+		CHECK(matches[i - 1].distance <= matches[i].distance);
+	}
+}
+
+/* Nicknames are matched by skeleton, so look-alikes find each other */
+static void testLookAlikes() {
+	struct NickMatch matches[16];
+	int count;
+
+	addAll();
+	count = nickindex_search("\xd0\x90" "dmin", 0, matches, 16);  /* Cyrillic A */
+	CHECK_EQ(findMatch(matches, count, "admin", 0), 101);
+	count = nickindex_search("ADMlN", 0, matches, 16);
+	CHECK_EQ(count, 0);  /* "admln" is one edit from "admin" */
+	count = nickindex_search("ADMlN", 1, matches, 16);
+	CHECK_EQ(findMatch(matches, count, "admin", 1), 101);
+}
+
+/* Adding a known skeleton again only updates its tag */
+static void testDuplicateUpdatesTag() {
+	struct NickMatch matches[4];
+	int id, count;
+
+	addAll();
+	id = nickindex_add("bob", 555);
+	CHECK_EQ(id, 6);
+	CHECK_EQ(nickindex_count(), NICKNAME_COUNT);
+	count = nickindex_search("Bob", 0, matches, 4);
+	CHECK_EQ(count, 1);
+	CHECK_EQ(nickindex_tag(matches[0].id), 555);
+}
+
+static void testMaxMatches() {
+	struct NickMatch matches[2];
+	char nickname[32];
+	int i;
+
+	nickindex_clear();
+	for(i = 0; i < 50; i++) {
+		snprintf(nickname, sizeof(nickname), "Player%02d", i);
+		nickindex_add(nickname, (unsigned int)i);
+	}
+	CHECK_EQ(nickindex_search("Player00", 2, matches, 2), 2);
+	CHECK_EQ(matches[0].distance, 0);
+}
+
+/*
+ * The trigram filter never drops a match: every query returns exactly what comparing the term
+ * with each nickname finds. Variants of a few stems on a small alphabet make many near matches.
+ * The terms are long enough that the distance is never lowered for them.
+ */
+static void testAgainstScan() {
+	static struct EditPattern pattern;
+	static struct NickMatch matches[2048];
+	static char stems[8][24];
+	char nickname[32];
+	unsigned int i, j, round, count, expected, distance, mismatches = 0, total = 0;
+	size_t length;
+	int found, m;
+
+	nickindex_clear();
+	for(i = 0; i < 8; i++) {
+		for(j = 0; j < 16; j++) {
+			stems[i][j] = (char)('a' + checkRandom() % 6);
+		}
+		stems[i][16] = '\0';
+	}
+	for(i = 0; i < 2000; i++) {
+		memcpy(nickname, stems[i % 8], 17);
+		for(j = checkRandom() % 5; j > 0; j--) {
+			nickname[checkRandom() % 16] = (char)('a' + checkRandom() % 6);
+		}
+		nickindex_add(nickname, i);
+	}
+	count = nickindex_count();
+	CHECK(count > 1000);
+
+	for(round = 0; round < 100; round++) {
+		memcpy(nickname, stems[round % 8], 17);
+		for(j = checkRandom() % 3; j > 0; j--) {
+			nickname[checkRandom() % 16] = (char)('a' + checkRandom() % 6);
+		}
+		length = round % 2 ? 16 : 14 + checkRandom() % 3;
+		nickname[length] = '\0';
+		distance = round % 4;
+		editdist_compile(&pattern, nickname, length);
+		expected = 0;
+		for(i = 0; i < count; i++) {
+			const char* indexed = nickindex_nickname(i);
+			if(editdist_bounded(&pattern, indexed, strlen(indexed), distance) <= distance) {
+				expected++;
+			}
+		}
+		found = nickindex_search(nickname, distance, matches, 2048);
+		total += expected;
+		if((unsigned int)found != expected) {
+			mismatches++;
+		}
+		for(m = 0; m < found; m++) {
+			const char* indexed = nickindex_nickname(matches[m].id);
+			if(editdist_bounded(&pattern, indexed, strlen(indexed), distance) != matches[m].distance) {
+				mismatches++;
+			}
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+	CHECK(total > 100);
+}
+
+static void testClear() {
+	struct NickMatch matches[4];
+
+	addAll();
+	nickindex_clear();
+	CHECK_EQ(nickindex_count(), 0);
+	CHECK_EQ(nickindex_search("Admin", 1, matches, 4), 0);
+	CHECK_EQ(nickindex_add("Admin", 7), 0);
+	CHECK_EQ(nickindex_search("Admin", 0, matches, 4), 1);
+	nickindex_clear();
+}
+
+int main() {
+	RUN(testExactAndFuzzy);
+	RUN(testLookAlikes);
+	RUN(testDuplicateUpdatesTag);
+	RUN(testMaxMatches);
+	RUN(testAgainstScan);
+	RUN(testClear);
+	return CHECK_EXIT();
+}
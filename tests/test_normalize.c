@@ -0,0 +1,123 @@
+/*
+ * Search By - nickname normalization tests
+ */
+
+#include "check.h"
+#include "normalize.h"
+
+static const char* skeleton(const char* nickname) {
+	static char out[256];
+
+	normalize_nickname(nickname, out, sizeof(out));
+	return out;
+}
+
+static void testAscii() {
+	CHECK_STR(skeleton("Admin"), "admin");
+	CHECK_STR(skeleton("ADMIN"), "admln");
+	CHECK_STR(skeleton("l1I|"), "llll");
+	CHECK_STR(skeleton("B0SS"), "boss");
+	CHECK_STR(skeleton("[Clan] Player Name 123"), "[clan] player name l23");
+	CHECK_STR(skeleton(""), "");
+}
+
+static void testLookAlikes() {
+	CHECK_STR(skeleton("\xd0\x90" "dmin"), "admin");          /* Cyrillic A */
+	CHECK_STR(skeleton("\xce\x91" "dmin"), "admin");          /* Greek Alpha */
+	CHECK_STR(skeleton("p\xd0\xb0ssw\xd0\xbe" "rd"), "password");  /* Cyrillic a and o */
+	CHECK_STR(skeleton("\xef\xbc\xa1\xef\xbd\x84\xef\xbd\x8d\xef\xbd\x89\xef\xbd\x8e"), "admin");  /* Fullwidth */
+	CHECK_STR(skeleton("Ad\xc3\xafn"), "adin");                /* i with diaeresis */
+	CHECK_STR(skeleton("Adm" "\xe2\x80\x8b" "in"), "admin");   /* Zero width space */
+	CHECK_STR(skeleton("Ad" "e\xcc\x81" "m"), "adem");         /* Combining acute accent */
+}
+
+static void testAccentsAndCase() {
+	CHECK_STR(skeleton("\xc5\x81\xc3\xb3" "d" "\xc5\xba"), "lodz");               /* Latin Extended-A */
+	CHECK_STR(skeleton("\xc5\x92"), "\xc5\x93");                                  /* No base letter, only case folded */
+	CHECK_STR(skeleton("\xce\xa3\xce\x9f\xce\xa6\xce\x99\xce\x91"), "\xcf\x83o\xcf\x86la");  /* Greek */
+	CHECK_STR(skeleton("\xd0\x96\xd0\x81"), "\xd0\xb6\xd1\x91");                    /* Cyrillic */
+	CHECK_STR(skeleton("GG \xf0\x9f\x98\x80"), "gg \xf0\x9f\x98\x80");               /* Outside the tables, copied */
+}
+
+static void testSpacesAndInvisibles() {
+	CHECK_STR(skeleton("a\xc2\xa0" "b\xe3\x80\x80" "c"), "a b c");        /* No-break and ideographic space */
+	CHECK_STR(skeleton("\xe2\x80\xae" "nimda"), "nimda");                /* Right-to-left override */
+	CHECK_STR(skeleton("ad\xc2\xad" "min\xef\xbb\xbf"), "admin");        /* Soft hyphen and BOM */
+}
+
+/* One character of each kind, as the scalar loop sees them when they stand alone */
+static const char* const pieces[] = {
+	"a", "Z", "I", "1", "|", "0", " ", "[", "\xd0\x90", "\xce\x91", "\xc3\xaf", "\xe2\x80\x8b", "\xcc\x81",
+	"\xef\xbc\xa1", "\xc2\xa0", "\xd0\x96", "\xf0\x9f\x98\x80", "\xff"
+};
+
+#define PIECE_COUNT (sizeof(pieces) / sizeof(pieces[0]))
+
+/*
+ * The skeleton is built character by character, so a string normalizes to its characters'
+ * skeletons put together. Long ASCII runs go through the 16 byte path, with the multibyte
+ * characters landing at every offset of a block.
+ */
+static void testRunsMatchCharacters() {
+	char nickname[256];
+	char expected[256];
+	char out[256];
+	unsigned int round, count, mismatches = 0;
+	size_t nicknameLength, expectedLength, length;
+	const char* piece;
+
+	for(round = 0; round < 2000; round++) {
+		nicknameLength = 0;
+		expectedLength = 0;
+		for(count = checkRandom() % 60; count > 0; count--) {
+			piece = checkRandom() % 4 ? pieces[checkRandom() % 8] : pieces[checkRandom() % PIECE_COUNT];
+			length = normalize_nickname(piece, out, sizeof(out));
+			memcpy(nickname + nicknameLength, piece, strlen(piece));
+			nicknameLength += strlen(piece);
+			memcpy(expected + expectedLength, out, length);
+			expectedLength += length;
+		}
+		nickname[nicknameLength] = '\0';
+		expected[expectedLength] = '\0';
+		if(normalize_nickname(nickname, out, sizeof(out)) != expectedLength || strcmp(out, expected) != 0) {
+			mismatches++;
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+}
+
+static void testInvalidUtf8() {
+	CHECK_STR(skeleton("a\xff" "b"), "a?b");
+	CHECK_STR(skeleton("a\xc3"), "a?");
+	CHECK_STR(skeleton("\xe0\x80\xaf"), "???");  /* Overlong '/' */
+	CHECK_STR(skeleton("\xf5\x80\x80\x80"), "????");  /* Beyond U+10FFFF */
+	CHECK_STR(skeleton("\xf8\x88\x80" "a"), "???a");  /* No lead byte, not a three byte sequence */
+	CHECK_STR(skeleton("\xfe\x80\x80"), "???");
+}
+
+/* The output is cut at a character boundary and always terminated */
+static void testTruncation() {
+	char out[6];
+
+	CHECK_EQ(normalize_nickname("abcdefgh", out, sizeof(out)), 5);
+	CHECK_STR(out, "abcde");
+	CHECK_EQ(normalize_nickname("abcd\xd0\xb6", out, sizeof(out)), 4);
+	CHECK_STR(out, "abcd");
+	CHECK_EQ(normalize_nickname("abc", out, 1), 0);
+	CHECK_STR(out, "");
+
+	/* The 16 byte path stops where the output would not fit */
+	CHECK_EQ(normalize_nickname("ABCDEFGHIJKLMNOPQRSTUVWXYZ", out, sizeof(out)), 5);
+	CHECK_STR(out, "abcde");
+}
+
+int main() {
+	RUN(testAscii);
+	RUN(testLookAlikes);
+	RUN(testAccentsAndCase);
+	RUN(testSpacesAndInvisibles);
+	RUN(testRunsMatchCharacters);
+	RUN(testInvalidUtf8);
+	RUN(testTruncation);
+	return CHECK_EXIT();
+}
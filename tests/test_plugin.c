@@ -0,0 +1,639 @@
+/*
+ * Search By - plugin callback tests against the mock client
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "check.h"
+#include "ts3mock.h"
+#include "clientlib_publicdefinitions.h"
+#include "plugin.h"
+#include "providers.h"
+#include "encode.h"
+#include "clientqueue.h"
+#include "recent.h"
+#include "protect.h"
+#include "allochook.h"
+
+#define SERVER 1
+#define MY_ID 1
+#define CHANNEL 7
+
+static char configPath[256];
+
+/* One connected server with ourselves and two other clients, as the plugin sees it after connecting */
+static void setUp() {
+	mock_reset(configPath);
+	mock_addServer(SERVER, "Test Server & Friends", "serveruid=", MY_ID);
+	mock_addClient(SERVER, MY_ID, CHANNEL, "Myself", "myuid=", 1);
+	mock_addClient(SERVER, 2, CHANNEL, "Alice & Bob", "rQ0V1g4uGJm1xrhgBbzKycIgNsw=", 42);
+	mock_addClient(SERVER, 3, CHANNEL + 1, "Carl", "carluid=", 43);
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_CONNECTION_ESTABLISHED, 0);
+	recent_clear();
+	mock_clearMessages();
+	mock_clearLaunches();
+}
+
+/* The URL a provider should open for a term */
+static const char* expectedUrl(const struct SearchProvider* provider, const char* term) {
+	static char url[2048];
+	char* encoded;
+
+	if(provider->encoding == PROVIDER_ENCODING_URL) {
+		encoded = url_encode(term);
+		snprintf(url, sizeof(url), "%s%s", provider->url, encoded);
+		free(encoded);
+	} else {
+		snprintf(url, sizeof(url), "%s%s", provider->url, term);
+	}
+	return url;
+}
+
+static void testInitMenus() {
+	struct PluginMenuItem** items = NULL;
+	char* icon = NULL;
+	unsigned int i;
+
+	ts3plugin_initMenus(&items, &icon);
+	CHECK(items != NULL);
+	CHECK_STR(icon, "search.png");
+	for(i = 0; items[i]; i++) {
+		if(i < PROVIDER_COUNT) {
+			CHECK_EQ(items[i]->id, providers[i].menuID);
+			CHECK_EQ(items[i]->type, providers[i].menuType);
+			CHECK_STR(items[i]->text, providers[i].text);
+		}
+	}
+	CHECK_EQ(i, PROVIDER_COUNT + 2);
+
+	/* The client frees every item, the array and the icon */
+	for(i = 0; items[i]; i++) {
+		ts3plugin_freeMemory(items[i]);
+	}
+	ts3plugin_freeMemory(items);
+	ts3plugin_freeMemory(icon);
+}
+
+/* The menu block is one allocation, freed once with the last pointer the client releases, whatever the order */
+static void testMenuRelease() {
+	struct PluginMenuItem** items;
+	char* icon;
+	unsigned int i, allocations;
+	int order;
+	void* other;
+
+	for(order = 0; order < 3; order++) {
+		allochook_begin();
+		ts3plugin_initMenus(&items, &icon);
+		CHECK(items != NULL);
+		if(order == 1) {
+			ts3plugin_freeMemory(items);  /* The array is the start of the block */
+		} else if(order == 2) {
+			ts3plugin_freeMemory(icon);
+		}
+		for(i = 0; i < PROVIDER_COUNT + 2; i++) {
+			ts3plugin_freeMemory(items[i]);  /* Still allocated, at least one pointer is outstanding */
+		}
+		if(order != 1) {
+			ts3plugin_freeMemory(items);
+		}
+		if(order != 2) {
+			ts3plugin_freeMemory(icon);
+		}
+		allocations = allochook_end();
+		if(allochook_available()) {
+			CHECK_EQ(allocations, 1);
+			CHECK_EQ(allochook_frees(), 1);
+		}
+	}
+
+	/* Once the block is gone every pointer is freed as usual */
+	allochook_begin();
+	other = malloc(sizeof(struct PluginMenuItem*));
+	ts3plugin_freeMemory(other);
+	allochook_end();
+	if(allochook_available()) {
+		CHECK_EQ(allochook_frees(), 1);
+	}
+}
+
+static void testClientMenus() {
+	unsigned int i;
+
+	setUp();
+	for(i = 0; i < PROVIDER_COUNT; i++) {
+		if(providers[i].menuType != PLUGIN_MENU_TYPE_CLIENT) {
+			continue;
+		}
+		ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, providers[i].menuID, 2);
+		switch(providers[i].source) {
+			case PROVIDER_SOURCE_CLIENT_NICKNAME:
+				CHECK_STR(mock_lastLaunch(), expectedUrl(&providers[i], "Alice & Bob"));
+				break;
+			case PROVIDER_SOURCE_CLIENT_UID:
+				CHECK_STR(mock_lastLaunch(), expectedUrl(&providers[i], "rQ0V1g4uGJm1xrhgBbzKycIgNsw="));
+				break;
+			default:
+				CHECK_STR(mock_lastLaunch(), expectedUrl(&providers[i], "42"));
+				break;
+		}
+	}
+	CHECK(mock_printed("Searching for"));
+	CHECK_EQ(mock_outstanding(), 0);
+}
+
+static void testGlobalMenus() {
+	struct MockServer* server;
+	unsigned int i;
+
+	setUp();
+	server = mock_server(SERVER);
+	snprintf(server->ip, sizeof(server->ip), "192.0.2.10");
+	for(i = 0; i < PROVIDER_COUNT; i++) {
+		if(providers[i].menuType != PLUGIN_MENU_TYPE_GLOBAL) {
+			continue;
+		}
+		ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_GLOBAL, providers[i].menuID, 0);
+		if(providers[i].source == PROVIDER_SOURCE_SERVER_NAME) {
+			CHECK_STR(mock_lastLaunch(), expectedUrl(&providers[i], "Test Server & Friends"));
+		} else {
+			CHECK_STR(mock_lastLaunch(), expectedUrl(&providers[i], "192.0.2.10"));
+		}
+	}
+	CHECK_EQ(mock_outstanding(), 0);
+}
+
+/* A second click on the same search within the window opens no second tab */
+static void testDuplicateSearch() {
+	setUp();
+	recent_setWindow(60000);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, 2);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, 2);
+	CHECK_EQ(mock_launchCount(), 1);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, 3);  /* Another client */
+	CHECK_EQ(mock_launchCount(), 2);
+	recent_setWindow(RECENT_DEFAULT_WINDOW_MS);
+}
+
+/* A search the launcher could not take is not remembered, retrying it within the window opens it */
+static void testRetryAfterFailedLaunch() {
+	setUp();
+	recent_setWindow(60000);
+	mock_setLauncherFull(1);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, 2);
+	CHECK_EQ(mock_launchCount(), 0);
+	mock_setLauncherFull(0);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, 2);
+	CHECK_EQ(mock_launchCount(), 1);
+
+	/* Also when the failed attempt reused a remembered URL */
+	recent_setWindow(0);
+	mock_setLauncherFull(1);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, 2);
+	mock_setLauncherFull(0);
+	recent_setWindow(60000);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, 2);
+	CHECK_EQ(mock_launchCount(), 2);
+	recent_setWindow(RECENT_DEFAULT_WINDOW_MS);
+}
+
+static void testNotConnected() {
+	setUp();
+	mock_server(SERVER)->connected = 0;
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_1, 0);
+	CHECK_EQ(mock_launchCount(), 0);
+	CHECK(mock_printed("Are you connected"));
+}
+
+/* Clicks the TSViewer IP search of a server and returns the URL it opened, or "" */
+static const char* searchServerIp(uint64 server) {
+	const unsigned int launches = mock_launchCount();
+
+	recent_clear();  /* Every click resolves the address, not the recent searches */
+	ts3plugin_onMenuItemEvent(server, PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_4, 0);
+	return mock_launchCount() != launches ? mock_lastLaunch() : "";
+}
+
+/* The address comes from VIRTUALSERVER_IP, else the raw property 76, else the address we connected to */
+static void testServerAddressFallbacks() {
+	const struct SearchProvider* provider = providers_find(MENU_ID_GLOBAL_4);
+	struct MockServer* server;
+
+	setUp();
+	server = mock_server(SERVER);
+	snprintf(server->ip, sizeof(server->ip), "192.0.2.10");
+	snprintf(server->property76, sizeof(server->property76), "198.51.100.7");
+	snprintf(server->connectedAddress, sizeof(server->connectedAddress), "203.0.113.5");
+	CHECK_STR(searchServerIp(SERVER), expectedUrl(provider, "192.0.2.10"));
+
+	server->ip[0] = '\0';
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_CONNECTION_ESTABLISHED, 0);
+	CHECK_STR(searchServerIp(SERVER), expectedUrl(provider, "198.51.100.7"));
+
+	server->property76[0] = '\0';
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_CONNECTION_ESTABLISHED, 0);
+	CHECK_STR(searchServerIp(SERVER), expectedUrl(provider, "203.0.113.5"));
+
+	/* Nothing to search for, and nothing is cached */
+	server->connectedAddress[0] = '\0';
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_CONNECTION_ESTABLISHED, 0);
+	CHECK_STR(searchServerIp(SERVER), "");
+	snprintf(server->ip, sizeof(server->ip), "192.0.2.11");
+	CHECK_STR(searchServerIp(SERVER), expectedUrl(provider, "192.0.2.11"));
+	CHECK_EQ(mock_outstanding(), 0);
+}
+
+/* The resolved address is kept until the connection status of its server changes, other servers keep theirs */
+static void testServerAddressInvalidation() {
+	const struct SearchProvider* provider = providers_find(MENU_ID_GLOBAL_4);
+	struct MockServer* server;
+	struct MockServer* other;
+	unsigned int calls;
+
+	setUp();
+	server = mock_server(SERVER);
+	snprintf(server->ip, sizeof(server->ip), "192.0.2.10");
+	other = mock_addServer(SERVER + 1, "Other Server", "otheruid=", MY_ID);
+	snprintf(other->ip, sizeof(other->ip), "192.0.2.50");
+	CHECK_STR(searchServerIp(SERVER), expectedUrl(provider, "192.0.2.10"));
+	CHECK_STR(searchServerIp(SERVER + 1), expectedUrl(provider, "192.0.2.50"));
+
+	/* Cached: a changed address is not seen, and the lookup makes no calls into the client */
+	snprintf(server->ip, sizeof(server->ip), "192.0.2.20");
+	snprintf(other->ip, sizeof(other->ip), "192.0.2.60");
+	calls = mock_calls();
+	CHECK_STR(searchServerIp(SERVER), expectedUrl(provider, "192.0.2.10"));
+	CHECK_EQ(mock_calls() - calls, 1);  /* Only getClientID, the connection check */
+
+	/* A disconnect and reconnect resolve it again, only for that server */
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_DISCONNECTED, 0);
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_CONNECTION_ESTABLISHED, 0);
+	CHECK_STR(searchServerIp(SERVER), expectedUrl(provider, "192.0.2.20"));
+	CHECK_STR(searchServerIp(SERVER + 1), expectedUrl(provider, "192.0.2.50"));
+	CHECK_EQ(mock_outstanding(), 0);
+}
+
+/* Menu IDs of another type or no provider at all are ignored */
+static void testUnknownMenus() {
+	setUp();
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_CLIENT_1, 2);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, 999, 2);
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CLIENT, MENU_ID_CLIENT_1, 999);
+	CHECK_EQ(mock_launchCount(), 0);
+}
+
+static void testAbout() {
+	setUp();
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_GLOBAL, MENU_ID_GLOBAL_ABOUT, 0);
+	CHECK(mock_printed("About Search By"));
+	CHECK_EQ(mock_launchCount(), 0);
+}
+
+/* Reads the page the last launch opened. Returns 1 if it could be read. */
+static int readLaunchedPage(char* page, size_t size) {
+	FILE* file = mock_lastLaunch() ? fopen(mock_lastLaunch(), "rb") : NULL;
+	size_t length;
+
+	if(!file) {
+		return 0;
+	}
+	length = fread(page, 1, size - 1, file);
+	page[length] = '\0';
+	fclose(file);
+	return 1;
+}
+
+/* The channel search writes one page with every client of the channel and opens it */
+static void testChannelSearch() {
+	char page[64 * 1024];
+
+	setUp();
+	ts3plugin_onMenuItemEvent(SERVER, PLUGIN_MENU_TYPE_CHANNEL, MENU_ID_CHANNEL_SEARCH_CLIENTS, CHANNEL);
+	CHECK_EQ(mock_launchCount(), 1);
+	CHECK(mock_lastLaunch() && strstr(mock_lastLaunch(), "search_by_channel.html"));
+	CHECK(mock_printed("Opening searches for 2 clients"));
+	CHECK(readLaunchedPage(page, sizeof(page)));
+	CHECK(strstr(page, "Clients in Channel 7") != NULL);
+	CHECK(strstr(page, "Myself") != NULL);
+	CHECK(strstr(page, "Alice &amp; Bob") != NULL);
+	CHECK(strstr(page, "Carl") == NULL);
+	CHECK_EQ(mock_outstanding(), 0);
+}
+
+/* An offline client is requested by UID, its searches open once the server confirmed the reply */
+static void testResolveUid() {
+	char page[64 * 1024];
+	char returnCode[64];
+
+	setUp();
+	ts3plugin_processCommand(SERVER, "uid offlineuid=");
+	CHECK(mock_lastReturnCode()[0] != '\0');
+	snprintf(returnCode, sizeof(returnCode), "%s", mock_lastReturnCode());
+	CHECK_EQ(mock_launchCount(), 0);
+
+	ts3plugin_onClientNamefromUIDEvent(SERVER, "offlineuid=", 55, "Offline Olga");
+	CHECK_EQ(mock_launchCount(), 0);
+	CHECK_EQ(ts3plugin_onServerErrorEvent(SERVER, "ok", MOCK_ERROR_OK, returnCode, ""), 1);
+	CHECK_EQ(mock_launchCount(), 1);
+	CHECK(mock_lastLaunch() && strstr(mock_lastLaunch(), "search_by_client.html"));
+	CHECK(mock_printed("offlineuid=: nickname \"Offline Olga\", database ID 55"));
+	CHECK(readLaunchedPage(page, sizeof(page)));
+	CHECK(strstr(page, "Offline Olga") != NULL);
+
+	/* Within the TTL the cached reply is used, by UID and by database ID, without another request */
+	ts3plugin_processCommand(SERVER, "uid offlineuid=");
+	ts3plugin_processCommand(SERVER, "dbid 55");
+	CHECK_STR(mock_lastReturnCode(), returnCode);
+	CHECK_EQ(mock_launchCount(), 3);
+
+	/* Errors of requests that are not ours are left to the client */
+	CHECK_EQ(ts3plugin_onServerErrorEvent(SERVER, "ok", MOCK_ERROR_OK, "someone else", ""), 0);
+	CHECK_EQ(ts3plugin_onServerErrorEvent(SERVER, "ok", MOCK_ERROR_OK, returnCode, ""), 0);
+}
+
+static void testResolveFailed() {
+	char returnCode[64];
+
+	setUp();
+	ts3plugin_processCommand(SERVER, "uid");
+	CHECK(mock_printed("Usage: /searchby uid <unique id>"));
+	CHECK_STR(mock_lastReturnCode(), "");
+
+	ts3plugin_processCommand(SERVER, "uid unknownuid=");
+	snprintf(returnCode, sizeof(returnCode), "%s", mock_lastReturnCode());
+	CHECK_EQ(ts3plugin_onServerErrorEvent(SERVER, "invalid clientID", MOCK_ERROR_CLIENT_INVALID_ID, returnCode, ""), 1);
+	CHECK(mock_printed("Lookup failed: invalid clientID"));
+
+	/* Confirmed without a reply */
+	ts3plugin_processCommand(SERVER, "dbid 9999");
+	CHECK(strcmp(mock_lastReturnCode(), returnCode) != 0);
+	CHECK_EQ(ts3plugin_onServerErrorEvent(SERVER, "ok", MOCK_ERROR_OK, mock_lastReturnCode(), ""), 1);
+	CHECK(mock_printed("Lookup failed: no such client"));
+	CHECK_EQ(mock_launchCount(), 0);
+}
+
+/* A disconnect drops the cached replies and the requests in flight of that server */
+static void testResolveDisconnect() {
+	char returnCode[64];
+
+	setUp();
+	ts3plugin_processCommand(SERVER, "uid leftuid=");
+	ts3plugin_onClientNamefromUIDEvent(SERVER, "leftuid=", 56, "Left");
+	CHECK_EQ(ts3plugin_onServerErrorEvent(SERVER, "ok", MOCK_ERROR_OK, mock_lastReturnCode(), ""), 1);
+	CHECK_EQ(mock_launchCount(), 1);
+	ts3plugin_processCommand(SERVER, "uid pendinguid=");
+	snprintf(returnCode, sizeof(returnCode), "%s", mock_lastReturnCode());
+
+	ts3plugin_onConnectStatusChangeEvent(SERVER, STATUS_DISCONNECTED, 0);
+	CHECK_EQ(ts3plugin_onServerErrorEvent(SERVER, "ok", MOCK_ERROR_OK, returnCode, ""), 0);
+
+	setUp();
+	ts3plugin_processCommand(SERVER, "uid leftuid=");
+	CHECK(mock_lastReturnCode()[0] != '\0');
+	CHECK(strcmp(mock_lastReturnCode(), returnCode) != 0);
+	CHECK_EQ(mock_launchCount(), 0);
+}
+
+static void testProviderCommand() {
+	setUp();
+	CHECK_EQ(ts3plugin_processCommand(SERVER, "google Some Term"), 0);
+	CHECK_STR(mock_lastLaunch(), "https://www.google.com/search?q=Some+Term");
+	CHECK_EQ(ts3plugin_processCommand(SERVER, "nonsense"), 0);
+	CHECK(mock_printed("Usage:"));
+	CHECK(mock_printed("/searchby <provider> <term>"));
+	CHECK_EQ(mock_launchCount(), 1);
+}
+
+#define BATCH_LINE_MAX 255  /* Longest term of plugin.c */
+
+/* A file of terms becomes one page with every term's searches, opened with a single launch */
+static void testBatch() {
+	static char page[256 * 1024];
+	char path[300];
+	char command[320];
+	char longTerm[BATCH_LINE_MAX + 64];
+	char expected[BATCH_LINE_MAX + 128];
+	FILE* file;
+
+	setUp();
+	ts3plugin_onClientMoveEvent(SERVER, 2, 0, CHANNEL, ENTER_VISIBILITY, "");
+	snprintf(path, sizeof(path), "%sbatch_terms.txt", configPath);
+	file = fopen(path, "wb");
+	CHECK(file != NULL);
+	if(!file) {
+		return;
+	}
+	memset(longTerm, 'x', sizeof(longTerm) - 1);
+	longTerm[sizeof(longTerm) - 1] = '\0';
+	fprintf(file, "Zed Zebra\r\n\n   \n# comment\n  rQ0V1g4uGJm1xrhgBbzKycIgNsw=\t\n%s\nLast", longTerm);
+	fclose(file);
+
+	snprintf(command, sizeof(command), "batch %s", path);
+	CHECK_EQ(ts3plugin_processCommand(SERVER, command), 0);
+	CHECK(mock_printed("Opening searches for 4 terms"));
+	CHECK_EQ(mock_launchCount(), 1);
+	CHECK(mock_lastLaunch() && strstr(mock_lastLaunch(), "search_by_batch.html"));
+	CHECK(readLaunchedPage(page, sizeof(page)));
+	CHECK(strstr(page, "https://www.google.com/search?q=Zed+Zebra") != NULL);
+	CHECK(strstr(page, "https://www.google.com/search?q=rQ0V1g4uGJm1xrhgBbzKycIgNsw%3d") != NULL);
+	CHECK(strstr(page, "Seen as &quot;Alice &amp; Bob&quot; (database ID 42)") != NULL);
+	CHECK(strstr(page, "https://www.google.com/search?q=Last") != NULL);
+	CHECK(strstr(page, "comment") == NULL);
+
+	/* An overlong line is cut to one term, its rest is not read as another line */
+	snprintf(expected, sizeof(expected), "https://www.google.com/search?q=%.*s\"", BATCH_LINE_MAX, longTerm);
+	CHECK(strstr(page, expected) != NULL);
+
+	ts3plugin_processCommand(SERVER, "batch");
+	CHECK(mock_printed("Usage: /searchby batch <file>"));
+	snprintf(command, sizeof(command), "batch %smissing.txt", configPath);
+	ts3plugin_processCommand(SERVER, command);
+	CHECK(mock_printed("Cant open"));
+	CHECK_EQ(mock_launchCount(), 1);
+	remove(path);
+}
+
+/* What the config watcher and the reclaim task do, run from the queue inside the next callback */
+static char reloadPath[300];
+
+static void reloadAndReclaim(struct ClientTask* task, int discard) {
+	if(!discard) {
+		providers_load(reloadPath);
+		providers_reclaim();
+	}
+}
+
+/* A table replaced and reclaimed while a command runs its queued tasks is not the one it searches */
+static void testProviderReload() {
+	struct ClientTask task;
+	FILE* file;
+
+	setUp();
+	snprintf(reloadPath, sizeof(reloadPath), "%sreload_providers.txt", configPath);
+	file = fopen(reloadPath, "wb");
+	CHECK(file != NULL);
+	if(!file) {
+		return;
+	}
+	fputs("mywiki\thttps://wiki.example/?q={term}\n", file);
+	fclose(file);
+
+	CHECK_EQ(ts3plugin_processCommand(SERVER, "google First"), 0);
+	CHECK_STR(mock_lastLaunch(), "https://www.google.com/search?q=First");
+	task.run = reloadAndReclaim;
+	clientqueue_post(&task);
+	CHECK_EQ(ts3plugin_processCommand(SERVER, "mywiki Second"), 0);
+	CHECK_STR(mock_lastLaunch(), "https://wiki.example/?q=Second");
+	CHECK_EQ(mock_launchCount(), 2);
+	CHECK_EQ(providers_retired(), 0);
+
+	/* Back to the built-in providers for the other tests */
+	remove(reloadPath);
+	clientqueue_post(&task);
+	ts3plugin_processCommand(SERVER, "google Third");
+	CHECK(providers_findKeyword(providers_current(), "mywiki") == NULL);
+}
+
+/* Joins go into the seen users index, which the seen and nick commands read */
+static void testSeenUsers() {
+	setUp();
+	mock_addClient(SERVER, 9, CHANNEL, "Dora", "dorauid=", 77);
+	ts3plugin_onClientMoveEvent(SERVER, 9, 0, CHANNEL, ENTER_VISIBILITY, "");
+	ts3plugin_processCommand(SERVER, "seen dorauid=");
+	CHECK(mock_printed("\"Dora\" (database ID 77) on server serveruid="));
+	ts3plugin_processCommand(SERVER, "nick Dorra");
+	CHECK(mock_printed("\"Dora\" (UID dorauid=, 1 edits away)"));
+	ts3plugin_processCommand(SERVER, "seen nobody=");
+	CHECK(mock_printed("This UID has not been seen yet."));
+}
+
+/* Update events without a rename, like talk status changes, are no new sighting */
+static void testRenameSighting() {
+	setUp();
+	mock_addClient(SERVER, 11, CHANNEL, "Eve", "eveuid=", 78);
+	ts3plugin_onClientMoveEvent(SERVER, 11, 0, CHANNEL, ENTER_VISIBILITY, "");
+	ts3plugin_onUpdateClientEvent(SERVER, 11, 0, "", "");
+	ts3plugin_onUpdateClientEvent(SERVER, 11, 0, "", "");
+	snprintf(mock_client(SERVER, 11)->nickname, sizeof(mock_client(SERVER, 11)->nickname), "Evelyn");
+	ts3plugin_onUpdateClientEvent(SERVER, 11, 0, "", "");
+	ts3plugin_processCommand(SERVER, "seen eveuid=");
+	CHECK(mock_printed("\"Eve\" (database ID 78) on server serveruid=, seen 1 times"));
+	CHECK(mock_printed("\"Evelyn\" (database ID 78) on server serveruid=, seen 1 times"));
+}
+
+static void testFind() {
+	setUp();
+	ts3plugin_processCommand(SERVER, "find aLiCe");
+	CHECK(mock_printed("Test Server & Friends: \"Alice & Bob\""));
+	mock_clearMessages();
+	ts3plugin_processCommand(SERVER, "find carluid=");
+	CHECK(mock_printed("\"Carl\" (UID carluid=)"));
+	ts3plugin_processCommand(SERVER, "find Zed");
+	CHECK(mock_printed("No client on any open server matches."));
+	CHECK_EQ(mock_outstanding(), 0);
+}
+
+/* Joins are checked on the protect worker, the warning is printed by a later callback on the client thread */
+static void testImpersonator() {
+	unsigned int waited;
+
+	setUp();
+	mock_addClient(SERVER, 12, CHANNEL, "Admin", "adminuid=", 80);
+	ts3plugin_onClientMoveEvent(SERVER, 12, 0, CHANNEL, ENTER_VISIBILITY, "");
+	mock_addClient(SERVER, 13, CHANNEL, "Adminn", "fakeuid=", 81);
+	ts3plugin_onClientMoveEvent(SERVER, 13, 0, CHANNEL, ENTER_VISIBILITY, "");
+	for(waited = 0; waited < 5000 && !mock_printed("Possible impersonator"); waited += 10) {
+		usleep(10 * 1000);
+		ts3plugin_onTalkStatusChangeEvent(SERVER, 0, 0, 2);
+	}
+	CHECK(mock_printed("Possible impersonator: \"Adminn\" (UID fakeuid=) is 1 edits away from protected nickname \"Admin\""));
+	CHECK(!mock_printed("UID adminuid="));
+	CHECK_EQ(mock_offThreadCalls(), 0);
+}
+
+/* A search click, missing or hitting the recent searches, makes no heap allocation for any provider */
+static void testMenuAllocations() {
+	unsigned int i, allocations;
+	int round;
+	uint64 selected;
+
+	if(!allochook_available()) {
+		printf("  allocations are not counted in this build, skipped\n");
+		return;
+	}
+	/* The hook itself sees allocations of the modules */
+	allochook_begin();
+	free(url_encode("a b"));
+	CHECK_EQ(allochook_end(), 1);
+
+	setUp();
+	snprintf(mock_server(SERVER)->ip, sizeof(mock_server(SERVER)->ip), "192.0.2.10");
+	recent_setWindow(0);
+	for(i = 0; i < PROVIDER_COUNT; i++) {
+		selected = providers[i].menuType == PLUGIN_MENU_TYPE_CLIENT ? 2 : 0;
+		for(round = 0; round < 2; round++) {
+			mock_clearLaunches();
+			allochook_begin();
+			ts3plugin_onMenuItemEvent(SERVER, providers[i].menuType, providers[i].menuID, selected);
+			allocations = allochook_end();
+			if(allocations != 0) {
+				printf("  %s, %s: %u allocations\n", providers[i].text, round ? "hit" : "miss", allocations);
+			}
+			CHECK_EQ(allocations, 0);
+			CHECK_EQ(mock_launchCount(), 1);
+		}
+	}
+	recent_setWindow(RECENT_DEFAULT_WINDOW_MS);
+	CHECK_EQ(mock_outstanding(), 0);
+}
+
+int main() {
+	char protectedPath[300];
+	FILE* file;
+
+	if(checkTempDirectory(configPath, sizeof(configPath), "plugin") != 0) {
+		printf("cannot create a temporary directory\n");
+		return 1;
+	}
+	snprintf(protectedPath, sizeof(protectedPath), "%s%s", configPath, PROTECT_FILENAME);
+	file = fopen(protectedPath, "wb");
+	if(file) {
+		fputs("Admin\tadminuid=\n", file);
+		fclose(file);
+	}
+	mock_reset(configPath);
+	mock_install();
+	ts3plugin_registerPluginID("test_plugin");
+	if(ts3plugin_init() != 0) {
+		printf("ts3plugin_init failed\n");
+		return 1;
+	}
+
+	RUN(testInitMenus);
+	RUN(testMenuRelease);
+	RUN(testClientMenus);
+	RUN(testGlobalMenus);
+	RUN(testMenuAllocations);
+	RUN(testDuplicateSearch);
+	RUN(testRetryAfterFailedLaunch);
+	RUN(testNotConnected);
+	RUN(testServerAddressFallbacks);
+	RUN(testServerAddressInvalidation);
+	RUN(testUnknownMenus);
+	RUN(testAbout);
+	RUN(testChannelSearch);
+	RUN(testResolveUid);
+	RUN(testResolveFailed);
+	RUN(testResolveDisconnect);
+	RUN(testProviderCommand);
+	RUN(testProviderReload);
+	RUN(testBatch);
+	RUN(testSeenUsers);
+	RUN(testRenameSighting);
+	RUN(testFind);
+	RUN(testImpersonator);
+
+	ts3plugin_shutdown();
+	checkRemoveTempDirectory(configPath);
+	return CHECK_EXIT();
+}
@@ -0,0 +1,148 @@
+/*
+ * Search By - protected nickname tests
+ */
+
+#include <unistd.h>
+#include "check.h"
+#include "clientqueue.h"
+#include "protect.h"
+
+#define WAIT_MS 5000
+
+static char configPath[256];
+static char listPath[300];
+static struct ProtectMatch matches[16];
+static unsigned int matchCount = 0;
+
+static void onMatch(const struct ProtectMatch* match) {
+	if(matchCount < 16) {
+		matches[matchCount] = *match;
+	}
+	matchCount++;
+}
+
+static void writeList(const char* contents) {
+	FILE* file = fopen(listPath, "wb");
+
+	if(file) {
+		fputs(contents, file);
+		fclose(file);
+	}
+}
+
+/* Runs the client queue until count matches arrived */
+static int waitForMatches(unsigned int count) {
+	unsigned int waited;
+
+	for(waited = 0; waited < WAIT_MS; waited += 10) {
+		clientqueue_run();
+		if(matchCount >= count) {
+			return 1;
+		}
+		usleep(10 * 1000);
+	}
+	return 0;
+}
+
+static void testLoad() {
+	writeList("# Admins\nAdmin\tadminuid=\nNoOwner\n\nModerator\tmoduid=\r\n");
+	CHECK_EQ(protect_load(listPath), 0);
+	CHECK_EQ(protect_count(), 2);
+	CHECK_EQ(protect_ignored(), 1);
+	CHECK_STR(protect_name(0), "Admin");
+	CHECK_STR(protect_name(1), "Moderator");
+	CHECK_STR(protect_name(2), "");
+}
+
+static void testCheck() {
+	unsigned int distance = 99;
+
+	writeList("Admin\tadminuid=\nModerator\tmoduid=\nBob\tbobuid=\n");
+	CHECK_EQ(protect_load(listPath), 0);
+	CHECK_EQ(protect_check("Admln", "other=", &distance), 0);
+	CHECK_EQ(distance, 1);
+	CHECK_EQ(protect_check("Moderat0r", "other=", &distance), 1);
+	CHECK_EQ(protect_check("Modrator_", "other=", &distance), 1);
+	CHECK_EQ(distance, 2);
+	CHECK_EQ(protect_check("Bobby", "other=", &distance), -1);  /* Short names allow one edit */
+	CHECK_EQ(protect_check("Someone", "other=", &distance), -1);
+}
+
+/* The owner of a protected nickname is never flagged, with it or anything close to it */
+static void testOwner() {
+	unsigned int distance;
+
+	writeList("Admin\tadminuid=\nAdmin\n");
+	CHECK_EQ(protect_load(listPath), 0);
+	CHECK_EQ(protect_check("Admin", "adminuid=", &distance), -1);
+	CHECK_EQ(protect_check("Admin_", "adminuid=", &distance), -1);
+	CHECK_EQ(protect_check("Admin", "other=", &distance), 0);
+}
+
+/* More names than one batch holds, and a skeleton too long for a batch */
+static void testManyNames() {
+	char list[4096];
+	char nickname[PROTECT_NICKNAME_BUFSIZE];
+	unsigned int i, distance;
+	size_t used = 0;
+
+	for(i = 0; i < 10; i++) {
+		used += snprintf(list + used, sizeof(list) - used, "Guardian%c\tuid%u=\n", 'a' + i, i);
+	}
+	memset(nickname, 'q', 100);
+	nickname[100] = '\0';
+	snprintf(list + used, sizeof(list) - used, "%s\tlonguid=\n", nickname);
+	writeList(list);
+	CHECK_EQ(protect_load(listPath), 0);
+	CHECK_EQ(protect_count(), 11);
+	CHECK_EQ(protect_check("Guardianj", "other=", &distance), 9);
+	CHECK_EQ(distance, 0);
+	CHECK_EQ(protect_check("Guardiann", "other=", &distance), 0);  /* One edit from all of them, the first listed wins */
+	nickname[50] = 'x';
+	CHECK_EQ(protect_check(nickname, "other=", &distance), 10);
+	CHECK_EQ(distance, 1);
+	CHECK_EQ(protect_check(nickname, "longuid=", &distance), -1);
+}
+
+/* Queued nicknames are checked on the worker, matches reach the callback from clientqueue_run */
+static void testSubmit() {
+	writeList("Admin\tadminuid=\n");
+	CHECK_EQ(protect_load(listPath), 0);
+	matchCount = 0;
+	CHECK_EQ(protect_submit(1, 5, "Admin", "adminuid="), 0);
+	CHECK_EQ(protect_submit(1, 6, "Someone", "other="), 0);
+	CHECK_EQ(protect_submit(2, 7, "Admln", "fake="), 0);
+	CHECK_EQ(matchCount, 0);
+	CHECK(waitForMatches(1));
+	CHECK_EQ(matchCount, 1);
+	CHECK_EQ(matches[0].server, 2);
+	CHECK_EQ(matches[0].client, 7);
+	CHECK_STR(matches[0].nickname, "Admln");
+	CHECK_STR(matches[0].uid, "fake=");
+	CHECK_STR(matches[0].protectedName, "Admin");
+	CHECK_EQ(matches[0].distance, 1);
+}
+
+int main() {
+	if(checkTempDirectory(configPath, sizeof(configPath), "protect") != 0) {
+		printf("cannot create a temporary directory\n");
+		return 1;
+	}
+	snprintf(listPath, sizeof(listPath), "%s%s", configPath, PROTECT_FILENAME);
+	clientqueue_init();
+	if(protect_init(onMatch) != 0) {
+		printf("protect_init failed\n");
+		return 1;
+	}
+
+	RUN(testLoad);
+	RUN(testCheck);
+	RUN(testOwner);
+	RUN(testManyNames);
+	RUN(testSubmit);
+
+	protect_shutdown();
+	clientqueue_shutdown();
+	checkRemoveTempDirectory(configPath);
+	return CHECK_EXIT();
+}
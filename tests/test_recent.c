@@ -0,0 +1,130 @@
+/*
+ * Search By - recent menu searches tests
+ */
+
+#include "check.h"
+#include "recent.h"
+
+#define GENERATION 1
+#define OTHER_GENERATION 2
+
+static void testMissStoreHit() {
+	struct RecentStats stats;
+	char url[RECENT_URL_BUFSIZE];
+
+	recent_clear();
+	recent_setWindow(0);
+	CHECK_EQ(recent_lookup(1, GENERATION, "Alice", url, sizeof(url)), RECENT_MISS);
+	recent_store(1, GENERATION, "Alice", "http://example.com/?q=Alice");
+	CHECK_EQ(recent_lookup(1, GENERATION, "Alice", url, sizeof(url)), RECENT_HIT);
+	CHECK_STR(url, "http://example.com/?q=Alice");
+
+	/* Menu ID, term and generation all belong to the key, an entry of a reloaded table is dropped */
+	CHECK_EQ(recent_lookup(2, GENERATION, "Alice", url, sizeof(url)), RECENT_MISS);
+	CHECK_EQ(recent_lookup(1, GENERATION, "alice", url, sizeof(url)), RECENT_MISS);
+	recent_stats(&stats);
+	CHECK_EQ(stats.count, 1);
+	CHECK_EQ(recent_lookup(1, OTHER_GENERATION, "Alice", url, sizeof(url)), RECENT_MISS);
+
+	recent_stats(&stats);
+	CHECK_EQ(stats.hits, 1);
+	CHECK_EQ(stats.misses, 4);
+	CHECK_EQ(stats.count, 0);
+}
+
+/* Within the window a repeat is a duplicate, nothing is copied */
+static void testDuplicateWindow() {
+	struct RecentStats stats;
+	char url[RECENT_URL_BUFSIZE];
+
+	recent_clear();
+	recent_setWindow(60000);
+	CHECK_EQ(recent_window(), 60000);
+	recent_store(1, GENERATION, "Alice", "http://example.com/?q=Alice");
+	url[0] = '\0';
+	CHECK_EQ(recent_lookup(1, GENERATION, "Alice", url, sizeof(url)), RECENT_DUPLICATE);
+	CHECK_STR(url, "");
+	recent_stats(&stats);
+	CHECK_EQ(stats.duplicates, 1);
+
+	/* A forgotten search is opened again within the window */
+	recent_forget(1, "Alice");
+	recent_forget(1, "Nobody");
+	CHECK_EQ(recent_lookup(1, GENERATION, "Alice", url, sizeof(url)), RECENT_MISS);
+	recent_stats(&stats);
+	CHECK_EQ(stats.count, 0);
+	recent_setWindow(RECENT_DEFAULT_WINDOW_MS);
+}
+
+/* The least recently used entry goes first, lookups refresh an entry */
+static void testEviction() {
+	struct RecentStats stats;
+	char term[32];
+	char url[RECENT_URL_BUFSIZE];
+	int i;
+
+	recent_clear();
+	recent_setWindow(0);
+	for(i = 0; i < RECENT_CAPACITY; i++) {
+		snprintf(term, sizeof(term), "term%d", i);
+		recent_store(1, GENERATION, term, term);
+	}
+	CHECK_EQ(recent_lookup(1, GENERATION, "term0", url, sizeof(url)), RECENT_HIT);
+	recent_store(1, GENERATION, "new", "new");  /* Evicts term1, term0 was just used */
+
+	CHECK_EQ(recent_lookup(1, GENERATION, "term0", url, sizeof(url)), RECENT_HIT);
+	CHECK_EQ(recent_lookup(1, GENERATION, "term1", url, sizeof(url)), RECENT_MISS);
+	CHECK_EQ(recent_lookup(1, GENERATION, "term2", url, sizeof(url)), RECENT_HIT);
+	CHECK_EQ(recent_lookup(1, GENERATION, "new", url, sizeof(url)), RECENT_HIT);
+	recent_stats(&stats);
+	CHECK_EQ(stats.evictions, 1);
+	CHECK_EQ(stats.count, RECENT_CAPACITY);
+}
+
+/* Random operations against a plain array kept in use order */
+static void testAgainstModel() {
+	static char modelTerms[RECENT_CAPACITY][16];
+	int modelCount = 0;
+	char term[16];
+	char url[RECENT_URL_BUFSIZE];
+	enum RecentResult result;
+	int i, j, found;
+
+	recent_clear();
+	recent_setWindow(0);
+	for(i = 0; i < 100000; i++) {
+		snprintf(term, sizeof(term), "t%u", checkRandom() % 150);
+		found = -1;
+		for(j = 0; j < modelCount; j++) {
+			if(strcmp(modelTerms[j], term) == 0) {
+				found = j;
+			}
+		}
+		result = recent_lookup(7, GENERATION, term, url, sizeof(url));
+		CHECK_EQ(result, found >= 0 ? RECENT_HIT : RECENT_MISS);
+		if(found >= 0) {
+			CHECK_STR(url, term);
+			memmove(modelTerms[found], modelTerms[found + 1], (size_t)(modelCount - found - 1) * sizeof(modelTerms[0]));
+			modelCount--;
+		} else {
+			recent_store(7, GENERATION, term, term);
+			if(modelCount == RECENT_CAPACITY) {
+				memmove(modelTerms[0], modelTerms[1], (size_t)(modelCount - 1) * sizeof(modelTerms[0]));
+				modelCount--;
+			}
+		}
+		memcpy(modelTerms[modelCount++], term, sizeof(term));
+		if(checkFailures > 20) {
+			return;
+		}
+	}
+	recent_clear();
+}
+
+int main() {
+	RUN(testMissStoreHit);
+	RUN(testDuplicateWindow);
+	RUN(testEviction);
+	RUN(testAgainstModel);
+	return CHECK_EXIT();
+}
@@ -0,0 +1,178 @@
+/*
+ * Search By - persistent seen users index tests
+ */
+
+#include "check.h"
+#include "seenindex.h"
+
+static char directory[256];
+static char path[512];
+
+static void openFresh(const char* name) {
+	seenindex_close();
+	snprintf(path, sizeof(path), "%s%s", directory, name);
+	remove(path);
+	CHECK_EQ(seenindex_open(path), 0);
+}
+
+static void testRecordAndFind() {
+	const struct SeenRecord* record;
+	int first, second, third;
+
+	openFresh("record.db");
+	CHECK_EQ(seenindex_count(), 0);
+	CHECK_EQ(seenindex_findUid("aliceuid=", -1), -1);
+
+	first = seenindex_record("aliceuid=", "server1=", "Alice", 42, 1000);
+	second = seenindex_record("aliceuid=", "server2=", "Alice", 0, 1001);
+	third = seenindex_record("aliceuid=", "server1=", "Alicia", 42, 1002);
+	CHECK_EQ(first, 0);
+	CHECK_EQ(second, 1);
+	CHECK_EQ(third, 2);
+	CHECK_EQ(seenindex_record("", "server1=", "Nobody", 0, 1000), -1);  /* Clients without a UID are not kept */
+
+	/* The same UID, server and nickname again only updates the record */
+	CHECK_EQ(seenindex_record("aliceuid=", "server1=", "Alice", 0, 2000), first);
+	CHECK_EQ(seenindex_count(), 3);
+	record = seenindex_get((unsigned int)first);
+	CHECK_EQ(record->sightings, 2);
+	CHECK_EQ(record->firstSeen, 1000);
+	CHECK_EQ(record->lastSeen, 2000);
+	CHECK_EQ(record->databaseID, 42);  /* An unknown database ID does not overwrite a known one */
+	CHECK_STR(record->serverUid, "server1=");
+	CHECK(seenindex_get(3) == NULL);
+
+	/* All records of a UID, newest first */
+	CHECK_EQ(seenindex_findUid("aliceuid=", -1), third);
+	CHECK_EQ(seenindex_findUid("aliceuid=", third), second);
+	CHECK_EQ(seenindex_findUid("aliceuid=", second), first);
+	CHECK_EQ(seenindex_findUid("aliceuid=", first), -1);
+	CHECK_EQ(seenindex_findUid("bobuid=", -1), -1);
+}
+
+static void testReopen() {
+	openFresh("reopen.db");
+	seenindex_record("aliceuid=", "server1=", "Alice", 42, 1000);
+	seenindex_record("bobuid=", "server1=", "Bob", 43, 1000);
+	seenindex_close();
+	CHECK_EQ(seenindex_count(), 0);
+	CHECK(seenindex_get(0) == NULL);
+	CHECK_EQ(seenindex_record("carluid=", "server1=", "Carl", 0, 1000), -1);
+
+	CHECK_EQ(seenindex_open(path), 0);
+	CHECK_EQ(seenindex_count(), 2);
+	CHECK_STR(seenindex_get((unsigned int)seenindex_findUid("bobuid=", -1))->nickname, "Bob");
+	seenindex_close();
+}
+
+/* A file that is not an index is replaced by an empty one */
+static void testInvalidFile() {
+	FILE* file;
+	char junk[4096];
+
+	seenindex_close();
+	snprintf(path, sizeof(path), "%s%s", directory, "junk.db");
+	file = fopen(path, "wb");
+	memset(junk, 'x', sizeof(junk));
+	fwrite(junk, 1, sizeof(junk), file);
+	fclose(file);
+	CHECK_EQ(seenindex_open(path), 0);
+	CHECK_EQ(seenindex_count(), 0);
+	CHECK_EQ(seenindex_record("aliceuid=", "server1=", "Alice", 42, 1000), 0);
+	seenindex_close();
+}
+
+/* Past the initial capacity the file grows and earlier records stay valid */
+static void testGrow() {
+	char uid[32];
+	char nickname[32];
+	unsigned int i;
+	int index;
+
+	openFresh("grow.db");
+	for(i = 0; i < SEENINDEX_INITIAL_CAPACITY * 2 + 10; i++) {
+		snprintf(uid, sizeof(uid), "uid%u=", i);
+		snprintf(nickname, sizeof(nickname), "Nick%u", i);
+		CHECK_EQ(seenindex_record(uid, "server1=", nickname, i, 1000), i);
+	}
+	CHECK_EQ(seenindex_count(), SEENINDEX_INITIAL_CAPACITY * 2 + 10);
+	for(i = 0; i < SEENINDEX_INITIAL_CAPACITY * 2 + 10; i += 97) {
+		snprintf(uid, sizeof(uid), "uid%u=", i);
+		index = seenindex_findUid(uid, -1);
+		CHECK_EQ(index, i);
+		CHECK_EQ(seenindex_get((unsigned int)index)->databaseID, i);
+	}
+	seenindex_close();
+	remove(path);
+}
+
+/* Overwrites one unsigned int of a closed index file */
+static void patchFile(long offset, unsigned int value) {
+	FILE* file = fopen(path, "r+b");
+
+	CHECK(file != NULL);
+	if(file) {
+		fseek(file, offset, SEEK_SET);
+		fwrite(&value, sizeof(value), 1, file);
+		fclose(file);
+	}
+}
+
+/* Links pointing past the records or at newer ones end a chain instead of being followed */
+static void testDamagedChains() {
+	const long buckets = (long)sizeof(struct SeenHeader);
+	const long records = buckets + (long)(SEENINDEX_BUCKET_COUNT * sizeof(unsigned int));
+	unsigned int bucket, value;
+	FILE* file;
+
+	openFresh("damaged.db");
+	seenindex_record("aliceuid=", "server1=", "Alice", 42, 1000);
+	seenindex_record("aliceuid=", "server2=", "Alice", 42, 1000);
+	seenindex_record("aliceuid=", "server3=", "Alice", 42, 1000);
+	seenindex_close();
+
+	/* Record 1 points at itself, record 0 far past the end */
+	patchFile(records + 1 * (long)sizeof(struct SeenRecord), 2);
+	patchFile(records + 0 * (long)sizeof(struct SeenRecord), 1000000);
+	CHECK_EQ(seenindex_open(path), 0);
+	CHECK_EQ(seenindex_findUid("aliceuid=", -1), 2);
+	CHECK_EQ(seenindex_findUid("aliceuid=", 2), 1);
+	CHECK_EQ(seenindex_findUid("aliceuid=", 1), -1);
+	CHECK_EQ(seenindex_findUid("aliceuid=", 0), -1);
+	CHECK_EQ(seenindex_findUid("aliceuid=", 1000000), -1);
+	CHECK_EQ(seenindex_record("aliceuid=", "server1=", "Alice", 42, 2000), 3);  /* Record 0 is out of reach now */
+	seenindex_close();
+
+	/* The bucket of the UID points past the records */
+	file = fopen(path, "rb");
+	CHECK(file != NULL);
+	if(!file) {
+		return;
+	}
+	fseek(file, buckets, SEEK_SET);
+	for(bucket = 0; bucket < SEENINDEX_BUCKET_COUNT && fread(&value, sizeof(value), 1, file) == 1 && value != 4; bucket++);
+	fclose(file);
+	CHECK(bucket < SEENINDEX_BUCKET_COUNT);
+	patchFile(buckets + (long)(bucket * sizeof(unsigned int)), 0xFFFFFFFF);
+	CHECK_EQ(seenindex_open(path), 0);
+	CHECK_EQ(seenindex_findUid("aliceuid=", -1), -1);
+	CHECK_EQ(seenindex_record("aliceuid=", "server1=", "Alice", 42, 3000), 4);
+	CHECK_EQ(seenindex_findUid("aliceuid=", -1), 4);
+	CHECK_EQ(seenindex_findUid("aliceuid=", 4), -1);
+	seenindex_close();
+	remove(path);
+}
+
+int main() {
+	if(checkTempDirectory(directory, sizeof(directory), "seenindex") != 0) {
+		printf("cannot create a temporary directory\n");
+		return 1;
+	}
+	RUN(testRecordAndFind);
+	RUN(testReopen);
+	RUN(testInvalidFile);
+	RUN(testGrow);
+	RUN(testDamagedChains);
+	checkRemoveTempDirectory(directory);
+	return CHECK_EXIT();
+}
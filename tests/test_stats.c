@@ -0,0 +1,93 @@
+/*
+ * Search By - search latency statistics tests
+ */
+
+#include "check.h"
+#include "stats.h"
+
+#define MAX_LINES 32
+
+static char lines[MAX_LINES][STATS_LINE_BUFSIZE];
+static unsigned int lineCount;
+
+static void collect(void* context, const char* line) {
+	if(lineCount < MAX_LINES) {
+		snprintf(lines[lineCount], STATS_LINE_BUFSIZE, "%s", line);
+	}
+	lineCount++;
+}
+
+static unsigned int report() {
+	static const char* const names[] = { "first", "second" };
+
+	lineCount = 0;
+	return stats_report(names, 2, collect, NULL);
+}
+
+static void testEmpty() {
+	stats_clear();
+	CHECK_EQ(report(), 0);
+	CHECK_EQ(lineCount, 0);
+}
+
+static void testClock() {
+	const stats_ticks first = stats_now();
+	const stats_ticks second = stats_now();
+
+	CHECK(second >= first);
+	CHECK(first > 0);
+}
+
+/*
+ * Samples recorded with a start far in the past dominate the few nanoseconds the
+ * call itself takes, so the percentiles are known up to the bucket width.
+ */
+static void testPercentiles() {
+	stats_ticks now;
+	unsigned int i;
+	char* p;
+	double value;
+
+	stats_clear();
+	for(i = 0; i < 1000; i++) {
+		now = stats_now();
+		stats_record(1, STATS_STAGE_URL, now - (i < 900 ? 1000000 : 50000000));
+	}
+	CHECK_EQ(report(), 1);
+	CHECK(strncmp(lines[0], "second url: 1000, p50 ", 22) == 0);
+
+	p = strstr(lines[0], "p50 ");
+	CHECK(p && sscanf(p + 4, "%lfms", &value) == 1 && value >= 1.0 && value <= 1.0 * 17 / 16 + 0.1);
+	p = strstr(lines[0], "p99 ");
+	CHECK(p && sscanf(p + 4, "%lfms", &value) == 1 && value >= 50.0 && value <= 50.0 * 17 / 16 + 1);
+	p = strstr(lines[0], "max ");
+	CHECK(p && sscanf(p + 4, "%lfms", &value) == 1 && value >= 50.0 && value < 60.0);
+}
+
+static void testErrors() {
+	stats_clear();
+	stats_error(0, STATS_ERROR_LAUNCH);
+	stats_error(0, STATS_ERROR_LAUNCH);
+	stats_error(0, STATS_ERROR_FETCH);
+	CHECK_EQ(report(), 1);
+	CHECK_STR(lines[0], "first errors: term 0, launch 2, fetch 1");
+	stats_clear();
+	CHECK_EQ(report(), 0);
+}
+
+/* Durations past the histogram range are counted in its last bucket */
+static void testOverflow() {
+	stats_clear();
+	stats_record(0, STATS_STAGE_FETCH, stats_now() - (1ULL << 50));
+	CHECK_EQ(report(), 1);
+	CHECK(strstr(lines[0], "first fetch: 1, ") == lines[0]);
+}
+
+int main() {
+	RUN(testEmpty);
+	RUN(testClock);
+	RUN(testPercentiles);
+	RUN(testErrors);
+	RUN(testOverflow);
+	return CHECK_EXIT();
+}
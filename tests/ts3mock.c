@@ -0,0 +1,579 @@
+/*
+ * Search By - mock TeamSpeak client
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "public_rare_definitions.h"
+#include "ts3mock.h"
+#include "plugin.h"
+#include "launcher.h"
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION mock_mutex;
+#define mutexLock(m)    EnterCriticalSection(m)
+#define mutexUnlock(m)  LeaveCriticalSection(m)
+#define snprintf sprintf_s
+#else
+typedef pthread_mutex_t mock_mutex;
+#define mutexLock(m)    pthread_mutex_lock(m)
+#define mutexUnlock(m)  pthread_mutex_unlock(m)
+#endif
+
+/* Memory handed to the plugin, sized for the client list of a full server */
+#define POOL_SLOTS 32
+#define POOL_SLOT_SIZE ((MOCK_MAX_CLIENTS + 1) * sizeof(anyID) + 64)
+
+static char pool[POOL_SLOTS][POOL_SLOT_SIZE];
+static int poolUsed[POOL_SLOTS];
+static unsigned int outstanding = 0;
+
+static struct MockServer servers[MOCK_MAX_SERVERS];
+static struct MockClient clients[MOCK_MAX_CLIENTS];
+static unsigned short clientSlot[MOCK_MAX_SERVERS][65536];  /* Index into clients + 1 by server slot and client ID, 0 = none */
+static char configPath[MOCK_PATH_BUFSIZE];
+static unsigned int calls = 0;
+static unsigned int offThreadCalls = 0;
+#ifdef _WIN32
+static DWORD clientThread;
+#else
+static pthread_t clientThread;
+#endif
+
+/* Messages can be printed from the plugin's worker threads */
+#ifdef _WIN32
+static mock_mutex logMutex;
+static int logMutexReady = 0;
+#else
+static mock_mutex logMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static char messages[MOCK_MAX_MESSAGES][MOCK_MESSAGE_BUFSIZE];
+static unsigned int messageCount = 0;
+static char launches[MOCK_MAX_LAUNCHES][MOCK_LAUNCH_BUFSIZE];
+static unsigned int launchCount = 0;
+static int launcherFull = 0;
+static int launcherRunning = 0;
+static int (*launcherOpen)(const char* url) = NULL;
+
+static char returnCode[64];
+static unsigned int returnCodeCounter = 0;
+
+static void* poolAlloc(size_t size) {
+	unsigned int i;
+
+	if(size > POOL_SLOT_SIZE) {
+		printf("MOCK: %u bytes do not fit a pool slot\n", (unsigned int)size);
+		return NULL;
+	}
+	for(i = 0; i < POOL_SLOTS; i++) {
+		if(!poolUsed[i]) {
+			poolUsed[i] = 1;
+			outstanding++;
+			return pool[i];
+		}
+	}
+	printf("MOCK: pool exhausted, the plugin does not free client memory\n");
+	return NULL;
+}
+
+static unsigned int poolString(const char* value, char** result) {
+	const size_t length = strlen(value);
+	char* copy = (char*)poolAlloc(length + 1);
+
+	if(!copy) {
+		return MOCK_ERROR_PARAMETER_INVALID;
+	}
+	memcpy(copy, value, length + 1);
+	*result = copy;
+	return MOCK_ERROR_OK;
+}
+
+static unsigned int mockFreeMemory(void* pointer) {
+	const char* p = (const char*)pointer;
+	unsigned int slot;
+
+	if(p < pool[0] || p >= pool[POOL_SLOTS - 1] + POOL_SLOT_SIZE || (size_t)(p - pool[0]) % POOL_SLOT_SIZE != 0) {
+		printf("MOCK: freeMemory(%p) was not handed out by the client\n", pointer);
+		return MOCK_ERROR_PARAMETER_INVALID;
+	}
+	slot = (unsigned int)((size_t)(p - pool[0]) / POOL_SLOT_SIZE);
+	if(!poolUsed[slot]) {
+		printf("MOCK: freeMemory(%p) twice\n", pointer);
+		return MOCK_ERROR_PARAMETER_INVALID;
+	}
+	poolUsed[slot] = 0;
+	outstanding--;
+	return MOCK_ERROR_OK;
+}
+
+struct MockServer* mock_server(uint64 id) {
+	unsigned int i;
+
+	for(i = 0; i < MOCK_MAX_SERVERS; i++) {
+		if(servers[i].id == id && id != 0) {
+			return &servers[i];
+		}
+	}
+	return NULL;
+}
+
+/* Returns the slot of a server in servers, or MOCK_MAX_SERVERS if there is none */
+static unsigned int serverSlot(uint64 id) {
+	const struct MockServer* server = mock_server(id);
+	return server ? (unsigned int)(server - servers) : MOCK_MAX_SERVERS;
+}
+
+struct MockClient* mock_client(uint64 server, anyID id) {
+	const unsigned int slot = serverSlot(server);
+
+	if(slot == MOCK_MAX_SERVERS || clientSlot[slot][id] == 0) {
+		return NULL;
+	}
+	return &clients[clientSlot[slot][id] - 1];
+}
+
+static void copyString(char* dest, size_t destSize, const char* src) {
+	snprintf(dest, destSize, "%s", src ? src : "");
+}
+
+/* The plugin may only call the client from the thread that calls its callbacks, which the tests run on */
+static void checkThread() {
+#ifdef _WIN32
+	const int onClientThread = GetCurrentThreadId() == clientThread;
+#else
+	const int onClientThread = pthread_equal(pthread_self(), clientThread);
+#endif
+	if(!onClientThread) {
+		mutexLock(&logMutex);
+		offThreadCalls++;
+		mutexUnlock(&logMutex);
+	}
+}
+
+static void countCall() {
+	checkThread();
+	calls++;
+}
+
+/********************************* Client library functions *********************************/
+
+static void mockGetConfigPath(char* path, size_t maxLen) {
+	copyString(path, maxLen, configPath);
+}
+
+static void mockGetEmptyPath(char* path, size_t maxLen) {
+	copyString(path, maxLen, "");
+}
+
+static void logMessage(const char* message) {
+	checkThread();
+	mutexLock(&logMutex);
+	copyString(messages[messageCount % MOCK_MAX_MESSAGES], MOCK_MESSAGE_BUFSIZE, message);
+	messageCount++;
+	mutexUnlock(&logMutex);
+}
+
+static void mockPrintMessageToCurrentTab(const char* message) {
+	logMessage(message);
+}
+
+static void mockPrintMessage(uint64 serverConnectionHandlerID, const char* message, enum PluginMessageTarget messageTarget) {
+	logMessage(message);
+}
+
+static unsigned int mockGetClientID(uint64 serverConnectionHandlerID, anyID* result) {
+	const struct MockServer* server = mock_server(serverConnectionHandlerID);
+
+	countCall();
+	if(!server) {
+		return MOCK_ERROR_SERVER_INVALID_ID;
+	}
+	if(!server->connected) {
+		return MOCK_ERROR_NOT_CONNECTED;
+	}
+	*result = server->myID;
+	return MOCK_ERROR_OK;
+}
+
+static unsigned int mockGetClientVariableAsString(uint64 serverConnectionHandlerID, anyID clientID, size_t flag, char** result) {
+	const struct MockClient* client = mock_client(serverConnectionHandlerID, clientID);
+
+	countCall();
+	if(!client) {
+		return MOCK_ERROR_CLIENT_INVALID_ID;
+	}
+	switch(flag) {
+		case CLIENT_NICKNAME:
+			return poolString(client->nickname, result);
+		case CLIENT_UNIQUE_IDENTIFIER:
+			return poolString(client->uid, result);
+		default:
+			return MOCK_ERROR_PARAMETER_INVALID;
+	}
+}
+
+static unsigned int mockGetClientVariableAsInt(uint64 serverConnectionHandlerID, anyID clientID, size_t flag, int* result) {
+	const struct MockClient* client = mock_client(serverConnectionHandlerID, clientID);
+
+	countCall();
+	if(!client) {
+		return MOCK_ERROR_CLIENT_INVALID_ID;
+	}
+	if(flag != CLIENT_DATABASE_ID) {
+		return MOCK_ERROR_PARAMETER_INVALID;
+	}
+	*result = client->databaseID;
+	return MOCK_ERROR_OK;
+}
+
+/* Lists the clients of a server, of one channel only if channelID is not 0 */
+static unsigned int listClients(uint64 serverConnectionHandlerID, uint64 channelID, anyID** result) {
+	anyID* list;
+	unsigned int i, count = 0;
+
+	if(!mock_server(serverConnectionHandlerID)) {
+		return MOCK_ERROR_SERVER_INVALID_ID;
+	}
+	list = (anyID*)poolAlloc((MOCK_MAX_CLIENTS + 1) * sizeof(anyID));
+	if(!list) {
+		return MOCK_ERROR_PARAMETER_INVALID;
+	}
+	for(i = 0; i < MOCK_MAX_CLIENTS; i++) {
+		if(clients[i].server == serverConnectionHandlerID && (channelID == 0 || clients[i].channel == channelID)) {
+			list[count++] = clients[i].id;
+		}
+	}
+	list[count] = 0;
+	*result = list;
+	return MOCK_ERROR_OK;
+}
+
+static unsigned int mockGetClientList(uint64 serverConnectionHandlerID, anyID** result) {
+	countCall();
+	return listClients(serverConnectionHandlerID, 0, result);
+}
+
+static unsigned int mockGetChannelClientList(uint64 serverConnectionHandlerID, uint64 channelID, anyID** result) {
+	countCall();
+	return listClients(serverConnectionHandlerID, channelID, result);
+}
+
+static unsigned int mockGetChannelOfClient(uint64 serverConnectionHandlerID, anyID clientID, uint64* result) {
+	const struct MockClient* client = mock_client(serverConnectionHandlerID, clientID);
+
+	countCall();
+	if(!client) {
+		return MOCK_ERROR_CLIENT_INVALID_ID;
+	}
+	*result = client->channel;
+	return MOCK_ERROR_OK;
+}
+
+static unsigned int mockGetChannelVariableAsString(uint64 serverConnectionHandlerID, uint64 channelID, size_t flag, char** result) {
+	char name[64];
+
+	countCall();
+	if(!mock_server(serverConnectionHandlerID) || flag != CHANNEL_NAME) {
+		return MOCK_ERROR_PARAMETER_INVALID;
+	}
+	snprintf(name, sizeof(name), "Channel %llu", (unsigned long long)channelID);
+	return poolString(name, result);
+}
+
+static unsigned int mockGetServerConnectionHandlerList(uint64** result) {
+	uint64* list;
+	unsigned int i, count = 0;
+
+	countCall();
+	list = (uint64*)poolAlloc((MOCK_MAX_SERVERS + 1) * sizeof(uint64));
+	if(!list) {
+		return MOCK_ERROR_PARAMETER_INVALID;
+	}
+	for(i = 0; i < MOCK_MAX_SERVERS; i++) {
+		if(servers[i].id) {
+			list[count++] = servers[i].id;
+		}
+	}
+	list[count] = 0;
+	*result = list;
+	return MOCK_ERROR_OK;
+}
+
+static unsigned int mockGetServerVariableAsString(uint64 serverConnectionHandlerID, size_t flag, char** result) {
+	const struct MockServer* server = mock_server(serverConnectionHandlerID);
+
+	countCall();
+	if(!server) {
+		return MOCK_ERROR_SERVER_INVALID_ID;
+	}
+	switch(flag) {
+		case VIRTUALSERVER_UNIQUE_IDENTIFIER:
+			return poolString(server->uid, result);
+		case VIRTUALSERVER_NAME:
+			return poolString(server->name, result);
+		case VIRTUALSERVER_IP:
+			return poolString(server->ip, result);
+		case 76:
+			return poolString(server->property76, result);
+		default:
+			return MOCK_ERROR_PARAMETER_INVALID;
+	}
+}
+
+static unsigned int mockGetConnectionVariableAsString(uint64 serverConnectionHandlerID, anyID clientID, size_t flag, char** result) {
+	const struct MockServer* server = mock_server(serverConnectionHandlerID);
+
+	countCall();
+	if(!server) {
+		return MOCK_ERROR_SERVER_INVALID_ID;
+	}
+	if(clientID != server->myID || flag != 6) {
+		return MOCK_ERROR_PARAMETER_INVALID;
+	}
+	return poolString(server->connectedAddress, result);
+}
+
+static void mockCreateReturnCode(const char* pluginID, char* result, size_t maxLen) {
+	snprintf(result, maxLen, "PR:%s:%u", pluginID, ++returnCodeCounter);
+}
+
+static unsigned int mockRequestClientNamefromUID(uint64 serverConnectionHandlerID, const char* clientUniqueIdentifier, const char* code) {
+	countCall();
+	if(!mock_server(serverConnectionHandlerID)) {
+		return MOCK_ERROR_SERVER_INVALID_ID;
+	}
+	copyString(returnCode, sizeof(returnCode), code);
+	return MOCK_ERROR_OK;
+}
+
+static unsigned int mockRequestClientNamefromDBID(uint64 serverConnectionHandlerID, uint64 clientDatabaseID, const char* code) {
+	countCall();
+	if(!mock_server(serverConnectionHandlerID)) {
+		return MOCK_ERROR_SERVER_INVALID_ID;
+	}
+	copyString(returnCode, sizeof(returnCode), code);
+	return MOCK_ERROR_OK;
+}
+
+/********************************* Launcher stub *********************************/
+
+int launcher_init() {
+	launcherRunning = 1;
+	return 0;
+}
+
+void launcher_shutdown() {
+	launcherRunning = 0;
+}
+
+int launcher_open(const char* url) {
+	if(launcherOpen) {
+		return launcherOpen(url);
+	}
+	if(!launcherRunning || launcherFull || strlen(url) >= LAUNCHER_URL_BUFSIZE) {
+		return 1;
+	}
+	mutexLock(&logMutex);
+	copyString(launches[launchCount % MOCK_MAX_LAUNCHES], MOCK_LAUNCH_BUFSIZE, url);
+	launchCount++;
+	mutexUnlock(&logMutex);
+	return 0;
+}
+
+/********************************* Scripting *********************************/
+
+void mock_reset(const char* path) {
+#ifdef _WIN32
+	if(!logMutexReady) {
+		InitializeCriticalSection(&logMutex);
+		logMutexReady = 1;
+	}
+#endif
+	memset(servers, 0, sizeof(servers));
+	memset(clients, 0, sizeof(clients));
+	memset(clientSlot, 0, sizeof(clientSlot));
+	copyString(configPath, sizeof(configPath), path);
+	calls = 0;
+	offThreadCalls = 0;
+#ifdef _WIN32
+	clientThread = GetCurrentThreadId();
+#else
+	clientThread = pthread_self();
+#endif
+	launcherFull = 0;
+	launcherOpen = NULL;
+	returnCode[0] = '\0';
+	mock_clearMessages();
+	mock_clearLaunches();
+}
+
+void mock_install() {
+	struct TS3Functions functions;
+
+	memset(&functions, 0, sizeof(functions));
+	functions.freeMemory = mockFreeMemory;
+	functions.getClientID = mockGetClientID;
+	functions.getClientVariableAsInt = mockGetClientVariableAsInt;
+	functions.getClientVariableAsString = mockGetClientVariableAsString;
+	functions.getClientList = mockGetClientList;
+	functions.getChannelOfClient = mockGetChannelOfClient;
+	functions.getChannelVariableAsString = mockGetChannelVariableAsString;
+	functions.getChannelClientList = mockGetChannelClientList;
+	functions.getServerConnectionHandlerList = mockGetServerConnectionHandlerList;
+	functions.getServerVariableAsString = mockGetServerVariableAsString;
+	functions.getConnectionVariableAsString = mockGetConnectionVariableAsString;
+	functions.requestClientNamefromUID = mockRequestClientNamefromUID;
+	functions.requestClientNamefromDBID = mockRequestClientNamefromDBID;
+	functions.getAppPath = mockGetEmptyPath;
+	functions.getResourcesPath = mockGetEmptyPath;
+	functions.getConfigPath = mockGetConfigPath;
+	functions.getPluginPath = mockGetEmptyPath;
+	functions.printMessage = mockPrintMessage;
+	functions.printMessageToCurrentTab = mockPrintMessageToCurrentTab;
+	functions.createReturnCode = mockCreateReturnCode;
+	ts3plugin_setFunctionPointers(functions);
+}
+
+struct MockServer* mock_addServer(uint64 id, const char* name, const char* uid, anyID myID) {
+	struct MockServer* server = mock_server(id);
+	unsigned int i;
+
+	for(i = 0; !server && i < MOCK_MAX_SERVERS; i++) {
+		if(servers[i].id == 0) {
+			server = &servers[i];
+		}
+	}
+	if(!server) {
+		return NULL;
+	}
+	memset(server, 0, sizeof(*server));
+	server->id = id;
+	server->connected = 1;
+	server->myID = myID;
+	copyString(server->name, sizeof(server->name), name);
+	copyString(server->uid, sizeof(server->uid), uid);
+	return server;
+}
+
+struct MockClient* mock_addClient(uint64 server, anyID id, uint64 channel, const char* nickname, const char* uid, int databaseID) {
+	const unsigned int slot = serverSlot(server);
+	struct MockClient* client = mock_client(server, id);
+	unsigned int i;
+
+	if(slot == MOCK_MAX_SERVERS) {
+		return NULL;
+	}
+	for(i = 0; !client && i < MOCK_MAX_CLIENTS; i++) {
+		if(clients[i].server == 0) {
+			client = &clients[i];
+			clientSlot[slot][id] = (unsigned short)(i + 1);
+		}
+	}
+	if(!client) {
+		return NULL;
+	}
+	client->server = server;
+	client->id = id;
+	client->channel = channel;
+	client->databaseID = databaseID;
+	copyString(client->nickname, sizeof(client->nickname), nickname);
+	copyString(client->uid, sizeof(client->uid), uid);
+	return client;
+}
+
+void mock_removeClient(uint64 server, anyID id) {
+	struct MockClient* client = mock_client(server, id);
+
+	if(client) {
+		memset(client, 0, sizeof(*client));
+		clientSlot[serverSlot(server)][id] = 0;
+	}
+}
+
+unsigned int mock_calls() {
+	return calls;
+}
+
+unsigned int mock_offThreadCalls() {
+	unsigned int count;
+
+	mutexLock(&logMutex);
+	count = offThreadCalls;
+	mutexUnlock(&logMutex);
+	return count;
+}
+
+unsigned int mock_outstanding() {
+	return outstanding;
+}
+
+unsigned int mock_messageCount() {
+	return messageCount;
+}
+
+const char* mock_message(unsigned int index) {
+	if(index >= messageCount || index + MOCK_MAX_MESSAGES < messageCount) {
+		return NULL;
+	}
+	return messages[index % MOCK_MAX_MESSAGES];
+}
+
+const char* mock_lastMessage() {
+	return messageCount ? mock_message(messageCount - 1) : NULL;
+}
+
+int mock_printed(const char* text) {
+	unsigned int i;
+
+	for(i = messageCount > MOCK_MAX_MESSAGES ? messageCount - MOCK_MAX_MESSAGES : 0; i < messageCount; i++) {
+		if(strstr(messages[i % MOCK_MAX_MESSAGES], text)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void mock_clearMessages() {
+	mutexLock(&logMutex);
+	messageCount = 0;
+	mutexUnlock(&logMutex);
+}
+
+unsigned int mock_launchCount() {
+	return launchCount;
+}
+
+const char* mock_launch(unsigned int index) {
+	if(index >= launchCount || index + MOCK_MAX_LAUNCHES < launchCount) {
+		return NULL;
+	}
+	return launches[index % MOCK_MAX_LAUNCHES];
+}
+
+const char* mock_lastLaunch() {
+	return launchCount ? mock_launch(launchCount - 1) : NULL;
+}
+
+void mock_clearLaunches() {
+	mutexLock(&logMutex);
+	launchCount = 0;
+	mutexUnlock(&logMutex);
+}
+
+void mock_setLauncherFull(int full) {
+	launcherFull = full;
+}
+
+void mock_setLauncher(int (*open)(const char* url)) {
+	launcherOpen = open;
+}
+
+const char* mock_lastReturnCode() {
+	return returnCode;
+}
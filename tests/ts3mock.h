@@ -0,0 +1,108 @@
+/*
+ * Search By - mock TeamSpeak client
+ *
+ * Fills a struct TS3Functions with functions answering from scriptable servers
+ * and clients, so the plugin callbacks can run outside the client. Messages the
+ * plugin prints are captured, and the launcher is replaced by a stub recording
+ * the URLs instead of opening them.
+ *
+ * Memory handed to the plugin comes from a fixed pool instead of the heap, so
+ * allocation counts only see the plugin's own allocations, and mock_outstanding
+ * shows whether the plugin freed everything it got.
+ */
+
+#ifndef TS3MOCK_H
+#define TS3MOCK_H
+
+#include <stddef.h>
+#include "public_definitions.h"
+#include "plugin_definitions.h"
+#include "ts3_functions.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOCK_MAX_SERVERS 16
+#define MOCK_MAX_CLIENTS 16384
+#define MOCK_MAX_MESSAGES 256
+#define MOCK_MESSAGE_BUFSIZE 1024
+#define MOCK_MAX_LAUNCHES 64
+#define MOCK_LAUNCH_BUFSIZE 1024
+#define MOCK_PATH_BUFSIZE 512
+
+/* Error codes of public_errors.h, which defines its constants and cannot be included twice in a program */
+#define MOCK_ERROR_OK 0x0000
+#define MOCK_ERROR_CLIENT_INVALID_ID 0x0200
+#define MOCK_ERROR_SERVER_INVALID_ID 0x0400
+#define MOCK_ERROR_PARAMETER_INVALID 0x0602
+#define MOCK_ERROR_NOT_CONNECTED 0x0702
+
+struct MockServer {
+	uint64 id;
+	int connected;
+	anyID myID;
+	char name[128];
+	char uid[32];
+	char ip[64];                 /* VIRTUALSERVER_IP */
+	char property76[64];         /* The raw property some servers report their address in */
+	char connectedAddress[64];   /* Connection variable 6 of our own client */
+};
+
+struct MockClient {
+	uint64 server;  /* 0 = unused slot */
+	anyID id;
+	uint64 channel;
+	int databaseID;
+	char nickname[128];
+	char uid[32];
+};
+
+/* Forgets all servers, clients, messages and launches. configPath must end with a separator. */
+void mock_reset(const char* configPath);
+
+/* Hands the mock functions to the plugin with ts3plugin_setFunctionPointers */
+void mock_install();
+
+/* Adds a connected server with our own client as myID, the addresses can be changed in the returned struct */
+struct MockServer* mock_addServer(uint64 id, const char* name, const char* uid, anyID myID);
+struct MockServer* mock_server(uint64 id);
+
+/* Adds a client or replaces it if the ID is taken on that server */
+struct MockClient* mock_addClient(uint64 server, anyID id, uint64 channel, const char* nickname, const char* uid, int databaseID);
+struct MockClient* mock_client(uint64 server, anyID id);
+void mock_removeClient(uint64 server, anyID id);
+
+/* Calls into the mock client library, and pool memory handed out and not freed yet */
+unsigned int mock_calls();
+unsigned int mock_outstanding();
+
+/* Calls and printed messages from any other thread than the one that last called mock_reset */
+unsigned int mock_offThreadCalls();
+
+/* Captured printMessageToCurrentTab and printMessage output, oldest first, the last MOCK_MAX_MESSAGES are kept */
+unsigned int mock_messageCount();
+const char* mock_message(unsigned int index);
+const char* mock_lastMessage();
+/* Returns 1 if any captured message contains text */
+int mock_printed(const char* text);
+void mock_clearMessages();
+
+/* URLs given to the stub launcher, the last MOCK_MAX_LAUNCHES are kept */
+unsigned int mock_launchCount();
+const char* mock_launch(unsigned int index);
+const char* mock_lastLaunch();
+void mock_clearLaunches();
+/* Makes the stub launcher reject URLs like a full queue */
+void mock_setLauncherFull(int full);
+/* Hands the URLs to open instead of recording them, NULL goes back to recording */
+void mock_setLauncher(int (*open)(const char* url));
+
+/* Server requests sent with requestClientNamefromUID/DBID, the last one is kept */
+const char* mock_lastReturnCode();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif